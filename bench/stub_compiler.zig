@@ -0,0 +1,116 @@
+//! Stands in for `clang++` and `ar` during `zig build bench`, so build
+//! benchmarks time ovo rather than a compiler. A compile writes a
+//! placeholder object and a depfile naming the source and every header its
+//! quoted `#include`s reach through `-I`; links and archives write a
+//! placeholder output.
+
+const std = @import("std");
+
+/// Printed for `--version`; the suite checks for it before timing builds.
+pub const banner = "ovo-bench-stub 1";
+
+pub fn main(init: std.process.Init) !void {
+    var arena_state = std.heap.ArenaAllocator.init(std.heap.page_allocator);
+    defer arena_state.deinit();
+    const arena = arena_state.allocator();
+    const io = init.io;
+
+    var argv: std.ArrayList([]const u8) = .empty;
+    var args = try init.minimal.args.iterateAllocator(arena);
+    while (args.next()) |arg| try argv.append(arena, arg);
+    if (argv.items.len < 2) return;
+
+    if (std.mem.eql(u8, std.fs.path.basename(argv.items[0]), "ar")) {
+        // `ar rcs <archive> <objects...>`
+        if (argv.items.len > 2) try writePlaceholder(io, argv.items[2]);
+        return;
+    }
+    if (std.mem.eql(u8, argv.items[1], "--version")) {
+        std.debug.print("{s}\n", .{banner});
+        return;
+    }
+
+    var output: ?[]const u8 = null;
+    var depfile: ?[]const u8 = null;
+    var source: ?[]const u8 = null;
+    var include_dirs: std.ArrayList([]const u8) = .empty;
+    var i: usize = 1;
+    while (i < argv.items.len) : (i += 1) {
+        const arg = argv.items[i];
+        const next = if (i + 1 < argv.items.len) argv.items[i + 1] else null;
+        if (std.mem.eql(u8, arg, "-o")) {
+            output = next;
+            i += 1;
+        } else if (std.mem.eql(u8, arg, "-MF")) {
+            depfile = next;
+            i += 1;
+        } else if (std.mem.eql(u8, arg, "-c")) {
+            source = next;
+            i += 1;
+        } else if (std.mem.startsWith(u8, arg, "-I") and arg.len > 2) {
+            try include_dirs.append(arena, arg[2..]);
+        }
+    }
+
+    const out = output orelse return;
+    try writePlaceholder(io, out);
+    const dep_path = depfile orelse return;
+    const src = source orelse return;
+
+    var rule: std.ArrayList(u8) = .empty;
+    try rule.print(arena, "{s}: {s}", .{ out, src });
+    var seen: std.StringHashMapUnmanaged(void) = .empty;
+    try scanIncludes(arena, io, src, include_dirs.items, &seen, &rule);
+    try rule.append(arena, '\n');
+    try std.Io.Dir.cwd().writeFile(io, .{ .sub_path = dep_path, .data = rule.items, .flags = .{ .truncate = true } });
+}
+
+fn writePlaceholder(io: std.Io, path: []const u8) !void {
+    try std.Io.Dir.cwd().writeFile(io, .{ .sub_path = path, .data = "stub\n", .flags = .{ .truncate = true } });
+}
+
+/// Appends each header `path` reaches to `rule`, once, depth first.
+fn scanIncludes(
+    allocator: std.mem.Allocator,
+    io: std.Io,
+    path: []const u8,
+    include_dirs: []const []const u8,
+    seen: *std.StringHashMapUnmanaged(void),
+    rule: *std.ArrayList(u8),
+) !void {
+    const bytes = std.Io.Dir.cwd().readFileAlloc(io, path, allocator, .limited(4 * 1024 * 1024)) catch return;
+    var lines = std.mem.splitScalar(u8, bytes, '\n');
+    while (lines.next()) |line| {
+        const trimmed = std.mem.trim(u8, line, " \t\r");
+        if (!std.mem.startsWith(u8, trimmed, "#include \"")) continue;
+        const rest = trimmed["#include \"".len..];
+        const close = std.mem.indexOfScalar(u8, rest, '"') orelse continue;
+        const name = rest[0..close];
+        const header = (try findHeader(allocator, io, path, name, include_dirs)) orelse continue;
+        const entry = try seen.getOrPut(allocator, header);
+        if (entry.found_existing) continue;
+        try rule.print(allocator, " {s}", .{header});
+        try scanIncludes(allocator, io, header, include_dirs, seen, rule);
+    }
+}
+
+fn findHeader(
+    allocator: std.mem.Allocator,
+    io: std.Io,
+    includer: []const u8,
+    name: []const u8,
+    include_dirs: []const []const u8,
+) !?[]const u8 {
+    const local = try std.fs.path.join(allocator, &.{ std.fs.path.dirname(includer) orelse ".", name });
+    if (exists(io, local)) return local;
+    for (include_dirs) |dir| {
+        const candidate = try std.fs.path.join(allocator, &.{ dir, name });
+        if (exists(io, candidate)) return candidate;
+    }
+    return null;
+}
+
+fn exists(io: std.Io, path: []const u8) bool {
+    std.Io.Dir.cwd().access(io, path, .{}) catch return false;
+    return true;
+}
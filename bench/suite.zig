@@ -0,0 +1,533 @@
+//! `zig build bench`: generates a synthetic project and CMake tree of the
+//! chosen size and times the parts of ovo that grow with them: parsing
+//! `build.zon`, resolving source globs, planning the target graph, the
+//! first and the null build, compile database emission, `import cmake` and
+//! every exporter. Builds run against `stub_compiler.zig`, which the build
+//! step puts first on PATH as `clang++` and `ar`, so they time ovo rather
+//! than a compiler.
+//!
+//! Results are written as JSON. With `--baseline`, a result slower than the
+//! baseline's by more than `--threshold` percent is reported as a
+//! regression and the run exits with status 1.
+//!
+//!   --preset small|medium|large   project size (default medium)
+//!   --targets N                   override the preset's target count
+//!   --sources N                   sources per target
+//!   --depth N                     headers in each target's include chain
+//!   --output FILE                 JSON results (default .zig-cache/ovo-bench/results.json)
+//!   --baseline FILE               compare against an earlier --output
+//!   --threshold PCT               allowed slowdown (default 10)
+//!   --no-build                    skip the build benchmarks
+
+const std = @import("std");
+const ovo = @import("ovo");
+const stub = @import("stub_compiler.zig");
+
+const Project = ovo.core_project.Project;
+const Target = ovo.core_project.Target;
+
+const Preset = struct {
+    name: []const u8,
+    targets: usize,
+    sources_per_target: usize,
+    include_depth: usize,
+};
+
+const presets = [_]Preset{
+    .{ .name = "small", .targets = 200, .sources_per_target = 16, .include_depth = 4 },
+    .{ .name = "medium", .targets = 1000, .sources_per_target = 20, .include_depth = 8 },
+    .{ .name = "large", .targets = 4000, .sources_per_target = 25, .include_depth = 12 },
+};
+
+/// Every tenth target is an executable; the rest are static libraries.
+const executable_every = 10;
+/// Targets per directory of the CMake tree, which nests groups under the root.
+const cmake_group_size = 50;
+
+const min_iterations = 5;
+const max_iterations = 1000;
+const min_total_ns = 500 * std.time.ns_per_ms;
+
+const work_dir = ".zig-cache/ovo-bench";
+const schema_version = 1;
+
+pub const Result = struct {
+    name: []const u8,
+    iterations: usize,
+    best_ns: u64,
+    median_ns: u64,
+};
+
+/// The JSON document `--output` writes and `--baseline` reads.
+pub const Report = struct {
+    version: u32 = schema_version,
+    preset: []const u8,
+    targets: usize,
+    sources: usize,
+    include_depth: usize,
+    results: []const Result,
+};
+
+const Options = struct {
+    preset: Preset = presets[1],
+    output: []const u8 = work_dir ++ "/results.json",
+    baseline: ?[]const u8 = null,
+    threshold_pct: f64 = 10,
+    build: bool = true,
+};
+
+pub fn main(init: std.process.Init) !void {
+    var arena_state = std.heap.ArenaAllocator.init(std.heap.page_allocator);
+    defer arena_state.deinit();
+    const arena = arena_state.allocator();
+    ovo.core_runtime.setIo(init.io);
+    ovo.core_runtime.setEnviron(init.environ_map);
+
+    var args = try init.minimal.args.iterateAllocator(arena);
+    _ = args.next();
+    const options = try parseOptions(&args);
+    const preset = options.preset;
+
+    const root = try ovo.core_fs.currentPathAlloc(arena);
+    const baseline: ?Report = if (options.baseline) |path| try loadReport(arena, path) else null;
+    if (baseline) |report| {
+        if (report.targets != preset.targets or report.sources != preset.targets * preset.sources_per_target or report.include_depth != preset.include_depth) {
+            std.debug.print("bench: baseline {s} was recorded for a different project size\n", .{options.baseline.?});
+            return error.BaselineSizeMismatch;
+        }
+    }
+
+    const base = try std.fmt.allocPrint(arena, "{s}/{s}/{s}-{d}x{d}", .{ root, work_dir, preset.name, preset.targets, preset.sources_per_target });
+    var suite = Suite{
+        .allocator = arena,
+        .io = init.io,
+        .preset = preset,
+        .project_dir = try std.fmt.allocPrint(arena, "{s}/project", .{base}),
+        .cmake_dir = try std.fmt.allocPrint(arena, "{s}/cmake", .{base}),
+    };
+    std.debug.print("bench: generating {d} targets, {d} sources, include depth {d}\n", .{
+        preset.targets,
+        preset.targets * preset.sources_per_target,
+        preset.include_depth,
+    });
+    try ovo.core_fs.removeTreeIfExists(base);
+    try suite.generate();
+
+    // Builds print progress; the timings are what matter here.
+    var sink_context: u8 = 0;
+    ovo.core_runtime.setOutputSink(.{ .context = &sink_context, .writeFn = discard });
+    defer ovo.core_runtime.setOutputSink(null);
+
+    try std.Io.Threaded.chdir(suite.project_dir);
+    try suite.measure("parse_build_zon", Suite.parseBuildZon);
+    try suite.measure("resolve_sources_cold", Suite.resolveSourcesCold);
+    try suite.measure("resolve_sources_warm", Suite.resolveSourcesWarm);
+    try suite.measure("plan_target_graph", Suite.planTargetGraph);
+    try suite.measure("emit_compile_commands", Suite.emitCompileCommands);
+    try suite.measure("import_cmake", Suite.importCMake);
+    inline for (comptime std.meta.tags(ovo.translate.exporter.ExportFormat)) |format| {
+        try suite.measure("export_" ++ @tagName(format), Suite.exporter(format));
+    }
+    if (options.build) {
+        if (suite.stubInstalled()) {
+            try suite.measureOnce("build_cold", Suite.buildCold);
+            try suite.measure("null_build", Suite.nullBuild);
+            try suite.measure("null_build_warm", Suite.nullBuildWarm);
+        } else {
+            std.debug.print("bench: build benchmarks skipped; clang++ on PATH is not the stub (run through `zig build bench`)\n", .{});
+        }
+    }
+    try std.Io.Threaded.chdir(root);
+
+    const report = Report{
+        .preset = preset.name,
+        .targets = preset.targets,
+        .sources = preset.targets * preset.sources_per_target,
+        .include_depth = preset.include_depth,
+        .results = suite.results.items,
+    };
+    try ovo.core_fs.writeFile(options.output, try renderReport(arena, report));
+    std.debug.print("bench: results written to {s}\n", .{options.output});
+
+    if (baseline) |previous| {
+        const regressions = compare(report, previous, options.threshold_pct);
+        if (regressions > 0) {
+            std.debug.print("bench: {d} regression(s) beyond {d:.0}% of {s}\n", .{ regressions, options.threshold_pct, options.baseline.? });
+            std.process.exit(1);
+        }
+    }
+}
+
+fn parseOptions(args: anytype) !Options {
+    var options = Options{};
+    var targets: ?usize = null;
+    var sources: ?usize = null;
+    var depth: ?usize = null;
+    while (args.next()) |arg| {
+        if (std.mem.eql(u8, arg, "--no-build")) {
+            options.build = false;
+            continue;
+        }
+        const value = args.next() orelse return error.MissingOptionValue;
+        if (std.mem.eql(u8, arg, "--preset")) {
+            options.preset = for (presets) |preset| {
+                if (std.mem.eql(u8, preset.name, value)) break preset;
+            } else return error.UnknownPreset;
+        } else if (std.mem.eql(u8, arg, "--targets")) {
+            targets = try std.fmt.parseInt(usize, value, 10);
+        } else if (std.mem.eql(u8, arg, "--sources")) {
+            sources = try std.fmt.parseInt(usize, value, 10);
+        } else if (std.mem.eql(u8, arg, "--depth")) {
+            depth = try std.fmt.parseInt(usize, value, 10);
+        } else if (std.mem.eql(u8, arg, "--output")) {
+            options.output = value;
+        } else if (std.mem.eql(u8, arg, "--baseline")) {
+            options.baseline = value;
+        } else if (std.mem.eql(u8, arg, "--threshold")) {
+            options.threshold_pct = try std.fmt.parseFloat(f64, value);
+        } else {
+            return error.UnknownOption;
+        }
+    }
+    if (targets) |count| options.preset.targets = @max(count, 1);
+    if (sources) |count| options.preset.sources_per_target = @max(count, 1);
+    if (depth) |count| options.preset.include_depth = @max(count, 1);
+    return options;
+}
+
+fn discard(context: *anyopaque, bytes: []const u8) void {
+    _ = context;
+    _ = bytes;
+}
+
+const Suite = struct {
+    allocator: std.mem.Allocator,
+    io: std.Io,
+    preset: Preset,
+    project_dir: []const u8,
+    cmake_dir: []const u8,
+    build_zon: []const u8 = "",
+    project: Project = undefined,
+    results: std.ArrayList(Result) = .empty,
+    /// Kept across iterations by the benchmarks that time reuse.
+    warm_index: ?ovo.build_glob.Index = null,
+    warm_workspace: ?*ovo.build_orchestrator.Workspace = null,
+    /// Compile argv of every source, for `emitCompileCommands`.
+    commands: std.ArrayList(Command) = .empty,
+
+    const Command = struct {
+        file: []const u8,
+        argv: []const []const u8,
+        object: []const u8,
+    };
+
+    /// Best and median of repeated runs, repeating until `min_total_ns`
+    /// has passed. Each run gets a fresh arena.
+    fn measure(self: *Suite, comptime name: []const u8, comptime run: anytype) !void {
+        var arena_state = std.heap.ArenaAllocator.init(std.heap.page_allocator);
+        defer arena_state.deinit();
+
+        var samples: std.ArrayList(u64) = .empty;
+        var total: u64 = 0;
+        while (samples.items.len < max_iterations and (samples.items.len < min_iterations or total < min_total_ns)) {
+            _ = arena_state.reset(.retain_capacity);
+            const start = std.Io.Timestamp.now(self.io, .awake).nanoseconds;
+            try run(self, arena_state.allocator());
+            const elapsed: u64 = @intCast(std.Io.Timestamp.now(self.io, .awake).nanoseconds - start);
+            try samples.append(self.allocator, elapsed);
+            total += elapsed;
+        }
+        try self.record(name, samples.items);
+    }
+
+    /// For what only happens once per tree, like the first build.
+    fn measureOnce(self: *Suite, comptime name: []const u8, comptime run: anytype) !void {
+        const start = std.Io.Timestamp.now(self.io, .awake).nanoseconds;
+        try run(self, self.allocator);
+        const elapsed: u64 = @intCast(std.Io.Timestamp.now(self.io, .awake).nanoseconds - start);
+        var samples = [_]u64{elapsed};
+        try self.record(name, &samples);
+    }
+
+    fn record(self: *Suite, name: []const u8, samples: []u64) !void {
+        std.mem.sort(u64, samples, {}, std.sort.asc(u64));
+        const result = Result{
+            .name = name,
+            .iterations = samples.len,
+            .best_ns = samples[0],
+            .median_ns = samples[samples.len / 2],
+        };
+        std.debug.print("{s:<28} {d:>12.3} ms  (median {d:.3} ms, {d} runs)\n", .{
+            name,
+            millis(result.best_ns),
+            millis(result.median_ns),
+            result.iterations,
+        });
+        try self.results.append(self.allocator, result);
+    }
+
+    fn parseBuildZon(self: *Suite, allocator: std.mem.Allocator) !void {
+        const project = try ovo.zon_parser.parseBuildZon(allocator, self.build_zon);
+        std.mem.doNotOptimizeAway(project.targets.len);
+    }
+
+    fn resolveSourcesCold(self: *Suite, allocator: std.mem.Allocator) !void {
+        var index = ovo.build_glob.Index.init(allocator, null);
+        defer index.deinit();
+        for (self.project.targets) |target| _ = try index.resolveSources(target.sources);
+    }
+
+    fn resolveSourcesWarm(self: *Suite, allocator: std.mem.Allocator) !void {
+        _ = allocator;
+        if (self.warm_index == null) self.warm_index = ovo.build_glob.Index.init(self.allocator, null);
+        const index = &self.warm_index.?;
+        index.beginRun();
+        for (self.project.targets) |target| _ = try index.resolveSources(target.sources);
+    }
+
+    fn planTargetGraph(self: *Suite, allocator: std.mem.Allocator) !void {
+        const graph = try ovo.build_target_graph.build(allocator, self.project.targets);
+        _ = try graph.needsPic(allocator);
+        const roots = try allocator.alloc(bool, self.project.targets.len);
+        @memset(roots, true);
+        _ = try graph.closure(allocator, roots);
+        for (self.project.targets, 0..) |target, i| {
+            if (target.kind == .executable) _ = try graph.linkPlan(allocator, i);
+        }
+    }
+
+    fn emitCompileCommands(self: *Suite, allocator: std.mem.Allocator) !void {
+        var out: std.ArrayList(u8) = .empty;
+        try out.appendSlice(allocator, "[\n");
+        for (self.commands.items, 0..) |command, i| {
+            try ovo.build_orchestrator.appendCommandEntry(allocator, &out, self.project_dir, command.file, command.argv, command.object, i == 0);
+        }
+        try out.appendSlice(allocator, "\n]\n");
+        std.mem.doNotOptimizeAway(out.items.len);
+    }
+
+    fn importCMake(self: *Suite, allocator: std.mem.Allocator) !void {
+        const project = try ovo.translate.importer.importIntoBuildZon(allocator, .cmake, self.cmake_dir);
+        if (project.targets.len != self.preset.targets) return error.ImportMissedTargets;
+    }
+
+    fn exporter(comptime format: ovo.translate.exporter.ExportFormat) fn (*Suite, std.mem.Allocator) anyerror!void {
+        return struct {
+            fn run(self: *Suite, allocator: std.mem.Allocator) anyerror!void {
+                const content = try ovo.translate.exporter.exportProject(allocator, self.project, format);
+                std.mem.doNotOptimizeAway(content.len);
+            }
+        }.run;
+    }
+
+    fn stubInstalled(self: *Suite) bool {
+        const probe = ovo.core_exec.runCaptured(self.allocator, &.{ "clang++", "--version" }) catch return false;
+        return probe.exit_code == 0 and std.mem.indexOf(u8, probe.output, stub.banner) != null;
+    }
+
+    /// Opened like `ovo build` opens it, minus the object cache, which would
+    /// time the cache instead of the build.
+    fn openWorkspace(allocator: std.mem.Allocator) !*ovo.build_orchestrator.Workspace {
+        const workspace = try ovo.build_orchestrator.Workspace.open(allocator, .{});
+        workspace.cache = null;
+        workspace.remote = null;
+        return workspace;
+    }
+
+    fn buildCold(self: *Suite, allocator: std.mem.Allocator) !void {
+        _ = self;
+        const workspace = try openWorkspace(allocator);
+        defer workspace.close();
+        _ = try workspace.build(allocator, .{});
+    }
+
+    fn nullBuild(self: *Suite, allocator: std.mem.Allocator) !void {
+        _ = self;
+        const workspace = try openWorkspace(allocator);
+        defer workspace.close();
+        const result = try workspace.build(allocator, .{});
+        for (result.artifacts) |artifact| {
+            if (!artifact.up_to_date) return error.NullBuildDidWork;
+        }
+    }
+
+    /// The daemon and watch mode keep the workspace open between builds.
+    fn nullBuildWarm(self: *Suite, allocator: std.mem.Allocator) !void {
+        if (self.warm_workspace == null) self.warm_workspace = try openWorkspace(self.allocator);
+        _ = try self.warm_workspace.?.build(allocator, .{});
+    }
+
+    /// Target `i` links its parent in a binary tree of libraries, so the
+    /// link graph is deep; each header chain ends in the parent's, so
+    /// include graphs are deeper.
+    fn generate(self: *Suite) !void {
+        const allocator = self.allocator;
+        const preset = self.preset;
+        try ovo.core_fs.ensureDir(self.project_dir);
+        try std.Io.Threaded.chdir(self.project_dir);
+
+        const targets = try allocator.alloc(Target, preset.targets);
+        var source: std.ArrayList(u8) = .empty;
+        for (targets, 0..) |*target, i| {
+            const name = try std.fmt.allocPrint(allocator, "module_{d}", .{i});
+            for (0..preset.include_depth) |depth| {
+                source.clearRetainingCapacity();
+                if (depth + 1 < preset.include_depth) {
+                    try source.print(allocator, "#include \"{s}/h_{d}.hpp\"\n", .{ name, depth + 1 });
+                } else if (parentOf(i)) |parent| {
+                    try source.print(allocator, "#include \"module_{d}/h_0.hpp\"\n", .{parent});
+                }
+                try source.print(allocator, "inline int {s}_h_{d}() {{ return {d}; }}\n", .{ name, depth, depth });
+                try ovo.core_fs.writeFile(try std.fmt.allocPrint(allocator, "include/{s}/h_{d}.hpp", .{ name, depth }), source.items);
+            }
+            for (0..preset.sources_per_target) |j| {
+                source.clearRetainingCapacity();
+                try source.print(allocator, "#include \"{s}/h_0.hpp\"\nint {s}_file_{d}() {{ return {s}_h_0(); }}\n", .{ name, name, j, name });
+                if (j == 0 and isExecutable(i)) try source.appendSlice(allocator, "int main() { return 0; }\n");
+                try ovo.core_fs.writeFile(try std.fmt.allocPrint(allocator, "src/{s}/file_{d}.cpp", .{ name, j }), source.items);
+            }
+            target.* = .{
+                .name = name,
+                .kind = if (isExecutable(i)) .executable else .library_static,
+                .sources = try allocator.dupe([]const u8, &.{try std.fmt.allocPrint(allocator, "src/{s}/*.cpp", .{name})}),
+                .include_dirs = &.{"include"},
+                .link_libraries = if (parentOf(i)) |parent| try allocator.dupe([]const u8, &.{try std.fmt.allocPrint(allocator, "module_{d}", .{parent})}) else &.{},
+            };
+        }
+
+        const project = Project{
+            .name = "bench",
+            .version = "1.0.0",
+            .license = "MIT",
+            .targets = targets,
+            .defaults = .{ .backend = "clang", .output_dir = "build", .linker = .default },
+        };
+        self.build_zon = try ovo.zon_writer.renderBuildZon(allocator, project);
+        try ovo.core_fs.writeFile("build.zon", self.build_zon);
+        self.project = try ovo.zon_parser.parseBuildZon(allocator, self.build_zon);
+
+        var index = ovo.build_glob.Index.init(allocator, null);
+        defer index.deinit();
+        for (self.project.targets) |target| {
+            var flags: std.ArrayList([]const u8) = .empty;
+            try ovo.build_orchestrator.appendCompilerPrefix(allocator, &flags, "clang");
+            try ovo.build_orchestrator.appendCommonCompileFlags(allocator, &flags, "Debug", project.defaults.cpp_standard, target.include_dirs, "clang");
+            for (try index.resolveSources(target.sources)) |file| {
+                const object = try std.fmt.allocPrint(allocator, "build/obj-{s}/{s}.o", .{ target.name, std.fs.path.stem(file) });
+                var argv: std.ArrayList([]const u8) = .empty;
+                try argv.appendSlice(allocator, flags.items);
+                try argv.appendSlice(allocator, &.{ "-c", file, "-o", object });
+                try self.commands.append(allocator, .{ .file = file, .argv = argv.items, .object = object });
+            }
+        }
+
+        try self.generateCMake();
+    }
+
+    fn generateCMake(self: *Suite) !void {
+        const allocator = self.allocator;
+        const preset = self.preset;
+        try ovo.core_fs.ensureDir(self.cmake_dir);
+        try std.Io.Threaded.chdir(self.cmake_dir);
+
+        var root: std.ArrayList(u8) = .empty;
+        try root.appendSlice(allocator, "cmake_minimum_required(VERSION 3.20)\nproject(Bench CXX)\ninclude(cmake/options)\n");
+        try ovo.core_fs.writeFile("cmake/options.cmake", "set(CMAKE_CXX_STANDARD 20)\nset(BENCH_INCLUDE include)\n");
+
+        var group: std.ArrayList(u8) = .empty;
+        var text: std.ArrayList(u8) = .empty;
+        const group_count = (preset.targets + cmake_group_size - 1) / cmake_group_size;
+        for (0..group_count) |g| {
+            try root.print(allocator, "add_subdirectory(group_{d})\n", .{g});
+            group.clearRetainingCapacity();
+            const first = g * cmake_group_size;
+            for (first..@min(first + cmake_group_size, preset.targets)) |i| {
+                try group.print(allocator, "add_subdirectory(module_{d})\n", .{i});
+                text.clearRetainingCapacity();
+                try text.appendSlice(allocator, "set(SOURCES");
+                for (0..preset.sources_per_target) |j| try text.print(allocator, " src/file_{d}.cpp", .{j});
+                try text.appendSlice(allocator, ")\n");
+                const kind = if (isExecutable(i)) "add_executable" else "add_library";
+                const static = if (isExecutable(i)) "" else " STATIC";
+                try text.print(allocator, "{s}(module_{d}{s} ${{SOURCES}})\n", .{ kind, i, static });
+                try text.print(allocator, "target_include_directories(module_{d} PUBLIC ${{CMAKE_CURRENT_SOURCE_DIR}}/${{BENCH_INCLUDE}})\n", .{i});
+                if (parentOf(i)) |parent| try text.print(allocator, "target_link_libraries(module_{d} PRIVATE module_{d})\n", .{ i, parent });
+                try ovo.core_fs.writeFile(try std.fmt.allocPrint(allocator, "group_{d}/module_{d}/CMakeLists.txt", .{ g, i }), text.items);
+            }
+            try ovo.core_fs.writeFile(try std.fmt.allocPrint(allocator, "group_{d}/CMakeLists.txt", .{g}), group.items);
+        }
+        try ovo.core_fs.writeFile("CMakeLists.txt", root.items);
+    }
+};
+
+fn isExecutable(i: usize) bool {
+    return i % executable_every == executable_every - 1;
+}
+
+/// The library target `i` links: its parent in a binary tree, skipping
+/// executables.
+fn parentOf(i: usize) ?usize {
+    if (i == 0) return null;
+    var parent = (i - 1) / 2;
+    while (isExecutable(parent)) parent -= 1;
+    return parent;
+}
+
+fn millis(ns: u64) f64 {
+    return @as(f64, @floatFromInt(ns)) / std.time.ns_per_ms;
+}
+
+fn renderReport(allocator: std.mem.Allocator, report: Report) ![]const u8 {
+    var out: std.ArrayList(u8) = .empty;
+    try out.print(allocator, "{{\n  \"version\": {d},\n  \"preset\": \"{s}\",\n  \"targets\": {d},\n  \"sources\": {d},\n  \"include_depth\": {d},\n  \"results\": [", .{
+        report.version,
+        report.preset,
+        report.targets,
+        report.sources,
+        report.include_depth,
+    });
+    for (report.results, 0..) |result, i| {
+        if (i > 0) try out.append(allocator, ',');
+        try out.print(allocator, "\n    {{\"name\": \"{s}\", \"iterations\": {d}, \"best_ns\": {d}, \"median_ns\": {d}}}", .{
+            result.name,
+            result.iterations,
+            result.best_ns,
+            result.median_ns,
+        });
+    }
+    try out.appendSlice(allocator, "\n  ]\n}\n");
+    return out.items;
+}
+
+fn loadReport(allocator: std.mem.Allocator, path: []const u8) !Report {
+    const bytes = try ovo.core_fs.readFileAlloc(allocator, path);
+    const report = try std.json.parseFromSliceLeaky(Report, allocator, bytes, .{ .ignore_unknown_fields = true });
+    if (report.version != schema_version) return error.UnsupportedBaselineVersion;
+    return report;
+}
+
+/// Compares best times, which vary least between runs. Benchmarks the
+/// baseline doesn't have are listed without a verdict.
+fn compare(current: Report, baseline: Report, threshold_pct: f64) usize {
+    var regressions: usize = 0;
+    std.debug.print("\n{s:<28} {s:>12} {s:>12} {s:>9}\n", .{ "benchmark", "baseline ms", "current ms", "change" });
+    for (current.results) |result| {
+        const previous = for (baseline.results) |entry| {
+            if (std.mem.eql(u8, entry.name, result.name)) break entry;
+        } else {
+            std.debug.print("{s:<28} {s:>12} {d:>12.3}\n", .{ result.name, "-", millis(result.best_ns) });
+            continue;
+        };
+        const change = (@as(f64, @floatFromInt(result.best_ns)) / @as(f64, @floatFromInt(@max(previous.best_ns, 1))) - 1) * 100;
+        const regressed = change > threshold_pct;
+        if (regressed) regressions += 1;
+        std.debug.print("{s:<28} {d:>12.3} {d:>12.3} {d:>8.1}%{s}\n", .{
+            result.name,
+            millis(previous.best_ns),
+            millis(result.best_ns),
+            change,
+            if (regressed) "  REGRESSION" else "",
+        });
+    }
+    return regressions;
+}
@@ -0,0 +1,97 @@
+//! Times `zon.parser.parseBuildZon` against the substring-scanning parser it
+//! replaced, on a synthetic build.zon. Run with `zig build bench-zon`; pass
+//! a target count to change the input size.
+
+const std = @import("std");
+const ovo = @import("ovo");
+const legacy = @import("legacy_zon_parser.zig");
+
+const default_targets = 2000;
+const sources_per_target = 16;
+const min_iterations = 5;
+const min_total_ns = 500 * std.time.ns_per_ms;
+
+pub fn main(init: std.process.Init) !void {
+    var arena_state = std.heap.ArenaAllocator.init(std.heap.page_allocator);
+    defer arena_state.deinit();
+    const arena = arena_state.allocator();
+
+    var args = try init.minimal.args.iterateAllocator(arena);
+    _ = args.next();
+    const target_count = if (args.next()) |arg| try std.fmt.parseInt(usize, arg, 10) else default_targets;
+
+    const source = try syntheticBuildZon(arena, target_count);
+    std.debug.print("input: {d} targets, {d} KiB\n", .{ target_count, source.len / 1024 });
+
+    const current = try measure(init.io, source, parseCurrent);
+    const baseline = try measure(init.io, source, parseLegacy);
+    report("zon.parser", source.len, current);
+    report("legacy", source.len, baseline);
+    std.debug.print("speedup: {d:.2}x\n", .{@as(f64, @floatFromInt(baseline)) / @as(f64, @floatFromInt(current))});
+}
+
+fn parseCurrent(allocator: std.mem.Allocator, source: []const u8) !usize {
+    const project = try ovo.zon_parser.parseBuildZon(allocator, source);
+    return project.targets.len;
+}
+
+fn parseLegacy(allocator: std.mem.Allocator, source: []const u8) !usize {
+    const project = try legacy.parseBuildZon(allocator, source);
+    return project.targets.len;
+}
+
+/// Best-of-N nanoseconds per parse, repeating until `min_total_ns` has passed.
+fn measure(
+    io: std.Io,
+    source: []const u8,
+    comptime parseFn: anytype,
+) !u64 {
+    var arena_state = std.heap.ArenaAllocator.init(std.heap.page_allocator);
+    defer arena_state.deinit();
+
+    var best: u64 = std.math.maxInt(u64);
+    var total: u64 = 0;
+    var iterations: usize = 0;
+    while (iterations < min_iterations or total < min_total_ns) : (iterations += 1) {
+        _ = arena_state.reset(.retain_capacity);
+        const start = std.Io.Timestamp.now(io, .awake).nanoseconds;
+        const targets = try parseFn(arena_state.allocator(), source);
+        const elapsed: u64 = @intCast(std.Io.Timestamp.now(io, .awake).nanoseconds - start);
+        std.mem.doNotOptimizeAway(targets);
+        best = @min(best, elapsed);
+        total += elapsed;
+    }
+    return best;
+}
+
+fn report(label: []const u8, bytes: usize, ns: u64) void {
+    const mib_per_s = @as(f64, @floatFromInt(bytes)) / (1024 * 1024) / (@as(f64, @floatFromInt(ns)) / std.time.ns_per_s);
+    std.debug.print("{s:<12} {d:>10.3} ms  {d:>8.1} MiB/s\n", .{
+        label,
+        @as(f64, @floatFromInt(ns)) / std.time.ns_per_ms,
+        mib_per_s,
+    });
+}
+
+fn syntheticBuildZon(allocator: std.mem.Allocator, target_count: usize) ![]const u8 {
+    var project = ovo.core_project.Project{
+        .name = "bench",
+        .version = "1.0.0",
+        .license = "MIT",
+    };
+    const targets = try allocator.alloc(ovo.core_project.Target, target_count);
+    for (targets, 0..) |*target, i| {
+        const sources = try allocator.alloc([]const u8, sources_per_target);
+        for (sources, 0..) |*source, j| source.* = try std.fmt.allocPrint(allocator, "src/module_{d}/file_{d}.cpp", .{ i, j });
+        target.* = .{
+            .name = try std.fmt.allocPrint(allocator, "module_{d}", .{i}),
+            .kind = if (i % 4 == 0) .executable else .library_static,
+            .sources = sources,
+            .include_dirs = &.{ "include", "third_party/include" },
+            .link_libraries = if (i > 0) &.{"module_0"} else &.{},
+        };
+    }
+    project.targets = targets;
+    project.dependencies = &.{ .{ .name = "fmt", .version = "10.2.1" }, .{ .name = "zlib" } };
+    return ovo.zon_writer.renderBuildZon(allocator, project);
+}
@@ -119,6 +119,63 @@ pub fn build(b: *std.Build) void {
         help_matrix.dependOn(&run_help.step);
     }
 
+    // Benchmarks always build ReleaseFast against their own copy of the module.
+    const bench_ovo_module = b.createModule(.{
+        .root_source_file = b.path("src/ovo.zig"),
+        .target = target,
+        .optimize = .ReleaseFast,
+    });
+    const zon_bench = b.addExecutable(.{
+        .name = "zon-parser-bench",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("bench/zon_parser_bench.zig"),
+            .target = target,
+            .optimize = .ReleaseFast,
+            .imports = &.{
+                .{ .name = "ovo", .module = bench_ovo_module },
+            },
+        }),
+    });
+    const run_zon_bench = b.addRunArtifact(zon_bench);
+    if (b.args) |args| run_zon_bench.addArgs(args);
+    const zon_bench_step = b.step("bench-zon", "Benchmark the build.zon parser against the legacy scanner");
+    zon_bench_step.dependOn(&run_zon_bench.step);
+
+    // The suite's builds find this as `clang++` and `ar` on PATH.
+    const stub_compiler = b.addExecutable(.{
+        .name = "ovo-bench-stub",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("bench/stub_compiler.zig"),
+            .target = target,
+            .optimize = .ReleaseFast,
+        }),
+    });
+    const stub_dir: std.Build.InstallDir = .{ .custom = "bench-bin" };
+    const suite = b.addExecutable(.{
+        .name = "ovo-bench",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("bench/suite.zig"),
+            .target = target,
+            .optimize = .ReleaseFast,
+            .imports = &.{
+                .{ .name = "ovo", .module = bench_ovo_module },
+            },
+        }),
+    });
+    const run_suite = b.addRunArtifact(suite);
+    run_suite.setCwd(b.path("."));
+    run_suite.addPathDir(b.getInstallPath(stub_dir, ""));
+    for ([_][]const u8{ "clang++", "ar" }) |name| {
+        const install_stub = b.addInstallArtifact(stub_compiler, .{
+            .dest_dir = .{ .override = stub_dir },
+            .dest_sub_path = name,
+        });
+        run_suite.step.dependOn(&install_stub.step);
+    }
+    if (b.args) |args| run_suite.addArgs(args);
+    const bench_step = b.step("bench", "Time parsing, globbing, planning, null builds, import and export on a synthetic project");
+    bench_step.dependOn(&run_suite.step);
+
     const test_all = b.step("test-all", "Run all verification steps");
     test_all.dependOn(check_step);
     test_all.dependOn(unit);
@@ -0,0 +1,335 @@
+const std = @import("std");
+const core = @import("../core/mod.zig");
+const project_mod = @import("../core/project.zig");
+const orchestrator = @import("orchestrator.zig");
+const glob = @import("glob.zig");
+const job_pool = @import("job_pool.zig");
+const manifest_mod = @import("manifest.zig");
+const toolchain = @import("../compiler/toolchain.zig");
+
+/// What `ovo fmt` and `ovo lint` run over the project's sources.
+pub const Tool = enum {
+    format,
+    tidy,
+
+    pub fn command(self: Tool) []const u8 {
+        return switch (self) {
+            .format => "clang-format",
+            .tidy => "clang-tidy",
+        };
+    }
+
+    /// Kept in the output directory, next to the build manifest.
+    fn stateName(self: Tool) []const u8 {
+        return switch (self) {
+            .format => "fmt.ovo",
+            .tidy => "lint.ovo",
+        };
+    }
+
+    /// Config files the tool looks for in a source's directory and its
+    /// parents.
+    fn configNames(self: Tool) []const []const u8 {
+        return switch (self) {
+            .format => &.{ ".clang-format", "_clang-format" },
+            .tidy => &.{".clang-tidy"},
+        };
+    }
+};
+
+/// Most files handed to one invocation; smaller batches when there are
+/// few files keep every job busy.
+pub const max_batch = 32;
+
+pub const Options = struct {
+    /// `--version` output of the tool, part of every clean key.
+    version: []const u8,
+    jobs: ?usize = null,
+    /// Only files git reports changed against HEAD, untracked ones
+    /// included; outside a git checkout every file is a candidate.
+    changed: bool = false,
+};
+
+pub const Report = struct {
+    /// Files handed to the tool.
+    checked: usize = 0,
+    /// Files skipped because they were clean at the same key last time.
+    clean: usize = 0,
+    /// Invocations that exited non-zero.
+    failed: usize = 0,
+};
+
+/// The tool's `--version` output, or null when it isn't installed. Comes
+/// from the toolchain cache while the binary is unchanged.
+pub fn toolVersion(allocator: std.mem.Allocator, tool: Tool) ?[]const u8 {
+    var tools = toolchain.Toolchain.init(allocator, toolchain.cache_path);
+    const probes = tools.probe(allocator, &.{.{ .argv = &.{tool.command()} }}) catch return null;
+    tools.save() catch {};
+    if (!probes[0].found) return null;
+    return probes[0].banner;
+}
+
+/// Files per invocation: spread evenly over `jobs`, at most `max_batch`.
+pub fn batchSize(files: usize, jobs: usize) usize {
+    return std.math.clamp(std.math.divCeil(usize, files, @max(jobs, 1)) catch 1, 1, max_batch);
+}
+
+/// Identifies one file's check: the tool, its config, the compile flags
+/// it parses the file with and the file's contents. A file is skipped
+/// while its key matches the last clean run.
+pub fn cleanKey(version: []const u8, config: u64, flags: u64, contents: []const u8) u64 {
+    var hasher = std.hash.Wyhash.init(0);
+    hasher.update(version);
+    hasher.update(&[_]u8{0});
+    hasher.update(std.mem.asBytes(&config));
+    hasher.update(std.mem.asBytes(&flags));
+    hasher.update(contents);
+    return hasher.final();
+}
+
+const state_header = "ovo-source-tool-state 1";
+
+/// Per file, the key it was last clean at. Keys borrow from the buffer
+/// handed to `parseState`.
+pub const State = struct {
+    clean: std.StringHashMapUnmanaged(u64) = .empty,
+
+    pub fn render(self: *const State, allocator: std.mem.Allocator) ![]u8 {
+        var out: std.ArrayList(u8) = .empty;
+        errdefer out.deinit(allocator);
+        try out.print(allocator, "{s}\n", .{state_header});
+        var entries = self.clean.iterator();
+        while (entries.next()) |entry| {
+            try out.print(allocator, "{s}\t{x:0>16}\n", .{ entry.key_ptr.*, entry.value_ptr.* });
+        }
+        return try out.toOwnedSlice(allocator);
+    }
+};
+
+/// An unknown header yields an empty state, so every file is checked again.
+pub fn parseState(allocator: std.mem.Allocator, bytes: []const u8) !State {
+    var state = State{};
+    var lines = std.mem.splitScalar(u8, bytes, '\n');
+    const first = lines.next() orelse return state;
+    if (!std.mem.eql(u8, std.mem.trimEnd(u8, first, "\r"), state_header)) return state;
+    while (lines.next()) |raw_line| {
+        const line = std.mem.trimEnd(u8, raw_line, "\r");
+        const tab = std.mem.lastIndexOfScalar(u8, line, '\t') orelse continue;
+        const key = std.fmt.parseInt(u64, line[tab + 1 ..], 16) catch continue;
+        try state.clean.put(allocator, line[0..tab], key);
+    }
+    return state;
+}
+
+const Item = struct {
+    path: []const u8,
+    target: usize,
+    flags_hash: u64,
+    key: u64,
+};
+
+/// Runs `tool` over every project source that isn't known clean, `max_batch`
+/// files at a time on up to `-j` processes. A failing batch doesn't stop
+/// the others; its output is printed and its files are checked again next
+/// time. clang-tidy reads each target's flags from a compile database in
+/// `<output_dir>/lint/<target>`: the entries `ovo build` wrote for it.
+pub fn run(allocator: std.mem.Allocator, project: project_mod.Project, tool: Tool, options: Options) !Report {
+    const state_path = try std.fmt.allocPrint(allocator, "{s}/{s}", .{ project.defaults.output_dir, tool.stateName() });
+    const state_bytes: []const u8 = core.fs.readFileAlloc(allocator, state_path) catch |err| switch (err) {
+        error.FileNotFound => "",
+        else => return err,
+    };
+    var state = try parseState(allocator, state_bytes);
+    const parts: []const []const u8 = if (tool == .tidy) try orchestrator.commandParts(allocator, project) else &.{};
+
+    var index = glob.Index.init(allocator, glob.default_path);
+    defer index.deinit();
+    defer index.save() catch {};
+    const changed = if (options.changed) try gitChanged(allocator) else null;
+
+    // A source listed by several targets is checked once, with the first
+    // target's flags.
+    const target_sources = try allocator.alloc([]const []const u8, project.targets.len);
+    const entries = try allocator.alloc([]const DatabaseEntry, project.targets.len);
+    var seen: std.StringHashMapUnmanaged(void) = .empty;
+    var configs = ConfigFinder{ .allocator = allocator, .names = tool.configNames() };
+    var pending: std.ArrayList(Item) = .empty;
+    var report = Report{};
+    for (project.targets, 0..) |target, i| {
+        target_sources[i] = try index.resolveSources(target.sources);
+        entries[i] = if (tool == .tidy) try databaseEntries(allocator, parts[i]) else &.{};
+        var compiles: std.StringHashMapUnmanaged([]const []const u8) = .empty;
+        for (entries[i]) |entry| try compiles.put(allocator, normalize(entry.file), entry.arguments);
+        for (target_sources[i]) |raw| {
+            const path = normalize(raw);
+            const flags_hash = manifest_mod.hashArgv(compiles.get(path) orelse &.{});
+            if ((try seen.getOrPut(allocator, path)).found_existing) continue;
+            if (changed) |set| if (!set.contains(path)) continue;
+            const contents = core.fs.readFileAlloc(allocator, path) catch "";
+            const key = cleanKey(options.version, try configs.digest(dirOf(path)), flags_hash, contents);
+            if (state.clean.get(path)) |previous| if (previous == key) {
+                report.clean += 1;
+                continue;
+            };
+            try pending.append(allocator, .{ .path = path, .target = i, .flags_hash = flags_hash, .key = key });
+        }
+    }
+    // Sources no longer in the project are forgotten.
+    if (!options.changed) {
+        var stale: std.ArrayList([]const u8) = .empty;
+        var clean_paths = state.clean.keyIterator();
+        while (clean_paths.next()) |path| if (!seen.contains(path.*)) try stale.append(allocator, path.*);
+        for (stale.items) |path| _ = state.clean.remove(path);
+    }
+    report.checked = pending.items.len;
+
+    const jobs = options.jobs orelse job_pool.defaultJobCount();
+    const size = batchSize(pending.items.len, jobs);
+    const databases = try allocator.alloc(?[]const u8, project.targets.len);
+    @memset(databases, null);
+    var batches: std.ArrayList([]const Item) = .empty;
+    var argvs: std.ArrayList([]const []const u8) = .empty;
+    var start: usize = 0;
+    while (start < pending.items.len) {
+        // A clang-tidy batch shares one target's database.
+        const target = pending.items[start].target;
+        var end = start + 1;
+        while (end < pending.items.len and end - start < size and
+            (tool == .format or pending.items[end].target == target)) end += 1;
+        const batch = pending.items[start..end];
+        var argv: std.ArrayList([]const u8) = .empty;
+        try argv.append(allocator, tool.command());
+        switch (tool) {
+            .format => try argv.append(allocator, "-i"),
+            .tidy => {
+                const dir = databases[target] orelse written: {
+                    const path = try std.fmt.allocPrint(allocator, "{s}/lint/{s}", .{ project.defaults.output_dir, project.targets[target].name });
+                    try writeDatabase(allocator, path, entries[target]);
+                    databases[target] = path;
+                    break :written path;
+                };
+                try argv.appendSlice(allocator, &.{ "-p", dir, "--quiet" });
+            },
+        }
+        for (batch) |item| try argv.append(allocator, item.path);
+        try batches.append(allocator, batch);
+        try argvs.append(allocator, argv.items);
+        start = end;
+    }
+
+    const pool_jobs = try allocator.alloc(job_pool.Job, batches.items.len);
+    for (pool_jobs, argvs.items) |*job, argv| {
+        job.* = .{ .label = tool.command(), .argv = argv, .may_fail = true };
+    }
+    _ = try job_pool.runAll(allocator, pool_jobs, jobs);
+    defer job_pool.freeOutputs(pool_jobs);
+
+    for (pool_jobs, batches.items) |job, batch| {
+        if (job.output.len > 0) core.runtime.printErr("{s}", .{job.output});
+        if (job.exit_code != 0) report.failed += 1;
+        for (batch) |item| {
+            const clean = job.exit_code == 0 and switch (tool) {
+                // A diagnostic names the file it's about.
+                .tidy => std.mem.indexOf(u8, job.output, try std.fmt.allocPrint(allocator, "{s}:", .{item.path})) == null,
+                .format => true,
+            };
+            if (!clean) {
+                _ = state.clean.remove(item.path);
+                continue;
+            }
+            // Formatting rewrote the file; it's clean at its new contents.
+            const key = if (tool == .format) rekey: {
+                const contents = core.fs.readFileAlloc(allocator, item.path) catch "";
+                break :rekey cleanKey(options.version, try configs.digest(dirOf(item.path)), item.flags_hash, contents);
+            } else item.key;
+            try state.clean.put(allocator, item.path, key);
+        }
+    }
+    try core.fs.writeFile(state_path, try state.render(allocator));
+    return report;
+}
+
+const DatabaseEntry = struct {
+    directory: []const u8,
+    file: []const u8,
+    arguments: []const []const u8,
+    output: []const u8,
+};
+
+/// `part`'s entries. zig's driver is two words, which a compile database
+/// can't name, so zigcc compiles are described as clang ones.
+fn databaseEntries(allocator: std.mem.Allocator, part: []const u8) ![]const DatabaseEntry {
+    if (part.len == 0) return &.{};
+    const bytes = try std.mem.concat(allocator, u8, &.{ "[", part, "]" });
+    const entries = try std.json.parseFromSliceLeaky([]DatabaseEntry, allocator, bytes, .{ .ignore_unknown_fields = true });
+    for (entries) |*entry| {
+        const argv = entry.arguments;
+        if (argv.len < 2 or !std.mem.eql(u8, argv[0], "zig") or !std.mem.eql(u8, argv[1], "c++")) continue;
+        entry.arguments = try std.mem.concat(allocator, []const u8, &.{ &.{"clang++"}, argv[2..] });
+    }
+    return entries;
+}
+
+/// Rewritten only when an entry changed, so clang-tidy's own caching of
+/// the database isn't defeated.
+fn writeDatabase(allocator: std.mem.Allocator, dir: []const u8, entries: []const DatabaseEntry) !void {
+    var out: std.ArrayList(u8) = .empty;
+    try out.appendSlice(allocator, "[\n");
+    for (entries, 0..) |entry, i| {
+        try orchestrator.appendCommandEntry(allocator, &out, entry.directory, entry.file, entry.arguments, entry.output, i == 0);
+    }
+    try out.appendSlice(allocator, if (entries.len == 0) "]\n" else "\n]\n");
+    try orchestrator.writeIfChanged(allocator, try std.fmt.allocPrint(allocator, "{s}/compile_commands.json", .{dir}), out.items);
+}
+
+/// Paths git reports modified, staged or untracked, relative to the
+/// current directory; null outside a git checkout or before its first
+/// commit.
+fn gitChanged(allocator: std.mem.Allocator) !?std.StringHashMapUnmanaged(void) {
+    var set: std.StringHashMapUnmanaged(void) = .empty;
+    const queries = [_][]const []const u8{
+        &.{ "git", "diff", "--name-only", "--relative", "HEAD" },
+        &.{ "git", "ls-files", "--others", "--exclude-standard" },
+    };
+    for (queries) |argv| {
+        const result = core.exec.runCapturedStdout(allocator, argv) catch return null;
+        if (result.exit_code != 0) return null;
+        var lines = std.mem.tokenizeAny(u8, result.stdout, "\r\n");
+        while (lines.next()) |line| try set.put(allocator, line, {});
+    }
+    return set;
+}
+
+fn normalize(path: []const u8) []const u8 {
+    var rest = path;
+    while (std.mem.startsWith(u8, rest, "./")) rest = rest[2..];
+    return rest;
+}
+
+fn dirOf(path: []const u8) []const u8 {
+    return std.fs.path.dirname(path) orelse "";
+}
+
+/// Digests of the config each directory's sources are checked with: the
+/// nearest config file in the directory or its parents, up to the project
+/// root. Zero when there is none.
+const ConfigFinder = struct {
+    allocator: std.mem.Allocator,
+    names: []const []const u8,
+    memo: std.StringHashMapUnmanaged(u64) = .empty,
+
+    fn digest(self: *ConfigFinder, dir: []const u8) !u64 {
+        if (self.memo.get(dir)) |value| return value;
+        var value: u64 = 0;
+        for (self.names) |name| {
+            const path = if (dir.len == 0) name else try std.fs.path.join(self.allocator, &.{ dir, name });
+            const bytes = core.fs.readFileAlloc(self.allocator, path) catch continue;
+            value = std.hash.Wyhash.hash(0, bytes);
+            break;
+        } else if (dir.len > 0) {
+            value = try self.digest(dirOf(dir));
+        }
+        try self.memo.put(self.allocator, dir, value);
+        return value;
+    }
+};
@@ -0,0 +1,249 @@
+const std = @import("std");
+const core = @import("../core/mod.zig");
+
+/// Stored next to the build manifest in the project's output directory.
+pub const file_name = "deps.ovodb";
+
+const magic = "OVODEP01";
+
+// Layout (all integers u32 little-endian):
+//   magic[8] object_count path_count edge_count strings_len
+//   objects: object_count * { path_index, first_edge, edge_count }  (sorted by path)
+//   paths:   path_count * { offset, len }                            (into strings)
+//   edges:   edge_count * path_index
+//   strings: strings_len bytes
+// Every path is stored once, and lookups binary-search the object table in
+// place, so loading is a single read with no per-edge allocation.
+const header_len = magic.len + 4 * 4;
+const object_entry_len = 3 * 4;
+const path_entry_len = 2 * 4;
+const edge_entry_len = 4;
+
+/// Header dependencies per object file. Entries recorded during this build
+/// shadow the loaded on-disk table until `save` merges both.
+pub const DepDb = struct {
+    bytes: []const u8 = "",
+    object_count: u32 = 0,
+    path_count: u32 = 0,
+    edge_count: u32 = 0,
+    updates: std.StringHashMapUnmanaged([]const []const u8) = .empty,
+    dirty: bool = false,
+
+    /// Best effort: a missing, unreadable or damaged database is empty, so
+    /// every object is compiled once to learn its headers again.
+    pub fn load(allocator: std.mem.Allocator, path: []const u8) DepDb {
+        const bytes = core.fs.readFileAllocUnlimited(allocator, path) catch return .{};
+        return fromBytes(bytes) catch .{};
+    }
+
+    /// Checks every table entry against the bounds of the table it indexes,
+    /// so lookups never read outside `bytes`.
+    pub fn fromBytes(bytes: []const u8) !DepDb {
+        if (bytes.len < header_len or !std.mem.eql(u8, bytes[0..magic.len], magic)) return error.InvalidDepDb;
+        const db = DepDb{
+            .bytes = bytes,
+            .object_count = readU32(bytes, magic.len),
+            .path_count = readU32(bytes, magic.len + 4),
+            .edge_count = readU32(bytes, magic.len + 8),
+        };
+        const strings_len = readU32(bytes, magic.len + 12);
+        const expected = @as(u64, header_len) +
+            @as(u64, db.object_count) * object_entry_len +
+            @as(u64, db.path_count) * path_entry_len +
+            @as(u64, db.edge_count) * edge_entry_len +
+            strings_len;
+        if (expected != bytes.len) return error.InvalidDepDb;
+
+        var index: u32 = 0;
+        while (index < db.object_count) : (index += 1) {
+            const entry = db.objectsOffset() + @as(usize, index) * object_entry_len;
+            if (readU32(bytes, entry) >= db.path_count) return error.InvalidDepDb;
+            const edge_end = @as(u64, readU32(bytes, entry + 4)) + readU32(bytes, entry + 8);
+            if (edge_end > db.edge_count) return error.InvalidDepDb;
+        }
+        index = 0;
+        while (index < db.path_count) : (index += 1) {
+            const entry = db.pathsOffset() + @as(usize, index) * path_entry_len;
+            const end = @as(u64, readU32(bytes, entry)) + readU32(bytes, entry + 4);
+            if (end > strings_len) return error.InvalidDepDb;
+        }
+        index = 0;
+        while (index < db.edge_count) : (index += 1) {
+            if (readU32(bytes, db.edgesOffset() + @as(usize, index) * edge_entry_len) >= db.path_count) return error.InvalidDepDb;
+        }
+        return db;
+    }
+
+    /// Appends the recorded dependencies of `object` to `out`. Returns false
+    /// when the object has never been compiled with dependency tracking.
+    pub fn collect(
+        self: *const DepDb,
+        allocator: std.mem.Allocator,
+        object: []const u8,
+        out: *std.ArrayList([]const u8),
+    ) !bool {
+        if (self.updates.get(object)) |deps| {
+            try out.appendSlice(allocator, deps);
+            return true;
+        }
+        const index = self.findObject(object) orelse return false;
+        const entry = self.objectsOffset() + @as(usize, index) * object_entry_len;
+        const first_edge: usize = readU32(self.bytes, entry + 4);
+        const count = readU32(self.bytes, entry + 8);
+        var edge: usize = 0;
+        while (edge < count) : (edge += 1) {
+            const path_index = readU32(self.bytes, self.edgesOffset() + (first_edge + edge) * edge_entry_len);
+            try out.append(allocator, self.pathAt(path_index));
+        }
+        return true;
+    }
+
+    pub fn record(self: *DepDb, allocator: std.mem.Allocator, object: []const u8, deps: []const []const u8) !void {
+        try self.updates.put(allocator, object, deps);
+        self.dirty = true;
+    }
+
+    pub fn save(self: *DepDb, allocator: std.mem.Allocator, path: []const u8) !void {
+        if (!self.dirty) return;
+        const rendered = try self.serialize(allocator);
+        defer allocator.free(rendered);
+        // Moved into place, so a build killed mid-save leaves the old table.
+        const file = try core.fs.AtomicFile.create(allocator, path);
+        file.writer().writeAll(rendered) catch |err| {
+            file.abort();
+            return err;
+        };
+        try file.finish();
+        self.dirty = false;
+    }
+
+    /// Merges loaded and updated entries into the binary on-disk layout.
+    pub fn serialize(self: *const DepDb, allocator: std.mem.Allocator) ![]u8 {
+        var arena_state = std.heap.ArenaAllocator.init(allocator);
+        defer arena_state.deinit();
+        const arena = arena_state.allocator();
+
+        var merged: std.StringHashMapUnmanaged([]const []const u8) = .empty;
+        var index: u32 = 0;
+        while (index < self.object_count) : (index += 1) {
+            const entry = self.objectsOffset() + @as(usize, index) * object_entry_len;
+            const object = self.pathAt(readU32(self.bytes, entry));
+            if (self.updates.contains(object)) continue;
+            var deps: std.ArrayList([]const u8) = .empty;
+            _ = try self.collect(arena, object, &deps);
+            try merged.put(arena, object, deps.items);
+        }
+        var updates = self.updates.iterator();
+        while (updates.next()) |entry| try merged.put(arena, entry.key_ptr.*, entry.value_ptr.*);
+
+        const objects = try arena.alloc([]const u8, merged.count());
+        var keys = merged.keyIterator();
+        var key_index: usize = 0;
+        while (keys.next()) |key| : (key_index += 1) objects[key_index] = key.*;
+        std.mem.sort([]const u8, objects, {}, lessThanPath);
+
+        var interned: std.StringHashMapUnmanaged(u32) = .empty;
+        var paths: std.ArrayList([]const u8) = .empty;
+        var object_table: std.ArrayList(u8) = .empty;
+        var edges: std.ArrayList(u8) = .empty;
+        var edge_count: u32 = 0;
+        for (objects) |object| {
+            const deps = merged.get(object).?;
+            try appendU32(arena, &object_table, try internPath(arena, &interned, &paths, object));
+            try appendU32(arena, &object_table, edge_count);
+            try appendU32(arena, &object_table, @intCast(deps.len));
+            for (deps) |dep| {
+                try appendU32(arena, &edges, try internPath(arena, &interned, &paths, dep));
+                edge_count += 1;
+            }
+        }
+
+        var path_table: std.ArrayList(u8) = .empty;
+        var strings: std.ArrayList(u8) = .empty;
+        for (paths.items) |item| {
+            try appendU32(arena, &path_table, @intCast(strings.items.len));
+            try appendU32(arena, &path_table, @intCast(item.len));
+            try strings.appendSlice(arena, item);
+        }
+
+        var out: std.ArrayList(u8) = .empty;
+        errdefer out.deinit(allocator);
+        try out.appendSlice(allocator, magic);
+        try appendU32(allocator, &out, @intCast(objects.len));
+        try appendU32(allocator, &out, @intCast(paths.items.len));
+        try appendU32(allocator, &out, edge_count);
+        try appendU32(allocator, &out, @intCast(strings.items.len));
+        try out.appendSlice(allocator, object_table.items);
+        try out.appendSlice(allocator, path_table.items);
+        try out.appendSlice(allocator, edges.items);
+        try out.appendSlice(allocator, strings.items);
+        return try out.toOwnedSlice(allocator);
+    }
+
+    fn findObject(self: *const DepDb, object: []const u8) ?u32 {
+        var low: u32 = 0;
+        var high: u32 = self.object_count;
+        while (low < high) {
+            const mid = low + (high - low) / 2;
+            const candidate = self.pathAt(readU32(self.bytes, self.objectsOffset() + @as(usize, mid) * object_entry_len));
+            switch (std.mem.order(u8, candidate, object)) {
+                .eq => return mid,
+                .lt => low = mid + 1,
+                .gt => high = mid,
+            }
+        }
+        return null;
+    }
+
+    fn pathAt(self: *const DepDb, index: u32) []const u8 {
+        const entry = self.pathsOffset() + @as(usize, index) * path_entry_len;
+        const offset = readU32(self.bytes, entry);
+        const len = readU32(self.bytes, entry + 4);
+        const start = self.stringsOffset() + offset;
+        return self.bytes[start .. start + len];
+    }
+
+    fn objectsOffset(_: *const DepDb) usize {
+        return header_len;
+    }
+
+    fn pathsOffset(self: *const DepDb) usize {
+        return self.objectsOffset() + @as(usize, self.object_count) * object_entry_len;
+    }
+
+    fn edgesOffset(self: *const DepDb) usize {
+        return self.pathsOffset() + @as(usize, self.path_count) * path_entry_len;
+    }
+
+    fn stringsOffset(self: *const DepDb) usize {
+        return self.edgesOffset() + @as(usize, self.edge_count) * edge_entry_len;
+    }
+};
+
+fn internPath(
+    allocator: std.mem.Allocator,
+    interned: *std.StringHashMapUnmanaged(u32),
+    paths: *std.ArrayList([]const u8),
+    path: []const u8,
+) !u32 {
+    const entry = try interned.getOrPut(allocator, path);
+    if (!entry.found_existing) {
+        entry.value_ptr.* = @intCast(paths.items.len);
+        try paths.append(allocator, path);
+    }
+    return entry.value_ptr.*;
+}
+
+fn lessThanPath(_: void, a: []const u8, b: []const u8) bool {
+    return std.mem.lessThan(u8, a, b);
+}
+
+fn readU32(bytes: []const u8, offset: usize) u32 {
+    return std.mem.readInt(u32, bytes[offset..][0..4], .little);
+}
+
+fn appendU32(allocator: std.mem.Allocator, out: *std.ArrayList(u8), value: u32) !void {
+    var buf: [4]u8 = undefined;
+    std.mem.writeInt(u32, &buf, value, .little);
+    try out.appendSlice(allocator, &buf);
+}
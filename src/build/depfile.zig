@@ -0,0 +1,121 @@
+const std = @import("std");
+
+pub const Format = enum {
+    /// Makefile rule written by `-MD -MF` (clang, gcc, zig cc).
+    make,
+    /// JSON written by MSVC `/sourceDependencies`.
+    msvc_json,
+};
+
+pub fn formatForBackend(backend: []const u8) Format {
+    return if (std.mem.eql(u8, backend, "msvc")) .msvc_json else .make;
+}
+
+/// Path the compiler writes dependency output to for `object`.
+pub fn pathForObject(allocator: std.mem.Allocator, object: []const u8, format: Format) ![]u8 {
+    return switch (format) {
+        .make => std.fmt.allocPrint(allocator, "{s}.d", .{object}),
+        .msvc_json => std.fmt.allocPrint(allocator, "{s}.json", .{object}),
+    };
+}
+
+pub fn appendFlags(
+    allocator: std.mem.Allocator,
+    argv: *std.ArrayList([]const u8),
+    depfile_path: []const u8,
+    format: Format,
+) !void {
+    switch (format) {
+        .make => {
+            try argv.append(allocator, "-MD");
+            try argv.append(allocator, "-MF");
+            try argv.append(allocator, depfile_path);
+        },
+        .msvc_json => {
+            try argv.append(allocator, "/sourceDependencies");
+            try argv.append(allocator, depfile_path);
+        },
+    }
+}
+
+pub fn parse(allocator: std.mem.Allocator, bytes: []const u8, format: Format) ![]const []const u8 {
+    return switch (format) {
+        .make => parseMake(allocator, bytes),
+        .msvc_json => parseMsvcJson(allocator, bytes),
+    };
+}
+
+/// Returns the prerequisites of the first rule in a Makefile-style depfile.
+/// Handles line continuations, `\ ` escaped spaces and `$$`; a drive-letter
+/// colon (`C:\...`) is not mistaken for the rule separator.
+pub fn parseMake(allocator: std.mem.Allocator, bytes: []const u8) ![]const []const u8 {
+    var deps: std.ArrayList([]const u8) = .empty;
+    errdefer deps.deinit(allocator);
+
+    var i: usize = 0;
+    while (i < bytes.len) : (i += 1) {
+        if (bytes[i] != ':') continue;
+        if (i + 1 >= bytes.len or isSeparator(bytes[i + 1])) break;
+    } else return try deps.toOwnedSlice(allocator);
+    i += 1;
+
+    var token: std.ArrayList(u8) = .empty;
+    defer token.deinit(allocator);
+    while (i < bytes.len) {
+        const c = bytes[i];
+        if (c == '\\' and i + 1 < bytes.len) {
+            const next = bytes[i + 1];
+            if (next == '\n' or (next == '\r' and i + 2 < bytes.len and bytes[i + 2] == '\n')) {
+                try flushToken(allocator, &token, &deps);
+                i += if (next == '\r') 3 else 2;
+                continue;
+            }
+            if (next == ' ' or next == '#' or next == '\\') {
+                try token.append(allocator, next);
+                i += 2;
+                continue;
+            }
+        }
+        if (c == '$' and i + 1 < bytes.len and bytes[i + 1] == '$') {
+            try token.append(allocator, '$');
+            i += 2;
+            continue;
+        }
+        if (c == '\n') {
+            // End of the first rule; later rules (e.g. -MP phony targets) add nothing new.
+            break;
+        }
+        if (isSeparator(c)) {
+            try flushToken(allocator, &token, &deps);
+            i += 1;
+            continue;
+        }
+        try token.append(allocator, c);
+        i += 1;
+    }
+    try flushToken(allocator, &token, &deps);
+    return try deps.toOwnedSlice(allocator);
+}
+
+fn flushToken(allocator: std.mem.Allocator, token: *std.ArrayList(u8), deps: *std.ArrayList([]const u8)) !void {
+    if (token.items.len == 0) return;
+    try deps.append(allocator, try allocator.dupe(u8, token.items));
+    token.clearRetainingCapacity();
+}
+
+fn isSeparator(c: u8) bool {
+    return c == ' ' or c == '\t' or c == '\r' or c == '\n';
+}
+
+const MsvcSourceDependencies = struct {
+    Data: struct {
+        Includes: []const []const u8 = &.{},
+    },
+};
+
+pub fn parseMsvcJson(allocator: std.mem.Allocator, bytes: []const u8) ![]const []const u8 {
+    const parsed = try std.json.parseFromSliceLeaky(MsvcSourceDependencies, allocator, bytes, .{
+        .ignore_unknown_fields = true,
+    });
+    return parsed.Data.Includes;
+}
@@ -0,0 +1,705 @@
+const std = @import("std");
+const core = @import("../core/mod.zig");
+const job_pool = @import("job_pool.zig");
+const toolchain = @import("../compiler/toolchain.zig");
+
+/// Where `ovo worker` listens unless told otherwise.
+pub const default_port: u16 = 3633;
+
+/// Compiles a host takes at once when `OVO_WORKERS` doesn't say.
+pub const default_slots = 4;
+
+/// Seconds a remote compile may take before it runs locally instead.
+pub const default_timeout_s = 120;
+
+/// How long a worker that failed or refused a job is left alone.
+const backoff_ns = 30 * std.time.ns_per_s;
+
+/// Bumped whenever a frame changes meaning.
+pub const protocol_version = "1";
+
+/// Preprocessed translation units can be large, but not this large.
+const max_frame_len = 256 * 1024 * 1024;
+
+/// Where a worker keeps the sources and objects of the jobs it runs.
+const worker_dir = ".ovo/worker";
+
+/// One `host[:port][/slots]` entry of `OVO_WORKERS`.
+pub const Host = struct {
+    name: []const u8,
+    port: u16 = default_port,
+    slots: usize = default_slots,
+};
+
+/// Entries are separated by commas or whitespace; IPv6 addresses with a
+/// port are written in brackets, `[::1]:3633`.
+pub fn parseHosts(allocator: std.mem.Allocator, spec: []const u8) ![]const Host {
+    var hosts: std.ArrayList(Host) = .empty;
+    var entries = std.mem.tokenizeAny(u8, spec, ", \t\r\n");
+    while (entries.next()) |entry| {
+        var host = Host{ .name = entry };
+        if (std.mem.lastIndexOfScalar(u8, host.name, '/')) |slash| {
+            host.slots = std.fmt.parseInt(usize, host.name[slash + 1 ..], 10) catch return error.InvalidWorkerHost;
+            if (host.slots == 0) return error.InvalidWorkerHost;
+            host.name = host.name[0..slash];
+        }
+        if (std.mem.startsWith(u8, host.name, "[")) {
+            const close = std.mem.indexOfScalar(u8, host.name, ']') orelse return error.InvalidWorkerHost;
+            const rest = host.name[close + 1 ..];
+            if (rest.len > 0) {
+                if (rest[0] != ':') return error.InvalidWorkerHost;
+                host.port = std.fmt.parseInt(u16, rest[1..], 10) catch return error.InvalidWorkerHost;
+            }
+            host.name = host.name[1..close];
+        } else if (std.mem.count(u8, host.name, ":") == 1) {
+            const colon = std.mem.indexOfScalar(u8, host.name, ':').?;
+            host.port = std.fmt.parseInt(u16, host.name[colon + 1 ..], 10) catch return error.InvalidWorkerHost;
+            host.name = host.name[0..colon];
+        }
+        if (host.name.len == 0) return error.InvalidWorkerHost;
+        try hosts.append(allocator, host);
+    }
+    return hosts.items;
+}
+
+/// What travels between a build and a worker. A job is one `compile` and
+/// one `source` frame; the worker answers with `output`, `object` and
+/// `exit`, or with `refused` when it won't run the job.
+pub const Frame = union(enum) {
+    /// Protocol version, compiler, its banner digest, then the flags.
+    compile: []const []const u8,
+    /// The translation unit, preprocessed on the client.
+    source: []const u8,
+    /// What the compiler printed.
+    output: []const u8,
+    object: []const u8,
+    exit: u8,
+    /// Busy, a different compiler, or a flag the worker doesn't run.
+    refused: []const u8,
+
+    fn tag(self: Frame) u8 {
+        return switch (self) {
+            .compile => 'c',
+            .source => 's',
+            .output => 'o',
+            .object => 'b',
+            .exit => 'x',
+            .refused => 'n',
+        };
+    }
+};
+
+/// Framed like the daemon's protocol: one tag byte, a little-endian u32
+/// payload length, the payload. Argument lists are NUL-terminated strings.
+pub fn writeFrame(writer: *std.Io.Writer, frame: Frame) !void {
+    try writer.writeByte(frame.tag());
+    switch (frame) {
+        .compile => |argv| {
+            var len: usize = 0;
+            for (argv) |arg| len += arg.len + 1;
+            try writer.writeInt(u32, @intCast(len), .little);
+            for (argv) |arg| {
+                try writer.writeAll(arg);
+                try writer.writeByte(0);
+            }
+        },
+        .source, .output, .object, .refused => |bytes| {
+            try writer.writeInt(u32, @intCast(bytes.len), .little);
+            try writer.writeAll(bytes);
+        },
+        .exit => |code| {
+            try writer.writeInt(u32, 1, .little);
+            try writer.writeByte(code);
+        },
+    }
+}
+
+pub fn readFrame(reader: *std.Io.Reader, allocator: std.mem.Allocator) !Frame {
+    const tag = try reader.takeByte();
+    const len = try reader.takeInt(u32, .little);
+    if (len > max_frame_len) return error.InvalidWorkerFrame;
+    const payload = try reader.readAlloc(allocator, len);
+    return switch (tag) {
+        'c' => .{ .compile = try splitArgv(allocator, payload) },
+        's' => .{ .source = payload },
+        'o' => .{ .output = payload },
+        'b' => .{ .object = payload },
+        'x' => if (len == 1) .{ .exit = payload[0] } else error.InvalidWorkerFrame,
+        'n' => .{ .refused = payload },
+        else => error.InvalidWorkerFrame,
+    };
+}
+
+fn splitArgv(allocator: std.mem.Allocator, payload: []const u8) ![]const []const u8 {
+    if (payload.len > 0 and payload[payload.len - 1] != 0) return error.InvalidWorkerFrame;
+    var argv: std.ArrayList([]const u8) = .empty;
+    var rest = payload;
+    while (std.mem.indexOfScalar(u8, rest, 0)) |end| {
+        try argv.append(allocator, rest[0..end]);
+        rest = rest[end + 1 ..];
+    }
+    return argv.items;
+}
+
+/// Identifies a compiler build on both ends, so a worker never compiles
+/// with a different version than the client would have.
+pub fn bannerDigest(allocator: std.mem.Allocator, banner: []const u8) ![]const u8 {
+    return std.fmt.allocPrint(allocator, "{x:0>16}", .{std.hash.Wyhash.hash(0, banner)});
+}
+
+/// The local compile `argv` with its trailing `-c <source> -o <object>`
+/// turned into `-E <source> -o <output>`. Its depfile flags stay, so the
+/// headers are recorded exactly as for a local compile.
+pub fn preprocessArgv(allocator: std.mem.Allocator, argv: []const []const u8, output: []const u8) ![]const []const u8 {
+    const common = argv[0 .. argv.len - 4];
+    return std.mem.concat(allocator, []const u8, &.{ common, &.{ "-E", argv[argv.len - 3], "-o", output } });
+}
+
+/// The flags a worker compiles the preprocessed source with: those of
+/// `argv` after its `prefix_len` compiler words, minus what preprocessing
+/// already applied or what only makes sense here (include paths, macros,
+/// depfiles, the source and the object). Null when `argv` doesn't end in
+/// `-c <source> -o <object>`.
+pub fn remoteFlags(allocator: std.mem.Allocator, argv: []const []const u8, prefix_len: usize) !?[]const []const u8 {
+    if (argv.len < prefix_len + 4) return null;
+    const tail = argv[argv.len - 4 ..];
+    if (!std.mem.eql(u8, tail[0], "-c") or !std.mem.eql(u8, tail[2], "-o")) return null;
+    var flags: std.ArrayList([]const u8) = .empty;
+    var i: usize = prefix_len;
+    while (i < argv.len - 4) : (i += 1) {
+        const arg = argv[i];
+        if (std.mem.eql(u8, arg, "-MF") or std.mem.eql(u8, arg, "-isystem") or std.mem.eql(u8, arg, "-include")) {
+            i += 1;
+            continue;
+        }
+        if (std.mem.eql(u8, arg, "-MD")) continue;
+        if (std.mem.startsWith(u8, arg, "-I") or std.mem.startsWith(u8, arg, "-D") or std.mem.startsWith(u8, arg, "-U")) continue;
+        try flags.append(allocator, arg);
+    }
+    return flags.items;
+}
+
+/// `-f<name>` and `-fno-<name>` switches a worker compiles with.
+const allowed_switches = [_][]const u8{
+    "PIC",                        "PIE",                     "pic",                        "pie",
+    "exceptions",                 "cxx-exceptions",          "rtti",                       "strict-aliasing",
+    "omit-frame-pointer",         "function-sections",       "data-sections",              "common",
+    "stack-protector",            "stack-protector-strong",  "stack-protector-all",        "stack-clash-protection",
+    "inline-functions",           "unroll-loops",            "fast-math",                  "finite-math-only",
+    "math-errno",                 "trapping-math",           "signed-char",                "unsigned-char",
+    "char8_t",                    "coroutines",              "threadsafe-statics",         "sized-deallocation",
+    "aligned-new",                "builtin",                 "wrapv",                      "trapv",
+    "semantic-interposition",     "plt",                     "delete-null-pointer-checks", "strict-overflow",
+    "permissive",                 "ms-extensions",           "gnu-keywords",               "operator-names",
+    "elide-constructors",         "vectorize",               "slp-vectorize",              "tree-vectorize",
+    "asynchronous-unwind-tables", "unwind-tables",           "merge-all-constants",        "visibility-inlines-hidden",
+    "lto",                        "openmp",                  "color-diagnostics",          "diagnostics-color",
+    "diagnostics-show-option",    "show-column",             "caret-diagnostics",          "ident",
+    "asm",                        "zero-initialized-in-bss", "short-enums",                "split-lto-unit",
+};
+
+/// `-f<name>=<value>` options a worker compiles with; values that look like
+/// paths are refused anyway.
+const allowed_options = [_][]const u8{
+    "lto",                    "visibility",          "sanitize",              "no-sanitize",
+    "sanitize-recover",       "no-sanitize-recover", "template-depth",        "constexpr-depth",
+    "constexpr-steps",        "diagnostics-color",   "cf-protection",         "trivial-auto-var-init",
+    "max-errors",             "message-length",      "debug-default-version", "ms-compatibility-version",
+    "stack-clash-protection", "tls-model",           "fp-model",              "fp-contract",
+};
+
+/// What may follow `-g`: `-gen-reproducer` and friends write files, and so
+/// does a plain `-gsplit-dwarf`, a `.dwo` the worker would never send back.
+/// `=single` keeps the split debug info inside the object.
+const allowed_debug = [_][]const u8{ "", "0", "1", "2", "3", "gdb", "dwarf", "dwarf-4", "dwarf-5", "split-dwarf=single", "gnu-pubnames", "line-tables-only", "column-info", "no-column-info" };
+
+/// Whether a worker compiles with `flag`. This is an allowlist, so a client
+/// can't make a worker load code or read or write files of its choosing:
+/// only language, optimization, debug-info, target and warning options
+/// pass, none of them with a path for a value and none taking the next
+/// argument as one.
+pub fn allowedFlag(flag: []const u8) bool {
+    if (!std.mem.startsWith(u8, flag, "-")) return false;
+    if (std.mem.indexOfAny(u8, flag, "/\\") != null) return false;
+    for ([_][]const u8{ "-pthread", "-pedantic", "-pedantic-errors", "-w" }) |exact| {
+        if (std.mem.eql(u8, flag, exact)) return true;
+    }
+    for ([_][]const u8{ "-std=", "-stdlib=", "--target=", "-O" }) |prefix| {
+        if (std.mem.startsWith(u8, flag, prefix)) return wordChars(flag[prefix.len..]);
+    }
+    if (std.mem.startsWith(u8, flag, "-g")) {
+        for (allowed_debug) |debug| {
+            if (std.mem.eql(u8, flag[2..], debug)) return true;
+        }
+        return false;
+    }
+    // `-mllvm`, alone or joined to its value, passes options on to LLVM,
+    // which can load plugins, and `-module-dependency-dir` names a
+    // directory to write to.
+    if (std.mem.startsWith(u8, flag, "-m")) {
+        return !std.mem.startsWith(u8, flag, "-mllvm") and !std.mem.startsWith(u8, flag, "-module") and wordChars(flag[2..]);
+    }
+    // No commas: `-Wa,`, `-Wl,` and `-Wp,` hand arguments to other tools.
+    if (std.mem.startsWith(u8, flag, "-W")) return flag.len > 2 and wordChars(flag[2..]) and std.mem.indexOfScalar(u8, flag, ',') == null;
+    if (std.mem.startsWith(u8, flag, "-f")) return allowedFeature(flag[2..]);
+    return false;
+}
+
+fn allowedFeature(feature: []const u8) bool {
+    if (std.mem.indexOfScalar(u8, feature, '=')) |eq| {
+        const value = feature[eq + 1 ..];
+        if (value.len == 0 or !wordChars(value)) return false;
+        for (allowed_options) |name| {
+            if (std.mem.eql(u8, feature[0..eq], name)) return true;
+        }
+        return false;
+    }
+    const name = if (std.mem.startsWith(u8, feature, "no-")) feature[3..] else feature;
+    for (allowed_switches) |allowed| {
+        if (std.mem.eql(u8, name, allowed)) return true;
+    }
+    return false;
+}
+
+/// Letters, digits and `-_.,=+` only: no paths, no response files.
+fn wordChars(text: []const u8) bool {
+    for (text) |c| {
+        if (!std.ascii.isAlphanumeric(c) and std.mem.indexOfScalar(u8, "-_.,=+", c) == null) return false;
+    }
+    return true;
+}
+
+/// The build's side: hands compiles to the hosts of `OVO_WORKERS`, up to
+/// each host's slot count, and falls back to compiling locally whenever a
+/// worker is full, unreachable, refuses the job, fails it or takes longer
+/// than `timeout_ns`. Shared by the pool's workers.
+pub const Client = struct {
+    hosts: []HostState,
+    timeout_ns: i128,
+    mutex: std.Thread.Mutex = .{},
+    /// Remote compiles in progress, for the watchdog.
+    flights: std.ArrayList(*Flight) = .empty,
+    watchdog: ?std.Thread = null,
+    stopping: bool = false,
+
+    const HostState = struct {
+        host: Host,
+        in_use: std.atomic.Value(usize) = .init(0),
+        /// Until when the host is skipped after a failure.
+        down_until_ns: std.atomic.Value(i64) = .init(0),
+
+        fn markDown(self: *HostState) void {
+            self.down_until_ns.store(@intCast(core.runtime.nowNs() + backoff_ns), .release);
+        }
+    };
+
+    const Flight = struct {
+        stream: std.Io.net.Stream,
+        deadline_ns: i128,
+    };
+
+    /// Null when `OVO_WORKERS` is unset or empty.
+    pub fn fromEnv(allocator: std.mem.Allocator) !?Client {
+        const spec = core.runtime.getEnv("OVO_WORKERS") orelse return null;
+        const hosts = try parseHosts(allocator, spec);
+        if (hosts.len == 0) return null;
+        const states = try allocator.alloc(HostState, hosts.len);
+        for (states, hosts) |*state, host| state.* = .{ .host = host };
+        var timeout_s: u64 = default_timeout_s;
+        if (core.runtime.getEnv("OVO_WORKER_TIMEOUT")) |value| {
+            timeout_s = std.fmt.parseInt(u64, value, 10) catch return error.InvalidWorkerTimeout;
+        }
+        return .{ .hosts = states, .timeout_ns = @as(i128, timeout_s) * std.time.ns_per_s };
+    }
+
+    pub fn deinit(self: *Client) void {
+        self.mutex.lock();
+        self.stopping = true;
+        const watchdog = self.watchdog;
+        self.mutex.unlock();
+        if (watchdog) |thread| thread.join();
+        self.flights.deinit(job_pool.output_allocator);
+    }
+
+    /// Remote compiles that can run at once, on top of the local jobs.
+    pub fn slots(self: *const Client) usize {
+        var total: usize = 0;
+        for (self.hosts) |state| total += state.host.slots;
+        return total;
+    }
+
+    /// A remote compile of the local compile `argv`, built with `compiler`
+    /// into `object`; null when `argv` can't be run remotely.
+    pub fn task(
+        self: *Client,
+        allocator: std.mem.Allocator,
+        argv: []const []const u8,
+        compiler: toolchain.Probe,
+        object: []const u8,
+    ) !?*job_pool.Offload {
+        const prefix_len = std.mem.count(u8, compiler.name, " ") + 1;
+        const flags = try remoteFlags(allocator, argv, prefix_len) orelse return null;
+        // A worker would refuse it, and be skipped for a while after.
+        for (flags) |flag| {
+            if (!allowedFlag(flag)) return null;
+        }
+        const preprocessed = try std.fmt.allocPrint(allocator, "{s}.ii", .{object});
+        const header = [_][]const u8{ protocol_version, compiler.name, try bannerDigest(allocator, compiler.banner) };
+        const created = try allocator.create(Task);
+        created.* = .{
+            .client = self,
+            .preprocess_argv = try preprocessArgv(allocator, argv, preprocessed),
+            .request = try std.mem.concat(allocator, []const u8, &.{ &header, flags }),
+            .preprocessed = preprocessed,
+            .object = object,
+        };
+        return &created.offload;
+    }
+
+    fn acquire(self: *Client) ?*HostState {
+        const now = core.runtime.nowNs();
+        for (self.hosts) |*state| {
+            if (state.down_until_ns.load(.acquire) > now) continue;
+            var used = state.in_use.load(.monotonic);
+            while (used < state.host.slots) {
+                used = state.in_use.cmpxchgWeak(used, used + 1, .acquire, .monotonic) orelse return state;
+            }
+        }
+        return null;
+    }
+
+    fn release(_: *Client, state: *HostState) void {
+        _ = state.in_use.fetchSub(1, .release);
+    }
+
+    /// Sends one job and waits for its result; null when the worker refused it.
+    fn exchange(self: *Client, allocator: std.mem.Allocator, state: *HostState, request: []const []const u8, source: []const u8) !?Result {
+        const io = core.runtime.io();
+        // Connecting counts against the timeout too: a host that drops SYNs
+        // would otherwise hold the slot for the kernel's connect timeout.
+        const deadline_ns = core.runtime.nowNs() + self.timeout_ns;
+        const stream = try connect(state.host, deadline_ns);
+        defer stream.close(io);
+        var flight = Flight{ .stream = stream, .deadline_ns = deadline_ns };
+        try self.track(&flight);
+        defer self.untrack(&flight);
+
+        var write_buffer: [64 * 1024]u8 = undefined;
+        var writer = stream.writer(io, &write_buffer);
+        try writeFrame(&writer.interface, .{ .compile = request });
+        try writeFrame(&writer.interface, .{ .source = source });
+        try writer.interface.flush();
+
+        var read_buffer: [64 * 1024]u8 = undefined;
+        var reader = stream.reader(io, &read_buffer);
+        var result = Result{};
+        while (true) {
+            switch (try readFrame(&reader.interface, allocator)) {
+                .output => |bytes| result.output = bytes,
+                .object => |bytes| result.object = bytes,
+                .exit => |code| {
+                    result.exit_code = code;
+                    return result;
+                },
+                .refused => return null,
+                .compile, .source => return error.InvalidWorkerFrame,
+            }
+        }
+    }
+
+    fn track(self: *Client, flight: *Flight) !void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        try self.flights.append(job_pool.output_allocator, flight);
+        if (self.watchdog == null) self.watchdog = try std.Thread.spawn(.{}, watch, .{self});
+    }
+
+    fn untrack(self: *Client, flight: *Flight) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        for (self.flights.items, 0..) |tracked, i| {
+            if (tracked == flight) {
+                _ = self.flights.swapRemove(i);
+                return;
+            }
+        }
+    }
+
+    /// Shuts down connections past their deadline, which fails the blocked
+    /// read and sends the job back to the local pool.
+    fn watch(self: *Client) void {
+        while (true) {
+            {
+                self.mutex.lock();
+                defer self.mutex.unlock();
+                if (self.stopping) return;
+                const now = core.runtime.nowNs();
+                for (self.flights.items) |flight| {
+                    if (flight.deadline_ns <= now) flight.stream.shutdown(core.runtime.io(), .both) catch {};
+                }
+            }
+            core.runtime.sleepMs(100) catch {};
+        }
+    }
+};
+
+/// Connects to `host` on a thread of its own, so the caller can stop
+/// waiting at `deadline_ns`; a connect that finishes after that is closed.
+fn connect(host: Host, deadline_ns: i128) !std.Io.net.Stream {
+    const allocator = job_pool.output_allocator;
+    const pending = try allocator.create(PendingConnect);
+    pending.* = .{ .name = allocator.dupe(u8, host.name) catch |err| {
+        allocator.destroy(pending);
+        return err;
+    }, .port = host.port };
+    const thread = std.Thread.spawn(.{}, PendingConnect.run, .{pending}) catch |err| {
+        pending.destroy();
+        return err;
+    };
+    thread.detach();
+    defer pending.release();
+
+    pending.mutex.lock();
+    defer pending.mutex.unlock();
+    while (!pending.finished) {
+        const now = core.runtime.nowNs();
+        if (now >= deadline_ns) {
+            pending.abandoned = true;
+            return error.WorkerConnectTimeout;
+        }
+        pending.done.timedWait(&pending.mutex, @intCast(deadline_ns - now)) catch {};
+    }
+    return pending.result;
+}
+
+/// Shared by `connect` and its thread; the last one done with it frees it.
+const PendingConnect = struct {
+    name: []const u8,
+    port: u16,
+    mutex: std.Thread.Mutex = .{},
+    done: std.Thread.Condition = .{},
+    finished: bool = false,
+    /// Set when `connect` gave up waiting; the thread closes what it got.
+    abandoned: bool = false,
+    result: anyerror!std.Io.net.Stream = error.WorkerConnectTimeout,
+    refs: std.atomic.Value(u8) = .init(2),
+
+    fn run(self: *PendingConnect) void {
+        defer self.release();
+        const io = core.runtime.io();
+        const result = connected: {
+            const host_name = std.Io.net.HostName.init(self.name) catch |err| break :connected err;
+            break :connected host_name.connect(io, self.port, .{ .mode = .stream });
+        };
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        if (self.abandoned) {
+            if (result) |stream| stream.close(io) else |_| {}
+            return;
+        }
+        self.result = result;
+        self.finished = true;
+        self.done.signal();
+    }
+
+    fn release(self: *PendingConnect) void {
+        if (self.refs.fetchSub(1, .acq_rel) == 1) self.destroy();
+    }
+
+    fn destroy(self: *PendingConnect) void {
+        job_pool.output_allocator.free(self.name);
+        job_pool.output_allocator.destroy(self);
+    }
+};
+
+const Result = struct {
+    exit_code: u8 = 1,
+    output: []const u8 = "",
+    object: []const u8 = "",
+};
+
+/// One compile job's remote side, reached from its `job_pool.Job` through
+/// `offload`.
+const Task = struct {
+    offload: job_pool.Offload = .{ .runFn = run },
+    client: *Client,
+    preprocess_argv: []const []const u8,
+    request: []const []const u8,
+    /// Where the preprocessed source is written, next to the object.
+    preprocessed: []const u8,
+    object: []const u8,
+
+    fn run(offload: *job_pool.Offload, job: *job_pool.Job, local: ?*job_pool.Slots) bool {
+        const self: *Task = @fieldParentPtr("offload", offload);
+        const state = self.client.acquire() orelse return false;
+        defer self.client.release(state);
+        var arena = std.heap.ArenaAllocator.init(core.memory.page_allocator);
+        defer arena.deinit();
+        return self.compile(arena.allocator(), state, job, local) catch {
+            state.markDown();
+            return false;
+        };
+    }
+
+    /// False sends the job back to run locally. A source that fails to
+    /// preprocess or compile is compiled again locally too, so its
+    /// diagnostics always come from this machine's compiler.
+    fn compile(self: *Task, allocator: std.mem.Allocator, state: *Client.HostState, job: *job_pool.Job, local: ?*job_pool.Slots) !bool {
+        const preprocessed = preprocessed: {
+            if (local) |slots| slots.acquire(0);
+            defer if (local) |slots| slots.release(0);
+            break :preprocessed try core.exec.runCaptured(allocator, self.preprocess_argv);
+        };
+        defer core.fs.deleteFileIfExists(self.preprocessed) catch {};
+        if (preprocessed.exit_code != 0) return false;
+        const source = try core.fs.readFileAllocUnlimited(allocator, self.preprocessed);
+
+        const result = try self.client.exchange(allocator, state, self.request, source) orelse {
+            state.markDown();
+            return false;
+        };
+        if (result.exit_code != 0) return false;
+        try core.fs.writeFile(self.object, result.object);
+        job.exit_code = 0;
+        job.output = if (result.output.len > 0) try job_pool.output_allocator.dupe(u8, result.output) else "";
+        return true;
+    }
+};
+
+pub const WorkerOptions = struct {
+    /// `host:port` to listen on.
+    listen: []const u8,
+    /// Compiles run at once; further connections are refused.
+    jobs: usize,
+};
+
+/// `ovo worker`: compiles preprocessed sources for builds on other
+/// machines until killed. Only compilers this machine has, at the version
+/// the client asks for, are run, and flags that load code or touch files
+/// outside the job are refused; workers still belong on a trusted network,
+/// as anyone who can reach one can make it run its compiler.
+pub fn serve(allocator: std.mem.Allocator, options: WorkerOptions) !void {
+    const io = core.runtime.io();
+    const colon = std.mem.lastIndexOfScalar(u8, options.listen, ':') orelse return error.InvalidWorkerAddress;
+    const port = std.fmt.parseInt(u16, options.listen[colon + 1 ..], 10) catch return error.InvalidWorkerAddress;
+    const host = std.mem.trim(u8, options.listen[0..colon], "[]");
+    const address = std.Io.net.IpAddress.parse(host, port) catch return error.InvalidWorkerAddress;
+
+    var worker = Worker{ .jobs = options.jobs };
+    try worker.probeCompilers(allocator);
+    try core.fs.ensureDir(worker_dir);
+    var server = try address.listen(io, .{ .reuse_address = true });
+    defer server.deinit(io);
+
+    core.runtime.printErr("worker: listening on {s}, {d} job(s)\n", .{ options.listen, options.jobs });
+    for (worker.compilers.keys(), worker.compilers.values()) |name, digest| {
+        core.runtime.printErr("worker: {s} ({s})\n", .{ name, digest });
+    }
+    while (true) {
+        const stream = server.accept(io) catch |err| {
+            core.runtime.printErr("warning: worker: accept failed: {s}\n", .{@errorName(err)});
+            continue;
+        };
+        if (worker.active.fetchAdd(1, .acquire) >= worker.jobs) {
+            _ = worker.active.fetchSub(1, .release);
+            refuse(stream, "busy");
+            continue;
+        }
+        const thread = std.Thread.spawn(.{}, Worker.handle, .{ &worker, stream }) catch {
+            _ = worker.active.fetchSub(1, .release);
+            refuse(stream, "busy");
+            continue;
+        };
+        thread.detach();
+    }
+}
+
+fn refuse(stream: std.Io.net.Stream, reason: []const u8) void {
+    const io = core.runtime.io();
+    defer stream.close(io);
+    var buffer: [256]u8 = undefined;
+    var writer = stream.writer(io, &buffer);
+    writeFrame(&writer.interface, .{ .refused = reason }) catch return;
+    writer.interface.flush() catch {};
+}
+
+/// Why a worker with `compilers` (banner digests by name) won't run a
+/// `compile` request; null when it will.
+pub fn refusal(compilers: *const std.StringArrayHashMapUnmanaged([]const u8), request: []const []const u8) ?[]const u8 {
+    if (request.len < 3 or !std.mem.eql(u8, request[0], protocol_version)) return "protocol version mismatch";
+    const digest = compilers.get(request[1]) orelse return "compiler not installed";
+    if (!std.mem.eql(u8, digest, request[2])) return "compiler version differs";
+    for (request[3..]) |flag| {
+        if (!allowedFlag(flag)) return "flag not allowed";
+    }
+    return null;
+}
+
+const Worker = struct {
+    jobs: usize,
+    active: std.atomic.Value(usize) = .init(0),
+    next_id: std.atomic.Value(u64) = .init(0),
+    /// Banner digest of every compiler found here, by name (`clang++`,
+    /// `g++`, `zig c++`); read-only once serving.
+    compilers: std.StringArrayHashMapUnmanaged([]const u8) = .empty,
+
+    fn probeCompilers(self: *Worker, allocator: std.mem.Allocator) !void {
+        var tools = toolchain.Toolchain.init(allocator, toolchain.cache_path);
+        const specs = [_]toolchain.Spec{ toolchain.compilerSpec(.clang), toolchain.compilerSpec(.gcc), toolchain.compilerSpec(.zigcc) };
+        const probes = try tools.probe(allocator, &specs);
+        tools.save() catch {};
+        for (probes) |compiler| {
+            if (compiler.found) try self.compilers.put(allocator, compiler.name, try bannerDigest(allocator, compiler.banner));
+        }
+        if (self.compilers.count() == 0) return error.NoCompilers;
+    }
+
+    fn handle(self: *Worker, stream: std.Io.net.Stream) void {
+        defer _ = self.active.fetchSub(1, .release);
+        const io = core.runtime.io();
+        defer stream.close(io);
+        var arena = std.heap.ArenaAllocator.init(core.memory.page_allocator);
+        defer arena.deinit();
+
+        var write_buffer: [64 * 1024]u8 = undefined;
+        var writer = stream.writer(io, &write_buffer);
+        self.run(arena.allocator(), stream, &writer.interface) catch |err| {
+            core.runtime.printErr("warning: worker: job failed: {s}\n", .{@errorName(err)});
+            return;
+        };
+        writer.interface.flush() catch {};
+    }
+
+    fn run(self: *Worker, allocator: std.mem.Allocator, stream: std.Io.net.Stream, writer: *std.Io.Writer) !void {
+        var read_buffer: [64 * 1024]u8 = undefined;
+        var reader = stream.reader(core.runtime.io(), &read_buffer);
+        const request = switch (try readFrame(&reader.interface, allocator)) {
+            .compile => |argv| argv,
+            else => return error.InvalidWorkerFrame,
+        };
+        const source = switch (try readFrame(&reader.interface, allocator)) {
+            .source => |bytes| bytes,
+            else => return error.InvalidWorkerFrame,
+        };
+        if (refusal(&self.compilers, request)) |reason| return writeFrame(writer, .{ .refused = reason });
+        const flags = request[3..];
+
+        const id = self.next_id.fetchAdd(1, .monotonic);
+        const input = try std.fmt.allocPrint(allocator, "{s}/job-{d}.ii", .{ worker_dir, id });
+        const output = try std.fmt.allocPrint(allocator, "{s}/job-{d}.o", .{ worker_dir, id });
+        defer core.fs.deleteFileIfExists(input) catch {};
+        defer core.fs.deleteFileIfExists(output) catch {};
+        try core.fs.writeFile(input, source);
+
+        var argv: std.ArrayList([]const u8) = .empty;
+        var words = std.mem.tokenizeScalar(u8, request[1], ' ');
+        while (words.next()) |word| try argv.append(allocator, word);
+        try argv.appendSlice(allocator, flags);
+        try argv.appendSlice(allocator, &.{ "-x", "c++-cpp-output", "-c", input, "-o", output });
+        const compiled = try core.exec.runCaptured(allocator, argv.items);
+
+        if (compiled.output.len > 0) try writeFrame(writer, .{ .output = compiled.output });
+        if (compiled.exit_code == 0) try writeFrame(writer, .{ .object = try core.fs.readFileAllocUnlimited(allocator, output) });
+        try writeFrame(writer, .{ .exit = compiled.exit_code });
+    }
+};
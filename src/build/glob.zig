@@ -0,0 +1,647 @@
+const std = @import("std");
+const core = @import("../core/mod.zig");
+
+/// Persisted directory listings, shared by every command run in the project.
+pub const default_path = ".ovo/glob.index";
+
+const header = "ovo-glob-index 1";
+
+/// Directories listed in one parallel batch before threads are worth spawning.
+const parallel_threshold = 8;
+const max_threads = 16;
+
+/// Contents of one directory as of `mtime_ns`; names are sorted.
+pub const Listing = struct {
+    mtime_ns: i128,
+    files: []const []const u8,
+    dirs: []const []const u8,
+};
+
+/// True when `value` contains glob syntax and must be expanded.
+pub fn isPattern(value: []const u8) bool {
+    return std.mem.indexOfAny(u8, value, "*?[{") != null;
+}
+
+/// Expands `{a,b}` alternatives (nested or repeated) into plain patterns.
+/// Unbalanced braces are kept literally.
+pub fn expandBraces(allocator: std.mem.Allocator, pattern: []const u8) ![]const []const u8 {
+    var out: std.ArrayList([]const u8) = .empty;
+    try appendBraceExpansions(allocator, &out, pattern);
+    return try out.toOwnedSlice(allocator);
+}
+
+fn appendBraceExpansions(allocator: std.mem.Allocator, out: *std.ArrayList([]const u8), pattern: []const u8) !void {
+    const open = std.mem.indexOfScalar(u8, pattern, '{') orelse return out.append(allocator, pattern);
+    var depth: usize = 0;
+    var alt_start = open + 1;
+    var alternatives: std.ArrayList([]const u8) = .empty;
+    defer alternatives.deinit(allocator);
+    const close = for (pattern[open..], open..) |c, i| {
+        switch (c) {
+            '{' => depth += 1,
+            '}' => {
+                depth -= 1;
+                if (depth == 0) break i;
+            },
+            ',' => if (depth == 1) {
+                try alternatives.append(allocator, pattern[alt_start..i]);
+                alt_start = i + 1;
+            },
+            else => {},
+        }
+    } else return out.append(allocator, pattern);
+    try alternatives.append(allocator, pattern[alt_start..close]);
+
+    for (alternatives.items) |alternative| {
+        const joined = try std.mem.concat(allocator, u8, &.{ pattern[0..open], alternative, pattern[close + 1 ..] });
+        try appendBraceExpansions(allocator, out, joined);
+    }
+}
+
+/// Matches one path component against `*`, `?` and `[...]` (with `!` or
+/// `^` negation and `a-z` ranges). Wildcards never match a leading `.`
+/// unless the pattern starts with one.
+pub fn matchSegment(pattern: []const u8, name: []const u8) bool {
+    if (name.len > 0 and name[0] == '.' and (pattern.len == 0 or pattern[0] != '.')) return false;
+    var p: usize = 0;
+    var n: usize = 0;
+    // Backtracking point for the most recent `*`.
+    var star_p: ?usize = null;
+    var star_n: usize = 0;
+    while (n < name.len) {
+        if (p < pattern.len) {
+            switch (pattern[p]) {
+                '*' => {
+                    star_p = p;
+                    star_n = n;
+                    p += 1;
+                    continue;
+                },
+                '?' => {
+                    p += 1;
+                    n += 1;
+                    continue;
+                },
+                '[' => if (matchClass(pattern[p..], name[n])) |len| {
+                    p += len;
+                    n += 1;
+                    continue;
+                },
+                else => |c| if (c == name[n]) {
+                    p += 1;
+                    n += 1;
+                    continue;
+                },
+            }
+        }
+        const star = star_p orelse return false;
+        p = star + 1;
+        star_n += 1;
+        n = star_n;
+    }
+    while (p < pattern.len and pattern[p] == '*') p += 1;
+    return p == pattern.len;
+}
+
+/// Length of the `[...]` class at the start of `pattern` when it matches
+/// `c`, or null when it doesn't (an unterminated `[` matches only itself).
+fn matchClass(pattern: []const u8, c: u8) ?usize {
+    var i: usize = 1;
+    const negate = i < pattern.len and (pattern[i] == '!' or pattern[i] == '^');
+    if (negate) i += 1;
+    var matched = false;
+    var first = true;
+    while (i < pattern.len and (first or pattern[i] != ']')) : (first = false) {
+        if (i + 2 < pattern.len and pattern[i + 1] == '-' and pattern[i + 2] != ']') {
+            if (c >= pattern[i] and c <= pattern[i + 2]) matched = true;
+            i += 3;
+        } else {
+            if (c == pattern[i]) matched = true;
+            i += 1;
+        }
+    }
+    if (i >= pattern.len) return if (c == '[') 1 else null;
+    return if (matched != negate) i + 1 else null;
+}
+
+/// Matches a whole `/`-separated path; `**` spans any number of components.
+/// `pattern` must already be brace-expanded.
+pub fn matchPath(pattern: []const u8, path: []const u8) bool {
+    var pattern_segments = std.mem.splitScalar(u8, pattern, '/');
+    var path_segments = std.mem.splitScalar(u8, path, '/');
+    return matchSegments(&pattern_segments, &path_segments);
+}
+
+fn matchSegments(pattern: *std.mem.SplitIterator(u8, .scalar), path: *std.mem.SplitIterator(u8, .scalar)) bool {
+    while (pattern.next()) |segment| {
+        if (std.mem.eql(u8, segment, "**")) {
+            // Try every split point: `**` as zero, one, two... components.
+            while (true) {
+                var pattern_rest = pattern.*;
+                var path_rest = path.*;
+                if (matchSegments(&pattern_rest, &path_rest)) return true;
+                const skipped = path.next() orelse return false;
+                if (skipped.len > 0 and skipped[0] == '.') return false;
+            }
+        }
+        const name = path.next() orelse return false;
+        if (!matchSegment(segment, name)) return false;
+    }
+    return path.next() == null;
+}
+
+/// Expands source patterns against a per-project cache of directory
+/// listings. A listing is reused while its directory's mtime is unchanged
+/// (adding, removing or renaming an entry bumps it), so a warm expansion
+/// stats directories instead of reading them; each directory is checked at
+/// most once per run, and each pattern is expanded at most once. An index
+/// kept across runs (`beginRun`) reuses an expansion while none of the
+/// directories it visited changed. All results are owned by `allocator`.
+pub const Index = struct {
+    allocator: std.mem.Allocator,
+    /// Where listings persist between runs; null keeps them in memory only.
+    path: ?[]const u8,
+    loaded: bool = false,
+    dirty: bool = false,
+    listings: std.StringHashMapUnmanaged(Listing) = .empty,
+    /// Directories already checked against the filesystem during this run.
+    verified: std.StringHashMapUnmanaged(void) = .empty,
+    /// Directories found added, removed or modified during this run.
+    changed: std.StringHashMapUnmanaged(void) = .empty,
+    expansions: std.StringHashMapUnmanaged(Expansion) = .empty,
+    run: u32 = 0,
+    /// One per listing thread, kept until `deinit` because listings point into them.
+    arenas: []std.heap.ArenaAllocator = &.{},
+
+    const Expansion = struct {
+        files: []const []const u8,
+        /// Every directory the walk listed, so a later run can revalidate it.
+        dirs: []const []const u8,
+        /// Run the expansion was last known current in.
+        run: u32,
+        /// False when a brace alternative was a plain path, whose existence
+        /// no listing tracks.
+        reusable: bool,
+    };
+
+    /// Nothing is read until the first pattern needs the filesystem.
+    pub fn init(allocator: std.mem.Allocator, path: ?[]const u8) Index {
+        return .{ .allocator = allocator, .path = path };
+    }
+
+    pub fn deinit(self: *Index) void {
+        for (self.arenas) |*arena| arena.deinit();
+        self.allocator.free(self.arenas);
+        self.arenas = &.{};
+    }
+
+    /// Starts a new run: directories are checked against the filesystem
+    /// again, and expansions are revalidated before they are reused.
+    pub fn beginRun(self: *Index) void {
+        self.verified.clearRetainingCapacity();
+        self.changed.clearRetainingCapacity();
+        self.run += 1;
+    }
+
+    /// Directories checked during this run, as filesystem paths.
+    pub fn visitedDirs(self: *const Index) std.StringHashMapUnmanaged(void).KeyIterator {
+        return self.verified.keyIterator();
+    }
+
+    pub fn save(self: *Index) !void {
+        const path = self.path orelse return;
+        if (!self.dirty) return;
+        const rendered = try renderListings(self.allocator, self.listings);
+        defer self.allocator.free(rendered);
+        try core.fs.writeFile(path, rendered);
+        self.dirty = false;
+    }
+
+    /// Files named by a target's `.sources`: plain paths are kept as-is,
+    /// patterns are expanded and sorted, duplicates are dropped, and any
+    /// file matching a `!pattern` entry is excluded. Directories a `!dir/**`
+    /// entry covers are never listed.
+    pub fn resolveSources(self: *Index, patterns: []const []const u8) ![]const []const u8 {
+        var files: std.ArrayList([]const u8) = .empty;
+        var seen: std.StringHashMapUnmanaged(void) = .empty;
+        defer seen.deinit(self.allocator);
+        var excludes: std.ArrayList([]const u8) = .empty;
+        defer excludes.deinit(self.allocator);
+
+        for (patterns) |pattern| {
+            if (pattern.len > 0 and pattern[0] == '!') {
+                try excludes.appendSlice(self.allocator, try expandBraces(self.allocator, pattern[1..]));
+            }
+        }
+        for (patterns) |pattern| {
+            if (pattern.len > 0 and pattern[0] == '!') continue;
+            for (try self.expandExcluding(pattern, excludes.items)) |file| {
+                const entry = try seen.getOrPut(self.allocator, file);
+                if (!entry.found_existing) try files.append(self.allocator, file);
+            }
+        }
+
+        if (excludes.items.len == 0) return try files.toOwnedSlice(self.allocator);
+        var kept: usize = 0;
+        for (files.items) |file| {
+            for (excludes.items) |exclude| {
+                if (matchPath(exclude, file)) break;
+            } else {
+                files.items[kept] = file;
+                kept += 1;
+            }
+        }
+        files.shrinkRetainingCapacity(kept);
+        return try files.toOwnedSlice(self.allocator);
+    }
+
+    /// Files matching one pattern, memoized for the life of the index.
+    pub fn expand(self: *Index, pattern: []const u8) ![]const []const u8 {
+        return self.expandExcluding(pattern, &.{});
+    }
+
+    /// `expand`, without descending into the directories `excludes` (brace
+    /// expanded) cover entirely; files are not filtered otherwise.
+    fn expandExcluding(self: *Index, pattern: []const u8, excludes: []const []const u8) ![]const []const u8 {
+        if (!isPattern(pattern)) {
+            const single = try self.allocator.alloc([]const u8, 1);
+            single[0] = pattern;
+            return single;
+        }
+        // What a walk prunes depends on the exclusions, so they are part of the key.
+        var key = pattern;
+        if (excludes.len > 0) {
+            var parts: std.ArrayList([]const u8) = .empty;
+            defer parts.deinit(self.allocator);
+            try parts.append(self.allocator, pattern);
+            try parts.appendSlice(self.allocator, excludes);
+            key = try std.mem.join(self.allocator, "\x00!", parts.items);
+        }
+        if (self.expansions.getKey(key)) |existing| {
+            if (key.ptr != pattern.ptr) self.allocator.free(key);
+            key = existing;
+        }
+        if (self.expansions.getPtr(key)) |cached| {
+            if (cached.run == self.run) return cached.files;
+            if (cached.reusable and !try self.anyChanged(cached.dirs)) {
+                cached.run = self.run;
+                return cached.files;
+            }
+        }
+
+        var files: std.ArrayList([]const u8) = .empty;
+        var dirs: std.ArrayList([]const u8) = .empty;
+        var reusable = true;
+        for (try expandBraces(self.allocator, pattern)) |alternative| {
+            if (!try self.walk(alternative, excludes, &files, &dirs)) reusable = false;
+        }
+        std.mem.sort([]const u8, files.items, {}, lessThanPath);
+        // Brace alternatives can overlap; after sorting duplicates are adjacent.
+        var unique: usize = 0;
+        for (files.items) |file| {
+            if (unique > 0 and std.mem.eql(u8, files.items[unique - 1], file)) continue;
+            files.items[unique] = file;
+            unique += 1;
+        }
+        files.shrinkRetainingCapacity(unique);
+
+        const result = try files.toOwnedSlice(self.allocator);
+        try self.expansions.put(self.allocator, key, .{
+            .files = result,
+            .dirs = try dirs.toOwnedSlice(self.allocator),
+            .run = self.run,
+            .reusable = reusable,
+        });
+        return result;
+    }
+
+    fn anyChanged(self: *Index, dirs: []const []const u8) !bool {
+        try self.refresh(dirs);
+        for (dirs) |dir| {
+            if (self.changed.contains(dir)) return true;
+        }
+        return false;
+    }
+
+    const WalkState = struct {
+        /// Directory as it appears in results: "" for the working directory.
+        dir: []const u8,
+        segment: usize,
+    };
+
+    /// Breadth-first over the directories the pattern can reach: a literal
+    /// or wildcard component only descends into matching subdirectories,
+    /// and each level's listings are fetched as one parallel batch. Appends
+    /// the directories it listed to `dirs`; returns false when the pattern
+    /// was a plain path and no directory was listed.
+    fn walk(
+        self: *Index,
+        pattern: []const u8,
+        excludes: []const []const u8,
+        files: *std.ArrayList([]const u8),
+        dirs: *std.ArrayList([]const u8),
+    ) !bool {
+        var segments: std.ArrayList([]const u8) = .empty;
+        defer segments.deinit(self.allocator);
+        var it = std.mem.splitScalar(u8, pattern, '/');
+        while (it.next()) |segment| try segments.append(self.allocator, segment);
+
+        // The literal prefix is opened directly instead of being matched.
+        var first_glob: usize = 0;
+        while (first_glob < segments.items.len and !isPattern(segments.items[first_glob])) first_glob += 1;
+        if (first_glob == segments.items.len) {
+            if (core.fs.fileExists(pattern)) try files.append(self.allocator, pattern);
+            return false;
+        }
+        var base: []const u8 = if (first_glob == 0) "" else try std.mem.join(self.allocator, "/", segments.items[0..first_glob]);
+        if (first_glob > 0 and base.len == 0) base = "/";
+        if (coveredDir(excludes, base)) return true;
+
+        var frontier: std.ArrayList(WalkState) = .empty;
+        defer frontier.deinit(self.allocator);
+        try frontier.append(self.allocator, .{ .dir = base, .segment = first_glob });
+        var next: std.ArrayList(WalkState) = .empty;
+        defer next.deinit(self.allocator);
+
+        while (frontier.items.len > 0) {
+            const level_start = dirs.items.len;
+            for (frontier.items) |state| try dirs.append(self.allocator, fsPath(state.dir));
+            try self.refresh(dirs.items[level_start..]);
+            next.clearRetainingCapacity();
+            for (frontier.items) |state| {
+                try self.step(segments.items, excludes, state, files, &next);
+            }
+            std.mem.swap(std.ArrayList(WalkState), &frontier, &next);
+        }
+        return true;
+    }
+
+    fn step(
+        self: *Index,
+        segments: []const []const u8,
+        excludes: []const []const u8,
+        state: WalkState,
+        files: *std.ArrayList([]const u8),
+        next: *std.ArrayList(WalkState),
+    ) !void {
+        const listing = self.listings.get(fsPath(state.dir)) orelse return;
+        const segment = segments[state.segment];
+        const last = state.segment + 1 == segments.len;
+
+        if (std.mem.eql(u8, segment, "**")) {
+            if (last) {
+                for (listing.files) |name| {
+                    if (name[0] != '.') try files.append(self.allocator, try self.child(state.dir, name));
+                }
+            } else {
+                // `**` matching zero components: continue with the rest here.
+                try self.step(segments, excludes, .{ .dir = state.dir, .segment = state.segment + 1 }, files, next);
+            }
+            for (listing.dirs) |name| {
+                if (name[0] == '.') continue;
+                const dir = try self.child(state.dir, name);
+                if (coveredDir(excludes, dir)) continue;
+                try next.append(self.allocator, .{ .dir = dir, .segment = state.segment });
+            }
+            return;
+        }
+
+        if (last) {
+            for (listing.files) |name| {
+                if (matchSegment(segment, name)) try files.append(self.allocator, try self.child(state.dir, name));
+            }
+            return;
+        }
+        for (listing.dirs) |name| {
+            if (!matchSegment(segment, name)) continue;
+            const dir = try self.child(state.dir, name);
+            if (coveredDir(excludes, dir)) continue;
+            try next.append(self.allocator, .{ .dir = dir, .segment = state.segment + 1 });
+        }
+    }
+
+    fn child(self: *Index, dir: []const u8, name: []const u8) ![]const u8 {
+        if (dir.len == 0) return name;
+        if (dir[dir.len - 1] == '/') return std.mem.concat(self.allocator, u8, &.{ dir, name });
+        return std.fmt.allocPrint(self.allocator, "{s}/{s}", .{ dir, name });
+    }
+
+    /// Brings the listings of `dirs` up to date, reading the stale ones in
+    /// parallel.
+    fn refresh(self: *Index, dirs: []const []const u8) !void {
+        if (!self.loaded) try self.load();
+
+        var batch = Batch{ .items = &.{} };
+        var items: std.ArrayList(Batch.Item) = .empty;
+        defer items.deinit(self.allocator);
+        for (dirs) |path| {
+            const entry = try self.verified.getOrPut(self.allocator, path);
+            if (entry.found_existing) continue;
+            try items.append(self.allocator, .{ .path = path, .cached = self.listings.get(path) });
+        }
+        if (items.items.len == 0) return;
+        batch.items = items.items;
+
+        const wanted = if (items.items.len < parallel_threshold) 1 else @min(items.items.len / parallel_threshold + 1, self.arenas.len);
+        var threads: [max_threads]std.Thread = undefined;
+        var spawned: usize = 0;
+        while (spawned + 1 < wanted) : (spawned += 1) {
+            threads[spawned] = std.Thread.spawn(.{}, Batch.run, .{ &batch, &self.arenas[spawned + 1] }) catch break;
+        }
+        batch.run(&self.arenas[0]);
+        for (threads[0..spawned]) |thread| thread.join();
+
+        for (items.items) |item| {
+            if (item.err) |err| return err;
+            const listing = item.result orelse {
+                if (self.listings.remove(item.path)) {
+                    self.dirty = true;
+                    try self.changed.put(self.allocator, item.path, {});
+                }
+                continue;
+            };
+            if (item.fresh) {
+                try self.listings.put(self.allocator, item.path, listing);
+                self.dirty = true;
+                try self.changed.put(self.allocator, item.path, {});
+            }
+        }
+    }
+
+    fn load(self: *Index) !void {
+        self.loaded = true;
+        const thread_count = @min(max_threads, std.Thread.getCpuCount() catch 1);
+        self.arenas = try self.allocator.alloc(std.heap.ArenaAllocator, @max(thread_count, 1));
+        for (self.arenas) |*arena| arena.* = std.heap.ArenaAllocator.init(core.memory.page_allocator);
+
+        const path = self.path orelse return;
+        const bytes = core.fs.readFileAllocUnlimited(self.allocator, path) catch |err| switch (err) {
+            error.FileNotFound => return,
+            else => return err,
+        };
+        self.listings = parseListings(self.allocator, bytes) catch .empty;
+    }
+};
+
+/// Directory listings read by worker threads; each worker allocates from
+/// its own arena and claims items through a shared counter.
+const Batch = struct {
+    items: []Item,
+    next_item: std.atomic.Value(usize) = .init(0),
+
+    const Item = struct {
+        path: []const u8,
+        cached: ?Listing,
+        /// Null when the directory no longer exists.
+        result: ?Listing = null,
+        /// The directory was re-read because its mtime changed.
+        fresh: bool = false,
+        err: ?anyerror = null,
+    };
+
+    fn run(batch: *Batch, arena: *std.heap.ArenaAllocator) void {
+        while (true) {
+            const index = batch.next_item.fetchAdd(1, .monotonic);
+            if (index >= batch.items.len) return;
+            const item = &batch.items[index];
+            refreshItem(arena.allocator(), item) catch |err| {
+                item.err = err;
+            };
+        }
+    }
+
+    fn refreshItem(allocator: std.mem.Allocator, item: *Item) !void {
+        const stat = core.fs.fingerprint(item.path) catch |err| switch (err) {
+            error.FileNotFound, error.NotDir => return,
+            else => return err,
+        };
+        if (item.cached) |cached| {
+            if (cached.mtime_ns == stat.mtime_ns) {
+                item.result = cached;
+                return;
+            }
+        }
+        item.result = readListing(allocator, item.path, stat.mtime_ns) catch |err| switch (err) {
+            error.FileNotFound, error.NotDir => return,
+            else => return err,
+        };
+        item.fresh = true;
+    }
+};
+
+fn readListing(allocator: std.mem.Allocator, path: []const u8, mtime_ns: i128) !Listing {
+    const io = core.runtime.io();
+    var dir = try std.Io.Dir.cwd().openDir(io, path, .{ .iterate = true });
+    defer dir.close(io);
+
+    var files: std.ArrayList([]const u8) = .empty;
+    var dirs: std.ArrayList([]const u8) = .empty;
+    var it = dir.iterate();
+    while (try it.next(io)) |entry| {
+        // One name per line in the index file.
+        if (std.mem.indexOfScalar(u8, entry.name, '\n') != null) continue;
+        switch (entry.kind) {
+            .file => try files.append(allocator, try allocator.dupe(u8, entry.name)),
+            .directory => try dirs.append(allocator, try allocator.dupe(u8, entry.name)),
+            else => {},
+        }
+    }
+    std.mem.sort([]const u8, files.items, {}, lessThanPath);
+    std.mem.sort([]const u8, dirs.items, {}, lessThanPath);
+    return .{
+        .mtime_ns = mtime_ns,
+        .files = try files.toOwnedSlice(allocator),
+        .dirs = try dirs.toOwnedSlice(allocator),
+    };
+}
+
+/// True when some exclusion matches everything below `dir`, as `vendor/**`
+/// does for `vendor` and `third_party/*/**` for `third_party/zlib`.
+/// `dir` is result-relative, "" for the working directory.
+fn coveredDir(excludes: []const []const u8, dir: []const u8) bool {
+    for (excludes) |exclude| {
+        if (std.mem.eql(u8, exclude, "**")) return true;
+        if (!std.mem.endsWith(u8, exclude, "/**") or dir.len == 0) continue;
+        if (matchPath(exclude[0 .. exclude.len - "/**".len], dir)) return true;
+    }
+    return false;
+}
+
+/// Filesystem spelling of a result-relative directory.
+fn fsPath(dir: []const u8) []const u8 {
+    return if (dir.len == 0) "." else dir;
+}
+
+fn lessThanPath(_: void, a: []const u8, b: []const u8) bool {
+    return std.mem.lessThan(u8, a, b);
+}
+
+// Format, one record per line:
+//   ovo-glob-index 1
+//   d\t<mtime_ns>\t<directory>
+//   f\t<file name>        (files of the preceding directory)
+//   s\t<subdirectory name>
+pub fn renderListings(allocator: std.mem.Allocator, listings: std.StringHashMapUnmanaged(Listing)) ![]u8 {
+    const dirs = try allocator.alloc([]const u8, listings.count());
+    defer allocator.free(dirs);
+    var keys = listings.keyIterator();
+    var i: usize = 0;
+    while (keys.next()) |key| : (i += 1) dirs[i] = key.*;
+    std.mem.sort([]const u8, dirs, {}, lessThanPath);
+
+    var out: std.ArrayList(u8) = .empty;
+    errdefer out.deinit(allocator);
+    try out.appendSlice(allocator, header ++ "\n");
+    for (dirs) |dir| {
+        const listing = listings.get(dir).?;
+        try out.print(allocator, "d\t{d}\t{s}\n", .{ listing.mtime_ns, dir });
+        for (listing.files) |name| try out.print(allocator, "f\t{s}\n", .{name});
+        for (listing.dirs) |name| try out.print(allocator, "s\t{s}\n", .{name});
+    }
+    return try out.toOwnedSlice(allocator);
+}
+
+/// Names are sliced out of `bytes`, which must outlive the result.
+pub fn parseListings(allocator: std.mem.Allocator, bytes: []const u8) !std.StringHashMapUnmanaged(Listing) {
+    var listings: std.StringHashMapUnmanaged(Listing) = .empty;
+    var lines = std.mem.splitScalar(u8, bytes, '\n');
+    if (!std.mem.eql(u8, lines.next() orelse "", header)) return error.InvalidGlobIndex;
+
+    var dir: ?[]const u8 = null;
+    var mtime_ns: i128 = 0;
+    var files: std.ArrayList([]const u8) = .empty;
+    var dirs: std.ArrayList([]const u8) = .empty;
+    while (lines.next()) |line| {
+        if (line.len == 0) continue;
+        if (line.len < 2 or line[1] != '\t') return error.InvalidGlobIndex;
+        const rest = line[2..];
+        switch (line[0]) {
+            'd' => {
+                if (dir) |previous| try putListing(allocator, &listings, previous, mtime_ns, &files, &dirs);
+                const tab = std.mem.indexOfScalar(u8, rest, '\t') orelse return error.InvalidGlobIndex;
+                mtime_ns = std.fmt.parseInt(i128, rest[0..tab], 10) catch return error.InvalidGlobIndex;
+                dir = rest[tab + 1 ..];
+            },
+            'f' => try files.append(allocator, rest),
+            's' => try dirs.append(allocator, rest),
+            else => return error.InvalidGlobIndex,
+        }
+    }
+    if (dir) |previous| try putListing(allocator, &listings, previous, mtime_ns, &files, &dirs);
+    return listings;
+}
+
+fn putListing(
+    allocator: std.mem.Allocator,
+    listings: *std.StringHashMapUnmanaged(Listing),
+    dir: []const u8,
+    mtime_ns: i128,
+    files: *std.ArrayList([]const u8),
+    dirs: *std.ArrayList([]const u8),
+) !void {
+    try listings.put(allocator, dir, .{
+        .mtime_ns = mtime_ns,
+        .files = try files.toOwnedSlice(allocator),
+        .dirs = try dirs.toOwnedSlice(allocator),
+    });
+}
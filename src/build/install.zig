@@ -0,0 +1,359 @@
+const std = @import("std");
+const builtin = @import("builtin");
+const core = @import("../core/mod.zig");
+const project_mod = @import("../core/project.zig");
+const orchestrator = @import("orchestrator.zig");
+
+/// Kept in the prefix, so the next install into it skips what is unchanged.
+pub const record_name = ".ovo-install";
+const record_header = "ovo-install 1";
+
+/// Where each kind of file goes; the directories are relative to `prefix`.
+pub const Layout = struct {
+    prefix: []const u8 = ".ovo/install",
+    bindir: []const u8 = "bin",
+    libdir: []const u8 = "lib",
+    includedir: []const u8 = "include",
+};
+
+pub const Mode = enum {
+    /// Independent copies, sharing extents with the build's outputs where
+    /// the file system can clone.
+    copy,
+    /// Hard links to the build's outputs, copying only where a link fails,
+    /// e.g. across file systems.
+    link,
+};
+
+pub const Item = struct {
+    source: []const u8,
+    dest: []const u8,
+    /// Installed 0755 rather than 0644 when copied.
+    executable: bool = false,
+};
+
+pub const Method = enum {
+    up_to_date,
+    reflink,
+    copy_range,
+    copy,
+    hard_link,
+
+    pub fn label(self: Method) []const u8 {
+        return switch (self) {
+            .up_to_date => "up to date",
+            .reflink => "reflink",
+            .copy_range => "copy_file_range",
+            .copy => "copy",
+            .hard_link => "hard link",
+        };
+    }
+};
+
+const header_extensions = [_][]const u8{ ".h", ".hh", ".hpp", ".hxx", ".h++", ".inl", ".ipp", ".tpp" };
+
+/// Every artifact, plus the headers under the include dirs of the libraries
+/// among them. Headers keep their path below the include dir they are in;
+/// a header found through two targets is installed once.
+pub fn plan(
+    allocator: std.mem.Allocator,
+    project: project_mod.Project,
+    artifacts: []const orchestrator.BuiltArtifact,
+    layout: Layout,
+) ![]const Item {
+    var items: std.StringArrayHashMapUnmanaged(Item) = .empty;
+    for (artifacts) |artifact| {
+        const library = artifact.kind == .library_static or artifact.kind == .library_shared;
+        const dest = try std.fs.path.join(allocator, &.{
+            layout.prefix,
+            if (library) layout.libdir else layout.bindir,
+            std.fs.path.basename(artifact.path),
+        });
+        try items.put(allocator, dest, .{
+            .source = artifact.path,
+            .dest = dest,
+            .executable = artifact.kind != .library_static,
+        });
+        if (!library) continue;
+        const target = for (project.targets) |candidate| {
+            if (std.mem.eql(u8, candidate.name, artifact.name)) break candidate;
+        } else continue;
+        for (target.include_dirs) |include_dir| {
+            for (try core.fs.walkFiles(allocator, include_dir)) |file| {
+                var relative = file.path[include_dir.len..];
+                while (relative.len > 0 and relative[0] == '/') relative = relative[1..];
+                if (!isHeader(relative) or hidden(relative)) continue;
+                const header_dest = try std.fs.path.join(allocator, &.{ layout.prefix, layout.includedir, relative });
+                if (items.contains(header_dest)) continue;
+                try items.put(allocator, header_dest, .{ .source = file.path, .dest = header_dest });
+            }
+        }
+    }
+    return items.values();
+}
+
+fn isHeader(path: []const u8) bool {
+    const ext = std.fs.path.extension(path);
+    for (header_extensions) |header_ext| {
+        if (std.ascii.eqlIgnoreCase(ext, header_ext)) return true;
+    }
+    return false;
+}
+
+/// Dot-files and anything under a dot-directory, such as `.ovo` below an
+/// include dir of `.`.
+fn hidden(path: []const u8) bool {
+    return path[0] == '.' or std.mem.indexOf(u8, path, "/.") != null;
+}
+
+/// What the last install into a prefix wrote, by destination: a file is
+/// skipped while neither it nor its source changed since.
+pub const Record = struct {
+    source: []const u8,
+    source_fingerprint: core.fs.Fingerprint,
+    dest_fingerprint: core.fs.Fingerprint,
+    mode: Mode,
+};
+
+pub const Records = std.StringHashMapUnmanaged(Record);
+
+/// `<source mtime>\t<size>\t<dest mtime>\t<size>\t<mode>\t<dest>\t<source>`
+/// lines after a version header. Keys and sources point into `bytes`.
+pub fn parseRecords(allocator: std.mem.Allocator, bytes: []const u8) !Records {
+    var lines = std.mem.splitScalar(u8, bytes, '\n');
+    if (!std.mem.eql(u8, lines.first(), record_header)) return error.InvalidInstallRecord;
+    var records: Records = .empty;
+    errdefer records.deinit(allocator);
+    while (lines.next()) |line| {
+        if (line.len == 0) continue;
+        var fields = std.mem.splitScalar(u8, line, '\t');
+        var numbers: [4]u64 = undefined;
+        for (&numbers) |*number| {
+            number.* = std.fmt.parseInt(u64, fields.next() orelse return error.InvalidInstallRecord, 10) catch return error.InvalidInstallRecord;
+        }
+        const mode = std.meta.stringToEnum(Mode, fields.next() orelse return error.InvalidInstallRecord) orelse return error.InvalidInstallRecord;
+        const dest = fields.next() orelse return error.InvalidInstallRecord;
+        const source = fields.rest();
+        if (dest.len == 0 or source.len == 0) return error.InvalidInstallRecord;
+        try records.put(allocator, dest, .{
+            .source = source,
+            .source_fingerprint = .{ .mtime_ns = numbers[0], .size = numbers[1] },
+            .dest_fingerprint = .{ .mtime_ns = numbers[2], .size = numbers[3] },
+            .mode = mode,
+        });
+    }
+    return records;
+}
+
+pub fn renderRecords(allocator: std.mem.Allocator, records: Records) ![]u8 {
+    const dests = try allocator.alloc([]const u8, records.count());
+    defer allocator.free(dests);
+    var it = records.keyIterator();
+    var i: usize = 0;
+    while (it.next()) |dest| : (i += 1) dests[i] = dest.*;
+    std.mem.sort([]const u8, dests, {}, stringLessThan);
+
+    var out: std.ArrayList(u8) = .empty;
+    errdefer out.deinit(allocator);
+    try out.print(allocator, "{s}\n", .{record_header});
+    for (dests) |dest| {
+        const record = records.get(dest).?;
+        try out.print(allocator, "{d}\t{d}\t{d}\t{d}\t{s}\t{s}\t{s}\n", .{
+            record.source_fingerprint.mtime_ns,
+            record.source_fingerprint.size,
+            record.dest_fingerprint.mtime_ns,
+            record.dest_fingerprint.size,
+            @tagName(record.mode),
+            dest,
+            record.source,
+        });
+    }
+    return try out.toOwnedSlice(allocator);
+}
+
+fn stringLessThan(_: void, a: []const u8, b: []const u8) bool {
+    return std.mem.lessThan(u8, a, b);
+}
+
+pub const Options = struct {
+    prefix: []const u8,
+    mode: Mode = .copy,
+    jobs: usize,
+};
+
+/// Installs `items` on up to `options.jobs` threads and returns how each
+/// one was installed. Unchanged files are skipped without being read. The
+/// rest are written beside their destination and renamed over it, so a
+/// program running from the prefix keeps its old file.
+pub fn run(allocator: std.mem.Allocator, items: []const Item, options: Options) ![]const Method {
+    const record_path = try std.fs.path.join(allocator, &.{ options.prefix, record_name });
+    var records: Records = records: {
+        const bytes = core.fs.readFileAlloc(allocator, record_path) catch break :records .empty;
+        break :records parseRecords(allocator, bytes) catch .empty;
+    };
+
+    const methods = try allocator.alloc(Method, items.len);
+    var pending: std.ArrayList(usize) = .empty;
+    for (items, 0..) |item, i| {
+        methods[i] = .up_to_date;
+        if (!upToDate(&records, item, options.mode)) try pending.append(allocator, i);
+    }
+    if (pending.items.len == 0) return methods;
+
+    var copies = Copies{
+        .items = items,
+        .pending = pending.items,
+        .mode = options.mode,
+        .methods = methods,
+        .failures = try allocator.alloc(?anyerror, items.len),
+    };
+    @memset(copies.failures, null);
+    const threads = try allocator.alloc(std.Thread, @min(options.jobs, pending.items.len) -| 1);
+    var spawned: usize = 0;
+    for (threads) |*thread| {
+        // The calling thread installs too, so a failed spawn only costs parallelism.
+        thread.* = std.Thread.spawn(.{}, Copies.work, .{&copies}) catch break;
+        spawned += 1;
+    }
+    copies.work();
+    for (threads[0..spawned]) |thread| thread.join();
+
+    // Files that did install are recorded even when another one failed.
+    var first_error: ?anyerror = null;
+    for (pending.items) |i| {
+        if (copies.failures[i]) |err| {
+            first_error = first_error orelse err;
+            continue;
+        }
+        const item = items[i];
+        try records.put(allocator, item.dest, .{
+            .source = item.source,
+            .source_fingerprint = core.fs.fingerprint(item.source) catch continue,
+            .dest_fingerprint = core.fs.fingerprint(item.dest) catch continue,
+            .mode = options.mode,
+        });
+    }
+    try core.fs.writeFile(record_path, try renderRecords(allocator, records));
+    if (first_error) |err| return err;
+    return methods;
+}
+
+fn upToDate(records: *const Records, item: Item, mode: Mode) bool {
+    const record = records.get(item.dest) orelse return false;
+    if (record.mode != mode or !std.mem.eql(u8, record.source, item.source)) return false;
+    const source = core.fs.fingerprint(item.source) catch return false;
+    const dest = core.fs.fingerprint(item.dest) catch return false;
+    return std.meta.eql(source, record.source_fingerprint) and std.meta.eql(dest, record.dest_fingerprint);
+}
+
+const Copies = struct {
+    items: []const Item,
+    /// Indices into `items` still to install.
+    pending: []const usize,
+    mode: Mode,
+    methods: []Method,
+    failures: []?anyerror,
+    next: std.atomic.Value(usize) = .init(0),
+
+    fn work(self: *Copies) void {
+        while (true) {
+            const n = self.next.fetchAdd(1, .monotonic);
+            if (n >= self.pending.len) return;
+            const i = self.pending[n];
+            self.methods[i] = installFile(self.items[i], self.mode) catch |err| {
+                self.failures[i] = err;
+                continue;
+            };
+        }
+    }
+};
+
+fn installFile(item: Item, mode: Mode) !Method {
+    // Worker threads must not touch the caller's (usually arena) allocator.
+    const allocator = std.heap.smp_allocator;
+    if (std.fs.path.dirname(item.dest)) |dir| try core.fs.ensureDir(dir);
+    const tmp = try std.fmt.allocPrint(allocator, "{s}.ovo-tmp", .{item.dest});
+    defer allocator.free(tmp);
+    try core.fs.deleteFileIfExists(tmp);
+    errdefer core.fs.deleteFileIfExists(tmp) catch {};
+
+    const method = method: {
+        if (mode == .link) {
+            const cwd = std.Io.Dir.cwd();
+            if (std.Io.Dir.hardLink(cwd, item.source, cwd, tmp, core.runtime.io(), .{})) |_| {
+                break :method .hard_link;
+            } else |_| {}
+        }
+        if (try cloneFile(allocator, item, tmp)) |cloned| break :method cloned;
+        try core.fs.copyFile(allocator, item.source, tmp);
+        break :method .copy;
+    };
+    try core.fs.renameFile(tmp, item.dest);
+    // Renaming a hard link over another link to the same file does nothing.
+    if (method == .hard_link) core.fs.deleteFileIfExists(tmp) catch {};
+    return method;
+}
+
+/// Clones `item.source` as `tmp` so both share extents: FICLONE on Linux
+/// (btrfs, XFS, bcachefs), falling back to an in-kernel `copy_file_range`,
+/// and `clonefile` on macOS (APFS). Null where neither applies, for a
+/// plain copy.
+fn cloneFile(allocator: std.mem.Allocator, item: Item, tmp: []const u8) !?Method {
+    switch (builtin.os.tag) {
+        .linux => return cloneLinux(allocator, item, tmp),
+        .macos => {
+            const source_z = try allocator.dupeZ(u8, item.source);
+            defer allocator.free(source_z);
+            const tmp_z = try allocator.dupeZ(u8, tmp);
+            defer allocator.free(tmp_z);
+            return if (clonefile(source_z, tmp_z, 0) == 0) .reflink else null;
+        },
+        else => return null,
+    }
+}
+
+extern "c" fn clonefile(source: [*:0]const u8, dest: [*:0]const u8, flags: u32) c_int;
+
+/// `_IOW(0x94, 9, int)`.
+const FICLONE: u32 = 0x40049409;
+
+fn cloneLinux(allocator: std.mem.Allocator, item: Item, tmp: []const u8) !?Method {
+    const linux = std.os.linux;
+    const source_z = try allocator.dupeZ(u8, item.source);
+    defer allocator.free(source_z);
+    const tmp_z = try allocator.dupeZ(u8, tmp);
+    defer allocator.free(tmp_z);
+    const size = (try core.fs.fingerprint(item.source)).size;
+
+    const in_fd = try openResult(linux.openat(linux.AT.FDCWD, source_z, .{ .ACCMODE = .RDONLY, .CLOEXEC = true }, 0));
+    defer _ = linux.close(in_fd);
+    const file_mode: linux.mode_t = if (item.executable) 0o755 else 0o644;
+    const out_fd = try openResult(linux.openat(linux.AT.FDCWD, tmp_z, .{ .ACCMODE = .WRONLY, .CREAT = true, .TRUNC = true, .CLOEXEC = true }, file_mode));
+    defer _ = linux.close(out_fd);
+
+    if (linux.E.init(linux.ioctl(out_fd, FICLONE, @intCast(in_fd))) == .SUCCESS) return .reflink;
+    var remaining = size;
+    while (remaining > 0) {
+        const rc = linux.copy_file_range(in_fd, null, out_fd, null, @intCast(remaining), 0);
+        switch (linux.E.init(rc)) {
+            .SUCCESS => {
+                if (rc == 0) break;
+                remaining -|= rc;
+            },
+            .INTR => continue,
+            // Not between these two files; a plain copy still is.
+            .XDEV, .NOSYS, .INVAL, .OPNOTSUPP => return null,
+            else => return error.InstallCopyFailed,
+        }
+    }
+    return .copy_range;
+}
+
+fn openResult(rc: usize) !i32 {
+    return switch (std.os.linux.E.init(rc)) {
+        .SUCCESS => @intCast(rc),
+        .NOENT => error.FileNotFound,
+        .ACCES, .PERM => error.AccessDenied,
+        else => error.InstallCopyFailed,
+    };
+}
@@ -0,0 +1,409 @@
+const std = @import("std");
+const core = @import("../core/mod.zig");
+
+/// One compiler, archiver, or linker invocation scheduled on the pool.
+/// `output` holds the combined stdout/stderr of the process so diagnostics
+/// from concurrent jobs are flushed as whole blocks instead of interleaving.
+pub const Job = struct {
+    label: []const u8,
+    argv: []const []const u8,
+    exit_code: u8 = 0,
+    output: []const u8 = "",
+    finished: bool = false,
+    /// Failures of optional work (cache probes, uploads) don't stop the pool.
+    may_fail: bool = false,
+    /// Writes the process's stdout here instead of into `output`, for tools
+    /// that print their result.
+    stdout_path: ?[]const u8 = null,
+    /// Caller-defined id for mapping a job handed back by `Pool.wait` to its owner.
+    tag: u64 = 0,
+    /// Worker that ran the job, from 1; 0 is the calling thread.
+    lane: u32 = 0,
+    started_ns: i128 = 0,
+    finished_ns: i128 = 0,
+    /// When the job was first picked up, on the clock of file mtimes: an
+    /// input modified since may have been read half-written.
+    started_wall_ns: i128 = 0,
+    /// Tried before `argv` runs locally, e.g. to compile on a remote worker.
+    offload: ?*Offload = null,
+    /// `Pool` starts higher priorities first; equal ones keep submission order.
+    priority: u64 = 0,
+    /// Expected wall time from earlier builds, kept for `--explain`.
+    predicted_ns: u64 = 0,
+    /// Expected peak RSS, held against the pool's memory budget while it runs.
+    predicted_rss: u64 = 0,
+    /// Routes the process's output through this file so its peak RSS can be
+    /// measured into `peak_rss`.
+    log_path: ?[]const u8 = null,
+    peak_rss: u64 = 0,
+    /// Set when `offload` ran the job, so its timings aren't this machine's.
+    remote: bool = false,
+};
+
+/// Runs a job somewhere other than a local process. Implementations embed it
+/// and recover themselves with `@fieldParentPtr`. `runFn` returns false to
+/// have the job run locally after all; local processes it starts itself
+/// take a slot from `local` like any other.
+pub const Offload = struct {
+    runFn: *const fn (offload: *Offload, job: *Job, local: ?*Slots) bool,
+};
+
+/// Bounds the local processes of a pool, by count and by the memory they
+/// are expected to need, when some of its workers exist only to wait on
+/// jobs that run elsewhere or when memory is tighter than the job count.
+pub const Slots = struct {
+    mutex: std.Thread.Mutex = .{},
+    freed: std.Thread.Condition = .{},
+    free: usize,
+    /// Bytes local jobs may reserve together; 0 for no limit.
+    memory_budget: u64 = 0,
+    memory_reserved: u64 = 0,
+
+    /// Waits for a free slot and `need` bytes of the budget. A job is always
+    /// admitted once nothing else holds memory, so one that is bigger than
+    /// the whole budget still runs, alone.
+    pub fn acquire(self: *Slots, need: u64) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        while (self.free == 0 or !self.fits(need)) self.freed.wait(&self.mutex);
+        self.free -= 1;
+        self.memory_reserved += need;
+    }
+
+    pub fn release(self: *Slots, need: u64) void {
+        self.mutex.lock();
+        self.free += 1;
+        self.memory_reserved -= need;
+        self.mutex.unlock();
+        // Freed memory may admit more than one smaller job.
+        self.freed.broadcast();
+    }
+
+    fn fits(self: *const Slots, need: u64) bool {
+        if (self.memory_budget == 0 or self.memory_reserved == 0) return true;
+        return self.memory_reserved + need <= self.memory_budget;
+    }
+};
+
+pub const Limits = struct {
+    jobs: usize,
+    /// Extra workers for jobs that mostly wait on another machine. Local
+    /// processes stay bounded by `jobs`.
+    offload_slots: usize = 0,
+    /// Bytes of predicted peak RSS local jobs may hold at once; 0 for no limit.
+    memory_budget: u64 = 0,
+};
+
+pub const Summary = struct {
+    completed: usize = 0,
+    failed: usize = 0,
+    skipped: usize = 0,
+};
+
+/// Outputs are allocated from a thread-safe allocator because worker threads
+/// must not touch the caller's (usually arena) allocator.
+pub const output_allocator = std.heap.smp_allocator;
+
+pub fn defaultJobCount() usize {
+    return std.Thread.getCpuCount() catch 1;
+}
+
+const PoolState = struct {
+    jobs: []Job,
+    next: std.atomic.Value(usize) = .init(0),
+    failed: std.atomic.Value(bool) = .init(false),
+};
+
+/// Runs every job with at most `max_jobs` processes in flight. After the first
+/// failure no new jobs are started; jobs already running are allowed to finish.
+pub fn runAll(allocator: std.mem.Allocator, jobs: []Job, max_jobs: usize) !Summary {
+    if (jobs.len == 0) return .{};
+
+    var state = PoolState{ .jobs = jobs };
+    const worker_count = @max(1, @min(max_jobs, jobs.len));
+    if (worker_count == 1) {
+        worker(&state, 0);
+    } else {
+        const threads = try allocator.alloc(std.Thread, worker_count - 1);
+        defer allocator.free(threads);
+
+        var spawned: usize = 0;
+        defer for (threads[0..spawned]) |thread| thread.join();
+        for (threads, 1..) |*thread, lane| {
+            thread.* = std.Thread.spawn(.{}, worker, .{ &state, @as(u32, @intCast(lane)) }) catch break;
+            spawned += 1;
+        }
+        // The calling thread is a worker too, so a failed spawn degrades
+        // parallelism instead of aborting the build.
+        worker(&state, 0);
+    }
+
+    var summary = Summary{};
+    for (jobs) |job| {
+        if (!job.finished) {
+            summary.skipped += 1;
+        } else if (job.exit_code != 0) {
+            summary.failed += 1;
+        } else {
+            summary.completed += 1;
+        }
+    }
+    return summary;
+}
+
+pub fn freeOutputs(jobs: []Job) void {
+    for (jobs) |*job| {
+        if (job.output.len > 0) output_allocator.free(job.output);
+        job.output = "";
+    }
+}
+
+/// Long-lived worker pool for callers that schedule work as earlier jobs
+/// finish, such as a link that may start once its objects and libraries
+/// exist. Jobs start highest `priority` first, in submission order among
+/// equals, and `wait` hands them back as they complete. Only the thread that
+/// owns the pool may call its methods.
+pub const Pool = struct {
+    mutex: std.Thread.Mutex = .{},
+    work_ready: std.Thread.Condition = .{},
+    job_done: std.Thread.Condition = .{},
+    /// Binary max-heap on `Queued.before`.
+    queue: std.ArrayList(Queued) = .empty,
+    submitted: u64 = 0,
+    done: std.ArrayList(*Job) = .empty,
+    /// Submitted jobs not yet returned by `wait`.
+    outstanding: usize = 0,
+    stopping: bool = false,
+    threads: []std.Thread = &.{},
+    spawned: usize = 0,
+    /// Set when workers alone don't bound local processes: some only wait on
+    /// offloaded jobs, or memory is budgeted.
+    local: ?Slots = null,
+
+    const Queued = struct {
+        job: *Job,
+        sequence: u64,
+
+        fn before(a: Queued, b: Queued) bool {
+            if (a.job.priority != b.job.priority) return a.job.priority > b.job.priority;
+            return a.sequence < b.sequence;
+        }
+    };
+
+    /// `self` must not move until `deinit`; workers keep a pointer to it.
+    pub fn start(self: *Pool, max_jobs: usize) !void {
+        return self.startLimited(.{ .jobs = max_jobs });
+    }
+
+    pub fn startLimited(self: *Pool, limits: Limits) !void {
+        const max_jobs = @max(1, limits.jobs);
+        if (limits.offload_slots > 0 or limits.memory_budget > 0) {
+            self.local = .{ .free = max_jobs, .memory_budget = limits.memory_budget };
+        }
+        self.threads = try output_allocator.alloc(std.Thread, max_jobs + limits.offload_slots);
+        for (self.threads, 1..) |*thread, lane| {
+            // With no workers at all, `wait` runs jobs inline instead.
+            thread.* = std.Thread.spawn(.{}, poolWorker, .{ self, @as(u32, @intCast(lane)) }) catch break;
+            self.spawned += 1;
+        }
+    }
+
+    pub fn deinit(self: *Pool) void {
+        self.mutex.lock();
+        self.stopping = true;
+        self.mutex.unlock();
+        self.work_ready.broadcast();
+        for (self.threads[0..self.spawned]) |thread| thread.join();
+        output_allocator.free(self.threads);
+        self.queue.deinit(output_allocator);
+        self.done.deinit(output_allocator);
+    }
+
+    /// `job` must stay at the same address until `wait` returns it.
+    pub fn submit(self: *Pool, job: *Job) !void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        // Reserve the completion slot now so workers never allocate.
+        try self.done.ensureTotalCapacity(output_allocator, self.outstanding + 1);
+        try self.queue.append(output_allocator, .{ .job = job, .sequence = self.submitted });
+        self.submitted += 1;
+        self.siftUp(self.queue.items.len - 1);
+        self.outstanding += 1;
+        self.work_ready.signal();
+    }
+
+    /// Next finished job, blocking while jobs are still running; null once
+    /// nothing is outstanding. Cancelled jobs come back with `finished` unset.
+    pub fn wait(self: *Pool) ?*Job {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        while (true) {
+            if (self.done.items.len > 0) {
+                self.outstanding -= 1;
+                return self.done.orderedRemove(0);
+            }
+            if (self.outstanding == 0) return null;
+            if (self.spawned == 0) {
+                const job = self.popQueued() orelse return null;
+                self.mutex.unlock();
+                runJob(job, 0, self.localSlots());
+                self.mutex.lock();
+                self.done.appendAssumeCapacity(job);
+                continue;
+            }
+            self.job_done.wait(&self.mutex);
+        }
+    }
+
+    /// Drops jobs that have not started yet, e.g. after a failure.
+    pub fn cancelQueued(self: *Pool) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        while (self.popQueued()) |job| self.done.appendAssumeCapacity(job);
+    }
+
+    fn localSlots(self: *Pool) ?*Slots {
+        return if (self.local) |*slots| slots else null;
+    }
+
+    fn popQueued(self: *Pool) ?*Job {
+        const items = self.queue.items;
+        if (items.len == 0) return null;
+        const job = items[0].job;
+        items[0] = items[items.len - 1];
+        self.queue.items.len -= 1;
+        self.siftDown(0);
+        return job;
+    }
+
+    fn siftUp(self: *Pool, start_index: usize) void {
+        const items = self.queue.items;
+        var index = start_index;
+        while (index > 0) {
+            const parent = (index - 1) / 2;
+            if (!items[index].before(items[parent])) return;
+            std.mem.swap(Queued, &items[index], &items[parent]);
+            index = parent;
+        }
+    }
+
+    fn siftDown(self: *Pool, start_index: usize) void {
+        const items = self.queue.items;
+        var index = start_index;
+        while (true) {
+            var first = index;
+            for ([_]usize{ 2 * index + 1, 2 * index + 2 }) |child| {
+                if (child < items.len and items[child].before(items[first])) first = child;
+            }
+            if (first == index) return;
+            std.mem.swap(Queued, &items[index], &items[first]);
+            index = first;
+        }
+    }
+};
+
+fn poolWorker(pool: *Pool, lane: u32) void {
+    pool.mutex.lock();
+    defer pool.mutex.unlock();
+    while (true) {
+        if (pool.popQueued()) |job| {
+            pool.mutex.unlock();
+            runJob(job, lane, pool.localSlots());
+            pool.mutex.lock();
+            pool.done.appendAssumeCapacity(job);
+            pool.job_done.signal();
+            continue;
+        }
+        if (pool.stopping) return;
+        pool.work_ready.wait(&pool.mutex);
+    }
+}
+
+fn worker(state: *PoolState, lane: u32) void {
+    while (!state.failed.load(.acquire)) {
+        const index = state.next.fetchAdd(1, .monotonic);
+        if (index >= state.jobs.len) return;
+        const job = &state.jobs[index];
+        runJob(job, lane, null);
+        if (job.exit_code != 0 and !job.may_fail) state.failed.store(true, .release);
+    }
+}
+
+fn runJob(job: *Job, lane: u32, local: ?*Slots) void {
+    job.lane = lane;
+    job.started_ns = core.runtime.nowNs();
+    job.started_wall_ns = core.runtime.wallClockNs();
+    defer job.finished_ns = core.runtime.nowNs();
+    if (job.offload) |offload| {
+        if (offload.runFn(offload, job, local)) {
+            job.remote = true;
+            job.finished = true;
+            flushOutput(job);
+            return;
+        }
+    }
+    if (local) |slots| {
+        slots.acquire(job.predicted_rss);
+        // Waiting for admission isn't part of the job's time.
+        job.started_ns = core.runtime.nowNs();
+    }
+    defer if (local) |slots| slots.release(job.predicted_rss);
+    if (job.stdout_path) |path| return runJobToFile(job, path);
+    if (job.log_path) |path| return runJobMeasured(job, path);
+    const captured = core.exec.runCaptured(output_allocator, job.argv) catch |err| {
+        job.exit_code = 127;
+        job.output = std.fmt.allocPrint(output_allocator, "error: unable to run '{s}': {s}\n", .{
+            job.argv[0],
+            @errorName(err),
+        }) catch "";
+        job.finished = true;
+        flushOutput(job);
+        return;
+    };
+    job.exit_code = captured.exit_code;
+    job.output = captured.output;
+    job.finished = true;
+    flushOutput(job);
+}
+
+fn runJobMeasured(job: *Job, log_path: []const u8) void {
+    defer job.finished = true;
+    defer flushOutput(job);
+    const measured = core.exec.runMeasured(output_allocator, job.argv, log_path) catch |err| {
+        job.exit_code = 127;
+        job.output = std.fmt.allocPrint(output_allocator, "error: unable to run '{s}': {s}\n", .{
+            job.argv[0],
+            @errorName(err),
+        }) catch "";
+        return;
+    };
+    job.exit_code = measured.exit_code;
+    job.output = measured.output;
+    job.peak_rss = measured.peak_rss;
+}
+
+fn runJobToFile(job: *Job, path: []const u8) void {
+    defer job.finished = true;
+    defer flushOutput(job);
+    const split = core.exec.runCapturedStdout(output_allocator, job.argv) catch |err| {
+        job.exit_code = 127;
+        job.output = std.fmt.allocPrint(output_allocator, "error: unable to run '{s}': {s}\n", .{
+            job.argv[0],
+            @errorName(err),
+        }) catch "";
+        return;
+    };
+    defer output_allocator.free(split.stdout);
+    job.exit_code = split.exit_code;
+    job.output = split.stderr;
+    if (job.exit_code == 0) core.fs.writeFile(path, split.stdout) catch {
+        job.exit_code = 1;
+    };
+}
+
+fn flushOutput(job: *const Job) void {
+    if (job.output.len == 0) return;
+    // Printed under one lock, so each job's diagnostics land as one
+    // contiguous block.
+    core.runtime.printErr("{s}", .{job.output});
+}
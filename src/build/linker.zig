@@ -0,0 +1,87 @@
+const std = @import("std");
+const builtin = @import("builtin");
+const project_mod = @import("../core/project.zig");
+const toolchain = @import("../compiler/toolchain.zig");
+
+const Linker = project_mod.Linker;
+
+/// Tried in order when `.linker` is unset, fastest first.
+const candidates = [_]struct { linker: Linker, command: []const u8 }{
+    .{ .linker = .mold, .command = "mold" },
+    .{ .linker = .lld, .command = "ld.lld" },
+    .{ .linker = .gold, .command = "ld.gold" },
+};
+
+/// mold, lld and gold only link ELF; elsewhere the platform linker is kept.
+pub const elf_host = !builtin.os.tag.isDarwin() and builtin.os.tag != .windows;
+
+/// The fastest installed linker, or `.default` when there is none. Looks
+/// each candidate up on PATH without starting it.
+pub fn detect(allocator: std.mem.Allocator) Linker {
+    if (!elf_host) return .default;
+    for (candidates) |candidate| {
+        const found = toolchain.findExecutable(allocator, candidate.command) catch null;
+        if (found != null) return candidate.linker;
+    }
+    return .default;
+}
+
+pub fn isDebug(optimize: []const u8) bool {
+    return std.ascii.eqlIgnoreCase(optimize, "debug");
+}
+
+/// gcc's split debug info lands in a `.dwo` next to each object, which the
+/// object cache doesn't store, so those builds skip the caches.
+pub fn writesDwo(backend: []const u8, optimize: []const u8) bool {
+    return elf_host and isDebug(optimize) and std.mem.eql(u8, backend, "gcc");
+}
+
+/// bfd has no `--gdb-index`; the others build it from the objects' pubnames.
+fn gdbIndex(linker: Linker) bool {
+    return elf_host and linker != .default;
+}
+
+/// Debug info for Debug builds. On ELF it's split from what the linker
+/// has to copy: clang keeps it in a section of the object the linker
+/// skips, so objects stay self-contained; gcc writes it to a `.dwo`.
+/// msvc's goes into the objects, for `/DEBUG:FASTLINK` to reference.
+pub fn appendCompileFlags(
+    allocator: std.mem.Allocator,
+    argv: *std.ArrayList([]const u8),
+    backend: []const u8,
+    optimize: []const u8,
+    linker: Linker,
+) !void {
+    if (!isDebug(optimize)) return;
+    if (std.mem.eql(u8, backend, "msvc")) return argv.append(allocator, "/Z7");
+    try argv.append(allocator, "-g");
+    if (!elf_host) return;
+    if (std.mem.eql(u8, backend, "clang")) {
+        try argv.append(allocator, "-gsplit-dwarf=single");
+    } else if (std.mem.eql(u8, backend, "gcc")) {
+        try argv.append(allocator, "-gsplit-dwarf");
+    } else {
+        // zig keeps its own debug info layout.
+        return;
+    }
+    if (gdbIndex(linker)) try argv.append(allocator, "-ggnu-pubnames");
+}
+
+/// Link flags placed like `lto.appendLinkFlags`, ahead of them so a linker
+/// LTO needs takes precedence. zig always links with its own linker.
+pub fn appendLinkFlags(
+    allocator: std.mem.Allocator,
+    argv: *std.ArrayList([]const u8),
+    backend: []const u8,
+    optimize: []const u8,
+    linker: Linker,
+) !void {
+    if (std.mem.eql(u8, backend, "msvc")) {
+        // Leaves the debug info in the objects instead of merging a PDB.
+        if (isDebug(optimize)) try argv.append(allocator, "/DEBUG:FASTLINK");
+        return;
+    }
+    if (std.mem.eql(u8, backend, "zigcc") or linker == .default) return;
+    try argv.append(allocator, try std.fmt.allocPrint(allocator, "-fuse-ld={s}", .{project_mod.linkerLabel(linker)}));
+    if (isDebug(optimize) and gdbIndex(linker)) try argv.append(allocator, "-Wl,--gdb-index");
+}
@@ -0,0 +1,103 @@
+const std = @import("std");
+const builtin = @import("builtin");
+const project_mod = @import("../core/project.zig");
+
+/// Kept under the output directory so incremental ThinLTO links reuse the
+/// backend's work across builds.
+pub const cache_dir_name = "lto-cache";
+
+/// LTO only applies to optimized builds; Debug builds keep linking fast.
+pub fn active(mode: ?project_mod.Lto, optimize: []const u8) ?project_mod.Lto {
+    if (std.ascii.eqlIgnoreCase(optimize, "debug")) return null;
+    return mode;
+}
+
+/// Compile flags that emit objects the linker optimizes as a whole:
+/// LLVM bitcode for clang and zig, GIMPLE for gcc and CIL for msvc.
+pub fn appendCompileFlags(
+    allocator: std.mem.Allocator,
+    argv: *std.ArrayList([]const u8),
+    mode: project_mod.Lto,
+    backend: []const u8,
+) !void {
+    if (std.mem.eql(u8, backend, "clang")) {
+        try argv.append(allocator, if (mode == .thin) "-flto=thin" else "-flto=full");
+    } else if (std.mem.eql(u8, backend, "gcc")) {
+        try argv.append(allocator, "-flto=auto");
+    } else if (std.mem.eql(u8, backend, "zigcc")) {
+        // zig's linker only does monolithic LTO.
+        try argv.append(allocator, "-flto");
+    } else if (std.mem.eql(u8, backend, "msvc")) {
+        try argv.append(allocator, "/GL");
+    } else {
+        return error.UnsupportedCompilerBackend;
+    }
+}
+
+/// Link flags for an LTO link of `output`. ThinLTO keeps its cache in
+/// `cache_dir`; gcc partitions the program instead (ThinLTO's counterpart)
+/// and has no cache, and msvc's incremental LTCG stands in for ThinLTO.
+/// msvc's are linker options, for after `/link`; the others go before the
+/// objects.
+pub fn appendLinkFlags(
+    allocator: std.mem.Allocator,
+    argv: *std.ArrayList([]const u8),
+    mode: project_mod.Lto,
+    backend: []const u8,
+    cache_dir: []const u8,
+    output: []const u8,
+) !void {
+    if (std.mem.eql(u8, backend, "clang")) {
+        try argv.append(allocator, if (mode == .thin) "-flto=thin" else "-flto=full");
+        switch (builtin.os.tag) {
+            .macos => if (mode == .thin) {
+                try argv.append(allocator, try std.fmt.allocPrint(allocator, "-Wl,-cache_path_lto,{s}", .{cache_dir}));
+            },
+            .windows => if (mode == .thin) {
+                try argv.append(allocator, try std.fmt.allocPrint(allocator, "-Wl,/lldltocache:{s}", .{cache_dir}));
+            },
+            else => {
+                // The system linker needs a plugin to read bitcode; lld doesn't.
+                try argv.append(allocator, "-fuse-ld=lld");
+                if (mode == .thin) {
+                    try argv.append(allocator, try std.fmt.allocPrint(allocator, "-Wl,--thinlto-cache-dir={s}", .{cache_dir}));
+                }
+            },
+        }
+    } else if (std.mem.eql(u8, backend, "gcc")) {
+        try argv.append(allocator, "-flto=auto");
+        if (mode == .full) try argv.append(allocator, "-flto-partition=one");
+    } else if (std.mem.eql(u8, backend, "zigcc")) {
+        try argv.append(allocator, "-flto");
+    } else if (std.mem.eql(u8, backend, "msvc")) {
+        if (mode == .full) {
+            try argv.append(allocator, "/LTCG");
+            return;
+        }
+        try argv.append(allocator, "/LTCG:INCREMENTAL");
+        const name = std.fs.path.stem(output);
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "/LTCGOUT:{s}/{s}.iobj", .{ cache_dir, name }));
+    } else {
+        return error.UnsupportedCompilerBackend;
+    }
+}
+
+/// The archiver for a static library, one argument or two (`zig ar`).
+/// Archives of LTO objects need one that indexes their symbols.
+pub fn appendArchiver(
+    allocator: std.mem.Allocator,
+    argv: *std.ArrayList([]const u8),
+    lto: bool,
+    backend: []const u8,
+) !void {
+    if (std.mem.eql(u8, backend, "msvc")) {
+        try argv.append(allocator, "lib");
+        if (lto) try argv.append(allocator, "/LTCG");
+        return;
+    }
+    if (!lto) return argv.append(allocator, "ar");
+    if (std.mem.eql(u8, backend, "clang")) return argv.append(allocator, "llvm-ar");
+    if (std.mem.eql(u8, backend, "gcc")) return argv.append(allocator, "gcc-ar");
+    try argv.append(allocator, "zig");
+    try argv.append(allocator, "ar");
+}
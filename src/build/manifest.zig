@@ -0,0 +1,193 @@
+const std = @import("std");
+const core = @import("../core/mod.zig");
+
+/// Stored inside the project's output directory (`.ovo/build` by default).
+pub const file_name = "manifest.ovo";
+
+const header = "ovo-build-manifest 1";
+
+pub const ObjectRecord = struct {
+    source: []const u8,
+    argv_hash: u64,
+    inputs_hash: u64,
+};
+
+/// Per-object and per-artifact records from previous builds. Keys and values
+/// borrow from the buffer handed to `parse`, so keep it alive with the manifest.
+pub const Manifest = struct {
+    objects: std.StringHashMapUnmanaged(ObjectRecord) = .empty,
+    artifacts: std.StringHashMapUnmanaged(u64) = .empty,
+    dirty: bool = false,
+
+    pub fn load(allocator: std.mem.Allocator, path: []const u8) !Manifest {
+        const bytes = core.fs.readFileAlloc(allocator, path) catch |err| switch (err) {
+            error.FileNotFound => return .{},
+            else => return err,
+        };
+        return parse(allocator, bytes);
+    }
+
+    pub fn save(self: *Manifest, allocator: std.mem.Allocator, path: []const u8) !void {
+        if (!self.dirty) return;
+        const rendered = try self.render(allocator);
+        defer allocator.free(rendered);
+        try core.fs.writeFile(path, rendered);
+        self.dirty = false;
+    }
+
+    pub fn objectUpToDate(self: *const Manifest, object: []const u8, argv_hash: u64, inputs_hash: ?u64) bool {
+        const inputs = inputs_hash orelse return false;
+        const record = self.objects.get(object) orelse return false;
+        if (record.argv_hash != argv_hash or record.inputs_hash != inputs) return false;
+        return core.fs.fileExists(object);
+    }
+
+    pub fn recordObject(
+        self: *Manifest,
+        allocator: std.mem.Allocator,
+        object: []const u8,
+        record: ObjectRecord,
+    ) !void {
+        try self.objects.put(allocator, object, record);
+        self.dirty = true;
+    }
+
+    pub fn artifactUpToDate(self: *const Manifest, artifact: []const u8, inputs_hash: ?u64) bool {
+        const inputs = inputs_hash orelse return false;
+        const recorded = self.artifacts.get(artifact) orelse return false;
+        if (recorded != inputs) return false;
+        return core.fs.fileExists(artifact);
+    }
+
+    pub fn recordArtifact(self: *Manifest, allocator: std.mem.Allocator, artifact: []const u8, inputs_hash: u64) !void {
+        try self.artifacts.put(allocator, artifact, inputs_hash);
+        self.dirty = true;
+    }
+
+    pub fn render(self: *const Manifest, allocator: std.mem.Allocator) ![]u8 {
+        var out: std.ArrayList(u8) = .empty;
+        errdefer out.deinit(allocator);
+        try out.print(allocator, "{s}\n", .{header});
+
+        var objects = self.objects.iterator();
+        while (objects.next()) |entry| {
+            const record = entry.value_ptr.*;
+            try out.print(allocator, "o\t{s}\t{s}\t{x:0>16}\t{x:0>16}\n", .{
+                entry.key_ptr.*,
+                record.source,
+                record.argv_hash,
+                record.inputs_hash,
+            });
+        }
+        var artifacts = self.artifacts.iterator();
+        while (artifacts.next()) |entry| {
+            try out.print(allocator, "a\t{s}\t{x:0>16}\n", .{ entry.key_ptr.*, entry.value_ptr.* });
+        }
+        return try out.toOwnedSlice(allocator);
+    }
+};
+
+/// Parses the tab-separated manifest format. An unknown header yields an empty
+/// manifest so a format bump simply triggers a full rebuild.
+pub fn parse(allocator: std.mem.Allocator, bytes: []const u8) !Manifest {
+    var manifest = Manifest{};
+    var lines = std.mem.splitScalar(u8, bytes, '\n');
+    const first = lines.next() orelse return manifest;
+    if (!std.mem.eql(u8, std.mem.trimEnd(u8, first, "\r"), header)) return manifest;
+
+    while (lines.next()) |raw_line| {
+        const line = std.mem.trimEnd(u8, raw_line, "\r");
+        if (line.len == 0) continue;
+        var fields = std.mem.splitScalar(u8, line, '\t');
+        const kind = fields.next() orelse continue;
+        if (std.mem.eql(u8, kind, "o")) {
+            const object = fields.next() orelse continue;
+            const source = fields.next() orelse continue;
+            const argv_hash = parseHash(fields.next()) orelse continue;
+            const inputs_hash = parseHash(fields.next()) orelse continue;
+            try manifest.objects.put(allocator, object, .{
+                .source = source,
+                .argv_hash = argv_hash,
+                .inputs_hash = inputs_hash,
+            });
+        } else if (std.mem.eql(u8, kind, "a")) {
+            const artifact = fields.next() orelse continue;
+            const inputs_hash = parseHash(fields.next()) orelse continue;
+            try manifest.artifacts.put(allocator, artifact, inputs_hash);
+        }
+    }
+    return manifest;
+}
+
+fn parseHash(field: ?[]const u8) ?u64 {
+    const value = field orelse return null;
+    return std.fmt.parseInt(u64, value, 16) catch null;
+}
+
+pub fn hashArgv(argv: []const []const u8) u64 {
+    var hasher = std.hash.Wyhash.init(0);
+    for (argv) |arg| {
+        hasher.update(arg);
+        // Separator keeps {"-I", "a"} distinct from {"-Ia"}.
+        hasher.update(&[_]u8{0});
+    }
+    return hasher.final();
+}
+
+/// Combines the mtime and size of every input. Returns null when an input
+/// cannot be stat'ed so callers treat the output as stale.
+pub fn fingerprintInputs(paths: []const []const u8) ?u64 {
+    var hasher = std.hash.Wyhash.init(0);
+    for (paths) |path| {
+        const stat = core.fs.fingerprint(path) catch return null;
+        hashInput(&hasher, path, stat);
+    }
+    return hasher.final();
+}
+
+/// Inputs of one compile as they were before it was spawned, by path.
+pub const InputStats = std.StringHashMapUnmanaged(core.fs.Fingerprint);
+
+/// Stats `paths` ahead of the job that reads them, for
+/// `fingerprintInputsSince`. Inputs that cannot be stat'ed are left out.
+pub fn statInputs(allocator: std.mem.Allocator, paths: []const []const u8) !InputStats {
+    var stats: InputStats = .empty;
+    errdefer stats.deinit(allocator);
+    try stats.ensureTotalCapacity(allocator, @intCast(paths.len));
+    for (paths) |path| {
+        const stat = core.fs.fingerprint(path) catch continue;
+        stats.putAssumeCapacity(path, stat);
+    }
+    return stats;
+}
+
+/// `fingerprintInputs` for the inputs of a job that started at
+/// `started_wall_ns`. An input in `before` hashes as it was then, so one
+/// saved while the job ran no longer matches on the next build. Any other
+/// input modified at or after the start returns null, leaving the output
+/// unrecorded, since the job may have read its older text.
+pub fn fingerprintInputsSince(paths: []const []const u8, before: *const InputStats, started_wall_ns: i128) ?u64 {
+    var hasher = std.hash.Wyhash.init(0);
+    for (paths) |path| {
+        const stat = before.get(path) orelse stat: {
+            const now = core.fs.fingerprint(path) catch return null;
+            if (now.mtime_ns >= started_wall_ns) return null;
+            break :stat now;
+        };
+        hashInput(&hasher, path, stat);
+    }
+    return hasher.final();
+}
+
+fn hashInput(hasher: *std.hash.Wyhash, path: []const u8, stat: core.fs.Fingerprint) void {
+    hasher.update(path);
+    hasher.update(std.mem.asBytes(&stat.mtime_ns));
+    hasher.update(std.mem.asBytes(&stat.size));
+}
+
+/// Object file name derived from the source path: readable stem plus a short
+/// digest of the full path, so adding or removing sources never renames others.
+pub fn objectFileName(allocator: std.mem.Allocator, source: []const u8, ext: []const u8) ![]u8 {
+    const digest: u32 = @truncate(std.hash.Wyhash.hash(0, source));
+    return std.fmt.allocPrint(allocator, "{s}-{x:0>8}{s}", .{ std.fs.path.stem(source), digest, ext });
+}
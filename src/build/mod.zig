@@ -1 +1,22 @@
 pub const orchestrator = @import("orchestrator.zig");
+pub const job_pool = @import("job_pool.zig");
+pub const manifest = @import("manifest.zig");
+pub const depfile = @import("depfile.zig");
+pub const dep_db = @import("dep_db.zig");
+pub const object_cache = @import("object_cache.zig");
+pub const remote_cache = @import("remote_cache.zig");
+pub const target_graph = @import("target_graph.zig");
+pub const glob = @import("glob.zig");
+pub const watch = @import("watch.zig");
+pub const trace = @import("trace.zig");
+pub const pch = @import("pch.zig");
+pub const unity = @import("unity.zig");
+pub const modules = @import("modules.zig");
+pub const test_runner = @import("test_runner.zig");
+pub const lto = @import("lto.zig");
+pub const pgo = @import("pgo.zig");
+pub const linker = @import("linker.zig");
+pub const code_tools = @import("code_tools.zig");
+pub const distributed = @import("distributed.zig");
+pub const schedule = @import("schedule.zig");
+pub const install = @import("install.zig");
@@ -0,0 +1,169 @@
+const std = @import("std");
+const project_mod = @import("../core/project.zig");
+
+/// Extensions that mark a source as a module interface unit. A build scans
+/// for modules only when a selected target has one of these.
+pub const interface_extensions = [_][]const u8{ ".cppm", ".ccm", ".cxxm", ".c++m", ".ixx", ".mpp" };
+
+/// Backends ovo can scan with: clang through `clang-scan-deps`, gcc 14+
+/// through `-fdeps-format=p1689r5`, msvc through `/scanDependencies`.
+pub fn supported(standard: project_mod.CppStandard, backend: []const u8) bool {
+    const modules_standard = switch (standard) {
+        .cpp20, .cpp23 => true,
+        else => false,
+    };
+    if (!modules_standard) return false;
+    for ([_][]const u8{ "clang", "gcc", "msvc" }) |name| {
+        if (std.mem.eql(u8, backend, name)) return true;
+    }
+    return false;
+}
+
+pub fn isInterfaceUnit(source: []const u8) bool {
+    const ext = std.fs.path.extension(source);
+    for (interface_extensions) |candidate| {
+        if (std.ascii.eqlIgnoreCase(ext, candidate)) return true;
+    }
+    return false;
+}
+
+/// What one translation unit provides and imports, from its P1689 scan.
+pub const Scan = struct {
+    provides: []const Provided = &.{},
+    requires: []const []const u8 = &.{},
+
+    pub fn usesModules(self: Scan) bool {
+        return self.provides.len > 0 or self.requires.len > 0;
+    }
+};
+
+pub const Provided = struct {
+    name: []const u8,
+    /// False for implementation partitions (`module m:part;`).
+    is_interface: bool = true,
+};
+
+/// Where a scan writes its P1689 output for `object`.
+pub fn scanPath(allocator: std.mem.Allocator, object: []const u8) ![]u8 {
+    return std.fmt.allocPrint(allocator, "{s}.ddi", .{object});
+}
+
+/// The scan command for `source`. `compile` is the compiler and the flags
+/// the source compiles with. clang-scan-deps prints its result, so the
+/// caller must send the command's stdout to `ddi`; the others write it.
+pub fn appendScanArgv(
+    allocator: std.mem.Allocator,
+    argv: *std.ArrayList([]const u8),
+    compile: []const []const u8,
+    source: []const u8,
+    object: []const u8,
+    ddi: []const u8,
+    backend: []const u8,
+) !void {
+    if (std.mem.eql(u8, backend, "msvc")) {
+        try argv.appendSlice(allocator, compile);
+        try argv.append(allocator, "/TP");
+        try argv.append(allocator, "/scanDependencies");
+        try argv.append(allocator, ddi);
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "/Fo:{s}", .{object}));
+        try argv.append(allocator, source);
+    } else if (std.mem.eql(u8, backend, "gcc")) {
+        try argv.appendSlice(allocator, compile);
+        try argv.appendSlice(allocator, &.{ "-fmodules-ts", "-E", "-x", "c++", source });
+        try argv.append(allocator, "-MD");
+        try argv.append(allocator, "-MF");
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "{s}.d", .{ddi}));
+        try argv.append(allocator, "-fdeps-format=p1689r5");
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "-fdeps-file={s}", .{ddi}));
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "-fdeps-target={s}", .{object}));
+        try argv.append(allocator, "-o");
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "{s}.i", .{ddi}));
+    } else {
+        try argv.appendSlice(allocator, &.{ "clang-scan-deps", "-format=p1689", "--" });
+        try argv.appendSlice(allocator, compile);
+        try argv.appendSlice(allocator, &.{ "-x", "c++", source, "-c", "-o", object });
+    }
+}
+
+const P1689 = struct {
+    rules: []const struct {
+        provides: []const struct {
+            @"logical-name": []const u8,
+            @"is-interface": bool = true,
+        } = &.{},
+        requires: []const struct {
+            @"logical-name": []const u8,
+        } = &.{},
+    } = &.{},
+};
+
+/// Reads the first rule of a P1689 dependency file.
+pub fn parseP1689(allocator: std.mem.Allocator, bytes: []const u8) !Scan {
+    const parsed = try std.json.parseFromSliceLeaky(P1689, allocator, bytes, .{
+        .ignore_unknown_fields = true,
+    });
+    if (parsed.rules.len == 0) return .{};
+    const rule = parsed.rules[0];
+    const provides = try allocator.alloc(Provided, rule.provides.len);
+    for (provides, rule.provides) |*out, item| out.* = .{ .name = item.@"logical-name", .is_interface = item.@"is-interface" };
+    const requires = try allocator.alloc([]const u8, rule.requires.len);
+    for (requires, rule.requires) |*out, item| out.* = item.@"logical-name";
+    return .{ .provides = provides, .requires = requires };
+}
+
+/// Built module interface of `name` in `dir`; partitions `m:part` become
+/// `m-part`, the name clang and msvc look up.
+pub fn bmiPath(allocator: std.mem.Allocator, dir: []const u8, name: []const u8, backend: []const u8) ![]u8 {
+    const ext = if (std.mem.eql(u8, backend, "msvc")) ".ifc" else if (std.mem.eql(u8, backend, "gcc")) ".gcm" else ".pcm";
+    const file = try std.fmt.allocPrint(allocator, "{s}/{s}{s}", .{ dir, name, ext });
+    std.mem.replaceScalar(u8, file[dir.len + 1 ..], ':', '-');
+    return file;
+}
+
+/// gcc module mapper: one `name cmi` line per module of the build.
+pub fn renderModuleMap(allocator: std.mem.Allocator, names: []const []const u8, bmis: []const []const u8) ![]u8 {
+    var out: std.ArrayList(u8) = .empty;
+    errdefer out.deinit(allocator);
+    for (names, bmis) |name, bmi| try out.print(allocator, "{s} {s}\n", .{ name, bmi });
+    return try out.toOwnedSlice(allocator);
+}
+
+/// Flags for a compile of a module-aware source. `provided` is the module
+/// the source provides, with `bmi` where its interface goes; importers find
+/// built interfaces in `dir` (clang, msvc) or through `map` (gcc).
+pub fn appendCompileFlags(
+    allocator: std.mem.Allocator,
+    argv: *std.ArrayList([]const u8),
+    source: []const u8,
+    provided: ?Provided,
+    bmi: ?[]const u8,
+    dir: []const u8,
+    map: []const u8,
+    backend: []const u8,
+) !void {
+    const ext = std.fs.path.extension(source);
+    if (std.mem.eql(u8, backend, "msvc")) {
+        try argv.append(allocator, "/ifcSearchDir");
+        try argv.append(allocator, dir);
+        if (provided) |module| {
+            try argv.append(allocator, if (module.is_interface) "/interface" else "/internalPartition");
+            try argv.append(allocator, "/ifcOutput");
+            try argv.append(allocator, bmi.?);
+        }
+    } else if (std.mem.eql(u8, backend, "gcc")) {
+        try argv.append(allocator, "-fmodules-ts");
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "-fmodule-mapper={s}", .{map}));
+        // gcc doesn't know the interface extensions.
+        if (isInterfaceUnit(source)) try argv.appendSlice(allocator, &.{ "-x", "c++" });
+    } else {
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "-fprebuilt-module-path={s}", .{dir}));
+        if (provided != null) {
+            try argv.append(allocator, try std.fmt.allocPrint(allocator, "-fmodule-output={s}", .{bmi.?}));
+            // clang only treats its own interface extensions as module units.
+            const known = for ([_][]const u8{ ".cppm", ".ccm", ".cxxm", ".c++m" }) |candidate| {
+                if (std.mem.eql(u8, ext, candidate)) break true;
+            } else false;
+            if (!known) try argv.appendSlice(allocator, &.{ "-x", "c++-module" });
+        }
+    }
+}
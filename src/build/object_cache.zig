@@ -0,0 +1,463 @@
+const std = @import("std");
+const core = @import("../core/mod.zig");
+
+const Sha256 = std.crypto.hash.sha2.Sha256;
+pub const Digest = [Sha256.digest_length]u8;
+
+pub const default_max_size: u64 = 5 * 1024 * 1024 * 1024;
+const entry_header = "ovo-cache-entry 1";
+const stats_file = "stats.ovo";
+
+/// Counters persisted in `<root>/stats.ovo`. `size_bytes` is a running
+/// estimate between evictions, which recompute it from the directory.
+pub const Stats = struct {
+    hits: u64 = 0,
+    misses: u64 = 0,
+    stores: u64 = 0,
+    evictions: u64 = 0,
+    /// Local misses served by the remote tier (also counted in `hits`).
+    remote_hits: u64 = 0,
+    remote_uploads: u64 = 0,
+    size_bytes: u64 = 0,
+
+    pub fn hitRatePercent(self: Stats) u64 {
+        const lookups = self.hits + self.misses;
+        if (lookups == 0) return 0;
+        return self.hits * 100 / lookups;
+    }
+};
+
+/// Content-addressed object store shared by every checkout on the machine.
+///
+/// Lookups work in two steps, like ccache's direct mode. The entry key
+/// hashes the compiler identity, the normalized argv and the source text.
+/// The entry lists the headers of the last compile. The object key adds
+/// the current contents of those headers, so an edited header misses even
+/// if the dependency database of the checkout was wiped by `ovo clean`.
+pub const ObjectCache = struct {
+    root: []const u8,
+    max_size: u64 = default_max_size,
+    compiler_id: Digest = undefined,
+    /// Content digests of headers already hashed this build; most TUs share them.
+    content_digests: std.StringHashMapUnmanaged(Digest) = .empty,
+    session: Stats = .{},
+
+    /// Opens the cache described by the environment, or returns null when it
+    /// has been disabled or there is no home directory to put it in.
+    ///   OVO_CACHE_DIR       cache root (default `$XDG_CACHE_HOME/ovo` or `~/.cache/ovo`)
+    ///   OVO_CACHE_MAX_SIZE  size bound, e.g. `500M` or `20G` (default 5G)
+    ///   OVO_CACHE_DISABLE   any non-empty value turns the cache off
+    pub fn open(allocator: std.mem.Allocator) !?ObjectCache {
+        if (core.runtime.getEnv("OVO_CACHE_DISABLE")) |value| {
+            if (value.len > 0) return null;
+        }
+        const root = try resolveRoot(allocator) orelse return null;
+        var cache = ObjectCache{ .root = root };
+        if (core.runtime.getEnv("OVO_CACHE_MAX_SIZE")) |value| {
+            cache.max_size = parseSize(value) orelse default_max_size;
+        }
+        return cache;
+    }
+
+    /// Hashes the compiler's version banner so upgrading the toolchain
+    /// invalidates every entry without any explicit versioning.
+    pub fn identifyCompiler(self: *ObjectCache, compiler_argv: []const []const u8, banner: []const u8) void {
+        var hasher = Sha256.init(.{});
+        for (compiler_argv) |arg| hashField(&hasher, arg);
+        hashField(&hasher, banner);
+        hasher.final(&self.compiler_id);
+    }
+
+    /// Forgets the content digests of the previous build, whose memory they
+    /// lived in; the files may have changed since.
+    pub fn beginBuild(self: *ObjectCache) void {
+        self.content_digests = .empty;
+    }
+
+    /// Entry key for one translation unit, or null when the source is unreadable.
+    pub fn entryKey(
+        self: *ObjectCache,
+        allocator: std.mem.Allocator,
+        normalized_argv: []const []const u8,
+        source: []const u8,
+    ) !?Digest {
+        const source_digest = try self.contentDigest(allocator, source) orelse return null;
+        var hasher = Sha256.init(.{});
+        hasher.update(&self.compiler_id);
+        for (normalized_argv) |arg| hashField(&hasher, arg);
+        hasher.update(&source_digest);
+        var key: Digest = undefined;
+        hasher.final(&key);
+        return key;
+    }
+
+    /// Copies a cached object to `object` on a hit and returns the dependency
+    /// list recorded with it; returns null on a miss. Misses are reported via
+    /// `noteMiss` once every cache tier has been tried.
+    pub fn fetch(
+        self: *ObjectCache,
+        allocator: std.mem.Allocator,
+        key: Digest,
+        object: []const u8,
+    ) !?[]const []const u8 {
+        const current = try self.currentEntry(allocator, key) orelse return null;
+        const cached = try self.objectPath(allocator, current.entry.object_key, std.fs.path.extension(object));
+        if (!core.fs.fileExists(cached)) return null;
+        try core.fs.copyFile(allocator, cached, object);
+        // The entry's mtime is the LRU clock.
+        core.fs.touch(current.path) catch {};
+        self.session.hits += 1;
+        return current.entry.deps;
+    }
+
+    /// Path of the object an entry points at when the entry still matches the
+    /// headers on disk but the object itself is absent, as after a remote tier
+    /// has downloaded only the entry. Null when there is nothing to fill in.
+    pub fn missingObject(self: *ObjectCache, allocator: std.mem.Allocator, key: Digest, ext: []const u8) !?[]const u8 {
+        const current = try self.currentEntry(allocator, key) orelse return null;
+        const cached = try self.objectPath(allocator, current.entry.object_key, ext);
+        if (core.fs.fileExists(cached)) return null;
+        return cached;
+    }
+
+    pub fn noteMiss(self: *ObjectCache) void {
+        self.session.misses += 1;
+    }
+
+    pub const Published = struct {
+        entry_path: []const u8,
+        object_path: []const u8,
+    };
+
+    /// Publishes a freshly compiled object. Failures are not fatal for the
+    /// build, so callers usually ignore the error.
+    pub fn store(
+        self: *ObjectCache,
+        allocator: std.mem.Allocator,
+        key: Digest,
+        deps: []const []const u8,
+        object: []const u8,
+    ) !?Published {
+        const object_key = try self.objectKey(allocator, key, deps) orelse return null;
+        const cached = try self.objectPath(allocator, object_key, std.fs.path.extension(object));
+        if (!core.fs.fileExists(cached)) {
+            try publishFile(allocator, object, cached);
+            const stat = try core.fs.fingerprint(cached);
+            self.session.size_bytes += stat.size;
+        }
+        // Renamed into place like the object, so a concurrent build never
+        // reads a cut-off dependency list as a hit.
+        const entry_path = try self.entryPath(allocator, key);
+        const temp = try tempPath(allocator, entry_path);
+        core.fs.writeFile(temp, try renderEntry(allocator, object_key, deps)) catch |err| {
+            core.fs.deleteFileIfExists(temp) catch {};
+            return err;
+        };
+        try commitTemp(temp, entry_path);
+        self.session.stores += 1;
+        return .{ .entry_path = entry_path, .object_path = cached };
+    }
+
+    /// Merges this build's counters into the shared stats file and evicts
+    /// least recently used entries once the size bound is exceeded.
+    pub fn flush(self: *ObjectCache, allocator: std.mem.Allocator) !void {
+        const path = try std.fs.path.join(allocator, &.{ self.root, stats_file });
+        var stats = try loadStats(allocator, self.root);
+        stats.hits += self.session.hits;
+        stats.misses += self.session.misses;
+        stats.stores += self.session.stores;
+        stats.remote_hits += self.session.remote_hits;
+        stats.remote_uploads += self.session.remote_uploads;
+        stats.size_bytes += self.session.size_bytes;
+        if (stats.size_bytes > self.max_size) {
+            const evicted = try self.evict(allocator);
+            stats.evictions += evicted.count;
+            stats.size_bytes = evicted.remaining_bytes;
+        }
+        try core.fs.writeFile(path, try renderStats(allocator, stats));
+        self.session = .{};
+    }
+
+    const CurrentEntry = struct {
+        path: []const u8,
+        entry: Entry,
+    };
+
+    /// Loads the entry for `key` if it is well formed and every header it
+    /// lists still has the contents the object was compiled against.
+    fn currentEntry(self: *ObjectCache, allocator: std.mem.Allocator, key: Digest) !?CurrentEntry {
+        const entry_path = try self.entryPath(allocator, key);
+        const bytes = core.fs.readFileAlloc(allocator, entry_path) catch |err| switch (err) {
+            error.OutOfMemory => return err,
+            else => return null,
+        };
+        const entry = parseEntry(allocator, bytes) catch return null;
+        const object_key = try self.objectKey(allocator, key, entry.deps) orelse return null;
+        if (!std.mem.eql(u8, &object_key, &entry.object_key)) return null;
+        return .{ .path = entry_path, .entry = entry };
+    }
+
+    fn objectKey(self: *ObjectCache, allocator: std.mem.Allocator, key: Digest, deps: []const []const u8) !?Digest {
+        var hasher = Sha256.init(.{});
+        hasher.update(&key);
+        for (deps) |dep| {
+            const digest = try self.contentDigest(allocator, dep) orelse return null;
+            hashField(&hasher, dep);
+            hasher.update(&digest);
+        }
+        var object_key: Digest = undefined;
+        hasher.final(&object_key);
+        return object_key;
+    }
+
+    fn contentDigest(self: *ObjectCache, allocator: std.mem.Allocator, path: []const u8) !?Digest {
+        if (self.content_digests.get(path)) |digest| return digest;
+        const bytes = core.fs.readFileAlloc(allocator, path) catch |err| switch (err) {
+            error.OutOfMemory => return err,
+            else => return null,
+        };
+        defer allocator.free(bytes);
+        var digest: Digest = undefined;
+        Sha256.hash(bytes, &digest, .{});
+        try self.content_digests.put(allocator, try allocator.dupe(u8, path), digest);
+        return digest;
+    }
+
+    pub fn entryPath(self: *const ObjectCache, allocator: std.mem.Allocator, key: Digest) ![]u8 {
+        const hex = std.fmt.bytesToHex(key, .lower);
+        return std.fmt.allocPrint(allocator, "{s}/entries/{s}/{s}", .{ self.root, hex[0..2], hex[2..] });
+    }
+
+    pub fn objectPath(self: *const ObjectCache, allocator: std.mem.Allocator, object_key: Digest, ext: []const u8) ![]u8 {
+        const hex = std.fmt.bytesToHex(object_key, .lower);
+        return std.fmt.allocPrint(allocator, "{s}/objects/{s}/{s}{s}", .{ self.root, hex[0..2], hex[2..], ext });
+    }
+
+    const Eviction = struct { count: u64, remaining_bytes: u64 };
+
+    fn evict(self: *const ObjectCache, allocator: std.mem.Allocator) !Eviction {
+        const entries_root = try std.fs.path.join(allocator, &.{ self.root, "entries" });
+        const objects_root = try std.fs.path.join(allocator, &.{ self.root, "objects" });
+        const entries = try core.fs.walkFiles(allocator, entries_root);
+        const objects = try core.fs.walkFiles(allocator, objects_root);
+
+        // Object files are named by the hex of their key minus the two-char
+        // fan-out directory; map that name back to the file for sizing.
+        var object_by_name: std.StringHashMapUnmanaged(core.fs.FileEntry) = .empty;
+        for (objects) |file| {
+            try object_by_name.put(allocator, objectName(file.path), file);
+        }
+
+        std.mem.sort(core.fs.FileEntry, entries, {}, olderFirst);
+        var referenced: std.StringHashMapUnmanaged(void) = .empty;
+        var total: u64 = 0;
+        for (entries) |file| {
+            total += file.size;
+            const name = entryObjectName(allocator, file.path) catch continue;
+            if (object_by_name.get(name)) |object| {
+                const slot = try referenced.getOrPut(allocator, name);
+                if (!slot.found_existing) total += object.size;
+            }
+        }
+
+        var evicted: u64 = 0;
+        // Objects no entry points at any more are garbage regardless of age.
+        for (objects) |file| {
+            if (referenced.contains(objectName(file.path))) continue;
+            core.fs.deleteFileIfExists(file.path) catch continue;
+            evicted += 1;
+        }
+
+        // Leave headroom so the next few builds don't evict again immediately.
+        const target = self.max_size / 10 * 9;
+        for (entries) |file| {
+            if (total <= target) break;
+            const name = entryObjectName(allocator, file.path) catch "";
+            core.fs.deleteFileIfExists(file.path) catch continue;
+            total -|= file.size;
+            if (referenced.fetchRemove(name) != null) {
+                if (object_by_name.get(name)) |object| {
+                    core.fs.deleteFileIfExists(object.path) catch {};
+                    total -|= object.size;
+                }
+            }
+            evicted += 1;
+        }
+        return .{ .count = evicted, .remaining_bytes = total };
+    }
+};
+
+/// Whether any of `paths` was modified at or after `since`, the moment a
+/// compile's key was taken. Its object may then have been built from text
+/// other than what the key and entry hash, so, as ccache does, it is not
+/// published. Inputs that cannot be stat'ed count as modified.
+pub fn modifiedSince(paths: []const []const u8, since: i128) bool {
+    for (paths) |path| {
+        const stat = core.fs.fingerprint(path) catch return true;
+        if (stat.mtime_ns >= since) return true;
+    }
+    return false;
+}
+
+/// Copies `source` next to `destination` and renames it into place so that
+/// concurrent builds never observe a partially written file.
+pub fn publishFile(allocator: std.mem.Allocator, source: []const u8, destination: []const u8) !void {
+    const temp = try tempPath(allocator, destination);
+    try core.fs.copyFile(allocator, source, temp);
+    try commitTemp(temp, destination);
+}
+
+/// Sibling path that is unique per process and call, for write-then-rename.
+pub fn tempPath(allocator: std.mem.Allocator, destination: []const u8) ![]u8 {
+    if (std.fs.path.dirname(destination)) |dir| try core.fs.ensureDir(dir);
+    const seed: u64 = @truncate(@as(u128, @bitCast(core.runtime.nowNs())));
+    return std.fmt.allocPrint(allocator, "{s}.tmp-{x}", .{ destination, std.hash.Wyhash.hash(seed, destination) });
+}
+
+pub fn commitTemp(temp: []const u8, destination: []const u8) !void {
+    core.fs.renameFile(temp, destination) catch |err| {
+        core.fs.deleteFileIfExists(temp) catch {};
+        return err;
+    };
+}
+
+fn olderFirst(_: void, a: core.fs.FileEntry, b: core.fs.FileEntry) bool {
+    return a.mtime_ns < b.mtime_ns;
+}
+
+fn objectName(path: []const u8) []const u8 {
+    const base = std.fs.path.basename(path);
+    const ext = std.fs.path.extension(base);
+    return base[0 .. base.len - ext.len];
+}
+
+fn entryObjectName(allocator: std.mem.Allocator, entry_path: []const u8) ![]const u8 {
+    const bytes = try core.fs.readFileAlloc(allocator, entry_path);
+    const entry = try parseEntry(allocator, bytes);
+    const hex = std.fmt.bytesToHex(entry.object_key, .lower);
+    return try allocator.dupe(u8, hex[2..]);
+}
+
+/// Length-prefixes each field so adjacent arguments cannot run together.
+fn hashField(hasher: *Sha256, bytes: []const u8) void {
+    var len: [8]u8 = undefined;
+    std.mem.writeInt(u64, &len, bytes.len, .little);
+    hasher.update(&len);
+    hasher.update(bytes);
+}
+
+pub fn resolveRoot(allocator: std.mem.Allocator) !?[]const u8 {
+    if (core.runtime.getEnv("OVO_CACHE_DIR")) |dir| {
+        if (dir.len > 0) return try allocator.dupe(u8, dir);
+    }
+    if (core.runtime.getEnv("XDG_CACHE_HOME")) |dir| {
+        if (dir.len > 0) return try std.fs.path.join(allocator, &.{ dir, "ovo" });
+    }
+    const home = core.runtime.getEnv("HOME") orelse core.runtime.getEnv("USERPROFILE") orelse return null;
+    return try std.fs.path.join(allocator, &.{ home, ".cache", "ovo" });
+}
+
+/// Parses `1073741824`, `512K`, `500M` or `20G` (binary units).
+pub fn parseSize(text: []const u8) ?u64 {
+    const trimmed = std.mem.trim(u8, text, " \t");
+    if (trimmed.len == 0) return null;
+    const shift: u6 = switch (std.ascii.toUpper(trimmed[trimmed.len - 1])) {
+        'K' => 10,
+        'M' => 20,
+        'G' => 30,
+        'T' => 40,
+        else => 0,
+    };
+    const digits = if (shift == 0) trimmed else trimmed[0 .. trimmed.len - 1];
+    const value = std.fmt.parseInt(u64, digits, 10) catch return null;
+    return std.math.shlExact(u64, value, shift) catch null;
+}
+
+/// Replaces the per-checkout output paths with placeholders so the same
+/// compile in another worktree (or output dir) produces the same key.
+pub fn normalizeArgv(
+    allocator: std.mem.Allocator,
+    argv: []const []const u8,
+    object: []const u8,
+    depfile_path: []const u8,
+) ![]const []const u8 {
+    const normalized = try allocator.alloc([]const u8, argv.len);
+    for (argv, 0..) |arg, i| {
+        normalized[i] = if (std.mem.endsWith(u8, arg, depfile_path))
+            try std.fmt.allocPrint(allocator, "{s}<depfile>", .{arg[0 .. arg.len - depfile_path.len]})
+        else if (std.mem.endsWith(u8, arg, object))
+            try std.fmt.allocPrint(allocator, "{s}<object>", .{arg[0 .. arg.len - object.len]})
+        else
+            arg;
+    }
+    return normalized;
+}
+
+pub const Entry = struct {
+    object_key: Digest,
+    deps: []const []const u8,
+};
+
+pub fn renderEntry(allocator: std.mem.Allocator, object_key: Digest, deps: []const []const u8) ![]u8 {
+    var out: std.ArrayList(u8) = .empty;
+    errdefer out.deinit(allocator);
+    try out.print(allocator, "{s}\nobject {s}\n", .{ entry_header, &std.fmt.bytesToHex(object_key, .lower) });
+    for (deps) |dep| try out.print(allocator, "dep {s}\n", .{dep});
+    return try out.toOwnedSlice(allocator);
+}
+
+pub fn parseEntry(allocator: std.mem.Allocator, bytes: []const u8) !Entry {
+    var lines = std.mem.splitScalar(u8, bytes, '\n');
+    const first = lines.next() orelse return error.InvalidCacheEntry;
+    if (!std.mem.eql(u8, first, entry_header)) return error.InvalidCacheEntry;
+
+    var object_key: ?Digest = null;
+    var deps: std.ArrayList([]const u8) = .empty;
+    while (lines.next()) |line| {
+        if (std.mem.startsWith(u8, line, "object ")) {
+            var key: Digest = undefined;
+            _ = std.fmt.hexToBytes(&key, line["object ".len..]) catch return error.InvalidCacheEntry;
+            object_key = key;
+        } else if (std.mem.startsWith(u8, line, "dep ")) {
+            try deps.append(allocator, line["dep ".len..]);
+        }
+    }
+    return .{
+        .object_key = object_key orelse return error.InvalidCacheEntry,
+        .deps = try deps.toOwnedSlice(allocator),
+    };
+}
+
+pub fn loadStats(allocator: std.mem.Allocator, root: []const u8) !Stats {
+    const path = try std.fs.path.join(allocator, &.{ root, stats_file });
+    defer allocator.free(path);
+    const bytes = core.fs.readFileAlloc(allocator, path) catch |err| switch (err) {
+        error.FileNotFound => return .{},
+        else => return err,
+    };
+    defer allocator.free(bytes);
+    return parseStats(bytes);
+}
+
+pub fn parseStats(bytes: []const u8) Stats {
+    var stats = Stats{};
+    var lines = std.mem.splitScalar(u8, bytes, '\n');
+    while (lines.next()) |line| {
+        var fields = std.mem.splitScalar(u8, line, ' ');
+        const name = fields.next() orelse continue;
+        const value = std.fmt.parseInt(u64, fields.next() orelse continue, 10) catch continue;
+        inline for (std.meta.fields(Stats)) |field| {
+            if (std.mem.eql(u8, name, field.name)) @field(stats, field.name) = value;
+        }
+    }
+    return stats;
+}
+
+pub fn renderStats(allocator: std.mem.Allocator, stats: Stats) ![]u8 {
+    var out: std.ArrayList(u8) = .empty;
+    errdefer out.deinit(allocator);
+    inline for (std.meta.fields(Stats)) |field| {
+        try out.print(allocator, "{s} {d}\n", .{ field.name, @field(stats, field.name) });
+    }
+    return try out.toOwnedSlice(allocator);
+}
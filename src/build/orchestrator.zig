@@ -3,6 +3,25 @@ const builtin = @import("builtin");
 const core = @import("../core/mod.zig");
 const project_mod = @import("../core/project.zig");
 const zon = @import("../zon/mod.zig");
+const job_pool = @import("job_pool.zig");
+const manifest_mod = @import("manifest.zig");
+const dep_db = @import("dep_db.zig");
+const depfile = @import("depfile.zig");
+const object_cache = @import("object_cache.zig");
+const remote_cache = @import("remote_cache.zig");
+const target_graph = @import("target_graph.zig");
+const glob = @import("glob.zig");
+const trace = @import("trace.zig");
+const pch_mod = @import("pch.zig");
+const unity_mod = @import("unity.zig");
+const modules_mod = @import("modules.zig");
+const lto = @import("lto.zig");
+const pgo = @import("pgo.zig");
+const linker_mod = @import("linker.zig");
+const backend_mod = @import("../compiler/backend.zig");
+const toolchain = @import("../compiler/toolchain.zig");
+const distributed = @import("distributed.zig");
+const schedule = @import("schedule.zig");
 
 pub const BuildOptions = struct {
     target_name: ?[]const u8 = null,
@@ -10,12 +29,26 @@ pub const BuildOptions = struct {
     optimize_override: ?[]const u8 = null,
     backend_override: ?[]const u8 = null,
     test_only: bool = false,
+    /// Maximum concurrent compile jobs; defaults to the host's idle cores.
+    jobs: ?usize = null,
+    /// Already-loaded project, so callers that inspected it first don't load it twice.
+    project: ?project_mod.Project = null,
+    /// Receives a timed event for every step of the build (`--timings`).
+    trace: ?*trace.Recorder = null,
+    /// Unity-build every target, not only those with `.unity` set.
+    unity: bool = false,
+    /// Profile-guided stage to build every target in; `pgo.train` runs both.
+    pgo: ?pgo.Stage = null,
+    /// Plan every target and write its compile database entries, but
+    /// compile and link nothing (`ovo lint`, `ovo export compile_commands`).
+    commands_only: bool = false,
 };
 
 pub const BuiltArtifact = struct {
     name: []const u8,
     kind: project_mod.TargetType,
     path: []const u8,
+    up_to_date: bool = false,
 };
 
 pub const BuildResult = struct {
@@ -24,57 +57,283 @@ pub const BuildResult = struct {
 };
 
 pub fn loadProject(allocator: std.mem.Allocator) !project_mod.Project {
-    const bytes = try core.fs.readFileAlloc(allocator, "build.zon");
-    return zon.parser.parseBuildZon(allocator, bytes);
+    return zon.snapshot.loadProject(allocator);
 }
 
-pub fn buildProject(allocator: std.mem.Allocator, options: BuildOptions) !BuildResult {
-    const project = try loadProject(allocator);
-    try core.fs.ensureDir(project.defaults.output_dir);
+/// Per-invocation state shared by every target in one `Workspace.build` call.
+/// `allocator` is scratch memory for this build; anything that outlives it
+/// goes into `workspace.allocator`.
+const BuildSession = struct {
+    allocator: std.mem.Allocator,
+    workspace: *Workspace,
+    project: *const project_mod.Project,
+    optimize: []const u8,
+    backend: []const u8,
+    jobs: usize,
+    manifest: *manifest_mod.Manifest,
+    deps: *dep_db.DepDb,
+    /// Shared object cache; null when disabled or the compiler can't be identified.
+    cache: ?*object_cache.ObjectCache,
+    cache_probed: bool = false,
+    /// The backend's compiler as `workspace.toolchain` last probed it.
+    compiler: toolchain.Probe,
+    /// `OVO_WORKERS` compiles eligible sources remotely; null when unset or
+    /// when this build's compiles must stay local.
+    workers: ?*distributed.Client = null,
+    /// Expected time and memory of every step, from `workspace.history`.
+    predictor: schedule.Predictor,
+    remote: ?*remote_cache.RemoteCache,
+    /// Shared by every target, so `-j` bounds the whole build.
+    pool: *job_pool.Pool,
+    sources: *glob.Index,
+    graph: target_graph.Graph,
+    /// Per target: compile position independent (shared libraries and the
+    /// static libraries linked into them).
+    pic: []const bool,
+    trace: ?*trace.Recorder,
+    /// `--unity`: batch every target's sources.
+    unity: bool,
+    pgo: ?pgo.Stage = null,
+    /// Where the profiles of this backend's builds are kept.
+    profile_dir: []const u8 = "",
+    linker: project_mod.Linker = .default,
+    commands_only: bool = false,
+};
 
-    var artifacts: std.ArrayList(BuiltArtifact) = .empty;
-    errdefer artifacts.deinit(allocator);
+/// Everything a build keeps besides its outputs: the project and its target
+/// graph, the build manifest, the header database, the glob index and the
+/// caches. `buildProject` opens one per call; watch mode keeps one open
+/// across rebuilds so none of it is loaded again.
+pub const Workspace = struct {
+    allocator: std.mem.Allocator,
+    project: project_mod.Project,
+    graph: target_graph.Graph,
+    pic: []const bool,
+    manifest_path: []const u8,
+    manifest: manifest_mod.Manifest,
+    deps_path: []const u8,
+    deps: dep_db.DepDb,
+    sources: glob.Index,
+    cache: ?object_cache.ObjectCache,
+    remote: ?remote_cache.RemoteCache = null,
+    /// Record every file the build reads in `inputs`.
+    track_inputs: bool = false,
+    /// Sources and headers of the last build's objects.
+    inputs: std.StringArrayHashMapUnmanaged(void) = .empty,
+    /// Compiler probes, kept in `.ovo/toolchain.zon` so a build only stats
+    /// the compiler unless it changed since the last one.
+    toolchain: toolchain.Toolchain,
+    /// Remote workers from `OVO_WORKERS`, kept across rebuilds so a host
+    /// that failed stays skipped.
+    workers: ?distributed.Client = null,
+    history_path: []const u8,
+    /// How long each step took and how much memory it needed last time.
+    history: schedule.History,
+    /// What `linker.detect` found on the first build without `.linker`.
+    detected_linker: ?project_mod.Linker = null,
 
-    const optimize = options.optimize_override orelse project.defaults.optimize;
-    const backend = options.backend_override orelse project.defaults.backend;
+    /// Heap-allocated because the remote cache points at the local one.
+    /// Uses `options.project` when set instead of loading `build.zon`.
+    pub fn open(allocator: std.mem.Allocator, options: BuildOptions) !*Workspace {
+        var started = traceStart(options.trace);
+        const project = options.project orelse try loadProject(allocator);
+        try traceFinish(options.trace, .project, started, "load build.zon", .{});
+        try core.fs.ensureDir(project.defaults.output_dir);
 
-    var built_any = false;
-    for (project.targets) |target| {
-        if (options.target_name) |target_name| {
-            if (!std.mem.eql(u8, target.name, target_name)) continue;
+        const graph = try target_graph.build(allocator, project.targets);
+        const manifest_path = try std.fmt.allocPrint(allocator, "{s}/{s}", .{ project.defaults.output_dir, manifest_mod.file_name });
+        const deps_path = try std.fmt.allocPrint(allocator, "{s}/{s}", .{ project.defaults.output_dir, dep_db.file_name });
+        const history_path = try std.fmt.allocPrint(allocator, "{s}/{s}", .{ project.defaults.output_dir, schedule.file_name });
+        started = traceStart(options.trace);
+        const manifest = try manifest_mod.Manifest.load(allocator, manifest_path);
+        const deps = dep_db.DepDb.load(allocator, deps_path);
+        try traceFinish(options.trace, .project, started, "load manifest and dependency database", .{});
+
+        const self = try allocator.create(Workspace);
+        self.* = .{
+            .allocator = allocator,
+            .project = project,
+            .graph = graph,
+            .pic = try graph.needsPic(allocator),
+            .manifest_path = manifest_path,
+            .manifest = manifest,
+            .deps_path = deps_path,
+            .deps = deps,
+            .sources = glob.Index.init(allocator, glob.default_path),
+            .cache = object_cache.ObjectCache.open(allocator) catch null,
+            .toolchain = toolchain.Toolchain.init(allocator, toolchain.cache_path),
+            .workers = try distributed.Client.fromEnv(allocator),
+            .history_path = history_path,
+            .history = schedule.History.load(allocator, history_path),
+        };
+        if (self.cache) |*cache| {
+            self.remote = remote_cache.RemoteCache.open(allocator, project.defaults.remote_cache, cache) catch null;
+        }
+        return self;
+    }
+
+    pub fn close(self: *Workspace) void {
+        self.sources.deinit();
+        if (self.workers) |*workers| workers.deinit();
+    }
+
+    pub fn build(self: *Workspace, allocator: std.mem.Allocator, options: BuildOptions) !BuildResult {
+        const project = &self.project;
+        self.sources.beginRun();
+        self.inputs.clearRetainingCapacity();
+        if (self.cache) |*cache| cache.beginBuild();
+        // Saved on every exit path so objects compiled before a failure stay reusable.
+        defer self.persist(allocator);
+
+        const roots = try allocator.alloc(bool, project.targets.len);
+        var any_root = false;
+        for (project.targets, 0..) |target, i| {
+            roots[i] = targetRequested(target, options);
+            any_root = any_root or roots[i];
         }
-        if (options.target_pattern) |pattern| {
-            if (std.mem.indexOf(u8, target.name, pattern) == null) continue;
+        if (!any_root) {
+            if (options.target_name != null) return error.TargetNotFound;
+            if (options.test_only) return error.NoTestTargets;
+            return error.NoTargets;
         }
-        if (options.test_only and target.kind != .test_target and std.mem.indexOf(u8, target.name, "test") == null) continue;
+        // Libraries the requested targets link are built too; nothing else is.
+        const selected = try self.graph.closure(allocator, roots);
 
-        const artifact_path = try buildTarget(
-            allocator,
-            &project,
-            target,
-            optimize,
-            backend,
-        );
-        try artifacts.append(allocator, .{
-            .name = target.name,
-            .kind = target.kind,
-            .path = artifact_path,
+        const backend = options.backend_override orelse project.defaults.backend;
+        const profile_dir = try pgo.profileDir(allocator, project.defaults.output_dir, backend);
+        if (options.pgo == .use and !core.fs.fileExists((try pgo.mergedProfile(allocator, profile_dir, backend)) orelse profile_dir)) {
+            return error.NoPgoProfile;
+        }
+        const optimize = options.optimize_override orelse project.defaults.optimize;
+        const compiler = try self.probeCompiler(allocator, backend);
+        // Profiles aren't part of an object's cache key, so profile-guided
+        // builds neither use nor fill the caches; nor do builds whose
+        // objects come with a `.dwo`.
+        const cached = options.pgo == null and !linker_mod.writesDwo(backend, optimize);
+        // Remote workers are kept out of the same builds, whose profiles and
+        // `.dwo` files stay on this machine; msvc can't compile a
+        // preprocessed source on its own.
+        const remote_ok = cached and compiler.found and !std.mem.eql(u8, backend, "msvc");
+        const workers = if (self.workers) |*client| (if (remote_ok) client else null) else null;
+
+        const jobs = options.jobs orelse schedule.localJobs(job_pool.defaultJobCount(), schedule.loadAverage(allocator));
+        var pool = job_pool.Pool{};
+        try pool.startLimited(.{
+            .jobs = jobs,
+            .offload_slots = if (workers) |client| client.slots() else 0,
+            .memory_budget = schedule.memoryBudget(allocator),
         });
-        built_any = true;
+        defer pool.deinit();
+
+        const linker = project.defaults.linker orelse self.detected_linker orelse detected: {
+            const found = linker_mod.detect(allocator);
+            self.detected_linker = found;
+            break :detected found;
+        };
+
+        var session = BuildSession{
+            .allocator = allocator,
+            .workspace = self,
+            .project = project,
+            .optimize = optimize,
+            .backend = backend,
+            .jobs = jobs,
+            .manifest = &self.manifest,
+            .deps = &self.deps,
+            .cache = if (self.cache) |*cache| (if (cached) cache else null) else null,
+            .compiler = compiler,
+            .workers = workers,
+            .predictor = .init(&self.history),
+            .remote = if (self.remote) |*remote| (if (cached) remote else null) else null,
+            .pool = &pool,
+            .sources = &self.sources,
+            .graph = self.graph,
+            .pic = self.pic,
+            .trace = options.trace,
+            .unity = options.unity,
+            .pgo = options.pgo,
+            .profile_dir = profile_dir,
+            .linker = linker,
+            .commands_only = options.commands_only,
+        };
+
+        var scheduler = try Scheduler.init(&session, selected);
+        defer scheduler.deinit();
+        try scheduler.run();
+
+        var artifacts: std.ArrayList(BuiltArtifact) = .empty;
+        errdefer artifacts.deinit(allocator);
+        for (project.targets, scheduler.builds) |target, built| {
+            if (!selected[built.index]) continue;
+            try artifacts.append(allocator, .{
+                .name = target.name,
+                .kind = target.kind,
+                .path = built.output,
+                .up_to_date = built.up_to_date,
+            });
+        }
+
+        const started = traceStart(options.trace);
+        try scheduler.writeCompileCommands();
+        try traceFinish(options.trace, .output, started, "write compile_commands.json", .{});
+
+        return .{
+            .project_name = project.name,
+            .artifacts = try artifacts.toOwnedSlice(allocator),
+        };
     }
 
-    if (!built_any) {
-        if (options.target_name != null) return error.TargetNotFound;
-        if (options.test_only) return error.NoTestTargets;
-        return error.NoTargets;
+    fn persist(self: *Workspace, allocator: std.mem.Allocator) void {
+        // Uploads read the build's memory, so they finish before it is released,
+        // and before the local cache's stats flush.
+        if (self.remote) |*remote| remote.finish();
+        if (self.cache) |*cache| cache.flush(allocator) catch {};
+        self.deps.save(allocator, self.deps_path) catch {};
+        self.manifest.save(allocator, self.manifest_path) catch {};
+        self.sources.save() catch {};
+        self.toolchain.save() catch {};
+        self.history.save(allocator, self.history_path) catch {};
     }
 
-    try writeCompileCommands(allocator, project);
+    /// A compiler that isn't on PATH is left for the first compile to
+    /// report; one known to reject the project's language standard fails
+    /// the build before anything is spawned.
+    fn probeCompiler(self: *Workspace, allocator: std.mem.Allocator, backend: []const u8) !toolchain.Probe {
+        const parsed = backend_mod.parseBackend(backend) orelse return error.UnsupportedCompilerBackend;
+        const probes = try self.toolchain.probe(allocator, &.{toolchain.compilerSpec(parsed)});
+        const compiler = probes[0];
+        if (parsed != .msvc and compiler.rejects(cppStandardFlag(self.project.defaults.cpp_standard))) {
+            return error.UnsupportedCppStandard;
+        }
+        return compiler;
+    }
 
-    return .{
-        .project_name = project.name,
-        .artifacts = try artifacts.toOwnedSlice(allocator),
-    };
+    fn noteInputs(self: *Workspace, paths: []const []const u8) !void {
+        if (!self.track_inputs) return;
+        const output_dir = self.project.defaults.output_dir;
+        for (paths) |path| {
+            // Generated sources only change when their own inputs do.
+            if (std.mem.startsWith(u8, path, output_dir) and path.len > output_dir.len and path[output_dir.len] == '/') continue;
+            try self.inputs.put(self.allocator, path, {});
+        }
+    }
+};
+
+pub fn buildProject(allocator: std.mem.Allocator, options: BuildOptions) !BuildResult {
+    const workspace = try Workspace.open(allocator, options);
+    defer workspace.close();
+    return workspace.build(allocator, options);
+}
+
+fn targetRequested(target: project_mod.Target, options: BuildOptions) bool {
+    if (options.target_name) |target_name| {
+        if (!std.mem.eql(u8, target.name, target_name)) return false;
+    }
+    if (options.target_pattern) |pattern| {
+        if (std.mem.indexOf(u8, target.name, pattern) == null) return false;
+    }
+    if (options.test_only and target.kind != .test_target and std.mem.indexOf(u8, target.name, "test") == null) return false;
+    return true;
 }
 
 pub fn findRunnableArtifact(result: BuildResult, requested_name: ?[]const u8) ?BuiltArtifact {
@@ -102,227 +361,1354 @@ pub fn defaultRunnableTarget(project: project_mod.Project) ?project_mod.Target {
     return null;
 }
 
-fn writeCompileCommands(allocator: std.mem.Allocator, project: project_mod.Project) !void {
-    var out: std.ArrayList(u8) = .empty;
-    errdefer out.deinit(allocator);
-    try out.appendSlice(allocator, "[\n");
+fn commandsPartPath(allocator: std.mem.Allocator, output_dir: []const u8, target: []const u8) ![]const u8 {
+    return std.fmt.allocPrint(allocator, "{s}/obj-{s}/compile_commands.part", .{ output_dir, target });
+}
 
-    var first = true;
-    for (project.targets) |target| {
-        for (target.sources) |pattern| {
-            const sources = resolveSourcePattern(allocator, pattern) catch continue;
-            for (sources) |source| {
-                if (!first) try out.appendSlice(allocator, ",\n");
-                first = false;
-                try out.print(
-                    allocator,
-                    "  {{\"directory\":\".\",\"file\":\"{s}\",\"command\":\"c++ {s} -c {s}\"}}",
-                    .{ source, cppStandardFlag(project.defaults.cpp_standard), source },
-                );
-            }
-        }
+/// Every target's compile database entries, in project order, each one the
+/// body of a JSON array: exactly the compiles `ovo build` would run. The
+/// targets are planned first, compiling nothing, so code that doesn't
+/// build is described all the same. Where planning fails, e.g. a target
+/// without sources, the entries last written are used; a target that has
+/// none gets "".
+pub fn commandParts(allocator: std.mem.Allocator, project: project_mod.Project) ![]const []const u8 {
+    _ = buildProject(allocator, .{ .project = project, .commands_only = true }) catch |err| switch (err) {
+        error.OutOfMemory => return err,
+        else => {},
+    };
+    const parts = try allocator.alloc([]const u8, project.targets.len);
+    for (project.targets, parts) |target, *part| {
+        part.* = (try readPart(allocator, project.defaults.output_dir, target.name)) orelse "";
     }
-    try out.appendSlice(allocator, "\n]\n");
+    return parts;
+}
 
-    const path = try std.fmt.allocPrint(allocator, "{s}/compile_commands.json", .{project.defaults.output_dir});
-    try core.fs.writeFile(path, out.items);
+fn readPart(allocator: std.mem.Allocator, output_dir: []const u8, target: []const u8) !?[]const u8 {
+    return core.fs.readFileAllocUnlimited(allocator, try commandsPartPath(allocator, output_dir, target)) catch |err| switch (err) {
+        error.FileNotFound => null,
+        else => return err,
+    };
 }
 
-fn buildTarget(
+/// One `arguments`-style compile database entry, so no argument needs
+/// shell quoting; `first` leaves out the separator.
+pub fn appendCommandEntry(
     allocator: std.mem.Allocator,
-    project: *const project_mod.Project,
-    target: project_mod.Target,
-    optimize: []const u8,
-    backend: []const u8,
-) ![]const u8 {
-    var resolved_sources_list: std.ArrayList([]const u8) = .empty;
-    errdefer resolved_sources_list.deinit(allocator);
+    out: *std.ArrayList(u8),
+    cwd: []const u8,
+    file: []const u8,
+    argv: []const []const u8,
+    object: []const u8,
+    first: bool,
+) !void {
+    if (!first) try out.appendSlice(allocator, ",\n");
+    try out.print(allocator, "  {{\"directory\":\"{f}\",\"file\":\"{f}\",\"arguments\":[", .{ trace.jsonString(cwd), trace.jsonString(file) });
+    for (argv, 0..) |arg, i| {
+        if (i > 0) try out.append(allocator, ',');
+        try out.print(allocator, "\"{f}\"", .{trace.jsonString(arg)});
+    }
+    try out.print(allocator, "],\"output\":\"{f}\"}}", .{trace.jsonString(object)});
+}
+
+/// Packs the owner of a pool job into `Job.tag`.
+const JobTag = packed struct(u64) {
+    target: u32,
+    /// Index into `TargetBuild.pending`, `link_item` or `pch_item`.
+    item: u32,
+
+    const link_item = std.math.maxInt(u32);
+    const pch_item = link_item - 1;
+
+    fn encode(target: usize, item: usize) u64 {
+        return @bitCast(JobTag{ .target = @intCast(target), .item = @intCast(item) });
+    }
+};
+
+/// Scheduling state of one target in the build graph.
+const TargetBuild = struct {
+    index: usize,
+    state: State = .idle,
+    output: []const u8 = "",
+    /// Set once `sources`, `output` and `obj_dir` are known.
+    resolved: bool = false,
+    sources: []const []const u8 = &.{},
+    obj_dir: []const u8 = "",
+    objects: []const []const u8 = &.{},
+    /// Compiler and flags every compile of the target starts with, built
+    /// once rather than per source.
+    compile_flags: ?[]const []const u8 = null,
+    /// Compiles submitted so far, indexed by `JobTag.item`.
+    pending: std.ArrayList(PendingObject) = .empty,
+    published: std.ArrayList(object_cache.ObjectCache.Published) = .empty,
+    /// Compile jobs submitted and not yet handed back by the pool.
+    compiling: usize = 0,
+    /// Compile jobs submitted in total.
+    compiled: usize = 0,
+    /// Sources waiting for modules they import to be built, and per source
+    /// how many of those modules are missing.
+    blocked: usize = 0,
+    module_waits: []u32 = &.{},
+    /// Objects restored from a cache instead of compiled.
+    restored: usize = 0,
+    /// In-project libraries this target links that are not linked yet.
+    waiting_on: usize = 0,
+    link_job: job_pool.Job = .{ .label = "", .argv = &.{} },
+    link_inputs: []const []const u8 = &.{},
+    up_to_date: bool = false,
+    /// Trace events of this target's compiles and link, for `after` lists.
+    compile_events: std.ArrayList(usize) = .empty,
+    link_event: ?usize = null,
+    /// The target's precompiled header; compiles wait while it is rebuilt.
+    pch: ?pch_mod.Plan = null,
+    pch_job: job_pool.Job = .{ .label = "", .argv = &.{} },
+    pch_pending: PendingObject = undefined,
+    pch_event: ?usize = null,
+    pch_headers: []const []const u8 = &.{},
+    /// The sources of each generated unity source, for the compile database.
+    unity_members: std.StringHashMapUnmanaged([]const []const u8) = .empty,
+
+    const State = enum { idle, precompiling, compiling, linking, done };
+};
+
+/// Compile jobs of one scheduling step of a target, before they are submitted.
+const Round = struct {
+    compile_jobs: std.ArrayList(job_pool.Job) = .empty,
+    pending: std.ArrayList(PendingObject) = .empty,
+};
+
+/// Named modules of the build: where each one's interface is built and the
+/// compiles waiting for it.
+const ModuleState = struct {
+    /// Built interfaces, one directory per backend and optimize mode.
+    dir: []const u8,
+    /// gcc's module mapper, naming every interface in `dir`.
+    map: []const u8,
+    /// Scan of every source that provides or imports a module, by object.
+    scans: std.StringHashMapUnmanaged(modules_mod.Scan) = .empty,
+    providers: std.StringArrayHashMapUnmanaged(Provider) = .empty,
+    /// Sources whose last missing module was just built.
+    released: std.ArrayList(SourceRef) = .empty,
 
-    for (target.sources) |source_pattern| {
-        const expanded = try resolveSourcePattern(allocator, source_pattern);
-        for (expanded) |resolved| {
-            try resolved_sources_list.append(allocator, resolved);
+    const Provider = struct {
+        bmi: []const u8,
+        built: bool = false,
+        event: ?usize = null,
+        waiters: std.ArrayList(SourceRef) = .empty,
+    };
+};
+
+const SourceRef = struct { target: usize, source: usize };
+
+/// Scan bookkeeping until its job finishes.
+const PendingScan = struct {
+    object: []const u8,
+    ddi: []const u8,
+    source: []const u8,
+    argv_hash: u64,
+    inputs: []const []const u8,
+};
+
+/// Drives every selected target through compile and link on the shared pool.
+/// Compiles never wait on other targets, except for named modules they
+/// import and, within a target, a stale precompiled header; a link starts
+/// once the target's objects exist and every library it links has been
+/// linked. All bookkeeping runs on the calling thread, so the manifest,
+/// dependency database and caches need no locking.
+const Scheduler = struct {
+    session: *BuildSession,
+    builds: []TargetBuild,
+    first_error: ?anyerror = null,
+    modules: ?ModuleState = null,
+    /// Reset for every source's up-to-date check, so a no-op build of many
+    /// sources doesn't keep an argv per source.
+    scratch: std.heap.ArenaAllocator,
+    /// Per target, `schedule.chainTimes` of the predicted links.
+    chain_ns: []const u64,
+
+    fn init(session: *BuildSession, selected: []const bool) !Scheduler {
+        const allocator = session.allocator;
+        const targets = session.graph.targets;
+        const builds = try allocator.alloc(TargetBuild, targets.len);
+        const link_ns = try allocator.alloc(u64, targets.len);
+        for (builds, link_ns, 0..) |*build, *predicted, i| {
+            build.* = .{ .index = i, .state = if (selected[i]) .idle else .done };
+            if (selected[i]) build.waiting_on = session.graph.deps[i].len;
+            const output = try artifactPath(allocator, session.project.defaults.output_dir, targets[i]);
+            predicted.* = if (selected[i]) session.predictor.predict(output).wall_ns else 0;
         }
+        return .{
+            .session = session,
+            .builds = builds,
+            .scratch = .init(core.memory.page_allocator),
+            .chain_ns = try schedule.chainTimes(allocator, session.graph, link_ns),
+        };
     }
 
-    const sources = resolved_sources_list.items;
-    if (sources.len == 0) return error.NoSources;
+    fn deinit(self: *Scheduler) void {
+        self.scratch.deinit();
+    }
 
-    const output = try artifactPath(allocator, project.defaults.output_dir, target);
+    fn run(self: *Scheduler) !void {
+        try self.scanModules();
+        for (self.session.graph.order) |index| {
+            if (self.builds[index].state != .idle) continue;
+            self.startTarget(&self.builds[index]) catch |err| {
+                self.fail(err);
+                break;
+            };
+        }
+        while (self.session.pool.wait()) |job| {
+            defer job_pool.freeOutputs(job[0..1]);
+            self.jobFinished(job) catch |err| self.fail(err);
+        }
+        if (self.first_error) |err| return err;
+        // Only sources importing each other's modules wait forever.
+        for (self.builds) |build| {
+            if (build.state != .done) return error.ModuleCycle;
+        }
+    }
 
-    switch (target.kind) {
-        .executable, .test_target => {
-            try compileAndLinkExecutable(
-                allocator,
-                sources,
-                target.include_dirs,
-                target.link_libraries,
-                optimize,
-                project.defaults.cpp_standard,
-                backend,
-                output,
-            );
-        },
-        .library_shared => {
-            try compileSharedLibrary(
-                allocator,
-                sources,
-                target.include_dirs,
-                target.link_libraries,
-                optimize,
-                project.defaults.cpp_standard,
-                backend,
-                output,
-            );
-        },
-        .library_static => {
-            try compileStaticLibrary(
-                allocator,
-                sources,
-                target.include_dirs,
-                optimize,
-                project.defaults.cpp_standard,
-                backend,
-                output,
-                project.defaults.output_dir,
-                target.name,
-            );
-        },
+    fn fail(self: *Scheduler, err: anyerror) void {
+        if (self.first_error == null) self.first_error = err;
+        // Jobs already running finish; nothing new starts.
+        self.session.pool.cancelQueued();
+    }
+
+    fn resolveTarget(self: *Scheduler, build: *TargetBuild) !void {
+        if (build.resolved) return;
+        const session = self.session;
+        const allocator = session.allocator;
+        const project = session.project;
+        const target = session.graph.targets[build.index];
+
+        const started = traceStart(session.trace);
+        const sources = try session.sources.resolveSources(target.sources);
+        try traceFinish(session.trace, .glob, started, "resolve sources of {s}", .{target.name});
+        if (sources.len == 0) return error.NoSources;
+
+        build.output = try artifactPath(allocator, project.defaults.output_dir, target);
+        build.sources = sources;
+        build.obj_dir = try std.fmt.allocPrint(allocator, "{s}/obj-{s}", .{ project.defaults.output_dir, target.name });
+        try core.fs.ensureDir(build.obj_dir);
+        build.resolved = true;
+    }
+
+    fn compileFlags(self: *Scheduler, build: *TargetBuild) ![]const []const u8 {
+        if (build.compile_flags) |flags| return flags;
+        const session = self.session;
+        const allocator = session.allocator;
+        const backend = session.backend;
+        const target = session.graph.targets[build.index];
+        var flags: std.ArrayList([]const u8) = .empty;
+        try appendCompilerPrefix(allocator, &flags, backend);
+        if (session.pic[build.index] and !std.mem.eql(u8, backend, "msvc")) try flags.append(allocator, "-fPIC");
+        try appendCommonCompileFlags(allocator, &flags, session.optimize, session.project.defaults.cpp_standard, target.include_dirs, backend);
+        try linker_mod.appendCompileFlags(allocator, &flags, backend, session.optimize, session.linker);
+        if (lto.active(target.lto, session.optimize)) |mode| try lto.appendCompileFlags(allocator, &flags, mode, backend);
+        if (session.pgo) |stage| try pgo.appendCompileFlags(allocator, &flags, stage, backend, session.profile_dir);
+        build.compile_flags = flags.items;
+        return flags.items;
+    }
+
+    fn objectPath(self: *Scheduler, build: *const TargetBuild, source: []const u8) ![]const u8 {
+        const allocator = self.session.allocator;
+        const name = try manifest_mod.objectFileName(allocator, source, objectExtension(self.session.backend));
+        return std.fs.path.join(allocator, &.{ build.obj_dir, name });
+    }
+
+    /// Scans every source of the selected targets for the named modules it
+    /// provides and imports, when any of them is a module interface unit.
+    /// Scans are kept next to the objects and redone only when the source,
+    /// its headers or its flags change.
+    fn scanModules(self: *Scheduler) !void {
+        const session = self.session;
+        const allocator = session.allocator;
+        const backend = session.backend;
+        const standard = session.project.defaults.cpp_standard;
+        if (!modules_mod.supported(standard, backend)) return;
+
+        var any_interface = false;
+        for (self.builds) |*build| {
+            if (build.state != .idle) continue;
+            try self.resolveTarget(build);
+            for (build.sources) |source| any_interface = any_interface or modules_mod.isInterfaceUnit(source);
+        }
+        if (!any_interface) return;
+
+        const dir = try std.fmt.allocPrint(allocator, "{s}/modules/{s}-{s}", .{ session.project.defaults.output_dir, backend, session.optimize });
+        try core.fs.ensureDir(dir);
+        self.modules = .{ .dir = dir, .map = try std.fmt.allocPrint(allocator, "{s}/module.map", .{dir}) };
+
+        var jobs: std.ArrayList(job_pool.Job) = .empty;
+        var scans: std.ArrayList(PendingScan) = .empty;
+        for (self.builds) |*build| {
+            if (build.state != .idle) continue;
+            const compile = try self.compileFlags(build);
+            for (build.sources) |source| {
+                const object = try self.objectPath(build, source);
+                const ddi = try modules_mod.scanPath(allocator, object);
+                var argv: std.ArrayList([]const u8) = .empty;
+                try modules_mod.appendScanArgv(allocator, &argv, compile, source, object, ddi, backend);
+                const argv_hash = manifest_mod.hashArgv(argv.items);
+
+                var inputs: std.ArrayList([]const u8) = .empty;
+                try inputs.append(allocator, source);
+                _ = try session.deps.collect(allocator, object, &inputs);
+                if (session.manifest.objectUpToDate(ddi, argv_hash, manifest_mod.fingerprintInputs(inputs.items))) {
+                    try self.addScan(object, ddi);
+                    continue;
+                }
+                try jobs.append(allocator, .{
+                    .label = source,
+                    .argv = argv.items,
+                    .stdout_path = if (std.mem.eql(u8, backend, "clang")) ddi else null,
+                });
+                try scans.append(allocator, .{ .object = object, .ddi = ddi, .source = source, .argv_hash = argv_hash, .inputs = inputs.items });
+            }
+        }
+
+        for (jobs.items) |*job| try session.pool.submit(job);
+        var failed = false;
+        while (session.pool.wait()) |job| {
+            defer job_pool.freeOutputs(job[0..1]);
+            _ = try self.traceJob(job, .scan, &.{});
+            if (!job.finished or job.exit_code != 0) failed = true;
+        }
+        if (failed) return error.ModuleScanFailed;
+
+        const owned = session.workspace.allocator;
+        for (scans.items) |scan| {
+            try self.addScan(scan.object, scan.ddi);
+            const inputs_hash = manifest_mod.fingerprintInputs(scan.inputs) orelse continue;
+            try session.manifest.recordObject(owned, try owned.dupe(u8, scan.ddi), .{
+                .source = try owned.dupe(u8, scan.source),
+                .argv_hash = scan.argv_hash,
+                .inputs_hash = inputs_hash,
+            });
+        }
+
+        if (std.mem.eql(u8, backend, "gcc")) {
+            const modules = &self.modules.?;
+            const bmis = try allocator.alloc([]const u8, modules.providers.count());
+            for (bmis, modules.providers.values()) |*bmi, provider| bmi.* = provider.bmi;
+            try writeIfChanged(allocator, modules.map, try modules_mod.renderModuleMap(allocator, modules.providers.keys(), bmis));
+        }
+    }
+
+    fn addScan(self: *Scheduler, object: []const u8, ddi: []const u8) !void {
+        const allocator = self.session.allocator;
+        const modules = &self.modules.?;
+        const scan = modules_mod.parseP1689(allocator, try core.fs.readFileAlloc(allocator, ddi)) catch |err| {
+            if (err == error.OutOfMemory) return err;
+            return error.ModuleScanFailed;
+        };
+        if (!scan.usesModules()) return;
+        try modules.scans.put(allocator, object, scan);
+        for (scan.provides) |module| {
+            const entry = try modules.providers.getOrPut(allocator, module.name);
+            if (entry.found_existing) return error.DuplicateModule;
+            entry.value_ptr.* = .{ .bmi = try modules_mod.bmiPath(allocator, modules.dir, module.name, self.session.backend) };
+        }
+    }
+
+    fn scanOf(self: *Scheduler, object: []const u8) ?modules_mod.Scan {
+        const modules = self.modules orelse return null;
+        return modules.scans.get(object);
+    }
+
+    /// Records that `source` of `build` must wait for the modules it imports
+    /// that are not built yet. Returns whether it has to.
+    fn waitForModules(self: *Scheduler, build: *TargetBuild, source: usize) !bool {
+        const scan = self.scanOf(build.objects[source]) orelse return false;
+        const modules = &self.modules.?;
+        var waits: u32 = 0;
+        for (scan.requires) |name| {
+            // Modules from outside the build are the compiler's business.
+            const provider = modules.providers.getPtr(name) orelse continue;
+            if (provider.built) continue;
+            try provider.waiters.append(self.session.allocator, .{ .target = build.index, .source = source });
+            waits += 1;
+        }
+        if (waits == 0) return false;
+        build.module_waits[source] = waits;
+        build.blocked += 1;
+        return true;
+    }
+
+    /// Marks the modules provided by `object`'s source as built and queues
+    /// the sources that were waiting only for them.
+    fn modulesBuilt(self: *Scheduler, object: []const u8, event: ?usize) !void {
+        const scan = self.scanOf(object) orelse return;
+        const modules = &self.modules.?;
+        for (scan.provides) |module| {
+            const provider = modules.providers.getPtr(module.name).?;
+            provider.built = true;
+            provider.event = event;
+            for (provider.waiters.items) |waiter| {
+                const waits = &self.builds[waiter.target].module_waits[waiter.source];
+                waits.* -= 1;
+                if (waits.* == 0) try modules.released.append(self.session.allocator, waiter);
+            }
+            provider.waiters.clearRetainingCapacity();
+        }
+    }
+
+    /// Compiles sources whose imported modules have all been built.
+    fn startReleased(self: *Scheduler) !void {
+        const modules = if (self.modules) |*modules| modules else return;
+        while (modules.released.pop()) |waiter| {
+            const build = &self.builds[waiter.target];
+            build.blocked -= 1;
+            if (self.first_error != null) continue;
+            var round: Round = .{};
+            try self.planCompile(build, waiter.source, &round);
+            try self.submitRound(build, &round);
+            try self.compileStepDone(build);
+        }
+    }
+
+    fn startTarget(self: *Scheduler, build: *TargetBuild) !void {
+        const session = self.session;
+        const target = session.graph.targets[build.index];
+        build.state = .compiling;
+        try self.resolveTarget(build);
+        if (unity_mod.batchSize(target.unity, target.unity_batch, session.unity)) |size| {
+            build.sources = try self.unitySources(build, target, size);
+        }
+
+        if (target.pch) |header| {
+            if (try self.startPrecompile(build, header)) return;
+        }
+        try self.startCompiles(build);
+    }
+
+    /// Replaces batches of the target's sources with generated unity sources.
+    /// A unity source is rewritten only when its batch changes, so the other
+    /// batches stay up to date. Excluded sources and batches of one source
+    /// compile as they are.
+    fn unitySources(self: *Scheduler, build: *TargetBuild, target: project_mod.Target, size: usize) ![]const []const u8 {
+        const session = self.session;
+        const allocator = session.allocator;
+
+        var excluded: std.StringHashMapUnmanaged(void) = .empty;
+        if (target.unity_exclude.len > 0) {
+            for (try session.sources.resolveSources(target.unity_exclude)) |path| try excluded.put(allocator, path, {});
+        }
+        var units: std.ArrayList([]const u8) = .empty;
+        var batched: std.ArrayList([]const u8) = .empty;
+        for (build.sources) |source| {
+            // Module units must stay separate translation units.
+            if (excluded.contains(source) or self.scanOf(try self.objectPath(build, source)) != null) {
+                try units.append(allocator, source);
+            } else {
+                try batched.append(allocator, source);
+            }
+        }
+
+        const dir = try std.fs.path.join(allocator, &.{ build.obj_dir, "unity" });
+        try core.fs.ensureDir(dir);
+        const prefix = try unity_mod.includePrefix(allocator, dir, try core.fs.currentPathAlloc(allocator));
+        const ext = if (project_mod.isCStandard(session.project.defaults.cpp_standard)) ".c" else ".cpp";
+        for (try unity_mod.batches(allocator, batched.items, size)) |members| {
+            if (members.len == 1) {
+                try units.append(allocator, members[0]);
+                continue;
+            }
+            const path = try unity_mod.unitPath(allocator, dir, members[0], ext);
+            try writeIfChanged(allocator, path, try unity_mod.render(allocator, members, prefix));
+            try units.append(allocator, path);
+            try build.unity_members.put(allocator, path, members);
+        }
+        return try units.toOwnedSlice(allocator);
+    }
+
+    /// Plans the target's precompiled header and submits its compile when it
+    /// is stale. Returns whether the target's compiles must wait for it.
+    fn startPrecompile(self: *Scheduler, build: *TargetBuild, header: []const u8) !bool {
+        const session = self.session;
+        const allocator = session.allocator;
+        const backend = session.backend;
+
+        const dir = try std.fs.path.join(allocator, &.{ build.obj_dir, "pch" });
+        try core.fs.ensureDir(dir);
+        const cwd = if (std.mem.eql(u8, backend, "msvc")) try core.fs.currentPathAlloc(allocator) else "";
+        const pch = try pch_mod.plan(allocator, dir, header, backend, cwd);
+        build.pch = pch;
+        if (session.commands_only) return false;
+
+        const dep_format = depfile.formatForBackend(backend);
+        const dep_path = try depfile.pathForObject(allocator, pch.output, dep_format);
+        var argv: std.ArrayList([]const u8) = .empty;
+        try argv.appendSlice(allocator, try self.compileFlags(build));
+        try depfile.appendFlags(allocator, &argv, dep_path, dep_format);
+        try pch_mod.appendCreateFlags(allocator, &argv, pch, session.project.defaults.cpp_standard, backend);
+        const argv_hash = manifest_mod.hashArgv(argv.items);
+
+        // The PCH is tracked like an object keyed by its output path.
+        var inputs: std.ArrayList([]const u8) = .empty;
+        try inputs.append(allocator, header);
+        const recorded = try session.deps.collect(allocator, pch.output, &inputs);
+        try session.workspace.noteInputs(inputs.items);
+        if (recorded) {
+            const inputs_hash = manifest_mod.fingerprintInputs(inputs.items);
+            if (session.manifest.objectUpToDate(pch.output, argv_hash, inputs_hash)) return false;
+        }
+        const statted_ns = core.runtime.wallClockNs();
+        const before = try manifest_mod.statInputs(allocator, inputs.items);
+
+        if (pch.stub_source) |stub| try core.fs.writeFile(stub, try pch_mod.stubSource(allocator, pch));
+        build.pch_pending = .{
+            .object = pch.output,
+            .source = header,
+            .depfile = dep_path,
+            .argv_hash = argv_hash,
+            .cache_key = null,
+            .before = before,
+            .statted_ns = statted_ns,
+        };
+        const predicted = session.predictor.predict(pch.output);
+        build.pch_job = .{
+            .label = header,
+            .argv = argv.items,
+            .tag = JobTag.encode(build.index, JobTag.pch_item),
+            // Every compile of the target waits for it.
+            .priority = std.math.maxInt(u64),
+            .predicted_ns = predicted.wall_ns,
+            .predicted_rss = predicted.peak_rss,
+            .log_path = try std.fmt.allocPrint(allocator, "{s}.log", .{pch.output}),
+        };
+        build.state = .precompiling;
+        try session.pool.submit(&build.pch_job);
+        return true;
+    }
+
+    /// Checks every source of the target against the manifest and the
+    /// caches, and submits compiles for the rest. Sources importing modules
+    /// that are not built yet are planned once they are.
+    fn startCompiles(self: *Scheduler, build: *TargetBuild) !void {
+        const session = self.session;
+        const allocator = session.allocator;
+        const target = session.graph.targets[build.index];
+        const sources = build.sources;
+        build.state = .compiling;
+
+        // Every object also depends on what went into the PCH.
+        if (build.pch) |pch| {
+            var pch_headers: std.ArrayList([]const u8) = .empty;
+            _ = try session.deps.collect(allocator, pch.output, &pch_headers);
+            build.pch_headers = pch_headers.items;
+        }
+        const stub_object: ?[]const u8 = if (build.pch) |pch| pch.stub_object else null;
+
+        const objects = try allocator.alloc([]const u8, sources.len + @intFromBool(stub_object != null));
+        for (sources, 0..) |source, i| objects[i] = try self.objectPath(build, source);
+        if (stub_object) |object| objects[sources.len] = object;
+        build.objects = objects;
+        build.module_waits = try allocator.alloc(u32, sources.len);
+        @memset(build.module_waits, 0);
+        // Written before anything compiles, so a tree that doesn't build
+        // still has its compiles described.
+        try self.writeCommandsPart(build);
+        if (session.commands_only) {
+            build.state = .done;
+            return;
+        }
+
+        // Up-to-date checks and every cache tier count as the lookup.
+        const started = traceStart(session.trace);
+        var round: Round = .{};
+        for (0..sources.len) |i| {
+            if (try self.waitForModules(build, i)) continue;
+            try self.planCompile(build, i, &round);
+        }
+        try self.submitRound(build, &round);
+        try traceFinish(session.trace, .cache, started, "check and fetch objects of {s}", .{target.name});
+
+        try self.compileStepDone(build);
+        try self.startReleased();
+    }
+
+    /// Adds a compile of `source` to `round` unless its object is up to date
+    /// or in the local cache.
+    fn planCompile(self: *Scheduler, build: *TargetBuild, source_index: usize, round: *Round) !void {
+        const session = self.session;
+        const allocator = session.allocator;
+        const backend = session.backend;
+        const source = build.sources[source_index];
+        const object = build.objects[source_index];
+        const dep_path = try depfile.pathForObject(allocator, object, depfile.formatForBackend(backend));
+        // Only what a compile job keeps is copied out of the scratch arena.
+        _ = self.scratch.reset(.retain_capacity);
+        const scratch = self.scratch.allocator();
+
+        // Fingerprinted on top of the source and its headers.
+        var extra_inputs: std.ArrayList([]const u8) = .empty;
+        // A rebuilt PCH invalidates every object compiled against it.
+        if (build.pch) |pch| try extra_inputs.append(allocator, pch.output);
+        // So does a retrained profile.
+        if (session.pgo == .use) {
+            if (try pgo.mergedProfile(allocator, session.profile_dir, backend)) |profile| try extra_inputs.append(allocator, profile);
+        }
+        var bmi: ?[]const u8 = null;
+        const scan = self.scanOf(object);
+        if (scan) |units| {
+            const modules = &self.modules.?;
+            if (units.provides.len > 0) bmi = modules.providers.get(units.provides[0].name).?.bmi;
+            // So does a rebuilt interface of an imported module.
+            for (units.requires) |name| {
+                if (modules.providers.get(name)) |provider| try extra_inputs.append(allocator, provider.bmi);
+            }
+        }
+
+        const argv = try self.sourceArgv(build, source_index, dep_path, scratch);
+        const argv_hash = manifest_mod.hashArgv(argv);
+
+        var inputs: std.ArrayList([]const u8) = .empty;
+        try inputs.append(scratch, source);
+        // Objects without a dependency record predate header tracking and
+        // must be rebuilt once to learn their includes.
+        const recorded = try session.deps.collect(scratch, object, &inputs);
+        try session.workspace.noteInputs(inputs.items);
+        try inputs.appendSlice(scratch, extra_inputs.items);
+        if (recorded) {
+            const inputs_hash = manifest_mod.fingerprintInputs(inputs.items);
+            const bmi_present = if (bmi) |path| core.fs.fileExists(path) else true;
+            if (bmi_present and session.manifest.objectUpToDate(object, argv_hash, inputs_hash)) {
+                return self.modulesBuilt(object, null);
+            }
+        }
+        // What the object is recorded against, so an input saved while it
+        // compiles leaves it stale instead of matching the newer text.
+        const statted_ns = core.runtime.wallClockNs();
+        const before = try manifest_mod.statInputs(allocator, inputs.items);
+
+        // Module units are never cached: the cache holds objects, not the
+        // interfaces built with them.
+        var cache_key: ?object_cache.Digest = null;
+        if (scan == null) {
+            if (try objectCache(session)) |cache| {
+                const normalized = try object_cache.normalizeArgv(scratch, argv, object, dep_path);
+                cache_key = try cache.entryKey(scratch, normalized, source);
+                if (cache_key) |key| {
+                    if (try cache.fetch(allocator, key, object)) |cached_deps| {
+                        try recordObject(session, object, source, argv_hash, cached_deps, extra_inputs.items, &before, statted_ns);
+                        build.restored += 1;
+                        return;
+                    }
+                }
+            }
+        }
+
+        // The longest compiles on the longest chain of links start first.
+        const predicted = session.predictor.predict(object);
+        var job = job_pool.Job{
+            .label = source,
+            .argv = try dupeArgv(allocator, argv),
+            .priority = predicted.wall_ns + self.chain_ns[build.index],
+            .predicted_ns = predicted.wall_ns,
+            .predicted_rss = predicted.peak_rss,
+            .log_path = try std.fmt.allocPrint(allocator, "{s}.log", .{object}),
+        };
+        // Only plain TUs travel: a PCH or module interface is local state.
+        if (scan == null and build.pch == null) {
+            if (session.workers) |workers| job.offload = try workers.task(allocator, job.argv, session.compiler, object);
+        }
+        try round.compile_jobs.append(allocator, job);
+        try round.pending.append(allocator, .{
+            .object = object,
+            .source = source,
+            .depfile = dep_path,
+            .argv_hash = argv_hash,
+            .cache_key = cache_key,
+            .pch_output = if (build.pch) |pch| pch.output else null,
+            .pch_headers = build.pch_headers,
+            .extra_inputs = extra_inputs.items,
+            .before = before,
+            .statted_ns = statted_ns,
+        });
+    }
+
+    /// The compile of `build.sources[source_index]`, exactly as `planCompile`
+    /// runs it.
+    fn sourceArgv(
+        self: *Scheduler,
+        build: *TargetBuild,
+        source_index: usize,
+        dep_path: []const u8,
+        allocator: std.mem.Allocator,
+    ) ![]const []const u8 {
+        const backend = self.session.backend;
+        const source = build.sources[source_index];
+        const object = build.objects[source_index];
+        var module_flags: std.ArrayList([]const u8) = .empty;
+        if (self.scanOf(object)) |units| {
+            const modules = &self.modules.?;
+            const provided: ?modules_mod.Provided = if (units.provides.len > 0) units.provides[0] else null;
+            const bmi = if (provided) |module| modules.providers.get(module.name).?.bmi else null;
+            try modules_mod.appendCompileFlags(allocator, &module_flags, source, provided, bmi, modules.dir, modules.map, backend);
+        }
+        return compileObjectArgv(
+            allocator,
+            source,
+            object,
+            dep_path,
+            try self.compileFlags(build),
+            backend,
+            build.pch,
+            module_flags.items,
+        );
     }
 
-    return output;
+    /// Writes the target's entries to `compile_commands.part` in its object
+    /// directory, once its compiles are planned, unless they are unchanged.
+    fn writeCommandsPart(self: *Scheduler, build: *TargetBuild) !void {
+        const session = self.session;
+        const allocator = session.allocator;
+        const cwd = try core.fs.currentPathAlloc(allocator);
+        const part = try commandsPartPath(allocator, session.project.defaults.output_dir, session.graph.targets[build.index].name);
+        const part_hash = try self.emitCommands(build, cwd, null);
+        if (session.manifest.artifactUpToDate(part, part_hash)) return;
+        const file = try core.fs.AtomicFile.create(allocator, part);
+        _ = self.emitCommands(build, cwd, file.writer()) catch |err| {
+            file.abort();
+            return err;
+        };
+        try self.commitCommands(file, part_hash);
+    }
+
+    /// Writes `<output_dir>/compile_commands.json` with every translation
+    /// unit's exact compile, streamed together from the targets' parts, so
+    /// targets this build didn't touch keep theirs. It is rewritten only
+    /// when one of them changed: an unchanged database keeps its mtime, and
+    /// editors don't reindex.
+    fn writeCompileCommands(self: *Scheduler) !void {
+        const session = self.session;
+        const allocator = session.allocator;
+        const output_dir = session.project.defaults.output_dir;
+
+        var parts: std.ArrayList([]const u8) = .empty;
+        var hasher = std.hash.Wyhash.init(0);
+        for (session.project.targets) |target| {
+            const part = try commandsPartPath(allocator, output_dir, target.name);
+            const part_hash = session.manifest.artifacts.get(part) orelse continue;
+            hasher.update(part);
+            hasher.update(std.mem.asBytes(&part_hash));
+            try parts.append(allocator, part);
+        }
+        const path = try std.fmt.allocPrint(allocator, "{s}/compile_commands.json", .{output_dir});
+        const hash = hasher.final();
+        if (session.manifest.artifactUpToDate(path, hash)) return;
+        const file = try core.fs.AtomicFile.create(allocator, path);
+        self.joinParts(parts.items, file.writer()) catch |err| {
+            file.abort();
+            return err;
+        };
+        try self.commitCommands(file, hash);
+    }
+
+    /// Moves `file` into place and records `hash` as what it holds.
+    fn commitCommands(self: *Scheduler, file: *core.fs.AtomicFile, hash: u64) !void {
+        try file.finish();
+        const owned = self.session.workspace.allocator;
+        try self.session.manifest.recordArtifact(owned, try owned.dupe(u8, file.path), hash);
+    }
+
+    /// Renders the target's entries, one per translation unit and one per
+    /// source of a unity batch (compiled on its own with the batch's
+    /// flags, which is what an editor needs), to `out` when set. Returns
+    /// their hash.
+    fn emitCommands(self: *Scheduler, build: *TargetBuild, cwd: []const u8, out: ?*std.Io.Writer) !u64 {
+        const dep_format = depfile.formatForBackend(self.session.backend);
+        var hasher = std.hash.Wyhash.init(0);
+        var first = true;
+        for (build.sources, 0..) |source, i| {
+            // One entry in memory at a time, however large the target.
+            _ = self.scratch.reset(.retain_capacity);
+            const scratch = self.scratch.allocator();
+            const object = build.objects[i];
+            const argv = try self.sourceArgv(build, i, try depfile.pathForObject(scratch, object, dep_format), scratch);
+            var entry: std.ArrayList(u8) = .empty;
+            try appendCommandEntry(scratch, &entry, cwd, source, argv, object, first);
+            for (build.unity_members.get(source) orelse &.{}) |member| {
+                const member_argv = try scratch.dupe([]const u8, argv);
+                for (member_argv) |*arg| {
+                    if (std.mem.eql(u8, arg.*, source)) arg.* = member;
+                }
+                try appendCommandEntry(scratch, &entry, cwd, member, member_argv, object, false);
+            }
+            first = false;
+            hasher.update(entry.items);
+            if (out) |writer| try writer.writeAll(entry.items);
+        }
+        return hasher.final();
+    }
+
+    /// The database: the parts' entries inside one array.
+    fn joinParts(self: *Scheduler, parts: []const []const u8, out: *std.Io.Writer) !void {
+        try out.writeAll("[\n");
+        var first = true;
+        for (parts) |part| {
+            _ = self.scratch.reset(.retain_capacity);
+            const bytes = core.fs.readFileAllocUnlimited(self.scratch.allocator(), part) catch |err| switch (err) {
+                error.FileNotFound => continue,
+                else => return err,
+            };
+            if (bytes.len == 0) continue;
+            if (!first) try out.writeAll(",\n");
+            first = false;
+            try out.writeAll(bytes);
+        }
+        try out.writeAll(if (first) "]\n" else "\n]\n");
+    }
+
+    /// Tries the remote cache for the round's misses and submits the rest.
+    fn submitRound(self: *Scheduler, build: *TargetBuild, round: *Round) !void {
+        const session = self.session;
+        const allocator = session.allocator;
+        if (round.pending.items.len == 0) return;
+        if (session.remote) |remote| {
+            if (session.cache) |cache| {
+                build.restored += try fetchRemoteObjects(session, remote, cache, &round.compile_jobs, &round.pending, objectExtension(session.backend));
+            }
+        }
+        if (session.cache) |cache| {
+            for (round.pending.items) |entry| {
+                if (entry.cache_key != null) cache.noteMiss();
+            }
+        }
+        // The pool keeps pointers to the jobs.
+        const jobs = try allocator.dupe(job_pool.Job, round.compile_jobs.items);
+        for (jobs, round.pending.items) |*job, entry| {
+            job.tag = JobTag.encode(build.index, build.pending.items.len);
+            try build.pending.append(allocator, entry);
+            try session.pool.submit(job);
+            build.compiling += 1;
+            build.compiled += 1;
+        }
+    }
+
+    /// Events a compile of `object` waited for: the PCH and the modules it imports.
+    fn compileAfter(self: *Scheduler, build: *const TargetBuild, object: []const u8) ![]const usize {
+        if (self.session.trace == null) return &.{};
+        var after: std.ArrayList(usize) = .empty;
+        if (build.pch_event) |event| try after.append(self.session.allocator, event);
+        if (self.scanOf(object)) |scan| {
+            for (scan.requires) |name| {
+                const provider = self.modules.?.providers.get(name) orelse continue;
+                if (provider.event) |event| try after.append(self.session.allocator, event);
+            }
+        }
+        return after.items;
+    }
+
+    fn jobFinished(self: *Scheduler, job: *job_pool.Job) !void {
+        const tag: JobTag = @bitCast(job.tag);
+        const build = &self.builds[tag.target];
+        if (tag.item == JobTag.link_item) return self.linkFinished(build, job);
+        if (tag.item == JobTag.pch_item) return self.precompileFinished(build, job);
+
+        build.compiling -= 1;
+        if (!job.finished) return;
+        const entry = build.pending.items[tag.item];
+        const event = try self.traceJob(job, .compile, try self.compileAfter(build, entry.object));
+        if (event) |index| try build.compile_events.append(self.session.allocator, index);
+        if (job.exit_code != 0) return self.fail(error.CompileFailed);
+        try self.recordHistory(entry.object, job);
+        const dep_format = depfile.formatForBackend(self.session.backend);
+        if (try recordCompiledObject(self.session, entry, dep_format, job.started_wall_ns)) |item| {
+            try build.published.append(self.session.allocator, item);
+        }
+        try self.modulesBuilt(entry.object, event);
+        try self.compileStepDone(build);
+        try self.startReleased();
+    }
+
+    fn precompileFinished(self: *Scheduler, build: *TargetBuild, job: *job_pool.Job) !void {
+        if (!job.finished) return;
+        build.pch_event = try self.traceJob(job, .compile, &.{});
+        if (job.exit_code != 0) return self.fail(error.PrecompiledHeaderFailed);
+        try self.recordHistory(build.pch_pending.object, job);
+        _ = try recordCompiledObject(self.session, build.pch_pending, depfile.formatForBackend(self.session.backend), job.started_wall_ns);
+        if (self.first_error != null) return;
+        try self.startCompiles(build);
+    }
+
+    fn compileStepDone(self: *Scheduler, build: *TargetBuild) !void {
+        if (build.compiling > 0 or build.blocked > 0 or build.state != .compiling) return;
+        if (self.session.remote) |remote| {
+            remote.upload(self.session.allocator, build.published.items) catch {};
+            build.published.clearRetainingCapacity();
+        }
+        try self.maybeLink(build);
+    }
+
+    fn maybeLink(self: *Scheduler, build: *TargetBuild) !void {
+        if (self.first_error != null) return;
+        if (build.state != .compiling or build.compiling > 0 or build.blocked > 0 or build.waiting_on > 0) return;
+
+        const session = self.session;
+        const allocator = session.allocator;
+        const backend = session.backend;
+        const target = session.graph.targets[build.index];
+
+        var libs = LinkLibraries{ .output_dir = session.project.defaults.output_dir };
+        var link_inputs: std.ArrayList([]const u8) = .empty;
+        try link_inputs.appendSlice(allocator, build.objects);
+        // Linking LTO objects of a library is an LTO link too.
+        var link_lto = target.lto;
+        if (target.kind != .library_static) {
+            const plan = try session.graph.linkPlan(allocator, build.index);
+            const project_libs = try allocator.alloc(project_mod.Target, plan.project_libs.len);
+            for (plan.project_libs, 0..) |lib, i| {
+                project_libs[i] = session.graph.targets[lib];
+                link_lto = link_lto orelse project_libs[i].lto;
+                // A relinked library must relink its dependents.
+                try link_inputs.append(allocator, self.builds[lib].output);
+            }
+            libs.project_libs = project_libs;
+            libs.external = plan.external;
+        }
+
+        const msvc = std.mem.eql(u8, backend, "msvc");
+        var link_flags: std.ArrayList([]const u8) = .empty;
+        try linker_mod.appendLinkFlags(allocator, &link_flags, backend, session.optimize, session.linker);
+        // msvc's profile-guided links are whole-program LTCG already.
+        if (lto.active(link_lto, session.optimize)) |mode| {
+            if (!msvc or session.pgo == null) {
+                const cache_dir = try std.fmt.allocPrint(allocator, "{s}/{s}", .{ session.project.defaults.output_dir, lto.cache_dir_name });
+                try core.fs.ensureDir(cache_dir);
+                try lto.appendLinkFlags(allocator, &link_flags, mode, backend, cache_dir, build.output);
+            }
+        }
+        if (session.pgo) |stage| try pgo.appendLinkFlags(allocator, &link_flags, stage, backend, session.profile_dir, build.output);
+        const lto_objects = lto.active(target.lto, session.optimize) != null or (msvc and session.pgo != null);
+
+        const link_argv = switch (target.kind) {
+            .executable, .test_target => try executableLinkArgv(allocator, build.objects, libs, backend, build.output, link_flags.items),
+            .library_shared => try sharedLibraryLinkArgv(allocator, build.objects, libs, backend, build.output, link_flags.items),
+            .library_static => try staticArchiveArgv(allocator, build.objects, backend, build.output, lto_objects),
+        };
+        build.link_inputs = link_inputs.items;
+        const link_hash = linkInputsHash(link_argv, build.link_inputs);
+        if (build.compiled == 0 and build.restored == 0 and session.manifest.artifactUpToDate(build.output, link_hash)) {
+            build.up_to_date = true;
+            return self.targetDone(build);
+        }
+
+        if (target.kind == .library_static and !std.mem.eql(u8, backend, "msvc")) {
+            // `ar rcs` only adds members; start fresh so dropped sources don't linger.
+            try core.fs.deleteFileIfExists(build.output);
+        }
+        build.state = .linking;
+        const predicted = session.predictor.predict(build.output);
+        build.link_job = .{
+            .label = build.output,
+            .argv = link_argv,
+            .tag = JobTag.encode(build.index, JobTag.link_item),
+            .priority = self.chain_ns[build.index],
+            .predicted_ns = predicted.wall_ns,
+            .predicted_rss = predicted.peak_rss,
+            .log_path = try std.fmt.allocPrint(allocator, "{s}.log", .{build.output}),
+        };
+        try session.pool.submit(&build.link_job);
+    }
+
+    fn linkFinished(self: *Scheduler, build: *TargetBuild, job: *job_pool.Job) !void {
+        if (!job.finished) return;
+        const kind = self.session.graph.targets[build.index].kind;
+        if (self.session.trace != null) {
+            // The link waited on this target's compiles and its libraries' links.
+            var after: std.ArrayList(usize) = .empty;
+            try after.appendSlice(self.session.allocator, build.compile_events.items);
+            for (self.session.graph.deps[build.index]) |lib| {
+                if (self.builds[lib].link_event) |event| try after.append(self.session.allocator, event);
+            }
+            build.link_event = try self.traceJob(job, if (kind == .library_static) .archive else .link, after.items);
+        }
+        if (job.exit_code != 0) {
+            return self.fail(if (kind == .library_static) error.ArchiveFailed else error.LinkFailed);
+        }
+        try self.recordHistory(build.output, job);
+        // Hash again: the objects' fingerprints are part of the key and may have
+        // just been rewritten by the compile step.
+        if (linkInputsHash(job.argv, build.link_inputs)) |inputs| {
+            const allocator = self.session.workspace.allocator;
+            try self.session.manifest.recordArtifact(allocator, try allocator.dupe(u8, build.output), inputs);
+        }
+        try self.targetDone(build);
+    }
+
+    fn traceJob(self: *Scheduler, job: *const job_pool.Job, category: trace.Category, after: []const usize) !?usize {
+        const recorder = self.session.trace orelse return null;
+        return try recorder.record(.{
+            .name = job.label,
+            .category = category,
+            .start_ns = job.started_ns,
+            .end_ns = job.finished_ns,
+            .lane = job.lane,
+            .exit_code = job.exit_code,
+            .backend = self.session.backend,
+            .after = after,
+            .predicted_ns = job.predicted_ns,
+        });
+    }
+
+    fn recordHistory(self: *Scheduler, output: []const u8, job: *const job_pool.Job) !void {
+        // A compile on a worker host says nothing about this machine.
+        if (job.remote) return;
+        const workspace = self.session.workspace;
+        try workspace.history.record(workspace.allocator, output, .{
+            .wall_ns = @intCast(job.finished_ns - job.started_ns),
+            .peak_rss = job.peak_rss,
+        });
+    }
+
+    fn targetDone(self: *Scheduler, build: *TargetBuild) !void {
+        build.state = .done;
+        for (self.builds, 0..) |*dependent, i| {
+            if (dependent.state == .done) continue;
+            if (std.mem.indexOfScalar(usize, self.session.graph.deps[i], build.index) == null) continue;
+            dependent.waiting_on -= 1;
+            try self.maybeLink(dependent);
+        }
+    }
+};
+
+fn traceStart(recorder: ?*trace.Recorder) i128 {
+    return if (recorder != null) trace.Recorder.now() else 0;
+}
+
+fn traceFinish(recorder: ?*trace.Recorder, category: trace.Category, started: i128, comptime fmt: []const u8, args: anytype) !void {
+    if (recorder) |r| try r.finish(category, started, fmt, args);
+}
+
+const PendingObject = struct {
+    object: []const u8,
+    source: []const u8,
+    depfile: []const u8,
+    argv_hash: u64,
+    cache_key: ?object_cache.Digest,
+    /// Set when the object was compiled against a precompiled header.
+    pch_output: ?[]const u8 = null,
+    pch_headers: []const []const u8 = &.{},
+    /// Fingerprinted with the object's headers but not recorded as headers:
+    /// the PCH and the interfaces of imported modules.
+    extra_inputs: []const []const u8 = &.{},
+    /// The inputs known when the compile was planned, stat'ed at `statted_ns`.
+    before: manifest_mod.InputStats = .empty,
+    statted_ns: i128 = 0,
+};
+
+/// Keys the cache on the compiler's probed version banner; a compiler that
+/// couldn't be run for one disables the cache rather than failing the
+/// build here.
+fn objectCache(session: *BuildSession) !?*object_cache.ObjectCache {
+    const cache = session.cache orelse return null;
+    if (!session.cache_probed) {
+        session.cache_probed = true;
+        if (!session.compiler.found) {
+            session.cache = null;
+            return null;
+        }
+        var argv: std.ArrayList([]const u8) = .empty;
+        try appendCompilerPrefix(session.allocator, &argv, session.backend);
+        cache.identifyCompiler(argv.items, session.compiler.banner);
+    }
+    return cache;
+}
+
+/// Asks the remote tier for every local cache miss in one batch and drops
+/// the compile jobs it can satisfy. Returns the number of objects restored.
+fn fetchRemoteObjects(
+    session: *BuildSession,
+    remote: *remote_cache.RemoteCache,
+    cache: *object_cache.ObjectCache,
+    compile_jobs: *std.ArrayList(job_pool.Job),
+    pending: *std.ArrayList(PendingObject),
+    obj_ext: []const u8,
+) !usize {
+    const allocator = session.allocator;
+    var lookups: std.ArrayList(remote_cache.Lookup) = .empty;
+    for (pending.items) |entry| {
+        if (entry.cache_key) |key| try lookups.append(allocator, .{ .key = key, .ext = obj_ext });
+    }
+    if (lookups.items.len == 0) return 0;
+    try remote.hydrate(allocator, lookups.items);
+
+    var restored: usize = 0;
+    var kept: usize = 0;
+    for (compile_jobs.items, pending.items) |job, entry| {
+        if (entry.cache_key) |key| {
+            if (try cache.fetch(allocator, key, entry.object)) |cached_deps| {
+                try recordObject(session, entry.object, entry.source, entry.argv_hash, cached_deps, entry.extra_inputs, &entry.before, entry.statted_ns);
+                cache.session.remote_hits += 1;
+                restored += 1;
+                continue;
+            }
+        }
+        compile_jobs.items[kept] = job;
+        pending.items[kept] = entry;
+        kept += 1;
+    }
+    compile_jobs.shrinkRetainingCapacity(kept);
+    pending.shrinkRetainingCapacity(kept);
+    return restored;
+}
+
+/// Merges the compiler's dependency output into the dependency database and
+/// fingerprints the object against the headers it actually included. Objects
+/// whose depfile is missing are left unrecorded so the next build retries them.
+/// Returns the cache entry published for the object, if any.
+fn recordCompiledObject(
+    session: *BuildSession,
+    entry: PendingObject,
+    dep_format: depfile.Format,
+    /// When the compile started, on the clock of file mtimes.
+    started_wall_ns: i128,
+) !?object_cache.ObjectCache.Published {
+    const allocator = session.allocator;
+    const bytes = core.fs.readFileAlloc(allocator, entry.depfile) catch |err| {
+        if (err == error.OutOfMemory) return err;
+        return null;
+    };
+    var headers = depfile.parse(allocator, bytes, dep_format) catch return null;
+    if (entry.pch_output) |output| headers = try pch_mod.mergeHeaders(allocator, headers, output, entry.pch_headers);
+    try recordObject(session, entry.object, entry.source, entry.argv_hash, headers, entry.extra_inputs, &entry.before, started_wall_ns);
+    const cache = session.cache orelse return null;
+    const key = entry.cache_key orelse return null;
+    // The key hashes the source as it was when planned; one saved since
+    // may be what the compiler read.
+    if (object_cache.modifiedSince(&.{entry.source}, entry.statted_ns)) return null;
+    if (object_cache.modifiedSince(headers, entry.statted_ns)) return null;
+    return cache.store(allocator, key, headers, entry.object) catch null;
+}
+
+/// Records go into workspace memory, which outlives the build's allocator.
+/// `extra_inputs` are fingerprinted but, unlike headers, not recorded as
+/// dependencies. Inputs are fingerprinted as `before` saw them ahead of the
+/// compile; one it didn't know that changed since `started_wall_ns` leaves
+/// the object unrecorded, so the next build compiles it again.
+fn recordObject(
+    session: *BuildSession,
+    object: []const u8,
+    source: []const u8,
+    argv_hash: u64,
+    headers: []const []const u8,
+    extra_inputs: []const []const u8,
+    before: *const manifest_mod.InputStats,
+    started_wall_ns: i128,
+) !void {
+    const allocator = session.workspace.allocator;
+    const owned_object = try allocator.dupe(u8, object);
+    const owned_headers = try allocator.alloc([]const u8, headers.len);
+    for (owned_headers, headers) |*owned, header| owned.* = try allocator.dupe(u8, header);
+    try session.deps.record(allocator, owned_object, owned_headers);
+    try session.workspace.noteInputs(owned_headers);
+
+    var inputs: std.ArrayList([]const u8) = .empty;
+    defer inputs.deinit(session.allocator);
+    try inputs.append(session.allocator, source);
+    try inputs.appendSlice(session.allocator, headers);
+    try inputs.appendSlice(session.allocator, extra_inputs);
+    const inputs_hash = manifest_mod.fingerprintInputsSince(inputs.items, before, started_wall_ns) orelse return;
+    try session.manifest.recordObject(allocator, owned_object, .{
+        .source = try allocator.dupe(u8, source),
+        .argv_hash = argv_hash,
+        .inputs_hash = inputs_hash,
+    });
 }
 
-fn compileAndLinkExecutable(
+fn linkInputsHash(link_argv: []const []const u8, inputs: []const []const u8) ?u64 {
+    const input_fingerprints = manifest_mod.fingerprintInputs(inputs) orelse return null;
+    return manifest_mod.hashArgv(link_argv) ^ input_fingerprints;
+}
+
+/// Libraries for one link step. In-project libraries are found in the
+/// output directory; external ones come from the toolchain's search path.
+pub const LinkLibraries = struct {
+    output_dir: []const u8,
+    project_libs: []const project_mod.Target = &.{},
+    external: []const []const u8 = &.{},
+};
+
+fn compileObjectArgv(
     allocator: std.mem.Allocator,
-    sources: []const []const u8,
-    include_dirs: []const []const u8,
-    link_libraries: []const []const u8,
-    optimize: []const u8,
-    standard: project_mod.CppStandard,
+    source: []const u8,
+    object: []const u8,
+    dep_path: []const u8,
+    /// The target's compiler and flags, from `Scheduler.compileFlags`.
+    compile_flags: []const []const u8,
     backend: []const u8,
-    output: []const u8,
-) !void {
+    pch: ?pch_mod.Plan,
+    /// Placed before the source, e.g. module flags with `-x c++-module`.
+    extra_flags: []const []const u8,
+) ![]const []const u8 {
     var argv: std.ArrayList([]const u8) = .empty;
-    defer argv.deinit(allocator);
+    errdefer argv.deinit(allocator);
+    // Room for the PCH, depfile and output arguments too.
+    try argv.ensureTotalCapacity(allocator, compile_flags.len + extra_flags.len + 12);
 
-    try appendCompilerPrefix(allocator, &argv, backend);
-    try appendCommonCompileFlags(allocator, &argv, optimize, standard, include_dirs, backend);
-    for (sources) |source| try argv.append(allocator, source);
-    if (std.mem.eql(u8, backend, "msvc")) {
-        for (link_libraries) |lib| try argv.append(allocator, try std.fmt.allocPrint(allocator, "{s}.lib", .{lib}));
-        try argv.append(allocator, try std.fmt.allocPrint(allocator, "/Fe:{s}", .{output}));
+    const msvc = std.mem.eql(u8, backend, "msvc");
+    argv.appendSliceAssumeCapacity(compile_flags);
+    if (pch) |plan| try pch_mod.appendUseFlags(allocator, &argv, plan, backend);
+    try argv.appendSlice(allocator, extra_flags);
+    try depfile.appendFlags(allocator, &argv, dep_path, depfile.formatForBackend(backend));
+    if (msvc) {
+        try argv.append(allocator, "/c");
+        try argv.append(allocator, source);
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "/Fo:{s}", .{object}));
     } else {
-        for (link_libraries) |lib| try argv.append(allocator, try std.fmt.allocPrint(allocator, "-l{s}", .{lib}));
+        try argv.append(allocator, "-c");
+        try argv.append(allocator, source);
         try argv.append(allocator, "-o");
-        try argv.append(allocator, output);
+        try argv.append(allocator, object);
     }
+    return try argv.toOwnedSlice(allocator);
+}
 
-    const code = try core.exec.runInherit(allocator, argv.items);
-    if (code != 0) return error.CompileFailed;
+/// Copies `argv` and its strings, e.g. out of a scratch arena.
+fn dupeArgv(allocator: std.mem.Allocator, argv: []const []const u8) ![]const []const u8 {
+    const copy = try allocator.alloc([]const u8, argv.len);
+    for (copy, argv) |*out, arg| out.* = try allocator.dupe(u8, arg);
+    return copy;
 }
 
-fn compileSharedLibrary(
+/// `link_flags` are the linker, LTO and PGO flags of the link, as the
+/// `linker`, `lto` and `pgo` modules produce them.
+fn executableLinkArgv(
     allocator: std.mem.Allocator,
-    sources: []const []const u8,
-    include_dirs: []const []const u8,
-    link_libraries: []const []const u8,
-    optimize: []const u8,
-    standard: project_mod.CppStandard,
+    objects: []const []const u8,
+    libs: LinkLibraries,
     backend: []const u8,
     output: []const u8,
-) !void {
+    link_flags: []const []const u8,
+) ![]const []const u8 {
     var argv: std.ArrayList([]const u8) = .empty;
-    defer argv.deinit(allocator);
+    errdefer argv.deinit(allocator);
+
+    try appendCompilerPrefix(allocator, &argv, backend);
+    if (!std.mem.eql(u8, backend, "msvc")) try argv.appendSlice(allocator, link_flags);
+    for (objects) |object| try argv.append(allocator, object);
+    try appendLinkOutput(allocator, &argv, libs, backend, output, link_flags);
+    return try argv.toOwnedSlice(allocator);
+}
+
+fn sharedLibraryLinkArgv(
+    allocator: std.mem.Allocator,
+    objects: []const []const u8,
+    libs: LinkLibraries,
+    backend: []const u8,
+    output: []const u8,
+    link_flags: []const []const u8,
+) ![]const []const u8 {
+    var argv: std.ArrayList([]const u8) = .empty;
+    errdefer argv.deinit(allocator);
 
     try appendCompilerPrefix(allocator, &argv, backend);
     if (std.mem.eql(u8, backend, "msvc")) {
         try argv.append(allocator, "/LD");
     } else {
         try argv.append(allocator, "-shared");
-        try argv.append(allocator, "-fPIC");
+        try argv.appendSlice(allocator, link_flags);
     }
-    try appendCommonCompileFlags(allocator, &argv, optimize, standard, include_dirs, backend);
-    for (sources) |source| try argv.append(allocator, source);
+    for (objects) |object| try argv.append(allocator, object);
+    try appendLinkOutput(allocator, &argv, libs, backend, output, link_flags);
+    return try argv.toOwnedSlice(allocator);
+}
+
+/// msvc takes the link flags as linker options, after `/link`.
+fn appendLinkOutput(
+    allocator: std.mem.Allocator,
+    argv: *std.ArrayList([]const u8),
+    libs: LinkLibraries,
+    backend: []const u8,
+    output: []const u8,
+    link_flags: []const []const u8,
+) !void {
+    try appendLinkLibraries(allocator, argv, libs, backend);
     if (std.mem.eql(u8, backend, "msvc")) {
-        for (link_libraries) |lib| try argv.append(allocator, try std.fmt.allocPrint(allocator, "{s}.lib", .{lib}));
         try argv.append(allocator, try std.fmt.allocPrint(allocator, "/Fe:{s}", .{output}));
+        if (link_flags.len > 0) {
+            try argv.append(allocator, "/link");
+            try argv.appendSlice(allocator, link_flags);
+        }
     } else {
-        for (link_libraries) |lib| try argv.append(allocator, try std.fmt.allocPrint(allocator, "-l{s}", .{lib}));
         try argv.append(allocator, "-o");
         try argv.append(allocator, output);
     }
-
-    const code = try core.exec.runInherit(allocator, argv.items);
-    if (code != 0) return error.CompileFailed;
 }
 
-fn compileStaticLibrary(
+/// The library arguments of a link, placed after its objects.
+pub fn appendLinkLibraries(
     allocator: std.mem.Allocator,
-    sources: []const []const u8,
-    include_dirs: []const []const u8,
-    optimize: []const u8,
-    standard: project_mod.CppStandard,
+    argv: *std.ArrayList([]const u8),
+    libs: LinkLibraries,
     backend: []const u8,
-    output: []const u8,
-    output_dir: []const u8,
-    target_name: []const u8,
 ) !void {
-    const obj_dir = try std.fmt.allocPrint(allocator, "{s}/obj-{s}", .{ output_dir, target_name });
-    try core.fs.ensureDir(obj_dir);
-
-    var objects: std.ArrayList([]const u8) = .empty;
-    defer objects.deinit(allocator);
-
-    for (sources, 0..) |source, i| {
-        const obj_ext = if (std.mem.eql(u8, backend, "msvc")) ".obj" else ".o";
-        const obj = try std.fmt.allocPrint(allocator, "{s}/{d}{s}", .{ obj_dir, i, obj_ext });
-        try objects.append(allocator, obj);
-
-        var compile_argv: std.ArrayList([]const u8) = .empty;
-        defer compile_argv.deinit(allocator);
-        try appendCompilerPrefix(allocator, &compile_argv, backend);
-        try appendCommonCompileFlags(allocator, &compile_argv, optimize, standard, include_dirs, backend);
-        if (std.mem.eql(u8, backend, "msvc")) {
-            try compile_argv.append(allocator, "/c");
-        } else {
-            try compile_argv.append(allocator, "-c");
+    if (std.mem.eql(u8, backend, "msvc")) {
+        // Shared libraries leave their import library next to the DLL.
+        for (libs.project_libs) |lib| {
+            try argv.append(allocator, try std.fmt.allocPrint(allocator, "{s}/{s}.lib", .{ libs.output_dir, lib.name }));
         }
-        try compile_argv.append(allocator, source);
-        if (std.mem.eql(u8, backend, "msvc")) {
-            try compile_argv.append(allocator, try std.fmt.allocPrint(allocator, "/Fo:{s}", .{obj}));
-        } else {
-            try compile_argv.append(allocator, "-o");
-            try compile_argv.append(allocator, obj);
+        for (libs.external) |lib| try argv.append(allocator, try std.fmt.allocPrint(allocator, "{s}.lib", .{lib}));
+        return;
+    }
+    if (libs.project_libs.len > 0) {
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "-L{s}", .{libs.output_dir}));
+        for (libs.project_libs) |lib| {
+            if (lib.kind != .library_shared) continue;
+            // Artifacts share the output directory, so `ovo run` finds
+            // in-project shared libraries without LD_LIBRARY_PATH.
+            switch (builtin.os.tag) {
+                .windows => {},
+                .macos => try argv.append(allocator, "-Wl,-rpath,@loader_path"),
+                else => try argv.append(allocator, "-Wl,-rpath,$ORIGIN"),
+            }
+            break;
         }
-
-        const compile_code = try core.exec.runInherit(allocator, compile_argv.items);
-        if (compile_code != 0) return error.CompileFailed;
     }
+    for (libs.project_libs) |lib| try argv.append(allocator, try std.fmt.allocPrint(allocator, "-l{s}", .{lib.name}));
+    for (libs.external) |lib| try argv.append(allocator, try std.fmt.allocPrint(allocator, "-l{s}", .{lib}));
+}
 
+/// `lto_objects`: the objects were compiled for link-time optimization.
+fn staticArchiveArgv(
+    allocator: std.mem.Allocator,
+    objects: []const []const u8,
+    backend: []const u8,
+    output: []const u8,
+    lto_objects: bool,
+) ![]const []const u8 {
+    var argv: std.ArrayList([]const u8) = .empty;
+    errdefer argv.deinit(allocator);
+
+    try lto.appendArchiver(allocator, &argv, lto_objects, backend);
     if (std.mem.eql(u8, backend, "msvc")) {
-        var lib_argv: std.ArrayList([]const u8) = .empty;
-        defer lib_argv.deinit(allocator);
-        try lib_argv.append(allocator, "lib");
-        try lib_argv.append(allocator, try std.fmt.allocPrint(allocator, "/OUT:{s}", .{output}));
-        for (objects.items) |obj| try lib_argv.append(allocator, obj);
-
-        const lib_code = try core.exec.runInherit(allocator, lib_argv.items);
-        if (lib_code != 0) return error.ArchiveFailed;
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "/OUT:{s}", .{output}));
     } else {
-        var ar_argv: std.ArrayList([]const u8) = .empty;
-        defer ar_argv.deinit(allocator);
-        try ar_argv.append(allocator, "ar");
-        try ar_argv.append(allocator, "rcs");
-        try ar_argv.append(allocator, output);
-        for (objects.items) |obj| try ar_argv.append(allocator, obj);
+        try argv.append(allocator, "rcs");
+        try argv.append(allocator, output);
+    }
+    for (objects) |object| try argv.append(allocator, object);
+    return try argv.toOwnedSlice(allocator);
+}
+
+pub fn objectExtension(backend: []const u8) []const u8 {
+    return if (std.mem.eql(u8, backend, "msvc")) ".obj" else ".o";
+}
 
-        const ar_code = try core.exec.runInherit(allocator, ar_argv.items);
-        if (ar_code != 0) return error.ArchiveFailed;
+/// Leaves `path` untouched when it already holds `bytes`, so generated
+/// inputs keep their fingerprint.
+pub fn writeIfChanged(allocator: std.mem.Allocator, path: []const u8, bytes: []const u8) !void {
+    const existing: ?[]const u8 = core.fs.readFileAlloc(allocator, path) catch null;
+    if (existing) |current| {
+        if (std.mem.eql(u8, current, bytes)) return;
     }
+    try core.fs.writeFile(path, bytes);
 }
 
-fn appendCompilerPrefix(
+/// The compiler driver of `backend`, one argument or two (`zig c++`).
+pub fn appendCompilerPrefix(
     allocator: std.mem.Allocator,
     argv: *std.ArrayList([]const u8),
     backend: []const u8,
@@ -347,7 +1733,9 @@ fn appendCompilerPrefix(
     return error.UnsupportedCompilerBackend;
 }
 
-fn appendCommonCompileFlags(
+/// Language standard, optimization, warnings and include directories;
+/// every compile of a target starts with these after the compiler.
+pub fn appendCommonCompileFlags(
     allocator: std.mem.Allocator,
     argv: *std.ArrayList([]const u8),
     optimize: []const u8,
@@ -416,7 +1804,8 @@ fn optimizeFlagMsvc(optimize: []const u8) ![]const u8 {
     return error.UnsupportedOptimizeMode;
 }
 
-fn artifactPath(
+/// Where the artifact of `target` goes in `output_dir`, named the host's way.
+pub fn artifactPath(
     allocator: std.mem.Allocator,
     output_dir: []const u8,
     target: project_mod.Target,
@@ -442,68 +1831,3 @@ fn artifactPath(
         },
     };
 }
-
-pub fn resolveSourcePattern(allocator: std.mem.Allocator, pattern: []const u8) ![]const []const u8 {
-    if (std.mem.indexOfScalar(u8, pattern, '*') == null) {
-        const single = try allocator.alloc([]const u8, 1);
-        single[0] = pattern;
-        return single;
-    }
-
-    const wildcard_index = std.mem.indexOfScalar(u8, pattern, '*').?;
-    var base_dir = trimTrailingSlashes(pattern[0..wildcard_index]);
-    if (base_dir.len == 0) base_dir = ".";
-    const recursive = std.mem.indexOf(u8, pattern, "**") != null;
-    const ext = std.fs.path.extension(pattern);
-
-    var files: std.ArrayList([]const u8) = .empty;
-    errdefer files.deinit(allocator);
-
-    if (recursive) {
-        var dir = try std.Io.Dir.cwd().openDir(core.runtime.io(), base_dir, .{ .iterate = true });
-        defer dir.close(core.runtime.io());
-
-        var walker = try dir.walk(allocator);
-        defer walker.deinit();
-        while (try walker.next(core.runtime.io())) |entry| {
-            if (entry.kind != .file) continue;
-            if (ext.len > 0 and !std.mem.eql(u8, std.fs.path.extension(entry.path), ext)) continue;
-            try files.append(allocator, try resolvePatternPath(allocator, base_dir, entry.path));
-        }
-    } else {
-        var dir = try std.Io.Dir.cwd().openDir(core.runtime.io(), base_dir, .{ .iterate = true });
-        defer dir.close(core.runtime.io());
-
-        var it = dir.iterate();
-        while (try it.next(core.runtime.io())) |entry| {
-            if (entry.kind != .file) continue;
-            if (ext.len > 0 and !std.mem.eql(u8, std.fs.path.extension(entry.name), ext)) continue;
-            try files.append(allocator, try std.fmt.allocPrint(allocator, "{s}/{s}", .{ base_dir, entry.name }));
-        }
-    }
-
-    if (files.items.len == 0) return error.NoSources;
-    return try files.toOwnedSlice(allocator);
-}
-
-fn resolvePatternPath(allocator: std.mem.Allocator, base_dir: []const u8, entry_path: []const u8) ![]u8 {
-    if (std.fs.path.isAbsolute(entry_path)) return try allocator.dupe(u8, entry_path);
-    if (hasBasePrefix(entry_path, base_dir)) return try allocator.dupe(u8, entry_path);
-    return try std.fs.path.join(allocator, &.{ base_dir, entry_path });
-}
-
-fn hasBasePrefix(path: []const u8, base_dir: []const u8) bool {
-    if (!std.mem.startsWith(u8, path, base_dir)) return false;
-    if (path.len == base_dir.len) return true;
-    return base_dir.len < path.len and isPathSeparator(path[base_dir.len]);
-}
-
-fn isPathSeparator(char: u8) bool {
-    return char == '/' or char == '\\';
-}
-
-fn trimTrailingSlashes(value: []const u8) []const u8 {
-    var end = value.len;
-    while (end > 0 and value[end - 1] == '/') : (end -= 1) {}
-    return value[0..end];
-}
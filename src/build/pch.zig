@@ -0,0 +1,129 @@
+const std = @import("std");
+const project_mod = @import("../core/project.zig");
+
+/// Where a target's precompiled header is built and how its compiles use it.
+pub const Plan = struct {
+    header: []const u8,
+    /// File the precompile step writes; consumers are fingerprinted against it.
+    output: []const u8,
+    /// Name consumers include the header by. gcc completes it with `.gch`;
+    /// msvc requires the same spelling in `/Yc`, `/Yu` and `/FI`.
+    include: []const u8,
+    /// msvc only: `/Yc` needs a translation unit, so a stub source that
+    /// includes the header is compiled, and its object linked into the target.
+    stub_source: ?[]const u8 = null,
+    stub_object: ?[]const u8 = null,
+};
+
+/// Lays out the precompiled header of `header` in `dir`. msvc names the
+/// header by its absolute path under `cwd`, which the stub source next to
+/// the output can include regardless of include directories.
+pub fn plan(
+    allocator: std.mem.Allocator,
+    dir: []const u8,
+    header: []const u8,
+    backend: []const u8,
+    cwd: []const u8,
+) !Plan {
+    const name = std.fs.path.basename(header);
+    if (std.mem.eql(u8, backend, "msvc")) {
+        return .{
+            .header = header,
+            .output = try std.fmt.allocPrint(allocator, "{s}/{s}.pch", .{ dir, name }),
+            .include = if (std.fs.path.isAbsolute(header)) header else try std.fs.path.join(allocator, &.{ cwd, header }),
+            .stub_source = try std.fmt.allocPrint(allocator, "{s}/{s}.cpp", .{ dir, name }),
+            .stub_object = try std.fmt.allocPrint(allocator, "{s}/{s}.obj", .{ dir, name }),
+        };
+    }
+    if (std.mem.eql(u8, backend, "gcc")) {
+        // gcc has no flag naming a PCH file: it looks for `<include>.gch`
+        // before opening `<include>` itself.
+        const include = try std.fs.path.join(allocator, &.{ dir, name });
+        return .{
+            .header = header,
+            .output = try std.fmt.allocPrint(allocator, "{s}.gch", .{include}),
+            .include = include,
+        };
+    }
+    return .{
+        .header = header,
+        .output = try std.fmt.allocPrint(allocator, "{s}/{s}.pch", .{ dir, name }),
+        .include = header,
+    };
+}
+
+/// Contents of the msvc stub translation unit.
+pub fn stubSource(allocator: std.mem.Allocator, pch: Plan) ![]u8 {
+    return std.fmt.allocPrint(allocator, "#include \"{s}\"\n", .{pch.include});
+}
+
+/// Input and output arguments of the precompile step; everything before
+/// them must match what consumers are compiled with.
+pub fn appendCreateFlags(
+    allocator: std.mem.Allocator,
+    argv: *std.ArrayList([]const u8),
+    pch: Plan,
+    standard: project_mod.CppStandard,
+    backend: []const u8,
+) !void {
+    if (std.mem.eql(u8, backend, "msvc")) {
+        try argv.append(allocator, "/c");
+        try argv.append(allocator, pch.stub_source.?);
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "/Yc{s}", .{pch.include}));
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "/Fp{s}", .{pch.output}));
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "/Fo:{s}", .{pch.stub_object.?}));
+        return;
+    }
+    try argv.append(allocator, "-x");
+    try argv.append(allocator, if (project_mod.isCStandard(standard)) "c-header" else "c++-header");
+    try argv.append(allocator, pch.header);
+    try argv.append(allocator, "-o");
+    try argv.append(allocator, pch.output);
+}
+
+/// Arguments that make a compile use the precompiled header. Sources need
+/// not include the header themselves.
+pub fn appendUseFlags(
+    allocator: std.mem.Allocator,
+    argv: *std.ArrayList([]const u8),
+    pch: Plan,
+    backend: []const u8,
+) !void {
+    if (std.mem.eql(u8, backend, "msvc")) {
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "/Yu{s}", .{pch.include}));
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "/Fp{s}", .{pch.output}));
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "/FI{s}", .{pch.include}));
+    } else if (std.mem.eql(u8, backend, "gcc")) {
+        try argv.append(allocator, "-include");
+        try argv.append(allocator, pch.include);
+        // An unusable .gch otherwise fails silently over to the missing header.
+        try argv.append(allocator, "-Winvalid-pch");
+    } else {
+        try argv.append(allocator, "-include-pch");
+        try argv.append(allocator, pch.output);
+    }
+}
+
+/// Headers to record for an object compiled against the precompiled header:
+/// its own, plus the ones inside the PCH, which a depfile may report only as
+/// the PCH file. The PCH file itself is dropped so cache keys depend on
+/// header contents, not compiler-specific PCH bytes.
+pub fn mergeHeaders(
+    allocator: std.mem.Allocator,
+    headers: []const []const u8,
+    pch_output: []const u8,
+    pch_headers: []const []const u8,
+) ![]const []const u8 {
+    var seen: std.StringHashMapUnmanaged(void) = .empty;
+    defer seen.deinit(allocator);
+    var merged: std.ArrayList([]const u8) = .empty;
+    errdefer merged.deinit(allocator);
+    for ([_][]const []const u8{ headers, pch_headers }) |list| {
+        for (list) |header| {
+            if (std.mem.eql(u8, header, pch_output)) continue;
+            if ((try seen.getOrPut(allocator, header)).found_existing) continue;
+            try merged.append(allocator, header);
+        }
+    }
+    return try merged.toOwnedSlice(allocator);
+}
@@ -0,0 +1,184 @@
+const std = @import("std");
+const core = @import("../core/mod.zig");
+const project_mod = @import("../core/project.zig");
+const orchestrator = @import("orchestrator.zig");
+
+/// Which half of a profile-guided build a compile belongs to.
+pub const Stage = enum {
+    /// Objects count what runs and the executables write it out.
+    instrument,
+    /// Objects are optimized with the merged profile.
+    use,
+};
+
+/// Where `backend` builds collect their profiles, per output directory.
+pub fn profileDir(allocator: std.mem.Allocator, output_dir: []const u8, backend: []const u8) ![]const u8 {
+    return std.fmt.allocPrint(allocator, "{s}/pgo/{s}", .{ output_dir, backend });
+}
+
+/// The merged profile every compile reads, when the backend has one; gcc
+/// keeps a profile per object and msvc one per linked image.
+pub fn mergedProfile(allocator: std.mem.Allocator, dir: []const u8, backend: []const u8) !?[]const u8 {
+    if (!std.mem.eql(u8, backend, "clang")) return null;
+    return try std.fmt.allocPrint(allocator, "{s}/default.profdata", .{dir});
+}
+
+/// zig ships no profiling runtime, so zigcc builds can't be instrumented.
+pub fn appendCompileFlags(
+    allocator: std.mem.Allocator,
+    argv: *std.ArrayList([]const u8),
+    stage: Stage,
+    backend: []const u8,
+    dir: []const u8,
+) !void {
+    if (std.mem.eql(u8, backend, "clang")) {
+        switch (stage) {
+            .instrument => {
+                try argv.append(allocator, try std.fmt.allocPrint(allocator, "-fprofile-generate={s}", .{dir}));
+                // Servers count from many threads at once.
+                try argv.append(allocator, "-fprofile-update=atomic");
+            },
+            .use => {
+                try argv.append(allocator, try std.fmt.allocPrint(allocator, "-fprofile-use={s}/default.profdata", .{dir}));
+                try argv.append(allocator, "-Wno-profile-instr-unprofiled");
+                try argv.append(allocator, "-Wno-profile-instr-out-of-date");
+            },
+        }
+    } else if (std.mem.eql(u8, backend, "gcc")) {
+        switch (stage) {
+            .instrument => {
+                try argv.append(allocator, try std.fmt.allocPrint(allocator, "-fprofile-generate={s}", .{dir}));
+                try argv.append(allocator, "-fprofile-update=atomic");
+            },
+            .use => {
+                try argv.append(allocator, try std.fmt.allocPrint(allocator, "-fprofile-use={s}", .{dir}));
+                // Sources the training never reached have no profile.
+                try argv.append(allocator, "-Wno-missing-profile");
+            },
+        }
+    } else if (std.mem.eql(u8, backend, "msvc")) {
+        // PGO is part of link-time code generation.
+        try argv.append(allocator, "/GL");
+    } else if (std.mem.eql(u8, backend, "zigcc")) {
+        return error.PgoUnsupportedBackend;
+    } else {
+        return error.UnsupportedCompilerBackend;
+    }
+}
+
+/// Link flags placed like `lto.appendLinkFlags`. clang and gcc link their
+/// profiling runtime; msvc instruments and optimizes at link time, with the
+/// profile of `output` next to the others.
+pub fn appendLinkFlags(
+    allocator: std.mem.Allocator,
+    argv: *std.ArrayList([]const u8),
+    stage: Stage,
+    backend: []const u8,
+    dir: []const u8,
+    output: []const u8,
+) !void {
+    if (std.mem.eql(u8, backend, "msvc")) {
+        try argv.append(allocator, "/LTCG");
+        const option = if (stage == .instrument) "GENPROFILE" else "USEPROFILE";
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "/{s}:PGD={s}", .{ option, try imageProfile(allocator, dir, output) }));
+        return;
+    }
+    if (stage == .instrument) {
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "-fprofile-generate={s}", .{dir}));
+    }
+}
+
+fn imageProfile(allocator: std.mem.Allocator, dir: []const u8, output: []const u8) ![]const u8 {
+    return std.fmt.allocPrint(allocator, "{s}/{s}.pgd", .{ dir, std.fs.path.stem(output) });
+}
+
+/// Commands folding the training runs' raw profiles in `dir` into what the
+/// optimized build reads: `llvm-profdata merge` for clang and `pgomgr` per
+/// instrumented image for msvc. gcc's runs accumulate into their profiles
+/// directly, so it needs none.
+pub fn mergeCommands(
+    allocator: std.mem.Allocator,
+    backend: []const u8,
+    dir: []const u8,
+    images: []const []const u8,
+) ![]const []const []const u8 {
+    var commands: std.ArrayList([]const []const u8) = .empty;
+    if (std.mem.eql(u8, backend, "clang")) {
+        var argv: std.ArrayList([]const u8) = .empty;
+        try argv.appendSlice(allocator, &.{ "llvm-profdata", "merge" });
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "-output={s}/default.profdata", .{dir}));
+        const initial = argv.items.len;
+        for (try core.fs.walkFiles(allocator, dir)) |entry| {
+            if (std.mem.endsWith(u8, entry.path, ".profraw")) try argv.append(allocator, entry.path);
+        }
+        if (argv.items.len == initial) return error.NoPgoProfile;
+        try commands.append(allocator, argv.items);
+    } else if (std.mem.eql(u8, backend, "msvc")) {
+        for (images) |image| {
+            const argv = try allocator.dupe([]const u8, &.{ "pgomgr", "/merge", try imageProfile(allocator, dir, image) });
+            try commands.append(allocator, argv);
+        }
+    }
+    return commands.items;
+}
+
+/// `ovo build --pgo=train`: builds instrumented, runs every built
+/// executable that has `.pgo_train` with those arguments, merges what they
+/// recorded and builds again with the profile. Profiles of an earlier
+/// training are discarded first, so they can't skew this one. Returns the
+/// optimized build.
+pub fn train(
+    allocator: std.mem.Allocator,
+    workspace: *orchestrator.Workspace,
+    options: orchestrator.BuildOptions,
+) !orchestrator.BuildResult {
+    const project = workspace.project;
+    if (std.ascii.eqlIgnoreCase(options.optimize_override orelse project.defaults.optimize, "debug")) {
+        return error.PgoRequiresOptimizedBuild;
+    }
+    const backend = options.backend_override orelse project.defaults.backend;
+    const dir = try profileDir(allocator, project.defaults.output_dir, backend);
+    try core.fs.removeTreeIfExists(dir);
+    try core.fs.ensureDir(dir);
+
+    var instrumented = options;
+    instrumented.pgo = .instrument;
+    const result = try workspace.build(allocator, instrumented);
+
+    var images: std.ArrayList([]const u8) = .empty;
+    var trained: usize = 0;
+    for (result.artifacts) |artifact| {
+        if (artifact.kind == .executable or artifact.kind == .library_shared) try images.append(allocator, artifact.path);
+        const target = findTarget(project, artifact.name) orelse continue;
+        if (artifact.kind != .executable or target.pgo_train.len == 0) continue;
+        var argv: std.ArrayList([]const u8) = .empty;
+        try argv.append(allocator, artifact.path);
+        try argv.appendSlice(allocator, target.pgo_train);
+        core.runtime.printErr("pgo: training {s}\n", .{artifact.name});
+        try runStep(allocator, argv.items, error.PgoTrainingFailed);
+        trained += 1;
+    }
+    if (trained == 0) return error.NoPgoTraining;
+    for (try mergeCommands(allocator, backend, dir, images.items)) |argv| {
+        try runStep(allocator, argv, error.PgoMergeFailed);
+    }
+
+    var optimized = options;
+    optimized.pgo = .use;
+    return workspace.build(allocator, optimized);
+}
+
+fn findTarget(project: project_mod.Project, name: []const u8) ?project_mod.Target {
+    for (project.targets) |target| {
+        if (std.mem.eql(u8, target.name, name)) return target;
+    }
+    return null;
+}
+
+/// Output is shown only when the step fails.
+fn runStep(allocator: std.mem.Allocator, argv: []const []const u8, failure: anyerror) !void {
+    const run = try core.exec.runCaptured(allocator, argv);
+    if (run.exit_code == 0) return;
+    core.runtime.printErr("{s}", .{run.output});
+    return failure;
+}
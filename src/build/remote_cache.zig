@@ -0,0 +1,356 @@
+const std = @import("std");
+const core = @import("../core/mod.zig");
+const project_mod = @import("../core/project.zig");
+const job_pool = @import("job_pool.zig");
+const object_cache = @import("object_cache.zig");
+
+/// Transfers are I/O bound, so they get their own width instead of `-j`.
+const transfer_jobs = 16;
+
+pub const Endpoint = struct {
+    base_url: []const u8,
+    /// Set for `s3://` URLs; requests are SigV4-signed from the AWS_* variables.
+    s3_region: ?[]const u8 = null,
+};
+
+/// Maps the configured URL to the HTTP base every cache path is appended to.
+/// `s3://bucket/prefix` uses virtual-hosted AWS addressing unless
+/// `endpoint_override` names an S3-compatible store, which gets path-style URLs.
+pub fn resolveEndpoint(
+    allocator: std.mem.Allocator,
+    url: []const u8,
+    region: ?[]const u8,
+    endpoint_override: ?[]const u8,
+) !Endpoint {
+    const trimmed = std.mem.trimEnd(u8, url, "/");
+    if (std.mem.startsWith(u8, trimmed, "s3://")) {
+        const rest = trimmed["s3://".len..];
+        const slash = std.mem.indexOfScalar(u8, rest, '/');
+        const bucket = if (slash) |i| rest[0..i] else rest;
+        const prefix = if (slash) |i| rest[i..] else "";
+        if (bucket.len == 0) return error.InvalidRemoteCacheUrl;
+        const s3_region = region orelse "us-east-1";
+        const base_url = if (endpoint_override) |endpoint|
+            try std.fmt.allocPrint(allocator, "{s}/{s}{s}", .{ std.mem.trimEnd(u8, endpoint, "/"), bucket, prefix })
+        else
+            try std.fmt.allocPrint(allocator, "https://{s}.s3.{s}.amazonaws.com{s}", .{ bucket, s3_region, prefix });
+        return .{ .base_url = base_url, .s3_region = s3_region };
+    }
+    if (std.mem.startsWith(u8, trimmed, "http://") or std.mem.startsWith(u8, trimmed, "https://")) {
+        return .{ .base_url = trimmed };
+    }
+    return error.InvalidRemoteCacheUrl;
+}
+
+/// The remote tier mirrors the local cache layout: `<root>/objects/ab/cd...`
+/// is stored at `<base>/objects/ab/cd...`.
+pub fn mirrorUrl(
+    allocator: std.mem.Allocator,
+    base_url: []const u8,
+    cache_root: []const u8,
+    local_path: []const u8,
+    suffix: []const u8,
+) ![]u8 {
+    var relative = local_path;
+    if (std.mem.startsWith(u8, relative, cache_root)) relative = relative[cache_root.len..];
+    relative = std.mem.trimStart(u8, relative, "/\\");
+    const url = try std.fmt.allocPrint(allocator, "{s}/{s}{s}", .{ base_url, relative, suffix });
+    std.mem.replaceScalar(u8, url, '\\', '/');
+    return url;
+}
+
+pub const Lookup = struct {
+    key: object_cache.Digest,
+    /// Object extension (`.o`/`.obj`), which is part of the cached file name.
+    ext: []const u8,
+};
+
+/// Shared cache tier for CI fleets, layered under the local object cache.
+/// Lookups download entries and zstd-compressed objects into the local cache
+/// in concurrent batches; uploads of fresh objects run on a background thread
+/// while the build carries on. Transfers shell out to `curl` and `zstd`.
+pub const RemoteCache = struct {
+    endpoint: Endpoint,
+    writable: bool,
+    cache: *object_cache.ObjectCache,
+    lookup_argv: []const []const u8,
+    upload_argv: []const []const u8,
+    probed: bool = false,
+    usable: bool = false,
+    uploads: std.ArrayList(*UploadBatch) = .empty,
+
+    /// `OVO_REMOTE_CACHE_URL` and `OVO_REMOTE_CACHE_MODE` (`read_only`,
+    /// `read_write` or `off`) override the project config, so CI can enable
+    /// writes without developers' checkouts doing the same.
+    pub fn open(
+        allocator: std.mem.Allocator,
+        config: ?project_mod.RemoteCache,
+        cache: *object_cache.ObjectCache,
+    ) !?RemoteCache {
+        var remote = config orelse project_mod.RemoteCache{ .url = "" };
+        if (core.runtime.getEnv("OVO_REMOTE_CACHE_URL")) |url| remote.url = url;
+        if (core.runtime.getEnv("OVO_REMOTE_CACHE_MODE")) |mode| {
+            if (std.mem.eql(u8, mode, "off")) return null;
+            remote.mode = project_mod.parseRemoteCacheMode(mode) orelse remote.mode;
+        }
+        if (remote.url.len == 0) return null;
+
+        const endpoint = try resolveEndpoint(
+            allocator,
+            remote.url,
+            core.runtime.getEnv("AWS_REGION") orelse core.runtime.getEnv("AWS_DEFAULT_REGION"),
+            core.runtime.getEnv("AWS_ENDPOINT_URL"),
+        );
+        return .{
+            .endpoint = endpoint,
+            .writable = remote.mode == .read_write,
+            .cache = cache,
+            .lookup_argv = try curlArgv(allocator, endpoint, false),
+            .upload_argv = try curlArgv(allocator, endpoint, true),
+        };
+    }
+
+    /// Pulls entries and objects for local misses into the local cache, so a
+    /// following `ObjectCache.fetch` finds them. Missing keys are not errors.
+    pub fn hydrate(self: *RemoteCache, allocator: std.mem.Allocator, lookups: []const Lookup) !void {
+        if (lookups.len == 0 or !self.ensureTools(allocator)) return;
+
+        const entry_jobs = try allocator.alloc(job_pool.Job, lookups.len);
+        const entry_paths = try allocator.alloc([]const u8, lookups.len);
+        const entry_temps = try allocator.alloc([]const u8, lookups.len);
+        for (lookups, 0..) |lookup, i| {
+            entry_paths[i] = try self.cache.entryPath(allocator, lookup.key);
+            entry_temps[i] = try object_cache.tempPath(allocator, entry_paths[i]);
+            const url = try mirrorUrl(allocator, self.endpoint.base_url, self.cache.root, entry_paths[i], "");
+            entry_jobs[i] = .{
+                .label = url,
+                .argv = try self.transferArgv(allocator, &.{ "-o", entry_temps[i], url }),
+                .may_fail = true,
+            };
+        }
+        _ = try job_pool.runAll(allocator, entry_jobs, transfer_jobs);
+        job_pool.freeOutputs(entry_jobs);
+
+        var object_jobs: std.ArrayList(job_pool.Job) = .empty;
+        var compressed: std.ArrayList([]const u8) = .empty;
+        var destinations: std.ArrayList([]const u8) = .empty;
+        for (lookups, entry_jobs, 0..) |lookup, job, i| {
+            if (job.exit_code != 0) {
+                core.fs.deleteFileIfExists(entry_temps[i]) catch {};
+                continue;
+            }
+            object_cache.commitTemp(entry_temps[i], entry_paths[i]) catch continue;
+            const cached = try self.cache.missingObject(allocator, lookup.key, lookup.ext) orelse continue;
+            const temp = try object_cache.tempPath(allocator, cached);
+            const archive = try std.fmt.allocPrint(allocator, "{s}.zst", .{temp});
+            const url = try mirrorUrl(allocator, self.endpoint.base_url, self.cache.root, cached, ".zst");
+            try object_jobs.append(allocator, .{
+                .label = url,
+                .argv = try self.transferArgv(allocator, &.{ "-o", archive, url }),
+                .may_fail = true,
+            });
+            try compressed.append(allocator, archive);
+            try destinations.append(allocator, cached);
+        }
+        _ = try job_pool.runAll(allocator, object_jobs.items, transfer_jobs);
+        job_pool.freeOutputs(object_jobs.items);
+
+        var unpack_jobs: std.ArrayList(job_pool.Job) = .empty;
+        var unpacked: std.ArrayList([]const u8) = .empty;
+        var unpack_destinations: std.ArrayList([]const u8) = .empty;
+        for (object_jobs.items, compressed.items, destinations.items) |job, archive, cached| {
+            if (job.exit_code != 0) {
+                core.fs.deleteFileIfExists(archive) catch {};
+                continue;
+            }
+            const temp = archive[0 .. archive.len - ".zst".len];
+            try unpack_jobs.append(allocator, .{
+                .label = archive,
+                .argv = try allocator.dupe([]const u8, &.{ "zstd", "-d", "-q", "-f", "--rm", "-o", temp, archive }),
+                .may_fail = true,
+            });
+            try unpacked.append(allocator, temp);
+            try unpack_destinations.append(allocator, cached);
+        }
+        _ = try job_pool.runAll(allocator, unpack_jobs.items, transfer_jobs);
+        job_pool.freeOutputs(unpack_jobs.items);
+
+        for (unpack_jobs.items, unpacked.items, unpack_destinations.items) |job, temp, cached| {
+            if (job.exit_code != 0) {
+                core.fs.deleteFileIfExists(temp) catch {};
+                continue;
+            }
+            object_cache.commitTemp(temp, cached) catch continue;
+            if (core.fs.fingerprint(cached)) |stat| {
+                self.cache.session.size_bytes += stat.size;
+            } else |_| {}
+        }
+    }
+
+    /// Queues freshly published objects for upload and returns immediately.
+    /// Objects are pushed before their entries, so readers that can see an
+    /// entry can always fetch its object.
+    pub fn upload(self: *RemoteCache, allocator: std.mem.Allocator, published: []const object_cache.ObjectCache.Published) !void {
+        if (!self.writable or published.len == 0 or !self.ensureTools(allocator)) return;
+
+        const batch = try allocator.create(UploadBatch);
+        batch.* = .{
+            .compress = try allocator.alloc(job_pool.Job, published.len),
+            .objects = try allocator.alloc(job_pool.Job, published.len),
+            .entries = try allocator.alloc(job_pool.Job, published.len),
+            .archives = try allocator.alloc([]const u8, published.len),
+        };
+        for (published, 0..) |item, i| {
+            const archive = try std.fmt.allocPrint(allocator, "{s}.zst", .{try object_cache.tempPath(allocator, item.object_path)});
+            batch.archives[i] = archive;
+            batch.compress[i] = .{
+                .label = item.object_path,
+                .argv = try allocator.dupe([]const u8, &.{ "zstd", "-q", "-f", "-o", archive, item.object_path }),
+                .may_fail = true,
+            };
+            const object_url = try mirrorUrl(allocator, self.endpoint.base_url, self.cache.root, item.object_path, ".zst");
+            batch.objects[i] = .{
+                .label = object_url,
+                .argv = try self.uploadArgv(allocator, archive, object_url),
+                .may_fail = true,
+            };
+            const entry_url = try mirrorUrl(allocator, self.endpoint.base_url, self.cache.root, item.entry_path, "");
+            batch.entries[i] = .{
+                .label = entry_url,
+                .argv = try self.uploadArgv(allocator, item.entry_path, entry_url),
+                .may_fail = true,
+            };
+        }
+        // Everything the worker touches is built above; it never allocates
+        // from `allocator`, which the build thread keeps using.
+        try self.uploads.append(allocator, batch);
+        batch.thread = std.Thread.spawn(.{}, UploadBatch.run, .{batch}) catch blk: {
+            batch.run();
+            break :blk null;
+        };
+    }
+
+    /// Waits for queued uploads and folds their results into the cache stats.
+    pub fn finish(self: *RemoteCache) void {
+        for (self.uploads.items) |batch| {
+            if (batch.thread) |thread| thread.join();
+            batch.thread = null;
+            self.cache.session.remote_uploads += batch.uploaded;
+            if (batch.failed > 0) {
+                core.runtime.printErr("warning: remote cache: {d} upload(s) failed\n", .{batch.failed});
+            }
+        }
+        // The list lives in the allocator of the build that queued it.
+        self.uploads = .empty;
+    }
+
+    fn ensureTools(self: *RemoteCache, allocator: std.mem.Allocator) bool {
+        if (self.probed) return self.usable;
+        self.probed = true;
+        for ([_][]const u8{ "curl", "zstd" }) |tool| {
+            const captured = core.exec.runCaptured(allocator, &.{ tool, "--version" }) catch {
+                core.runtime.printErr("warning: remote cache disabled: '{s}' is not available\n", .{tool});
+                return false;
+            };
+            allocator.free(captured.output);
+            if (captured.exit_code != 0) {
+                core.runtime.printErr("warning: remote cache disabled: '{s} --version' failed\n", .{tool});
+                return false;
+            }
+        }
+        self.usable = true;
+        return true;
+    }
+
+    fn transferArgv(self: *const RemoteCache, allocator: std.mem.Allocator, tail: []const []const u8) ![]const []const u8 {
+        return std.mem.concat(allocator, []const u8, &.{ self.lookup_argv, tail });
+    }
+
+    fn uploadArgv(self: *const RemoteCache, allocator: std.mem.Allocator, file: []const u8, url: []const u8) ![]const []const u8 {
+        return std.mem.concat(allocator, []const u8, &.{ self.upload_argv, &.{ "-T", file, url } });
+    }
+};
+
+const UploadBatch = struct {
+    compress: []job_pool.Job,
+    objects: []job_pool.Job,
+    entries: []job_pool.Job,
+    archives: [][]const u8,
+    thread: ?std.Thread = null,
+    uploaded: u64 = 0,
+    failed: u64 = 0,
+
+    fn run(batch: *UploadBatch) void {
+        const allocator = std.heap.smp_allocator;
+        _ = job_pool.runAll(allocator, batch.compress, transfer_jobs) catch {};
+        job_pool.freeOutputs(batch.compress);
+        // Skip uploads whose compression failed; the pool runs them all otherwise.
+        for (batch.compress, batch.objects, batch.entries) |compress, *object, *entry| {
+            if (compress.exit_code != 0 or !compress.finished) {
+                object.finished = true;
+                object.exit_code = compress.exit_code;
+                entry.finished = true;
+                entry.exit_code = compress.exit_code;
+            }
+        }
+        runPending(allocator, batch.objects);
+        for (batch.objects, batch.entries) |object, *entry| {
+            if (object.exit_code != 0 and !entry.finished) {
+                entry.finished = true;
+                entry.exit_code = object.exit_code;
+            }
+        }
+        runPending(allocator, batch.entries);
+        for (batch.entries) |entry| {
+            if (entry.exit_code == 0) batch.uploaded += 1 else batch.failed += 1;
+        }
+        for (batch.archives) |archive| core.fs.deleteFileIfExists(archive) catch {};
+    }
+
+    /// Runs the jobs not already marked finished by an earlier failed stage.
+    fn runPending(allocator: std.mem.Allocator, jobs: []job_pool.Job) void {
+        var pending: std.ArrayList(job_pool.Job) = .empty;
+        defer pending.deinit(allocator);
+        var indices: std.ArrayList(usize) = .empty;
+        defer indices.deinit(allocator);
+        for (jobs, 0..) |job, i| {
+            if (job.finished) continue;
+            pending.append(allocator, job) catch return;
+            indices.append(allocator, i) catch return;
+        }
+        _ = job_pool.runAll(allocator, pending.items, transfer_jobs) catch {};
+        job_pool.freeOutputs(pending.items);
+        for (pending.items, indices.items) |job, i| jobs[i] = job;
+    }
+};
+
+fn curlArgv(allocator: std.mem.Allocator, endpoint: Endpoint, upload: bool) ![]const []const u8 {
+    var argv: std.ArrayList([]const u8) = .empty;
+    errdefer argv.deinit(allocator);
+    try argv.appendSlice(allocator, &.{ "curl", "--fail", "--silent", "--location", "--connect-timeout", "5", "--retry", "2" });
+    // Lookups stay quiet: a 404 is an ordinary miss.
+    if (upload) try argv.append(allocator, "--show-error");
+    // Credentials are expanded by curl from its own environment (curl >= 8.3)
+    // so they never appear on a command line.
+    if (endpoint.s3_region) |region| {
+        try argv.append(allocator, "--aws-sigv4");
+        try argv.append(allocator, try std.fmt.allocPrint(allocator, "aws:amz:{s}:s3", .{region}));
+        try argv.appendSlice(allocator, &.{
+            "--variable",    "%AWS_ACCESS_KEY_ID",
+            "--variable",    "%AWS_SECRET_ACCESS_KEY",
+            "--expand-user", "{{AWS_ACCESS_KEY_ID}}:{{AWS_SECRET_ACCESS_KEY}}",
+        });
+        if (core.runtime.getEnv("AWS_SESSION_TOKEN") != null) {
+            try argv.appendSlice(allocator, &.{
+                "--variable",      "%AWS_SESSION_TOKEN",
+                "--expand-header", "x-amz-security-token: {{AWS_SESSION_TOKEN}}",
+            });
+        }
+    } else if (core.runtime.getEnv("OVO_REMOTE_CACHE_TOKEN") != null) {
+        try argv.appendSlice(allocator, &.{
+            "--variable",      "%OVO_REMOTE_CACHE_TOKEN",
+            "--expand-header", "Authorization: Bearer {{OVO_REMOTE_CACHE_TOKEN}}",
+        });
+    }
+    return try argv.toOwnedSlice(allocator);
+}
@@ -0,0 +1,197 @@
+const std = @import("std");
+const builtin = @import("builtin");
+const core = @import("../core/mod.zig");
+const object_cache = @import("object_cache.zig");
+const target_graph = @import("target_graph.zig");
+
+/// Kept in the output dir next to the manifest.
+pub const file_name = "history.ovo";
+const header = "ovo-build-history 1";
+
+pub const Entry = struct {
+    wall_ns: u64,
+    /// Bytes; 0 where the platform doesn't report it.
+    peak_rss: u64 = 0,
+};
+
+/// Wall time and peak RSS of the last local run of every compile and link,
+/// keyed by its output path. The file holds `<wall µs>\t<rss KiB>\t<path>`
+/// lines after a version header.
+pub const History = struct {
+    entries: std.StringHashMapUnmanaged(Entry) = .empty,
+    dirty: bool = false,
+
+    /// Best effort: a missing or malformed history predicts nothing.
+    pub fn load(allocator: std.mem.Allocator, path: []const u8) History {
+        const bytes = core.fs.readFileAlloc(allocator, path) catch return .{};
+        return parse(allocator, bytes) catch .{};
+    }
+
+    pub fn save(self: *History, allocator: std.mem.Allocator, path: []const u8) !void {
+        if (!self.dirty) return;
+        try core.fs.writeFile(path, try render(allocator, self.*));
+        self.dirty = false;
+    }
+
+    /// Copies `output` the first time it is recorded.
+    pub fn record(self: *History, allocator: std.mem.Allocator, output: []const u8, entry: Entry) !void {
+        self.dirty = true;
+        if (self.entries.getPtr(output)) |existing| {
+            existing.* = entry;
+            return;
+        }
+        try self.entries.put(allocator, try allocator.dupe(u8, output), entry);
+    }
+
+    pub fn get(self: *const History, output: []const u8) ?Entry {
+        return self.entries.get(output);
+    }
+};
+
+/// Keys point into `bytes`.
+pub fn parse(allocator: std.mem.Allocator, bytes: []const u8) !History {
+    var lines = std.mem.splitScalar(u8, bytes, '\n');
+    if (!std.mem.eql(u8, lines.first(), header)) return error.InvalidBuildHistory;
+    var history: History = .{};
+    errdefer history.entries.deinit(allocator);
+    while (lines.next()) |line| {
+        if (line.len == 0) continue;
+        var fields = std.mem.splitScalar(u8, line, '\t');
+        const wall_us = std.fmt.parseInt(u64, fields.first(), 10) catch return error.InvalidBuildHistory;
+        const rss_kb = std.fmt.parseInt(u64, fields.next() orelse return error.InvalidBuildHistory, 10) catch return error.InvalidBuildHistory;
+        const path = fields.rest();
+        if (path.len == 0) return error.InvalidBuildHistory;
+        try history.entries.put(allocator, path, .{
+            .wall_ns = wall_us * std.time.ns_per_us,
+            .peak_rss = rss_kb * 1024,
+        });
+    }
+    return history;
+}
+
+pub fn render(allocator: std.mem.Allocator, history: History) ![]u8 {
+    const paths = try allocator.alloc([]const u8, history.entries.count());
+    defer allocator.free(paths);
+    var it = history.entries.keyIterator();
+    var i: usize = 0;
+    while (it.next()) |path| : (i += 1) paths[i] = path.*;
+    std.mem.sort([]const u8, paths, {}, stringLessThan);
+
+    var out: std.ArrayList(u8) = .empty;
+    errdefer out.deinit(allocator);
+    try out.print(allocator, "{s}\n", .{header});
+    for (paths) |path| {
+        const entry = history.entries.get(path).?;
+        try out.print(allocator, "{d}\t{d}\t{s}\n", .{ entry.wall_ns / std.time.ns_per_us, entry.peak_rss / 1024, path });
+    }
+    return try out.toOwnedSlice(allocator);
+}
+
+fn stringLessThan(_: void, a: []const u8, b: []const u8) bool {
+    return std.mem.lessThan(u8, a, b);
+}
+
+/// What one build expects of its jobs. An output without a history is
+/// assumed to take as long as the longest known step, so a new TU isn't
+/// started last, and to need the average known peak RSS.
+pub const Predictor = struct {
+    history: *const History,
+    unknown: Entry,
+
+    pub fn init(history: *const History) Predictor {
+        var longest: u64 = 0;
+        var rss_total: u64 = 0;
+        var rss_count: u64 = 0;
+        var it = history.entries.valueIterator();
+        while (it.next()) |entry| {
+            longest = @max(longest, entry.wall_ns);
+            if (entry.peak_rss == 0) continue;
+            rss_total += entry.peak_rss;
+            rss_count += 1;
+        }
+        return .{
+            .history = history,
+            .unknown = .{ .wall_ns = longest, .peak_rss = if (rss_count > 0) rss_total / rss_count else 0 },
+        };
+    }
+
+    pub fn predict(self: Predictor, output: []const u8) Entry {
+        return self.history.get(output) orelse self.unknown;
+    }
+};
+
+/// Per target, the longest predicted time from the start of its link to the
+/// end of the build: its own link plus the longest chain among the
+/// dependents whose links wait for it. A compile's priority is its own
+/// prediction plus its target's chain.
+pub fn chainTimes(allocator: std.mem.Allocator, graph: target_graph.Graph, link_ns: []const u64) ![]u64 {
+    const chain = try allocator.alloc(u64, link_ns.len);
+    errdefer allocator.free(chain);
+    const longest_dependent = try allocator.alloc(u64, link_ns.len);
+    defer allocator.free(longest_dependent);
+    @memset(longest_dependent, 0);
+    // Dependents come later in `order`, so one reverse pass sees them first.
+    var i = graph.order.len;
+    while (i > 0) {
+        i -= 1;
+        const index = graph.order[i];
+        chain[index] = link_ns[index] + longest_dependent[index];
+        for (graph.deps[index]) |dep| longest_dependent[dep] = @max(longest_dependent[dep], chain[index]);
+    }
+    return chain;
+}
+
+/// Without `-j`: one job per core the load average says is idle, but never
+/// fewer than half the cores, since the load average lags and still counts
+/// the jobs of a build that just finished.
+pub fn localJobs(cores: usize, load: ?f64) usize {
+    const busy: usize = if (load) |value| @intFromFloat(std.math.clamp(value, 0, @as(f64, @floatFromInt(cores)))) else 0;
+    return @max(@max(1, cores / 2), cores - busy);
+}
+
+/// Bytes of predicted peak RSS local jobs may hold at once: the memory
+/// available now, capped by the cgroup's remaining limit, less a tenth for
+/// everything else. `OVO_MEMORY_BUDGET` (e.g. `12G`) overrides it; 0 means
+/// no limit, which is also what platforms without `/proc` get.
+pub fn memoryBudget(allocator: std.mem.Allocator) u64 {
+    if (core.runtime.getEnv("OVO_MEMORY_BUDGET")) |text| return object_cache.parseSize(text) orelse 0;
+    if (builtin.os.tag != .linux) return 0;
+    const meminfo = core.fs.readFileAlloc(allocator, "/proc/meminfo") catch return 0;
+    var available = parseMemAvailable(meminfo) orelse return 0;
+    if (cgroupHeadroom(allocator)) |headroom| available = @min(available, headroom);
+    return available / 10 * 9;
+}
+
+/// One-minute load average, where `/proc/loadavg` exists.
+pub fn loadAverage(allocator: std.mem.Allocator) ?f64 {
+    if (builtin.os.tag != .linux) return null;
+    const bytes = core.fs.readFileAlloc(allocator, "/proc/loadavg") catch return null;
+    return parseLoadAverage(bytes);
+}
+
+/// `MemAvailable` from `/proc/meminfo`, in bytes.
+pub fn parseMemAvailable(meminfo: []const u8) ?u64 {
+    var lines = std.mem.splitScalar(u8, meminfo, '\n');
+    while (lines.next()) |line| {
+        if (!std.mem.startsWith(u8, line, "MemAvailable:")) continue;
+        var fields = std.mem.tokenizeAny(u8, line["MemAvailable:".len..], " \t");
+        const kb = std.fmt.parseInt(u64, fields.next() orelse return null, 10) catch return null;
+        return kb * 1024;
+    }
+    return null;
+}
+
+pub fn parseLoadAverage(loadavg: []const u8) ?f64 {
+    var fields = std.mem.tokenizeAny(u8, loadavg, " \t\n");
+    return std.fmt.parseFloat(f64, fields.next() orelse return null) catch null;
+}
+
+/// Room left under the cgroup v2 memory limit, for builds in containers
+/// whose limit is below the host's available memory. Null when unlimited.
+fn cgroupHeadroom(allocator: std.mem.Allocator) ?u64 {
+    const max_text = core.fs.readFileAlloc(allocator, "/sys/fs/cgroup/memory.max") catch return null;
+    const limit = std.fmt.parseInt(u64, std.mem.trim(u8, max_text, " \n"), 10) catch return null;
+    const current_text = core.fs.readFileAlloc(allocator, "/sys/fs/cgroup/memory.current") catch return null;
+    const current = std.fmt.parseInt(u64, std.mem.trim(u8, current_text, " \n"), 10) catch return null;
+    return limit -| current;
+}
@@ -0,0 +1,140 @@
+const std = @import("std");
+const project_mod = @import("../core/project.zig");
+
+/// Link-time dependencies between targets of one project. A `.link` entry
+/// that names a library target of the same project is an edge; any other
+/// entry is an external library passed straight to the linker.
+pub const Graph = struct {
+    targets: []const project_mod.Target,
+    /// `deps[i]` lists the in-project libraries target `i` links, in `.link` order.
+    deps: []const []const usize,
+    /// Every target appears after all of its dependencies.
+    order: []const usize,
+
+    /// Marks `roots` plus everything they transitively link.
+    pub fn closure(self: Graph, allocator: std.mem.Allocator, roots: []const bool) ![]bool {
+        const selected = try allocator.dupe(bool, roots);
+        // Dependents come later in `order`, so one reverse pass propagates.
+        var i = self.order.len;
+        while (i > 0) {
+            i -= 1;
+            const index = self.order[i];
+            if (!selected[index]) continue;
+            for (self.deps[index]) |dep| selected[dep] = true;
+        }
+        return selected;
+    }
+
+    /// Libraries to pass when linking target `index`. Static libraries don't
+    /// carry their dependencies, so those are pulled through to the final
+    /// link in dependents-first order, followed by every external library.
+    pub fn linkPlan(self: Graph, allocator: std.mem.Allocator, index: usize) !LinkPlan {
+        const visited = try allocator.alloc(bool, self.targets.len);
+        @memset(visited, false);
+        var post_order: std.ArrayList(usize) = .empty;
+        var external: std.ArrayList([]const u8) = .empty;
+        try self.collectLinks(allocator, index, visited, &post_order, &external);
+        std.mem.reverse(usize, post_order.items);
+        return .{
+            .project_libs = try post_order.toOwnedSlice(allocator),
+            .external = try external.toOwnedSlice(allocator),
+        };
+    }
+
+    fn collectLinks(
+        self: Graph,
+        allocator: std.mem.Allocator,
+        index: usize,
+        visited: []bool,
+        post_order: *std.ArrayList(usize),
+        external: *std.ArrayList([]const u8),
+    ) !void {
+        for (self.targets[index].link_libraries) |lib| {
+            if (self.libraryIndex(lib) != null) continue;
+            for (external.items) |seen| {
+                if (std.mem.eql(u8, seen, lib)) break;
+            } else try external.append(allocator, lib);
+        }
+        for (self.deps[index]) |dep| {
+            if (visited[dep]) continue;
+            visited[dep] = true;
+            if (self.targets[dep].kind == .library_static) {
+                try self.collectLinks(allocator, dep, visited, post_order, external);
+            }
+            try post_order.append(allocator, dep);
+        }
+    }
+
+    /// Static libraries that end up inside a shared library must be built
+    /// position independent.
+    pub fn needsPic(self: Graph, allocator: std.mem.Allocator) ![]bool {
+        const pic = try allocator.alloc(bool, self.targets.len);
+        for (self.targets, 0..) |target, i| pic[i] = target.kind == .library_shared;
+        var i = self.order.len;
+        while (i > 0) {
+            i -= 1;
+            const index = self.order[i];
+            if (!pic[index]) continue;
+            for (self.deps[index]) |dep| {
+                if (self.targets[dep].kind == .library_static) pic[dep] = true;
+            }
+        }
+        return pic;
+    }
+
+    pub fn libraryIndex(self: Graph, name: []const u8) ?usize {
+        for (self.targets, 0..) |target, i| {
+            if (target.kind != .library_static and target.kind != .library_shared) continue;
+            if (std.mem.eql(u8, target.name, name)) return i;
+        }
+        return null;
+    }
+};
+
+pub const LinkPlan = struct {
+    project_libs: []const usize,
+    external: []const []const u8,
+};
+
+/// Builds the graph and a topological order; a target that links itself,
+/// directly or through other targets, is reported as `error.DependencyCycle`.
+pub fn build(allocator: std.mem.Allocator, targets: []const project_mod.Target) !Graph {
+    var graph = Graph{ .targets = targets, .deps = &.{}, .order = &.{} };
+    const deps = try allocator.alloc([]const usize, targets.len);
+    for (targets, 0..) |target, i| {
+        var edges: std.ArrayList(usize) = .empty;
+        for (target.link_libraries) |lib| {
+            const dep = graph.libraryIndex(lib) orelse continue;
+            if (std.mem.indexOfScalar(usize, edges.items, dep) == null) try edges.append(allocator, dep);
+        }
+        deps[i] = try edges.toOwnedSlice(allocator);
+    }
+    graph.deps = deps;
+
+    const marks = try allocator.alloc(Mark, targets.len);
+    @memset(marks, .unvisited);
+    var order: std.ArrayList(usize) = .empty;
+    for (0..targets.len) |i| try visit(allocator, deps, marks, &order, i);
+    graph.order = try order.toOwnedSlice(allocator);
+    return graph;
+}
+
+const Mark = enum { unvisited, visiting, done };
+
+fn visit(
+    allocator: std.mem.Allocator,
+    deps: []const []const usize,
+    marks: []Mark,
+    order: *std.ArrayList(usize),
+    index: usize,
+) !void {
+    switch (marks[index]) {
+        .done => return,
+        .visiting => return error.DependencyCycle,
+        .unvisited => {},
+    }
+    marks[index] = .visiting;
+    for (deps[index]) |dep| try visit(allocator, deps, marks, order, dep);
+    marks[index] = .done;
+    try order.append(allocator, index);
+}
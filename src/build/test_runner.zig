@@ -0,0 +1,367 @@
+const std = @import("std");
+const core = @import("../core/mod.zig");
+const trace = @import("trace.zig");
+
+/// Duration of each test in its last run, for `--slowest-first`.
+pub const history_path = ".ovo/test-timings";
+/// Each test's combined stdout and stderr, kept from its last run.
+pub const default_log_dir = ".ovo/test-logs";
+
+/// How often the runner checks deadlines and reports finished tests.
+const poll_ms = 20;
+
+pub const Test = struct {
+    name: []const u8,
+    path: []const u8,
+};
+
+/// `--shard=i/n`: run the i-th of n shards, counting from 1.
+pub const Shard = struct {
+    index: u32,
+    count: u32,
+};
+
+pub fn parseShard(text: []const u8) !Shard {
+    const slash = std.mem.indexOfScalar(u8, text, '/') orelse return error.InvalidShard;
+    const index = std.fmt.parseInt(u32, text[0..slash], 10) catch return error.InvalidShard;
+    const count = std.fmt.parseInt(u32, text[slash + 1 ..], 10) catch return error.InvalidShard;
+    if (index == 0 or index > count) return error.InvalidShard;
+    return .{ .index = index, .count = count };
+}
+
+/// The tests `shard` runs, in name order. Shard i of n takes every n-th test
+/// from the i-th, so every machine computes the same disjoint split.
+pub fn select(allocator: std.mem.Allocator, tests: []const Test, shard: ?Shard) ![]Test {
+    const sorted = try allocator.dupe(Test, tests);
+    defer allocator.free(sorted);
+    std.mem.sort(Test, sorted, {}, nameLessThan);
+
+    var selected: std.ArrayList(Test) = .empty;
+    errdefer selected.deinit(allocator);
+    for (sorted, 0..) |item, i| {
+        if (shard) |s| {
+            if (i % s.count != s.index - 1) continue;
+        }
+        try selected.append(allocator, item);
+    }
+    return try selected.toOwnedSlice(allocator);
+}
+
+fn nameLessThan(_: void, a: Test, b: Test) bool {
+    return std.mem.lessThan(u8, a.name, b.name);
+}
+
+/// Milliseconds each test took in its last run, by test name.
+pub const History = std.StringHashMapUnmanaged(u64);
+
+/// Reads `<ms> <name>` lines. The history is only a hint, so malformed
+/// lines are skipped.
+pub fn parseHistory(allocator: std.mem.Allocator, bytes: []const u8) !History {
+    var history: History = .empty;
+    errdefer history.deinit(allocator);
+    var lines = std.mem.tokenizeScalar(u8, bytes, '\n');
+    while (lines.next()) |line| {
+        const space = std.mem.indexOfScalar(u8, line, ' ') orelse continue;
+        const ms = std.fmt.parseInt(u64, line[0..space], 10) catch continue;
+        const name = line[space + 1 ..];
+        if (name.len == 0) continue;
+        try history.put(allocator, name, ms);
+    }
+    return history;
+}
+
+pub fn renderHistory(allocator: std.mem.Allocator, history: History) ![]u8 {
+    const names = try allocator.alloc([]const u8, history.count());
+    defer allocator.free(names);
+    var it = history.keyIterator();
+    var i: usize = 0;
+    while (it.next()) |name| : (i += 1) names[i] = name.*;
+    std.mem.sort([]const u8, names, {}, stringLessThan);
+
+    var out: std.ArrayList(u8) = .empty;
+    errdefer out.deinit(allocator);
+    for (names) |name| try out.print(allocator, "{d} {s}\n", .{ history.get(name).?, name });
+    return try out.toOwnedSlice(allocator);
+}
+
+fn stringLessThan(_: void, a: []const u8, b: []const u8) bool {
+    return std.mem.lessThan(u8, a, b);
+}
+
+/// Best effort: a missing or unreadable history orders tests by name.
+pub fn loadHistory(allocator: std.mem.Allocator) History {
+    const bytes = core.fs.readFileAlloc(allocator, history_path) catch return .empty;
+    return parseHistory(allocator, bytes) catch .empty;
+}
+
+/// Records this run's durations; tests on other shards keep theirs.
+pub fn saveHistory(allocator: std.mem.Allocator, history: *History, results: []const Result) !void {
+    for (results) |result| try history.put(allocator, result.name, result.duration_ns / std.time.ns_per_ms);
+    try core.fs.writeFile(history_path, try renderHistory(allocator, history.*));
+}
+
+/// Orders `tests` longest first by their last run, so the slowest ones
+/// don't start last and stretch the wall time. Tests without a history go
+/// first, since nothing says they are quick.
+pub fn orderSlowestFirst(tests: []Test, history: *const History) void {
+    std.mem.sort(Test, tests, history, slowerFirst);
+}
+
+fn slowerFirst(history: *const History, a: Test, b: Test) bool {
+    const a_ms = history.get(a.name) orelse std.math.maxInt(u64);
+    const b_ms = history.get(b.name) orelse std.math.maxInt(u64);
+    if (a_ms != b_ms) return a_ms > b_ms;
+    return std.mem.lessThan(u8, a.name, b.name);
+}
+
+pub const Status = enum { passed, failed, timed_out };
+
+pub const Result = struct {
+    name: []const u8,
+    status: Status = .passed,
+    exit_code: u8 = 0,
+    duration_ns: u64 = 0,
+    log_path: []const u8,
+    /// Captured stdout and stderr, read back for tests that didn't pass.
+    output: []const u8 = "",
+};
+
+pub const Options = struct {
+    jobs: usize,
+    /// Kills a test that runs longer and reports it as timed out.
+    timeout_ms: ?u64 = null,
+    log_dir: []const u8 = default_log_dir,
+};
+
+/// One worker's running test, where the calling thread can kill it.
+const Slot = struct {
+    mutex: std.Thread.Mutex = .{},
+    running: ?*const core.exec.Logged = null,
+    deadline_ns: i128 = 0,
+    timed_out: bool = false,
+};
+
+const RunState = struct {
+    tests: []const Test,
+    results: []Result,
+    timeout_ms: ?u64,
+    next: std.atomic.Value(usize) = .init(0),
+    mutex: std.Thread.Mutex = .{},
+    /// Indices of finished tests in completion order; the first `finished`
+    /// are valid.
+    completed: []usize,
+    finished: usize = 0,
+};
+
+/// Runs `tests` with at most `options.jobs` in flight, each with its output
+/// captured to a log under `options.log_dir`. A failure doesn't stop the
+/// others. `reporter.finished(result)` is called on the calling thread as
+/// each test completes; results come back in the order of `tests`.
+pub fn run(allocator: std.mem.Allocator, tests: []const Test, options: Options, reporter: anytype) ![]Result {
+    const results = try allocator.alloc(Result, tests.len);
+    if (tests.len == 0) return results;
+    try core.fs.ensureDir(options.log_dir);
+    for (results, tests) |*result, item| {
+        result.* = .{ .name = item.name, .log_path = try logPath(allocator, options.log_dir, item.name) };
+    }
+
+    var state = RunState{
+        .tests = tests,
+        .results = results,
+        .timeout_ms = options.timeout_ms,
+        .completed = try allocator.alloc(usize, tests.len),
+    };
+    const worker_count = @max(1, @min(options.jobs, tests.len));
+    const slots = try allocator.alloc(Slot, worker_count);
+    for (slots) |*slot| slot.* = .{};
+    const threads = try allocator.alloc(std.Thread, worker_count);
+    var spawned: usize = 0;
+    defer for (threads[0..spawned]) |thread| thread.join();
+    for (threads, slots) |*thread, *slot| {
+        thread.* = std.Thread.spawn(.{}, worker, .{ &state, slot }) catch break;
+        spawned += 1;
+    }
+    // Without workers the tests run here, one at a time and without a deadline.
+    if (spawned == 0) worker(&state, &slots[0]);
+
+    var reported: usize = 0;
+    while (true) {
+        state.mutex.lock();
+        const finished = state.finished;
+        state.mutex.unlock();
+        while (reported < finished) : (reported += 1) {
+            const result = &results[state.completed[reported]];
+            if (result.status != .passed) {
+                result.output = core.fs.readFileAlloc(allocator, result.log_path) catch "";
+            }
+            try reporter.finished(result.*);
+        }
+        if (reported == tests.len) return results;
+        if (options.timeout_ms != null) expire(slots);
+        core.runtime.sleepMs(poll_ms) catch {};
+    }
+}
+
+fn worker(state: *RunState, slot: *Slot) void {
+    while (true) {
+        const index = state.next.fetchAdd(1, .monotonic);
+        if (index >= state.tests.len) return;
+        runOne(state, slot, index);
+        state.mutex.lock();
+        defer state.mutex.unlock();
+        state.completed[state.finished] = index;
+        state.finished += 1;
+    }
+}
+
+fn runOne(state: *RunState, slot: *Slot, index: usize) void {
+    const result = &state.results[index];
+    const path = state.tests[index].path;
+    const started_ns = core.runtime.nowNs();
+    defer result.duration_ns = @intCast(core.runtime.nowNs() - started_ns);
+
+    var process = core.exec.spawnLogged(&.{path}, result.log_path) catch |err| {
+        result.status = .failed;
+        result.exit_code = 127;
+        var buf: [512]u8 = undefined;
+        const message = std.fmt.bufPrint(&buf, "error: unable to run '{s}': {s}\n", .{ path, @errorName(err) }) catch "";
+        core.fs.writeFile(result.log_path, message) catch {};
+        return;
+    };
+    slot.mutex.lock();
+    slot.running = &process;
+    slot.deadline_ns = if (state.timeout_ms) |ms| started_ns + @as(i128, ms) * std.time.ns_per_ms else 0;
+    slot.timed_out = false;
+    slot.mutex.unlock();
+
+    // The slot lets go of the child before it is reaped, so `expire` never
+    // kills a process that has been given its pid since.
+    process.awaitExit();
+    slot.mutex.lock();
+    slot.running = null;
+    const timed_out = slot.timed_out;
+    slot.mutex.unlock();
+    const code = process.wait() catch 127;
+    result.exit_code = code;
+    result.status = if (timed_out) .timed_out else if (code == 0) .passed else .failed;
+}
+
+fn expire(slots: []Slot) void {
+    const now_ns = core.runtime.nowNs();
+    for (slots) |*slot| {
+        slot.mutex.lock();
+        defer slot.mutex.unlock();
+        const process = slot.running orelse continue;
+        if (slot.timed_out or now_ns < slot.deadline_ns) continue;
+        process.kill();
+        slot.timed_out = true;
+    }
+}
+
+/// Log file of test `name`; anything but a plain file name character
+/// becomes `_`.
+pub fn logPath(allocator: std.mem.Allocator, dir: []const u8, name: []const u8) ![]u8 {
+    const path = try std.fmt.allocPrint(allocator, "{s}/{s}.log", .{ dir, name });
+    for (path[dir.len + 1 ..][0..name.len]) |*c| {
+        if (!std.ascii.isAlphanumeric(c.*) and c.* != '-' and c.* != '_' and c.* != '.') c.* = '_';
+    }
+    return path;
+}
+
+pub fn failureCount(results: []const Result) usize {
+    var count: usize = 0;
+    for (results) |result| {
+        if (result.status != .passed) count += 1;
+    }
+    return count;
+}
+
+fn totalNs(results: []const Result) u64 {
+    var total: u64 = 0;
+    for (results) |result| total += result.duration_ns;
+    return total;
+}
+
+fn seconds(ns: u64) f64 {
+    return @as(f64, @floatFromInt(ns)) / std.time.ns_per_s;
+}
+
+/// JUnit XML as CI servers read it: one `testcase` per test, with a
+/// `failure` holding the captured output of tests that didn't pass.
+pub fn renderJUnit(allocator: std.mem.Allocator, suite: []const u8, results: []const Result) ![]u8 {
+    var out: std.ArrayList(u8) = .empty;
+    errdefer out.deinit(allocator);
+    const failures = failureCount(results);
+    const time = seconds(totalNs(results));
+    try out.appendSlice(allocator, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    try out.print(allocator, "<testsuites tests=\"{d}\" failures=\"{d}\" time=\"{d:.3}\">\n", .{ results.len, failures, time });
+    try out.print(allocator, "  <testsuite name=\"{f}\" tests=\"{d}\" failures=\"{d}\" time=\"{d:.3}\">\n", .{
+        xmlText(suite),
+        results.len,
+        failures,
+        time,
+    });
+    for (results) |result| {
+        try out.print(allocator, "    <testcase name=\"{f}\" classname=\"{f}\" time=\"{d:.3}\"", .{
+            xmlText(result.name),
+            xmlText(suite),
+            seconds(result.duration_ns),
+        });
+        if (result.status == .passed) {
+            try out.appendSlice(allocator, "/>\n");
+            continue;
+        }
+        try out.appendSlice(allocator, ">\n      <failure message=\"");
+        switch (result.status) {
+            .timed_out => try out.appendSlice(allocator, "timed out"),
+            else => try out.print(allocator, "exit code {d}", .{result.exit_code}),
+        }
+        try out.print(allocator, "\">{f}</failure>\n    </testcase>\n", .{xmlText(result.output)});
+    }
+    try out.appendSlice(allocator, "  </testsuite>\n</testsuites>\n");
+    return try out.toOwnedSlice(allocator);
+}
+
+pub fn renderJson(allocator: std.mem.Allocator, suite: []const u8, results: []const Result) ![]u8 {
+    var out: std.ArrayList(u8) = .empty;
+    errdefer out.deinit(allocator);
+    try out.print(allocator, "{{\"suite\":\"{f}\",\"tests\":{d},\"failures\":{d},\"duration_ms\":{d},\"results\":[", .{
+        trace.jsonString(suite),
+        results.len,
+        failureCount(results),
+        totalNs(results) / std.time.ns_per_ms,
+    });
+    for (results, 0..) |result, i| {
+        if (i > 0) try out.append(allocator, ',');
+        try out.print(allocator, "\n{{\"name\":\"{f}\",\"status\":\"{s}\",\"exit_code\":{d},\"duration_ms\":{d},\"log\":\"{f}\"}}", .{
+            trace.jsonString(result.name),
+            @tagName(result.status),
+            result.exit_code,
+            result.duration_ns / std.time.ns_per_ms,
+            trace.jsonString(result.log_path),
+        });
+    }
+    try out.appendSlice(allocator, "\n]}\n");
+    return try out.toOwnedSlice(allocator);
+}
+
+fn xmlText(value: []const u8) XmlText {
+    return .{ .value = value };
+}
+
+const XmlText = struct {
+    value: []const u8,
+
+    pub fn format(self: XmlText, w: *std.Io.Writer) std.Io.Writer.Error!void {
+        for (self.value) |c| switch (c) {
+            '&' => try w.writeAll("&amp;"),
+            '<' => try w.writeAll("&lt;"),
+            '>' => try w.writeAll("&gt;"),
+            '"' => try w.writeAll("&quot;"),
+            '\t', '\n', '\r' => try w.writeByte(c),
+            // Not allowed in XML 1.0, even escaped.
+            0...8, 11, 12, 14...31 => try w.writeByte('?'),
+            else => try w.writeByte(c),
+        };
+    }
+};
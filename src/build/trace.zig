@@ -0,0 +1,295 @@
+const std = @import("std");
+const core = @import("../core/mod.zig");
+
+pub const Category = enum {
+    project,
+    glob,
+    scan,
+    cache,
+    compile,
+    archive,
+    link,
+    output,
+};
+
+/// One timed step of a build. Lane 0 is the scheduling thread; pool
+/// workers are lanes 1 and up.
+pub const Event = struct {
+    name: []const u8,
+    category: Category,
+    start_ns: i128,
+    end_ns: i128,
+    lane: u32 = 0,
+    /// Set for compile, archive and link steps.
+    exit_code: ?u8 = null,
+    backend: ?[]const u8 = null,
+    /// Events that had to finish before this one could start.
+    after: []const usize = &.{},
+    /// Expected duration from the build history; 0 for steps it doesn't cover.
+    predicted_ns: u64 = 0,
+
+    pub fn durationNs(self: Event) i128 {
+        return self.end_ns - self.start_ns;
+    }
+};
+
+/// Collects build events for `--timings`. Only the thread that drives the
+/// build records; pool jobs carry their own timestamps and lane, which the
+/// scheduler copies in when it collects them.
+pub const Recorder = struct {
+    allocator: std.mem.Allocator,
+    origin_ns: i128,
+    events: std.ArrayList(Event) = .empty,
+
+    pub fn init(allocator: std.mem.Allocator) Recorder {
+        return .{ .allocator = allocator, .origin_ns = core.runtime.nowNs() };
+    }
+
+    pub fn now() i128 {
+        return core.runtime.nowNs();
+    }
+
+    /// Records `event`, copying its name and dependency list, and returns
+    /// its index for later `after` lists.
+    pub fn record(self: *Recorder, event: Event) !usize {
+        var owned = event;
+        owned.name = try self.allocator.dupe(u8, event.name);
+        owned.after = try self.allocator.dupe(usize, event.after);
+        try self.events.append(self.allocator, owned);
+        return self.events.items.len - 1;
+    }
+
+    /// Records a step on the scheduling thread that started at `start_ns`
+    /// and ends now.
+    pub fn finish(self: *Recorder, category: Category, start_ns: i128, comptime fmt: []const u8, args: anytype) !void {
+        const end_ns = now();
+        try self.events.append(self.allocator, .{
+            .name = try std.fmt.allocPrint(self.allocator, fmt, args),
+            .category = category,
+            .start_ns = start_ns,
+            .end_ns = end_ns,
+        });
+    }
+};
+
+/// Chrome trace-event JSON, loadable in chrome://tracing and Perfetto.
+pub fn renderChromeTrace(allocator: std.mem.Allocator, events: []const Event, origin_ns: i128) ![]u8 {
+    var out: std.ArrayList(u8) = .empty;
+    errdefer out.deinit(allocator);
+    try out.appendSlice(allocator, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    var lanes: u32 = 0;
+    for (events) |event| lanes = @max(lanes, event.lane + 1);
+    var lane: u32 = 0;
+    while (lane < lanes) : (lane += 1) {
+        try out.print(allocator, "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{d},\"args\":{{\"name\":", .{lane});
+        if (lane == 0) {
+            try out.appendSlice(allocator, "\"ovo\"}},\n");
+        } else {
+            try out.print(allocator, "\"worker {d}\"}}}},\n", .{lane});
+        }
+    }
+
+    for (events, 0..) |event, i| {
+        if (i > 0) try out.appendSlice(allocator, ",\n");
+        try out.print(allocator, "{{\"name\":\"{f}\",\"cat\":\"{s}\",\"ph\":\"X\",\"pid\":1,\"tid\":{d},\"ts\":{d:.3},\"dur\":{d:.3}", .{
+            jsonString(event.name),
+            @tagName(event.category),
+            event.lane,
+            micros(event.start_ns - origin_ns),
+            micros(event.durationNs()),
+        });
+        if (event.exit_code != null or event.backend != null) {
+            try out.appendSlice(allocator, ",\"args\":{");
+            if (event.backend) |backend| try out.print(allocator, "\"backend\":\"{f}\"", .{jsonString(backend)});
+            if (event.exit_code) |code| {
+                if (event.backend != null) try out.append(allocator, ',');
+                try out.print(allocator, "\"exit\":{d}", .{code});
+            }
+            try out.append(allocator, '}');
+        }
+        try out.append(allocator, '}');
+    }
+    try out.appendSlice(allocator, "\n]}\n");
+    return try out.toOwnedSlice(allocator);
+}
+
+fn micros(ns: i128) f64 {
+    return @as(f64, @floatFromInt(ns)) / std.time.ns_per_us;
+}
+
+/// Indices of the chain of events that bounded the build's wall time: from
+/// the step that finished last, back through whichever prerequisite of
+/// each step finished last. Returned in execution order.
+pub fn criticalPath(allocator: std.mem.Allocator, events: []const Event) ![]const usize {
+    var path: std.ArrayList(usize) = .empty;
+    errdefer path.deinit(allocator);
+    var current: ?usize = null;
+    for (events, 0..) |event, i| {
+        if (!isStep(event)) continue;
+        if (current == null or event.end_ns > events[current.?].end_ns) current = i;
+    }
+    while (current) |index| {
+        try path.append(allocator, index);
+        current = null;
+        for (events[index].after) |dep| {
+            if (current == null or events[dep].end_ns > events[current.?].end_ns) current = dep;
+        }
+    }
+    std.mem.reverse(usize, path.items);
+    return try path.toOwnedSlice(allocator);
+}
+
+/// The path `criticalPath` would have taken had every step lasted its
+/// prediction: the longest chain of predicted durations through `after`.
+pub fn predictedCriticalPath(allocator: std.mem.Allocator, events: []const Event) ![]const usize {
+    // Events are recorded after everything in their `after` list, so one
+    // forward pass sees every prerequisite first.
+    const longest = try allocator.alloc(u64, events.len);
+    defer allocator.free(longest);
+    const previous = try allocator.alloc(?usize, events.len);
+    defer allocator.free(previous);
+    var last: ?usize = null;
+    for (events, 0..) |event, i| {
+        longest[i] = 0;
+        previous[i] = null;
+        if (!isStep(event)) continue;
+        for (event.after) |dep| {
+            if (previous[i] == null or longest[dep] > longest[previous[i].?]) previous[i] = dep;
+        }
+        longest[i] = event.predicted_ns + if (previous[i]) |dep| longest[dep] else 0;
+        if (last == null or longest[i] > longest[last.?]) last = i;
+    }
+
+    var path: std.ArrayList(usize) = .empty;
+    errdefer path.deinit(allocator);
+    var current = last;
+    while (current) |index| : (current = previous[index]) try path.append(allocator, index);
+    std.mem.reverse(usize, path.items);
+    return try path.toOwnedSlice(allocator);
+}
+
+/// `ovo build --explain`: the critical path the history predicted next to
+/// the one the build took, each step with its predicted and actual time.
+pub fn renderExplain(allocator: std.mem.Allocator, events: []const Event) ![]u8 {
+    var out: std.ArrayList(u8) = .empty;
+    errdefer out.deinit(allocator);
+    const predicted = try predictedCriticalPath(allocator, events);
+    const actual = try criticalPath(allocator, events);
+    if (actual.len == 0) {
+        try out.appendSlice(allocator, "explain: nothing was compiled or linked\n");
+        return try out.toOwnedSlice(allocator);
+    }
+
+    var predicted_total: u64 = 0;
+    for (predicted) |i| predicted_total += events[i].predicted_ns;
+    var actual_total: i128 = 0;
+    for (actual) |i| actual_total += events[i].durationNs();
+    try out.print(allocator, "explain: critical path predicted {d:.3}s, took {d:.3}s\n", .{ seconds(predicted_total), seconds(actual_total) });
+    try appendExplainedPath(allocator, &out, "predicted", events, predicted);
+    if (std.mem.eql(usize, predicted, actual)) {
+        try out.appendSlice(allocator, "  the build took the predicted path\n");
+    } else {
+        try appendExplainedPath(allocator, &out, "actual", events, actual);
+    }
+
+    var unknown: usize = 0;
+    for (events) |event| {
+        if (isStep(event) and event.predicted_ns == 0) unknown += 1;
+    }
+    if (unknown > 0) try out.print(allocator, "  {d} step(s) had no history\n", .{unknown});
+    return try out.toOwnedSlice(allocator);
+}
+
+fn appendExplainedPath(allocator: std.mem.Allocator, out: *std.ArrayList(u8), label: []const u8, events: []const Event, path: []const usize) !void {
+    try out.print(allocator, "  {s} path (predicted, actual):\n", .{label});
+    for (path) |i| {
+        const event = events[i];
+        try out.print(allocator, "    {d:>8.3}s {d:>8.3}s  {s} {s}\n", .{
+            seconds(event.predicted_ns),
+            seconds(event.durationNs()),
+            @tagName(event.category),
+            event.name,
+        });
+    }
+}
+
+/// Indices of the `limit` longest compile steps, longest first.
+pub fn slowestCompiles(allocator: std.mem.Allocator, events: []const Event, limit: usize) ![]const usize {
+    var compiles: std.ArrayList(usize) = .empty;
+    errdefer compiles.deinit(allocator);
+    for (events, 0..) |event, i| {
+        if (event.category == .compile) try compiles.append(allocator, i);
+    }
+    std.mem.sort(usize, compiles.items, events, longerFirst);
+    compiles.shrinkRetainingCapacity(@min(limit, compiles.items.len));
+    return try compiles.toOwnedSlice(allocator);
+}
+
+fn longerFirst(events: []const Event, a: usize, b: usize) bool {
+    return events[a].durationNs() > events[b].durationNs();
+}
+
+fn isStep(event: Event) bool {
+    return switch (event.category) {
+        .compile, .archive, .link => true,
+        else => false,
+    };
+}
+
+/// Human-readable totals, the slowest translation units and the critical path.
+pub fn renderSummary(allocator: std.mem.Allocator, events: []const Event, origin_ns: i128) ![]u8 {
+    var out: std.ArrayList(u8) = .empty;
+    errdefer out.deinit(allocator);
+
+    var end_ns = origin_ns;
+    var compiles: usize = 0;
+    var lanes: u32 = 0;
+    for (events) |event| {
+        end_ns = @max(end_ns, event.end_ns);
+        if (event.category == .compile) compiles += 1;
+        lanes = @max(lanes, event.lane);
+    }
+    try out.print(allocator, "timings: {d:.3}s wall, {d} compile(s) on {d} worker(s)\n", .{ seconds(end_ns - origin_ns), compiles, lanes });
+
+    const slowest = try slowestCompiles(allocator, events, 10);
+    if (slowest.len > 0) {
+        try out.appendSlice(allocator, "  slowest translation units:\n");
+        for (slowest) |i| try out.print(allocator, "    {d:>8.3}s  {s}\n", .{ seconds(events[i].durationNs()), events[i].name });
+    }
+
+    const path = try criticalPath(allocator, events);
+    if (path.len > 0) {
+        var total: i128 = 0;
+        for (path) |i| total += events[i].durationNs();
+        try out.print(allocator, "  critical path ({d:.3}s):\n", .{seconds(total)});
+        for (path) |i| {
+            try out.print(allocator, "    {d:>8.3}s  {s} {s}\n", .{ seconds(events[i].durationNs()), @tagName(events[i].category), events[i].name });
+        }
+    }
+    return try out.toOwnedSlice(allocator);
+}
+
+fn seconds(ns: i128) f64 {
+    return @as(f64, @floatFromInt(ns)) / std.time.ns_per_s;
+}
+
+/// Formats `value` as the inside of a JSON string literal.
+pub fn jsonString(value: []const u8) JsonString {
+    return .{ .value = value };
+}
+
+pub const JsonString = struct {
+    value: []const u8,
+
+    pub fn format(self: JsonString, w: *std.Io.Writer) std.Io.Writer.Error!void {
+        for (self.value) |c| switch (c) {
+            '"' => try w.writeAll("\\\""),
+            '\\' => try w.writeAll("\\\\"),
+            '\n' => try w.writeAll("\\n"),
+            '\t' => try w.writeAll("\\t"),
+            0...8, 11...31 => try w.print("\\u{x:0>4}", .{c}),
+            else => try w.writeByte(c),
+        };
+    }
+};
@@ -0,0 +1,79 @@
+const std = @import("std");
+const manifest_mod = @import("manifest.zig");
+
+/// Sources per batch when a target turns unity builds on without `.unity_batch`.
+pub const default_batch = 8;
+
+/// Batch size for a target's unity settings, or null when it compiles
+/// source by source. `force` is `ovo build --unity`.
+pub fn batchSize(unity: bool, unity_batch: ?u32, force: bool) ?usize {
+    if (unity_batch) |size| return if (size > 1) size else null;
+    return if (unity or force) default_batch else null;
+}
+
+/// Splits `sources` into batches of about `size`. Sources are taken in path
+/// order and a batch closes after a source whose path hash is a multiple of
+/// `size`, so where batches split depends on the paths there, not on how
+/// many sources come before. Adding or removing a source changes only the
+/// batch it falls in; the rest keep their contents and their cached objects.
+/// Batches are capped at twice `size`.
+pub fn batches(allocator: std.mem.Allocator, sources: []const []const u8, size: usize) ![]const []const []const u8 {
+    const sorted = try allocator.dupe([]const u8, sources);
+    std.mem.sort([]const u8, sorted, {}, lessThan);
+
+    var out: std.ArrayList([]const []const u8) = .empty;
+    errdefer out.deinit(allocator);
+    var start: usize = 0;
+    for (sorted, 0..) |source, i| {
+        const len = i + 1 - start;
+        if (std.hash.Wyhash.hash(0, source) % size == 0 or len == 2 * size or i + 1 == sorted.len) {
+            try out.append(allocator, sorted[start .. i + 1]);
+            start = i + 1;
+        }
+    }
+    return try out.toOwnedSlice(allocator);
+}
+
+fn lessThan(_: void, a: []const u8, b: []const u8) bool {
+    return std.mem.lessThan(u8, a, b);
+}
+
+/// Generated source for the batch starting with `first`, under `dir`.
+pub fn unitPath(allocator: std.mem.Allocator, dir: []const u8, first: []const u8, ext: []const u8) ![]u8 {
+    const name = try manifest_mod.objectFileName(allocator, first, ext);
+    defer allocator.free(name);
+    return std.fmt.allocPrint(allocator, "{s}/unity-{s}", .{ dir, name });
+}
+
+/// What a unity source for `dir` puts in front of project-relative paths.
+/// Quoted includes resolve against the including file, so a relative `dir`
+/// climbs back to the project root; otherwise paths are made absolute.
+pub fn includePrefix(allocator: std.mem.Allocator, dir: []const u8, cwd: []const u8) ![]u8 {
+    var prefix: std.ArrayList(u8) = .empty;
+    errdefer prefix.deinit(allocator);
+    if (!std.fs.path.isAbsolute(dir)) relative: {
+        var parts = std.mem.tokenizeAny(u8, dir, "/\\");
+        while (parts.next()) |part| {
+            if (std.mem.eql(u8, part, "..")) {
+                prefix.clearRetainingCapacity();
+                break :relative;
+            }
+            if (std.mem.eql(u8, part, ".")) continue;
+            try prefix.appendSlice(allocator, "../");
+        }
+        return try prefix.toOwnedSlice(allocator);
+    }
+    try prefix.print(allocator, "{s}/", .{cwd});
+    return try prefix.toOwnedSlice(allocator);
+}
+
+pub fn render(allocator: std.mem.Allocator, members: []const []const u8, prefix: []const u8) ![]u8 {
+    var out: std.ArrayList(u8) = .empty;
+    errdefer out.deinit(allocator);
+    try out.print(allocator, "// Generated by ovo: unity batch of {d} sources.\n", .{members.len});
+    for (members) |member| {
+        const member_prefix = if (std.fs.path.isAbsolute(member)) "" else prefix;
+        try out.print(allocator, "#include \"{s}{s}\"\n", .{ member_prefix, member });
+    }
+    return try out.toOwnedSlice(allocator);
+}
@@ -0,0 +1,415 @@
+const std = @import("std");
+const builtin = @import("builtin");
+const core = @import("../core/mod.zig");
+const zon = @import("../zon/mod.zig");
+const orchestrator = @import("orchestrator.zig");
+
+/// Quiet period that folds a burst of saves (or a branch switch) into one rebuild.
+pub const default_debounce_ms = 100;
+
+/// Rescan interval where the platform has no native backend.
+const poll_interval_ms = 250;
+
+/// Builds, then rebuilds every time a file the build read changes, until the
+/// process is interrupted. One workspace is kept open across rebuilds, so
+/// the project, manifest, header database and glob index stay in memory and
+/// a rebuild only fingerprints what it has to. A change to `build.zon`
+/// reopens the workspace.
+///
+/// `reporter.built(allocator, result)` is called after every build attempt
+/// with the build's scratch allocator; a failed build is reported the same
+/// way and the loop waits for the next change. `allocator` only holds the
+/// watched paths; per-build and per-workspace memory comes from arenas that
+/// are handed back to the page allocator, since the loop never returns.
+pub fn run(allocator: std.mem.Allocator, options: orchestrator.BuildOptions, reporter: anytype) !void {
+    var watcher = Watcher.init(allocator);
+    defer watcher.deinit();
+    var cycle_arena = std.heap.ArenaAllocator.init(core.memory.page_allocator);
+    defer cycle_arena.deinit();
+    var loaded = options.project;
+
+    while (true) {
+        // Everything the workspace keeps is released when build.zon changes.
+        var workspace_arena = std.heap.ArenaAllocator.init(core.memory.page_allocator);
+        defer workspace_arena.deinit();
+        _ = cycle_arena.reset(.retain_capacity);
+
+        defer loaded = null;
+        var open_options = options;
+        open_options.project = loaded;
+        const workspace = orchestrator.Workspace.open(workspace_arena.allocator(), open_options) catch |err| {
+            try reporter.built(cycle_arena.allocator(), err);
+            try watcher.watch(&.{zon.snapshot.zon_path}, &.{});
+            _ = try watcher.wait(cycle_arena.allocator(), default_debounce_ms);
+            continue;
+        };
+        defer workspace.close();
+        workspace.track_inputs = true;
+
+        while (true) {
+            _ = cycle_arena.reset(.retain_capacity);
+            const scratch = cycle_arena.allocator();
+            try reporter.built(scratch, workspace.build(scratch, options));
+
+            try watcher.watch(&.{zon.snapshot.zon_path}, workspace.inputs.keys());
+            var dirs: std.ArrayList([]const u8) = .empty;
+            var visited = workspace.sources.visitedDirs();
+            while (visited.next()) |dir| try dirs.append(scratch, dir.*);
+            try watcher.watch(&.{}, dirs.items);
+
+            const changed = try watcher.wait(scratch, default_debounce_ms);
+            if (containsPath(changed, zon.snapshot.zon_path)) break;
+        }
+    }
+}
+
+fn containsPath(paths: []const []const u8, wanted: []const u8) bool {
+    for (paths) |path| {
+        if (std.mem.eql(u8, path, wanted)) return true;
+    }
+    return false;
+}
+
+/// Reports changes to a set of files and directories. Files are watched
+/// for edits, replacement and removal; directories for entries being added,
+/// removed or renamed, which is how a glob gains or loses a match. Uses
+/// inotify on Linux and kqueue on macOS, and rescans modification times
+/// everywhere else or when the native backend runs out of watches.
+/// Watched paths are kept for the life of the watcher.
+pub const Watcher = struct {
+    allocator: std.mem.Allocator,
+    entries: std.StringArrayHashMapUnmanaged(Entry) = .empty,
+    backend: union(enum) {
+        native: Native,
+        polling,
+    },
+
+    const Entry = struct {
+        kind: Kind,
+        /// As of the last rescan; null while the path doesn't exist.
+        stamp: ?core.fs.Fingerprint,
+    };
+
+    const Kind = enum { file, dir };
+
+    pub fn init(allocator: std.mem.Allocator) Watcher {
+        const native = Native.init() catch return .{ .allocator = allocator, .backend = .polling };
+        return .{ .allocator = allocator, .backend = .{ .native = native } };
+    }
+
+    pub fn deinit(self: *Watcher) void {
+        switch (self.backend) {
+            .native => |*native| native.deinit(self.allocator),
+            .polling => {},
+        }
+        self.entries.deinit(self.allocator);
+    }
+
+    pub fn watch(self: *Watcher, files: []const []const u8, dirs: []const []const u8) !void {
+        for (files) |path| try self.add(path, .file);
+        for (dirs) |path| try self.add(path, .dir);
+    }
+
+    fn add(self: *Watcher, raw_path: []const u8, kind: Kind) !void {
+        const path = normalizePath(raw_path);
+        const entry = try self.entries.getOrPut(self.allocator, path);
+        if (!entry.found_existing) {
+            entry.key_ptr.* = try self.allocator.dupe(u8, path);
+            entry.value_ptr.* = .{ .kind = kind, .stamp = core.fs.fingerprint(path) catch null };
+        }
+        // Known paths are passed on as well: a directory that was missing,
+        // or was removed and recreated as by a branch switch, has no native
+        // watch until it is added again. Backends skip what they watch.
+        switch (self.backend) {
+            .native => |*native| native.add(self.allocator, entry.key_ptr.*, kind) catch |err| switch (err) {
+                error.WatchLimit => {
+                    core.runtime.printErr("warning: watch: out of native watches, polling instead\n", .{});
+                    native.deinit(self.allocator);
+                    self.backend = .polling;
+                },
+                else => return err,
+            },
+            .polling => {},
+        }
+    }
+
+    /// Blocks until a watched path changes, then keeps collecting changes
+    /// until `debounce_ms` pass without another one. Returns the changed
+    /// paths, allocated from `allocator`.
+    pub fn wait(self: *Watcher, allocator: std.mem.Allocator, debounce_ms: u32) ![]const []const u8 {
+        var changed: std.ArrayList([]const u8) = .empty;
+        var candidates: std.ArrayList([]const u8) = .empty;
+        defer candidates.deinit(allocator);
+        var last_change_ns: i128 = 0;
+
+        while (true) {
+            const quiet_ms: ?u32 = if (changed.items.len == 0) null else debounce_ms;
+            candidates.clearRetainingCapacity();
+            const wake: Wake = switch (self.backend) {
+                .native => |*native| try native.next(self.allocator, allocator, quiet_ms, &candidates),
+                .polling => blk: {
+                    try core.runtime.sleepMs(@min(quiet_ms orelse poll_interval_ms, poll_interval_ms));
+                    break :blk .rescan;
+                },
+            };
+
+            const before = changed.items.len;
+            switch (wake) {
+                .timeout => {},
+                .events => for (candidates.items) |path| {
+                    if (self.affects(path)) try appendUnique(allocator, &changed, path);
+                },
+                .rescan => try self.rescan(allocator, &changed),
+            }
+            const now = core.runtime.nowNs();
+            if (changed.items.len > before) last_change_ns = now;
+            if (changed.items.len > 0 and now - last_change_ns >= @as(i128, debounce_ms) * std.time.ns_per_ms) {
+                return try changed.toOwnedSlice(allocator);
+            }
+        }
+    }
+
+    /// Native events only fire for writes, creations, removals and renames,
+    /// so any event on a watched path is a change. Events for other names are
+    /// changes only inside a watched directory, minus dot-files and editor
+    /// backups, which no glob matches.
+    fn affects(self: *Watcher, path: []const u8) bool {
+        if (self.entries.contains(path)) return true;
+        const parent = std.fs.path.dirname(path) orelse ".";
+        const entry = self.entries.get(parent) orelse return false;
+        if (entry.kind != .dir) return false;
+        const name = std.fs.path.basename(path);
+        return name.len > 0 and name[0] != '.' and name[name.len - 1] != '~';
+    }
+
+    fn rescan(self: *Watcher, allocator: std.mem.Allocator, changed: *std.ArrayList([]const u8)) !void {
+        var it = self.entries.iterator();
+        while (it.next()) |entry| {
+            const stamp = core.fs.fingerprint(entry.key_ptr.*) catch null;
+            if (sameStamp(stamp, entry.value_ptr.stamp)) continue;
+            entry.value_ptr.stamp = stamp;
+            try appendUnique(allocator, changed, entry.key_ptr.*);
+        }
+    }
+};
+
+fn sameStamp(a: ?core.fs.Fingerprint, b: ?core.fs.Fingerprint) bool {
+    const x = a orelse return b == null;
+    const y = b orelse return false;
+    return x.mtime_ns == y.mtime_ns and x.size == y.size;
+}
+
+fn appendUnique(allocator: std.mem.Allocator, paths: *std.ArrayList([]const u8), path: []const u8) !void {
+    if (containsPath(paths.items, path)) return;
+    try paths.append(allocator, try allocator.dupe(u8, path));
+}
+
+/// Spelling used for lookups: build inputs may come as `./src/a.cpp` while
+/// events name `src/a.cpp`.
+pub fn normalizePath(path: []const u8) []const u8 {
+    var trimmed = path;
+    while (std.mem.startsWith(u8, trimmed, "./")) trimmed = trimmed["./".len..];
+    if (trimmed.len > 1) trimmed = std.mem.trimEnd(u8, trimmed, "/");
+    return if (trimmed.len == 0) "." else trimmed;
+}
+
+/// Path of `name` inside the watched directory `dir`, in `normalizePath` form.
+pub fn childPath(allocator: std.mem.Allocator, dir: []const u8, name: []const u8) ![]const u8 {
+    if (name.len == 0) return allocator.dupe(u8, dir);
+    if (std.mem.eql(u8, dir, ".")) return allocator.dupe(u8, name);
+    if (dir[dir.len - 1] == '/') return std.mem.concat(allocator, u8, &.{ dir, name });
+    return std.fmt.allocPrint(allocator, "{s}/{s}", .{ dir, name });
+}
+
+const Wake = enum {
+    timeout,
+    /// Candidate paths were appended.
+    events,
+    /// Events were lost; every entry must be checked.
+    rescan,
+};
+
+const Native = switch (builtin.os.tag) {
+    .linux => Inotify,
+    .macos => Kqueue,
+    // ReadDirectoryChangesW and the BSDs' kqueue (which needs libc there)
+    // are not wired up yet; those platforms poll.
+    else => struct {
+        fn init() !@This() {
+            return error.WatchUnavailable;
+        }
+        fn deinit(_: *@This(), _: std.mem.Allocator) void {}
+        fn add(_: *@This(), _: std.mem.Allocator, _: []const u8, _: Watcher.Kind) !void {}
+        fn next(_: *@This(), _: std.mem.Allocator, _: std.mem.Allocator, _: ?u32, _: *std.ArrayList([]const u8)) !Wake {
+            return .rescan;
+        }
+    },
+};
+
+/// One inotify watch per directory: a file is seen through its parent, so
+/// editors that save by writing a temporary file and renaming it over the
+/// original are caught as well.
+const Inotify = struct {
+    const linux = std.os.linux;
+    const mask = linux.IN.CLOSE_WRITE | linux.IN.MOVED_TO | linux.IN.MOVED_FROM |
+        linux.IN.CREATE | linux.IN.DELETE | linux.IN.DELETE_SELF | linux.IN.ONLYDIR;
+
+    fd: i32,
+    dirs: std.AutoHashMapUnmanaged(i32, []const u8) = .empty,
+    watched: std.StringHashMapUnmanaged(void) = .empty,
+    buffer: [16 * 1024]u8 align(@alignOf(linux.inotify_event)) = undefined,
+
+    fn init() !Inotify {
+        const rc = linux.inotify_init1(linux.IN.CLOEXEC | linux.IN.NONBLOCK);
+        if (syscallError(rc) != null) return error.WatchUnavailable;
+        return .{ .fd = @intCast(rc) };
+    }
+
+    fn deinit(self: *Inotify, allocator: std.mem.Allocator) void {
+        _ = linux.close(self.fd);
+        self.dirs.deinit(allocator);
+        self.watched.deinit(allocator);
+    }
+
+    fn add(self: *Inotify, allocator: std.mem.Allocator, path: []const u8, kind: Watcher.Kind) !void {
+        const dir = switch (kind) {
+            .dir => path,
+            .file => std.fs.path.dirname(path) orelse ".",
+        };
+        if (self.watched.contains(dir)) return;
+        const dir_z = try allocator.dupeZ(u8, dir);
+        const rc = linux.inotify_add_watch(self.fd, dir_z, mask);
+        if (syscallError(rc)) |err| switch (err) {
+            // Watched again once it exists and the next build names it.
+            .NOENT, .NOTDIR, .ACCES => return,
+            .NOSPC => return error.WatchLimit,
+            else => return error.WatchFailed,
+        };
+        try self.watched.put(allocator, dir_z, {});
+        try self.dirs.put(allocator, @intCast(rc), dir_z);
+    }
+
+    /// `scratch` owns the paths appended to `out`.
+    fn next(self: *Inotify, _: std.mem.Allocator, scratch: std.mem.Allocator, timeout_ms: ?u32, out: *std.ArrayList([]const u8)) !Wake {
+        var fds = [_]linux.pollfd{.{ .fd = self.fd, .events = linux.POLL.IN, .revents = 0 }};
+        const timeout: i32 = if (timeout_ms) |ms| @intCast(ms) else -1;
+        const ready = linux.poll(&fds, fds.len, timeout);
+        if (syscallError(ready)) |err| {
+            if (err == .INTR) return .timeout;
+            return error.WatchFailed;
+        }
+        if (ready == 0) return .timeout;
+
+        var wake: Wake = .timeout;
+        while (true) {
+            const len = linux.read(self.fd, &self.buffer, self.buffer.len);
+            if (syscallError(len)) |err| switch (err) {
+                .AGAIN => break,
+                .INTR => continue,
+                else => return error.WatchFailed,
+            };
+            if (len == 0) break;
+            var offset: usize = 0;
+            while (offset + @sizeOf(linux.inotify_event) <= len) {
+                const event: *const linux.inotify_event = @ptrCast(@alignCast(&self.buffer[offset]));
+                const name_start = offset + @sizeOf(linux.inotify_event);
+                offset = name_start + event.len;
+                if (event.mask & linux.IN.Q_OVERFLOW != 0) {
+                    wake = .rescan;
+                    continue;
+                }
+                const dir = self.dirs.get(event.wd) orelse continue;
+                if (event.mask & linux.IN.IGNORED != 0) {
+                    // The directory is gone; its watch descriptor may be reused.
+                    _ = self.dirs.remove(event.wd);
+                    _ = self.watched.remove(dir);
+                }
+                const name = std.mem.sliceTo(self.buffer[name_start..offset], 0);
+                try out.append(scratch, try childPath(scratch, dir, name));
+                if (wake == .timeout) wake = .events;
+            }
+        }
+        return wake;
+    }
+
+    fn syscallError(rc: usize) ?linux.E {
+        const signed: isize = @bitCast(rc);
+        if (signed < 0 and signed > -4096) return @enumFromInt(@as(u16, @intCast(-signed)));
+        return null;
+    }
+};
+
+/// One kqueue vnode watch per path. Without names in the events, files are
+/// watched individually rather than through their directory; a file that
+/// is replaced by a rename is watched again under its path.
+const Kqueue = struct {
+    const c = std.c;
+    const note = c.NOTE.WRITE | c.NOTE.EXTEND | c.NOTE.DELETE | c.NOTE.RENAME | c.NOTE.ATTRIB;
+
+    kq: c_int,
+    paths: std.AutoHashMapUnmanaged(c_int, []const u8) = .empty,
+    watched: std.StringHashMapUnmanaged(void) = .empty,
+
+    fn init() !Kqueue {
+        const kq = c.kqueue();
+        if (kq < 0) return error.WatchUnavailable;
+        return .{ .kq = kq };
+    }
+
+    fn deinit(self: *Kqueue, allocator: std.mem.Allocator) void {
+        var fds = self.paths.keyIterator();
+        while (fds.next()) |fd| _ = c.close(fd.*);
+        _ = c.close(self.kq);
+        self.paths.deinit(allocator);
+        self.watched.deinit(allocator);
+    }
+
+    fn add(self: *Kqueue, allocator: std.mem.Allocator, path: []const u8, _: Watcher.Kind) !void {
+        if (self.watched.contains(path)) return;
+        const path_z = try allocator.dupeZ(u8, path);
+        const fd = c.open(path_z, .{ .EVTONLY = true });
+        if (fd < 0) {
+            // A path that exists but can't be opened means descriptors ran out.
+            if (core.fs.fileExists(path)) return error.WatchLimit;
+            return;
+        }
+        const change = [_]c.Kevent{.{
+            .ident = @intCast(fd),
+            .filter = c.EVFILT.VNODE,
+            .flags = c.EV.ADD | c.EV.CLEAR,
+            .fflags = note,
+            .data = 0,
+            .udata = 0,
+        }};
+        if (c.kevent(self.kq, &change, change.len, &[_]c.Kevent{}, 0, null) < 0) {
+            _ = c.close(fd);
+            return error.WatchLimit;
+        }
+        try self.paths.put(allocator, fd, path_z);
+        try self.watched.put(allocator, path_z, {});
+    }
+
+    fn next(self: *Kqueue, allocator: std.mem.Allocator, scratch: std.mem.Allocator, timeout_ms: ?u32, out: *std.ArrayList([]const u8)) !Wake {
+        var events: [64]c.Kevent = undefined;
+        var timeout: c.timespec = undefined;
+        if (timeout_ms) |ms| {
+            timeout = .{ .sec = @intCast(ms / 1000), .nsec = @intCast((ms % 1000) * std.time.ns_per_ms) };
+        }
+        const count = c.kevent(self.kq, &[_]c.Kevent{}, 0, &events, events.len, if (timeout_ms != null) &timeout else null);
+        if (count < 0) return .timeout;
+        if (count == 0) return .timeout;
+
+        for (events[0..@intCast(count)]) |event| {
+            const fd: c_int = @intCast(event.ident);
+            const path = self.paths.get(fd) orelse continue;
+            try out.append(scratch, path);
+            if (event.fflags & (c.NOTE.DELETE | c.NOTE.RENAME) != 0) {
+                _ = self.paths.remove(fd);
+                _ = self.watched.remove(path);
+                _ = c.close(fd);
+                try self.add(allocator, path, .file);
+            }
+        }
+        return .events;
+    }
+};
@@ -7,6 +7,8 @@ pub const ParsedArgs = struct {
     show_version: bool = false,
     verbose: bool = false,
     quiet: bool = false,
+    /// Print allocation counts and peak memory when the command finishes.
+    stats: bool = false,
     cwd: ?[]const u8 = null,
     profile: ?[]const u8 = null,
     command: ?[]const u8 = null,
@@ -58,6 +60,10 @@ pub fn parse(argv: []const []const u8) !ParsedArgs {
                 parsed.quiet = true;
                 continue;
             }
+            if (std.mem.eql(u8, arg, "--stats")) {
+                parsed.stats = true;
+                continue;
+            }
             if (std.mem.eql(u8, arg, "--cwd")) {
                 index += 1;
                 if (index >= argv.len) return error.MissingCwdPath;
@@ -113,3 +119,235 @@ pub fn hasHelpFlag(values: []const []const u8) bool {
     }
     return false;
 }
+
+/// `--pgo=train` trains and then builds with the profile; `--pgo=use`
+/// builds with the profile of the last training.
+pub const PgoMode = enum { train, use };
+
+pub const BuildArgs = struct {
+    target: ?[]const u8 = null,
+    jobs: ?usize = null,
+    /// Rebuild whenever an input changes (`build` and `test` only).
+    watch: bool = false,
+    /// Chrome trace-event file to write the build's timings to.
+    timings: ?[]const u8 = null,
+    /// Print the predicted and actual critical path (`build` only).
+    explain: bool = false,
+    /// Build every target in unity batches.
+    unity: bool = false,
+    pgo: ?PgoMode = null,
+};
+
+/// Parses the arguments shared by build-driving commands (`build`, `run`,
+/// `test`, `install`): one optional positional target plus build flags.
+pub fn parseBuildArgs(values: []const []const u8) !BuildArgs {
+    var parsed = BuildArgs{};
+    var index: usize = 0;
+    while (index < values.len) : (index += 1) {
+        const value = values[index];
+        if (std.mem.eql(u8, value, "-j") or std.mem.eql(u8, value, "--jobs")) {
+            index += 1;
+            if (index >= values.len) return error.MissingJobCount;
+            parsed.jobs = try parseJobCount(values[index]);
+            continue;
+        }
+        if (std.mem.eql(u8, value, "-w") or std.mem.eql(u8, value, "--watch")) {
+            parsed.watch = true;
+            continue;
+        }
+        if (std.mem.eql(u8, value, "--unity")) {
+            parsed.unity = true;
+            continue;
+        }
+        if (std.mem.eql(u8, value, "--explain")) {
+            parsed.explain = true;
+            continue;
+        }
+        if (std.mem.eql(u8, value, "--timings")) {
+            index += 1;
+            if (index >= values.len) return error.MissingTimingsPath;
+            parsed.timings = values[index];
+            continue;
+        }
+        if (std.mem.startsWith(u8, value, "--timings=")) {
+            parsed.timings = value["--timings=".len..];
+            if (parsed.timings.?.len == 0) return error.MissingTimingsPath;
+            continue;
+        }
+        if (std.mem.startsWith(u8, value, "--pgo=")) {
+            parsed.pgo = std.meta.stringToEnum(PgoMode, value["--pgo=".len..]) orelse return error.InvalidPgoMode;
+            continue;
+        }
+        if (std.mem.startsWith(u8, value, "--jobs=")) {
+            parsed.jobs = try parseJobCount(value["--jobs=".len..]);
+            continue;
+        }
+        if (std.mem.startsWith(u8, value, "-j")) {
+            parsed.jobs = try parseJobCount(value["-j".len..]);
+            continue;
+        }
+        if (std.mem.startsWith(u8, value, "-")) return error.UnknownBuildFlag;
+        if (parsed.target != null) return error.UnexpectedArgument;
+        parsed.target = value;
+    }
+    return parsed;
+}
+
+/// `-j N` alone, for commands such as `fetch` whose work isn't a build.
+pub fn parseJobArgs(values: []const []const u8) !?usize {
+    const parsed = try parseBuildArgs(values);
+    if (parsed.target != null) return error.UnexpectedArgument;
+    if (parsed.watch or parsed.unity or parsed.explain or parsed.timings != null or parsed.pgo != null) return error.UnknownBuildFlag;
+    return parsed.jobs;
+}
+
+pub const SourceToolArgs = struct {
+    jobs: ?usize = null,
+    /// Only sources changed since the last commit or the last run.
+    changed: bool = false,
+};
+
+/// `fmt` and `lint`: `-j N` and `--changed`.
+pub fn parseSourceToolArgs(values: []const []const u8) !SourceToolArgs {
+    var parsed = SourceToolArgs{};
+    var rest: [max_args][]const u8 = undefined;
+    var rest_len: usize = 0;
+    for (values) |value| {
+        if (std.mem.eql(u8, value, "--changed")) {
+            parsed.changed = true;
+        } else {
+            try appendArg(&rest, &rest_len, value);
+        }
+    }
+    parsed.jobs = try parseJobArgs(rest[0..rest_len]);
+    return parsed;
+}
+
+pub const WorkerArgs = struct {
+    /// `host:port` to listen on.
+    listen: []const u8 = "0.0.0.0:3633",
+    jobs: ?usize = null,
+};
+
+/// `worker`: `--listen HOST:PORT` and `-j N`.
+pub fn parseWorkerArgs(values: []const []const u8) !WorkerArgs {
+    var parsed = WorkerArgs{};
+    var rest: [max_args][]const u8 = undefined;
+    var rest_len: usize = 0;
+    var index: usize = 0;
+    while (index < values.len) : (index += 1) {
+        if (optionValue(values, &index, "--listen")) |text| {
+            parsed.listen = text catch return error.MissingListenAddress;
+        } else {
+            try appendArg(&rest, &rest_len, values[index]);
+        }
+    }
+    parsed.jobs = try parseJobArgs(rest[0..rest_len]);
+    return parsed;
+}
+
+pub const TestArgs = struct {
+    build: BuildArgs = .{},
+    /// Seconds a test may run before it is killed and reported as timed out.
+    timeout_s: ?u64 = null,
+    /// `i/n`, validated when the tests are selected.
+    shard: ?[]const u8 = null,
+    junit: ?[]const u8 = null,
+    json: ?[]const u8 = null,
+    slowest_first: bool = false,
+
+    /// A flag that only the concurrent runner supports, for `--watch` to reject.
+    pub fn runnerFlag(self: TestArgs) ?[]const u8 {
+        if (self.timeout_s != null) return "--timeout";
+        if (self.shard != null) return "--shard";
+        if (self.junit != null) return "--junit";
+        if (self.json != null) return "--json";
+        if (self.slowest_first) return "--slowest-first";
+        return null;
+    }
+};
+
+pub const InstallArgs = struct {
+    build: BuildArgs = .{},
+    /// Defaults come from `build.install.Layout`.
+    prefix: ?[]const u8 = null,
+    bindir: ?[]const u8 = null,
+    libdir: ?[]const u8 = null,
+    includedir: ?[]const u8 = null,
+    /// Hard-link the build's outputs instead of copying them.
+    link: bool = false,
+};
+
+/// `install` takes the build arguments plus where to install to.
+pub fn parseInstallArgs(values: []const []const u8) !InstallArgs {
+    var parsed = InstallArgs{};
+    var rest: [max_args][]const u8 = undefined;
+    var rest_len: usize = 0;
+    var index: usize = 0;
+    while (index < values.len) : (index += 1) {
+        const value = values[index];
+        if (std.mem.eql(u8, value, "--link")) {
+            parsed.link = true;
+        } else if (optionValue(values, &index, "--prefix")) |text| {
+            parsed.prefix = text catch return error.MissingInstallDir;
+        } else if (optionValue(values, &index, "--bindir")) |text| {
+            parsed.bindir = text catch return error.MissingInstallDir;
+        } else if (optionValue(values, &index, "--libdir")) |text| {
+            parsed.libdir = text catch return error.MissingInstallDir;
+        } else if (optionValue(values, &index, "--includedir")) |text| {
+            parsed.includedir = text catch return error.MissingInstallDir;
+        } else {
+            try appendArg(&rest, &rest_len, value);
+        }
+    }
+    parsed.build = try parseBuildArgs(rest[0..rest_len]);
+    return parsed;
+}
+
+/// `test` takes the build arguments plus options of the test runner.
+pub fn parseTestArgs(values: []const []const u8) !TestArgs {
+    var parsed = TestArgs{};
+    var rest: [max_args][]const u8 = undefined;
+    var rest_len: usize = 0;
+    var index: usize = 0;
+    while (index < values.len) : (index += 1) {
+        const value = values[index];
+        if (std.mem.eql(u8, value, "--slowest-first")) {
+            parsed.slowest_first = true;
+        } else if (optionValue(values, &index, "--timeout")) |text| {
+            const seconds = std.fmt.parseInt(u64, text catch return error.InvalidTimeout, 10) catch return error.InvalidTimeout;
+            if (seconds == 0) return error.InvalidTimeout;
+            parsed.timeout_s = seconds;
+        } else if (optionValue(values, &index, "--shard")) |text| {
+            parsed.shard = text catch return error.MissingShard;
+        } else if (optionValue(values, &index, "--junit")) |text| {
+            parsed.junit = text catch return error.MissingReportPath;
+        } else if (optionValue(values, &index, "--json")) |text| {
+            parsed.json = text catch return error.MissingReportPath;
+        } else {
+            try appendArg(&rest, &rest_len, value);
+        }
+    }
+    parsed.build = try parseBuildArgs(rest[0..rest_len]);
+    return parsed;
+}
+
+/// The value of `--name=VALUE` or `--name VALUE` at `index`, advancing past
+/// a separate value; null when `values[index]` is another argument.
+fn optionValue(values: []const []const u8, index: *usize, comptime name: []const u8) ?error{MissingValue}![]const u8 {
+    const value = values[index.*];
+    if (std.mem.startsWith(u8, value, name ++ "=")) {
+        const text = value[name.len + 1 ..];
+        return if (text.len > 0) text else error.MissingValue;
+    }
+    if (!std.mem.eql(u8, value, name)) return null;
+    index.* += 1;
+    if (index.* >= values.len) return error.MissingValue;
+    return values[index.*];
+}
+
+fn parseJobCount(value: []const u8) !usize {
+    const count = std.fmt.parseInt(usize, value, 10) catch return error.InvalidJobCount;
+    if (count == 0) return error.InvalidJobCount;
+    return count;
+}
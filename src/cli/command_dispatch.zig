@@ -28,6 +28,8 @@ const CommandId = enum {
     info,
     import_cmd,
     export_cmd,
+    daemon,
+    worker,
 };
 
 const CommandHandler = struct {
@@ -56,6 +58,8 @@ const command_handlers = [_]CommandHandler{
     .{ .name = "info", .id = .info },
     .{ .name = "import", .id = .import_cmd },
     .{ .name = "export", .id = .export_cmd },
+    .{ .name = "daemon", .id = .daemon },
+    .{ .name = "worker", .id = .worker },
 };
 
 comptime {
@@ -197,6 +201,8 @@ fn dispatchCommand(
         .info => handlers.handleInfo(ctx, command_args),
         .import_cmd => handlers.handleImport(ctx, command_args),
         .export_cmd => handlers.handleExport(ctx, command_args),
+        .daemon => handlers.handleDaemon(ctx, command_args),
+        .worker => handlers.handleWorker(ctx, command_args),
     };
 }
 
@@ -33,23 +33,30 @@ pub const commands = [_]CommandSpec{
     .{
         .name = "build",
         .summary = "Build the project",
-        .usage = "ovo build [target]",
+        .usage = "ovo build [target] [-j N] [--watch] [--unity] [--timings=FILE] [--explain] [--pgo=train|use]",
         .group = .basic,
-        .examples = &.{"ovo build"},
+        .examples = &.{
+            "ovo build",
+            "ovo build app -j 16",
+            "ovo build --watch",
+            "ovo build --timings=trace.json",
+            "ovo build --explain",
+            "ovo --profile ReleaseFast build --pgo=train",
+        },
     },
     .{
         .name = "run",
         .summary = "Build and run target",
-        .usage = "ovo run [target] [-- args]",
+        .usage = "ovo run [target] [-j N] [-- args]",
         .group = .basic,
         .examples = &.{"ovo run app -- --port 8080"},
     },
     .{
         .name = "test",
         .summary = "Run tests",
-        .usage = "ovo test [pattern]",
+        .usage = "ovo test [pattern] [-j N] [--watch] [--timeout=SECS] [--shard=I/N] [--slowest-first] [--junit=FILE] [--json=FILE]",
         .group = .basic,
-        .examples = &.{"ovo test unit"},
+        .examples = &.{ "ovo test unit", "ovo test --watch", "ovo test -j 16 --shard=2/4 --junit=results.xml" },
     },
     .{
         .name = "clean",
@@ -61,9 +68,13 @@ pub const commands = [_]CommandSpec{
     .{
         .name = "install",
         .summary = "Install project artifacts",
-        .usage = "ovo install",
+        .usage = "ovo install [target] [-j N] [--prefix=DIR] [--bindir=DIR] [--libdir=DIR] [--includedir=DIR] [--link]",
         .group = .basic,
-        .examples = &.{"ovo install"},
+        .examples = &.{
+            "ovo install",
+            "ovo install --prefix=/opt/app --libdir=lib64",
+            "ovo install --link",
+        },
     },
     .{
         .name = "add",
@@ -85,23 +96,23 @@ pub const commands = [_]CommandSpec{
     .{
         .name = "fetch",
         .summary = "Download dependencies",
-        .usage = "ovo fetch",
+        .usage = "ovo fetch [-j N]",
         .group = .package,
-        .examples = &.{"ovo fetch"},
+        .examples = &.{ "ovo fetch", "ovo fetch -j 16" },
     },
     .{
         .name = "update",
         .summary = "Update dependencies",
         .usage = "ovo update [pkg]",
         .group = .package,
-        .examples = &.{"ovo update"},
+        .examples = &.{ "ovo update", "ovo update zlib" },
     },
     .{
         .name = "lock",
-        .summary = "Generate lock file",
-        .usage = "ovo lock",
+        .summary = "Resolve dependencies into ovo.lock.zon",
+        .usage = "ovo lock [-j N]",
         .group = .package,
-        .examples = &.{"ovo lock"},
+        .examples = &.{ "ovo lock", "ovo lock -j 16" },
     },
     .{
         .name = "deps",
@@ -127,16 +138,16 @@ pub const commands = [_]CommandSpec{
     .{
         .name = "fmt",
         .summary = "Format source code",
-        .usage = "ovo fmt",
+        .usage = "ovo fmt [--changed] [-j N]",
         .group = .tooling,
-        .examples = &.{"ovo fmt"},
+        .examples = &.{ "ovo fmt", "ovo fmt --changed" },
     },
     .{
         .name = "lint",
         .summary = "Run linter",
-        .usage = "ovo lint",
+        .usage = "ovo lint [--changed] [-j N]",
         .group = .tooling,
-        .examples = &.{"ovo lint"},
+        .examples = &.{ "ovo lint", "ovo lint --changed -j 16" },
     },
     .{
         .name = "info",
@@ -145,6 +156,20 @@ pub const commands = [_]CommandSpec{
         .group = .tooling,
         .examples = &.{"ovo info"},
     },
+    .{
+        .name = "daemon",
+        .summary = "Keep the project loaded and serve build, run, test and info",
+        .usage = "ovo daemon [stop|status]",
+        .group = .tooling,
+        .examples = &.{ "ovo daemon", "ovo daemon status", "ovo daemon stop" },
+    },
+    .{
+        .name = "worker",
+        .summary = "Compile preprocessed sources for builds on other machines",
+        .usage = "ovo worker [--listen HOST:PORT] [-j N]",
+        .group = .tooling,
+        .examples = &.{ "ovo worker", "ovo worker --listen 0.0.0.0:3633 -j 32" },
+    },
     .{
         .name = "import",
         .summary = "Import from another project format",
@@ -159,6 +184,7 @@ pub const commands = [_]CommandSpec{
         .group = .translation,
         .examples = &.{
             "ovo export cmake",
+            "ovo export ninja && ninja",
             "ovo export compile_commands.json build/compile_commands.json",
         },
     },
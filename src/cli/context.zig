@@ -1,4 +1,6 @@
 const std = @import("std");
+const core = @import("../core/mod.zig");
+const orchestrator = @import("../build/orchestrator.zig");
 
 pub const Context = struct {
     allocator: std.mem.Allocator,
@@ -7,14 +9,20 @@ pub const Context = struct {
     verbose: bool = false,
     quiet: bool = false,
     suppress_stderr: bool = false,
+    /// Set while `ovo daemon` serves the command: builds reuse this warm
+    /// workspace instead of opening `build.zon` again.
+    workspace: ?*orchestrator.Workspace = null,
+    /// Also set by the daemon: `run` leaves the program to the client, which
+    /// owns the terminal, by putting its command line here.
+    client_run: ?*?[]const []const u8 = null,
 
     pub fn print(self: *Context, comptime fmt: []const u8, args: anytype) !void {
         if (self.quiet) return;
-        std.debug.print(fmt, args);
+        core.runtime.printErr(fmt, args);
     }
 
     pub fn printErr(self: *Context, comptime fmt: []const u8, args: anytype) !void {
         if (self.suppress_stderr) return;
-        std.debug.print(fmt, args);
+        core.runtime.printErr(fmt, args);
     }
 };
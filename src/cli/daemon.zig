@@ -0,0 +1,392 @@
+const std = @import("std");
+const builtin = @import("builtin");
+const args = @import("args.zig");
+const dispatch = @import("command_dispatch.zig");
+const Context = @import("context.zig").Context;
+const core = @import("../core/mod.zig");
+const build = @import("../build/mod.zig");
+const zon = @import("../zon/mod.zig");
+
+/// One daemon per workspace, found through its socket.
+pub const socket_path = ".ovo/daemon.sock";
+
+/// Unix domain sockets; Windows runs every command in-process.
+pub const supported = builtin.os.tag != .windows;
+
+/// Commands the CLI hands to a running daemon. Everything else, and any
+/// `--watch`, runs in-process.
+const served_commands = [_][]const u8{ "build", "run", "test", "info" };
+
+/// What a build reads from the environment, itself or through the tools it
+/// runs. The daemon builds with its own, so it declines requests from a
+/// shell where any of these differ.
+const build_environment = [_][]const u8{
+    "PATH",                   "HOME",                 "USERPROFILE",
+    "XDG_CACHE_HOME",         "OVO_CACHE_DIR",        "OVO_CACHE_DISABLE",
+    "OVO_CACHE_MAX_SIZE",     "OVO_MEMORY_BUDGET",    "OVO_WORKERS",
+    "OVO_WORKER_TIMEOUT",     "OVO_REMOTE_CACHE_URL", "OVO_REMOTE_CACHE_MODE",
+    "OVO_REMOTE_CACHE_TOKEN", "AWS_REGION",           "AWS_DEFAULT_REGION",
+    "AWS_ENDPOINT_URL",       "AWS_ACCESS_KEY_ID",    "AWS_SECRET_ACCESS_KEY",
+    "AWS_SESSION_TOKEN",
+};
+
+/// Digest of `build_environment` as this process sees it; only the digest
+/// travels, so no credentials are sent over the socket.
+pub fn environmentDigest() u64 {
+    var hasher = std.hash.Wyhash.init(0);
+    for (build_environment) |name| {
+        hasher.update(name);
+        if (core.runtime.getEnv(name)) |value| {
+            hasher.update("=");
+            hasher.update(value);
+        }
+        hasher.update(&[_]u8{0});
+    }
+    return hasher.final();
+}
+
+/// Frames larger than this are a protocol error, not an allocation.
+const max_frame_len = 64 * 1024 * 1024;
+
+/// Whether the CLI should hand `parsed` to a running daemon: a served
+/// command, not measuring this process with `--stats`, and not disabled
+/// through `OVO_NO_DAEMON`.
+pub fn shouldForward(parsed: *const args.ParsedArgs) bool {
+    if (!supported or parsed.stats or parsed.show_help) return false;
+    if (core.runtime.getEnv("OVO_NO_DAEMON") != null) return false;
+    return serves(parsed);
+}
+
+/// Whether the daemon runs `parsed`: one of its commands, not watching.
+fn serves(parsed: *const args.ParsedArgs) bool {
+    const command = parsed.command orelse return false;
+    for (served_commands) |name| {
+        if (!std.mem.eql(u8, name, command)) continue;
+        for (parsed.commandArgs()) |arg| {
+            if (std.mem.eql(u8, arg, "--watch")) return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+/// What travels over the socket. A request is an `environment` and a
+/// `request` frame; the daemon answers with any number of `output` frames,
+/// an optional `run` and a final `exit`, or with `declined` when the client
+/// should run the command itself.
+pub const Frame = union(enum) {
+    /// The client's `environmentDigest`.
+    environment: u64,
+    /// The command line, program name included.
+    request: []const []const u8,
+    /// What the command printed.
+    output: []const u8,
+    /// A program for the client to start with its own terminal.
+    run: []const []const u8,
+    exit: u8,
+    /// Why the daemon won't run the request, e.g. a different environment.
+    declined: []const u8,
+
+    fn tag(self: Frame) u8 {
+        return switch (self) {
+            .environment => 'e',
+            .request => 'q',
+            .output => 'o',
+            .run => 'r',
+            .exit => 'x',
+            .declined => 'd',
+        };
+    }
+};
+
+/// One tag byte, a little-endian u32 payload length, the payload. Argument
+/// lists are NUL-terminated strings.
+pub fn writeFrame(writer: *std.Io.Writer, frame: Frame) !void {
+    try writer.writeByte(frame.tag());
+    switch (frame) {
+        .request, .run => |argv| {
+            var len: usize = 0;
+            for (argv) |arg| len += arg.len + 1;
+            try writer.writeInt(u32, @intCast(len), .little);
+            for (argv) |arg| {
+                try writer.writeAll(arg);
+                try writer.writeByte(0);
+            }
+        },
+        .output, .declined => |bytes| {
+            try writer.writeInt(u32, @intCast(bytes.len), .little);
+            try writer.writeAll(bytes);
+        },
+        .environment => |digest| {
+            try writer.writeInt(u32, 8, .little);
+            try writer.writeInt(u64, digest, .little);
+        },
+        .exit => |code| {
+            try writer.writeInt(u32, 1, .little);
+            try writer.writeByte(code);
+        },
+    }
+}
+
+pub fn readFrame(reader: *std.Io.Reader, allocator: std.mem.Allocator) !Frame {
+    const tag = try reader.takeByte();
+    const len = try reader.takeInt(u32, .little);
+    if (len > max_frame_len) return error.InvalidDaemonFrame;
+    const payload = try reader.readAlloc(allocator, len);
+    return switch (tag) {
+        'e' => if (len == 8) .{ .environment = std.mem.readInt(u64, payload[0..8], .little) } else error.InvalidDaemonFrame,
+        'q' => .{ .request = try splitArgv(allocator, payload) },
+        'o' => .{ .output = payload },
+        'r' => .{ .run = try splitArgv(allocator, payload) },
+        'x' => if (len == 1) .{ .exit = payload[0] } else error.InvalidDaemonFrame,
+        'd' => .{ .declined = payload },
+        else => error.InvalidDaemonFrame,
+    };
+}
+
+fn splitArgv(allocator: std.mem.Allocator, payload: []const u8) ![]const []const u8 {
+    if (payload.len > 0 and payload[payload.len - 1] != 0) return error.InvalidDaemonFrame;
+    var argv: std.ArrayList([]const u8) = .empty;
+    var rest = payload;
+    while (std.mem.indexOfScalar(u8, rest, 0)) |end| {
+        try argv.append(allocator, rest[0..end]);
+        rest = rest[end + 1 ..];
+    }
+    return argv.items;
+}
+
+/// Runs `argv` on the workspace's daemon and returns its exit code, or
+/// null when no daemon is listening or it declined because its environment
+/// differs, so the caller runs it in-process.
+/// Output is printed as it arrives; a program `run` hands back is started
+/// here, attached to this terminal.
+pub fn forward(allocator: std.mem.Allocator, argv: []const []const u8) !?u8 {
+    if (!supported or !core.fs.fileExists(socket_path)) return null;
+    const io = core.runtime.io();
+    const address = std.Io.net.UnixAddress.init(socket_path) catch return null;
+    // A socket left behind by a daemon that died refuses the connection.
+    const stream = address.connect(io) catch return null;
+    defer stream.close(io);
+
+    var write_buffer: [4096]u8 = undefined;
+    var writer = stream.writer(io, &write_buffer);
+    try writeFrame(&writer.interface, .{ .environment = environmentDigest() });
+    try writeFrame(&writer.interface, .{ .request = argv });
+    try writer.interface.flush();
+
+    var read_buffer: [64 * 1024]u8 = undefined;
+    var reader = stream.reader(io, &read_buffer);
+    var program: ?[]const []const u8 = null;
+    while (true) {
+        const frame = readFrame(&reader.interface, allocator) catch return error.DaemonDisconnected;
+        switch (frame) {
+            .output => |bytes| core.runtime.printErr("{s}", .{bytes}),
+            .run => |run_argv| program = run_argv,
+            .exit => |code| {
+                const run_argv = program orelse return code;
+                return try core.exec.runInherit(allocator, run_argv);
+            },
+            .declined => return null,
+            .environment, .request => return error.InvalidDaemonFrame,
+        }
+    }
+}
+
+/// `ovo daemon`: serves the workspace's commands until `ovo daemon stop`.
+/// One workspace stays open across requests, so the parsed project, target
+/// graph, glob index, header database and compiler identity are reused; a
+/// change to `build.zon`, seen by a file watcher, reopens it before the
+/// next request. Requests are served one at a time, each on its own arena.
+pub fn serve(ctx: *Context) !u8 {
+    if (!supported) {
+        try ctx.printErr("error: daemon: not supported on this platform\n", .{});
+        return 1;
+    }
+    const io = core.runtime.io();
+    if (try forward(ctx.allocator, &.{ "ovo", "daemon", "status" })) |_| {
+        try ctx.printErr("error: daemon: already running for this workspace\n", .{});
+        return 1;
+    }
+    try core.fs.ensureDir(".ovo");
+    // Nobody answered on it, so it is left over from a daemon that died.
+    try core.fs.deleteFileIfExists(socket_path);
+    const address = try std.Io.net.UnixAddress.init(socket_path);
+    var server = try address.listen(io, .{});
+    defer server.deinit(io);
+    defer core.fs.deleteFileIfExists(socket_path) catch {};
+
+    var daemon = Daemon{ .started_ns = core.runtime.nowNs() };
+    defer daemon.deinit();
+    const watcher = try std.Thread.spawn(.{}, watchProject, .{&daemon});
+    // Blocked waiting for a change; it ends with the process.
+    watcher.detach();
+
+    try ctx.print("daemon: serving {s} (stop with `ovo daemon stop`)\n", .{socket_path});
+    while (!daemon.stopping) {
+        const stream = server.accept(io) catch |err| {
+            try ctx.printErr("warning: daemon: accept failed: {s}\n", .{@errorName(err)});
+            continue;
+        };
+        defer stream.close(io);
+        daemon.handle(stream) catch |err| {
+            try ctx.printErr("warning: daemon: request failed: {s}\n", .{@errorName(err)});
+        };
+    }
+    return 0;
+}
+
+const Daemon = struct {
+    started_ns: i128,
+    workspace_arena: std.heap.ArenaAllocator = .init(core.memory.page_allocator),
+    workspace: ?*build.orchestrator.Workspace = null,
+    /// Set by the watcher when `build.zon` changes.
+    stale: std.atomic.Value(bool) = .init(false),
+    request_arena: std.heap.ArenaAllocator = .init(core.memory.page_allocator),
+    stopping: bool = false,
+    requests: usize = 0,
+
+    fn deinit(self: *Daemon) void {
+        if (self.workspace) |workspace| workspace.close();
+        self.workspace_arena.deinit();
+        self.request_arena.deinit();
+    }
+
+    fn openWorkspace(self: *Daemon) !*build.orchestrator.Workspace {
+        if (self.stale.swap(false, .acquire)) {
+            if (self.workspace) |workspace| workspace.close();
+            self.workspace = null;
+            _ = self.workspace_arena.reset(.retain_capacity);
+        }
+        if (self.workspace) |workspace| return workspace;
+        const workspace = try build.orchestrator.Workspace.open(self.workspace_arena.allocator(), .{});
+        self.workspace = workspace;
+        return workspace;
+    }
+
+    fn handle(self: *Daemon, stream: std.Io.net.Stream) !void {
+        const io = core.runtime.io();
+        _ = self.request_arena.reset(.retain_capacity);
+        const allocator = self.request_arena.allocator();
+
+        var read_buffer: [4096]u8 = undefined;
+        var reader = stream.reader(io, &read_buffer);
+        const environment = switch (try readFrame(&reader.interface, allocator)) {
+            .environment => |digest| digest,
+            else => return error.InvalidDaemonFrame,
+        };
+        const argv = switch (try readFrame(&reader.interface, allocator)) {
+            .request => |request| request,
+            else => return error.InvalidDaemonFrame,
+        };
+        var write_buffer: [64 * 1024]u8 = undefined;
+        var writer = stream.writer(io, &write_buffer);
+        // Controlling the daemon works from any shell; builds only from one
+        // that would build the same way.
+        if (environment != environmentDigest() and !isControl(argv)) {
+            try writeFrame(&writer.interface, .{ .declined = "environment differs" });
+            return writer.interface.flush();
+        }
+        var client = Client{ .writer = &writer.interface };
+        core.runtime.setOutputSink(.{ .context = &client, .writeFn = Client.write });
+        defer core.runtime.setOutputSink(null);
+
+        var program: ?[]const []const u8 = null;
+        const code = self.run(allocator, argv, &program) catch |err| code: {
+            core.runtime.printErr("error: {s}\n", .{@errorName(err)});
+            break :code 1;
+        };
+        self.requests += 1;
+        if (program) |run_argv| try writeFrame(client.writer, .{ .run = run_argv });
+        try writeFrame(client.writer, .{ .exit = code });
+        try client.writer.flush();
+    }
+
+    fn run(self: *Daemon, allocator: std.mem.Allocator, argv: []const []const u8, program: *?[]const []const u8) !u8 {
+        const parsed = try args.parse(argv);
+        var ctx = Context{
+            .allocator = allocator,
+            .profile = parsed.profile,
+            .verbose = parsed.verbose,
+            .quiet = parsed.quiet,
+        };
+        const command = parsed.command orelse "";
+        if (std.mem.eql(u8, command, "daemon")) return self.control(&ctx, parsed.commandArgs());
+        if (!serves(&parsed)) {
+            try ctx.printErr("error: daemon: `{s}` runs in-process, not on the daemon\n", .{command});
+            return 2;
+        }
+        ctx.workspace = try self.openWorkspace();
+        ctx.client_run = program;
+        return dispatch.dispatch(&ctx, &parsed);
+    }
+
+    fn control(self: *Daemon, ctx: *Context, command_args: []const []const u8) !u8 {
+        const action = if (command_args.len > 0) command_args[0] else "status";
+        if (std.mem.eql(u8, action, "stop")) {
+            self.stopping = true;
+            try ctx.print("daemon: stopped\n", .{});
+            return 0;
+        }
+        if (std.mem.eql(u8, action, "status")) {
+            const uptime_s = @divTrunc(core.runtime.nowNs() - self.started_ns, std.time.ns_per_s);
+            try ctx.print("daemon: running for {d}s, {d} request(s) served, project {s}\n", .{
+                uptime_s,
+                self.requests,
+                if (self.workspace) |workspace| workspace.project.name else "not loaded yet",
+            });
+            return 0;
+        }
+        try ctx.printErr("error: daemon: unknown action '{s}'\n", .{action});
+        return 2;
+    }
+};
+
+/// The output sink of one request: every print becomes an `output` frame.
+const Client = struct {
+    writer: *std.Io.Writer,
+    /// The client hung up; the command still runs to completion.
+    gone: bool = false,
+
+    fn write(context: *anyopaque, bytes: []const u8) void {
+        const self: *Client = @ptrCast(@alignCast(context));
+        if (self.gone) return;
+        writeFrame(self.writer, .{ .output = bytes }) catch {
+            self.gone = true;
+            return;
+        };
+        self.writer.flush() catch {
+            self.gone = true;
+        };
+    }
+};
+
+fn isControl(argv: []const []const u8) bool {
+    const parsed = args.parse(argv) catch return false;
+    const command = parsed.command orelse return false;
+    return std.mem.eql(u8, command, "daemon");
+}
+
+fn watchProject(daemon: *Daemon) void {
+    var watch_arena = std.heap.ArenaAllocator.init(core.memory.page_allocator);
+    defer watch_arena.deinit();
+    var arena = std.heap.ArenaAllocator.init(core.memory.page_allocator);
+    defer arena.deinit();
+    var watcher = build.watch.Watcher.init(watch_arena.allocator());
+    defer watcher.deinit();
+    watcher.watch(&.{zon.snapshot.zon_path}, &.{}) catch {
+        // Without notifications every request reopens the workspace.
+        while (true) {
+            daemon.stale.store(true, .release);
+            core.runtime.sleepMs(build.watch.default_debounce_ms) catch {};
+        }
+    };
+    while (true) {
+        _ = arena.reset(.retain_capacity);
+        _ = watcher.wait(arena.allocator(), build.watch.default_debounce_ms) catch {
+            daemon.stale.store(true, .release);
+            core.runtime.sleepMs(build.watch.default_debounce_ms) catch {};
+            continue;
+        };
+        daemon.stale.store(true, .release);
+    }
+}
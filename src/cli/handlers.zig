@@ -1,11 +1,14 @@
 const std = @import("std");
 const Context = @import("context.zig").Context;
 const scaffold = @import("scaffold.zig");
+const cli_args = @import("args.zig");
+const daemon = @import("daemon.zig");
 const core = @import("../core/mod.zig");
 const project_mod = @import("../core/project.zig");
 const build = @import("../build/mod.zig");
 const package = @import("../package/mod.zig");
 const translate = @import("../translate/mod.zig");
+const toolchain = @import("../compiler/toolchain.zig");
 
 pub fn handleNew(ctx: *Context, command_args: []const []const u8) !u8 {
     if (command_args.len == 0) {
@@ -30,32 +33,129 @@ pub fn handleInit(ctx: *Context, _: []const []const u8) !u8 {
 }
 
 pub fn handleBuild(ctx: *Context, command_args: []const []const u8, _: []const []const u8) !u8 {
-    const result = try build.orchestrator.buildProject(ctx.allocator, .{
-        .target_name = if (command_args.len > 0) command_args[0] else null,
+    const build_args = try cli_args.parseBuildArgs(command_args);
+    var options = build.orchestrator.BuildOptions{
+        .target_name = build_args.target,
         .optimize_override = ctx.profile,
-    });
+        .jobs = build_args.jobs,
+        .unity = build_args.unity,
+        .pgo = if (build_args.pgo == .use) .use else null,
+    };
+    if (build_args.watch) {
+        if (build_args.timings != null) return flagUnsupported(ctx, "--timings", "build --watch");
+        if (build_args.explain) return flagUnsupported(ctx, "--explain", "build --watch");
+        if (build_args.pgo != null) return flagUnsupported(ctx, "--pgo", "build --watch");
+        var reporter = BuildWatchReporter{ .ctx = ctx };
+        try build.watch.run(ctx.allocator, options, &reporter);
+        return 0;
+    }
+    var recorder: ?build.trace.Recorder = if (build_args.timings != null or build_args.explain) .init(ctx.allocator) else null;
+    options.trace = if (recorder) |*r| r else null;
+    defer if (recorder) |*r| reportBuildTrace(ctx, r, build_args);
+    if (build_args.pgo == .train) {
+        try printBuildResult(ctx, try trainProfile(ctx, options));
+        return 0;
+    }
+    try printBuildResult(ctx, try buildProject(ctx, options));
+    return 0;
+}
+
+fn trainProfile(ctx: *Context, options: build.orchestrator.BuildOptions) !build.orchestrator.BuildResult {
+    const workspace = ctx.workspace orelse try build.orchestrator.Workspace.open(ctx.allocator, options);
+    defer if (ctx.workspace == null) workspace.close();
+    return build.pgo.train(ctx.allocator, workspace, options);
+}
+
+/// Builds on the daemon's warm workspace when serving a client.
+fn buildProject(ctx: *Context, options: build.orchestrator.BuildOptions) !build.orchestrator.BuildResult {
+    const workspace = ctx.workspace orelse return build.orchestrator.buildProject(ctx.allocator, options);
+    return workspace.build(ctx.allocator, options);
+}
+
+fn loadProject(ctx: *Context) !project_mod.Project {
+    if (ctx.workspace) |workspace| return workspace.project;
+    return build.orchestrator.loadProject(ctx.allocator);
+}
+
+/// Writes the `--timings` trace and prints its summary. Runs on every exit
+/// path: failed builds are often the ones worth reading.
+fn writeTimings(ctx: *Context, recorder: *const build.trace.Recorder, path: []const u8) void {
+    reportTimings(ctx, recorder, path) catch |err| {
+        ctx.printErr("warning: timings: unable to write {s}: {s}\n", .{ path, @errorName(err) }) catch {};
+    };
+}
+
+fn reportTimings(ctx: *Context, recorder: *const build.trace.Recorder, path: []const u8) !void {
+    const events = recorder.events.items;
+    try core.fs.writeFile(path, try build.trace.renderChromeTrace(ctx.allocator, events, recorder.origin_ns));
+    try ctx.print("{s}", .{try build.trace.renderSummary(ctx.allocator, events, recorder.origin_ns)});
+    try ctx.print("timings: trace written to {s}\n", .{path});
+}
+
+fn reportBuildTrace(ctx: *Context, recorder: *const build.trace.Recorder, build_args: cli_args.BuildArgs) void {
+    if (build_args.timings) |path| writeTimings(ctx, recorder, path);
+    if (build_args.explain) explain(ctx, recorder);
+}
+
+/// `--explain`, printed after the build like the timings summary.
+fn explain(ctx: *Context, recorder: *const build.trace.Recorder) void {
+    const report = build.trace.renderExplain(ctx.allocator, recorder.events.items) catch |err| {
+        ctx.printErr("warning: explain: {s}\n", .{@errorName(err)}) catch {};
+        return;
+    };
+    ctx.print("{s}", .{report}) catch {};
+}
+
+fn printBuildResult(ctx: *Context, result: build.orchestrator.BuildResult) !void {
     try ctx.print("build: project={s}\n", .{result.project_name});
     for (result.artifacts) |artifact| {
-        try ctx.print("  built {s} -> {s}\n", .{ artifact.name, artifact.path });
+        const status = if (artifact.up_to_date) "up to date" else "built";
+        try ctx.print("  {s} {s} -> {s}\n", .{ status, artifact.name, artifact.path });
     }
-    return 0;
 }
 
+const BuildWatchReporter = struct {
+    ctx: *Context,
+
+    pub fn built(self: *BuildWatchReporter, _: std.mem.Allocator, result: anyerror!build.orchestrator.BuildResult) !void {
+        if (result) |built_result| {
+            try printBuildResult(self.ctx, built_result);
+        } else |err| {
+            try self.ctx.printErr("error: {s}\n", .{@errorName(err)});
+        }
+        try self.ctx.print("watch: waiting for changes\n", .{});
+    }
+};
+
 pub fn handleRun(ctx: *Context, command_args: []const []const u8, passthrough_args: []const []const u8) !u8 {
-    var requested_target = if (command_args.len > 0) command_args[0] else null;
+    const build_args = try cli_args.parseBuildArgs(command_args);
+    if (build_args.watch) return flagUnsupported(ctx, "--watch", "run");
+    if (build_args.explain) return flagUnsupported(ctx, "--explain", "run");
+    if (build_args.pgo == .train) return flagUnsupported(ctx, "--pgo=train", "run");
+    var requested_target = build_args.target;
+    var project: ?project_mod.Project = null;
     if (requested_target == null) {
-        const project = try build.orchestrator.loadProject(ctx.allocator);
-        const target = build.orchestrator.defaultRunnableTarget(project) orelse {
+        project = try loadProject(ctx);
+        const target = build.orchestrator.defaultRunnableTarget(project.?) orelse {
             try ctx.printErr("error: no executable or test target available\n", .{});
             return 2;
         };
         requested_target = target.name;
     }
 
-    const result = try build.orchestrator.buildProject(ctx.allocator, .{
-        .target_name = requested_target,
-        .optimize_override = ctx.profile,
-    });
+    var recorder: ?build.trace.Recorder = if (build_args.timings != null) .init(ctx.allocator) else null;
+    const result = result: {
+        defer if (recorder) |*r| writeTimings(ctx, r, build_args.timings.?);
+        break :result try buildProject(ctx, .{
+            .target_name = requested_target,
+            .optimize_override = ctx.profile,
+            .jobs = build_args.jobs,
+            .unity = build_args.unity,
+            .project = project,
+            .trace = if (recorder) |*r| r else null,
+            .pgo = if (build_args.pgo != null) .use else null,
+        });
+    };
     const artifact = build.orchestrator.findRunnableArtifact(result, requested_target) orelse {
         try ctx.printErr("error: no runnable executable target found\n", .{});
         return 2;
@@ -64,56 +164,222 @@ pub fn handleRun(ctx: *Context, command_args: []const []const u8, passthrough_ar
     var argv: std.ArrayList([]const u8) = .empty;
     try argv.append(ctx.allocator, artifact.path);
     for (passthrough_args) |arg| try argv.append(ctx.allocator, arg);
+    if (ctx.client_run) |client_run| {
+        client_run.* = argv.items;
+        return 0;
+    }
     const code = try core.exec.runInherit(ctx.allocator, argv.items);
     return code;
 }
 
 pub fn handleTest(ctx: *Context, command_args: []const []const u8, _: []const []const u8) !u8 {
-    const pattern = if (command_args.len > 0) command_args[0] else null;
-    const result = try build.orchestrator.buildProject(ctx.allocator, .{
-        .target_pattern = pattern,
+    const test_args = try cli_args.parseTestArgs(command_args);
+    const build_args = test_args.build;
+    if (build_args.pgo != null) return flagUnsupported(ctx, "--pgo", "test");
+    if (build_args.explain) return flagUnsupported(ctx, "--explain", "test");
+    const shard: ?build.test_runner.Shard = if (test_args.shard) |text| try build.test_runner.parseShard(text) else null;
+    var options = build.orchestrator.BuildOptions{
+        .target_pattern = build_args.target,
         .optimize_override = ctx.profile,
         .test_only = true,
-    });
+        .jobs = build_args.jobs,
+        .unity = build_args.unity,
+    };
+    if (build_args.watch) {
+        if (build_args.timings != null) return flagUnsupported(ctx, "--timings", "test --watch");
+        if (test_args.runnerFlag()) |flag| return flagUnsupported(ctx, flag, "test --watch");
+        var reporter = TestWatchReporter{ .ctx = ctx };
+        try build.watch.run(ctx.allocator, options, &reporter);
+        return 0;
+    }
+    var recorder: ?build.trace.Recorder = if (build_args.timings != null) .init(ctx.allocator) else null;
+    options.trace = if (recorder) |*r| r else null;
+    const result = result: {
+        // Only the build is traced, not the test runs.
+        defer if (recorder) |*r| writeTimings(ctx, r, build_args.timings.?);
+        break :result try buildProject(ctx, options);
+    };
 
+    var tests: std.ArrayList(build.test_runner.Test) = .empty;
     for (result.artifacts) |artifact| {
-        var argv: std.ArrayList([]const u8) = .empty;
-        try argv.append(ctx.allocator, artifact.path);
-        const code = try core.exec.runInherit(ctx.allocator, argv.items);
-        if (code != 0) return code;
+        if (!isRunnable(artifact)) continue;
+        try tests.append(ctx.allocator, .{ .name = artifact.name, .path = artifact.path });
     }
-    try ctx.print("test: executed {d} test target(s)\n", .{result.artifacts.len});
-    return 0;
+    const selected = try build.test_runner.select(ctx.allocator, tests.items, shard);
+    var history = build.test_runner.loadHistory(ctx.allocator);
+    if (test_args.slowest_first) build.test_runner.orderSlowestFirst(selected, &history);
+
+    var reporter = TestReporter{ .ctx = ctx };
+    const results = try build.test_runner.run(ctx.allocator, selected, .{
+        .jobs = build_args.jobs orelse build.job_pool.defaultJobCount(),
+        .timeout_ms = if (test_args.timeout_s) |seconds| seconds * std.time.ms_per_s else null,
+    }, &reporter);
+
+    build.test_runner.saveHistory(ctx.allocator, &history, results) catch |err| {
+        try ctx.printErr("warning: test: unable to record timings: {s}\n", .{@errorName(err)});
+    };
+    if (test_args.junit) |path| {
+        try core.fs.writeFile(path, try build.test_runner.renderJUnit(ctx.allocator, result.project_name, results));
+    }
+    if (test_args.json) |path| {
+        try core.fs.writeFile(path, try build.test_runner.renderJson(ctx.allocator, result.project_name, results));
+    }
+
+    const failed = build.test_runner.failureCount(results);
+    if (shard) |s| {
+        try ctx.print("test: shard {d}/{d}: {d} of {d} test target(s)\n", .{ s.index, s.count, selected.len, tests.items.len });
+    }
+    try ctx.print("test: executed {d} test target(s), {d} passed, {d} failed\n", .{ results.len, results.len - failed, failed });
+    return if (failed > 0) 1 else 0;
+}
+
+/// One line per finished test; the output of tests that didn't pass is
+/// replayed under theirs, so concurrent tests never interleave.
+const TestReporter = struct {
+    ctx: *Context,
+
+    pub fn finished(self: *TestReporter, result: build.test_runner.Result) !void {
+        const label = switch (result.status) {
+            .passed => "PASS",
+            .failed => "FAIL",
+            .timed_out => "TIMEOUT",
+        };
+        const ms = result.duration_ns / std.time.ns_per_ms;
+        try self.ctx.print("{s} {s} ({d} ms)\n", .{ label, result.name, ms });
+        if (result.status == .passed) return;
+        try self.ctx.print("{s}", .{result.output});
+        if (result.output.len > 0 and result.output[result.output.len - 1] != '\n') try self.ctx.print("\n", .{});
+        try self.ctx.print("  log: {s}\n", .{result.log_path});
+    }
+};
+
+/// Test builds also produce the libraries the tests link; those aren't run.
+fn isRunnable(artifact: build.orchestrator.BuiltArtifact) bool {
+    return artifact.kind == .executable or artifact.kind == .test_target;
+}
+
+/// Reruns a test target only when its executable was relinked, which
+/// happens exactly when one of its inputs changed, or when it failed last
+/// time. Every test runs on the first build.
+const TestWatchReporter = struct {
+    ctx: *Context,
+    first: bool = true,
+    failing: std.StringHashMapUnmanaged(void) = .empty,
+
+    pub fn built(self: *TestWatchReporter, allocator: std.mem.Allocator, result: anyerror!build.orchestrator.BuildResult) !void {
+        const ctx = self.ctx;
+        defer ctx.print("watch: waiting for changes\n", .{}) catch {};
+        const built_result = result catch |err| {
+            try ctx.printErr("error: {s}\n", .{@errorName(err)});
+            return;
+        };
+
+        var executed: usize = 0;
+        var total: usize = 0;
+        var failed: usize = 0;
+        for (built_result.artifacts) |artifact| {
+            if (!isRunnable(artifact)) continue;
+            total += 1;
+            if (!self.first and artifact.up_to_date and !self.failing.contains(artifact.name)) continue;
+            const code = try core.exec.runInherit(allocator, &.{artifact.path});
+            executed += 1;
+            if (code == 0) {
+                _ = self.failing.remove(artifact.name);
+                continue;
+            }
+            failed += 1;
+            if (!self.failing.contains(artifact.name)) {
+                try self.failing.put(ctx.allocator, try ctx.allocator.dupe(u8, artifact.name), {});
+            }
+        }
+        self.first = false;
+        try ctx.print("test: executed {d} of {d} test target(s), {d} failed\n", .{ executed, total, failed });
+    }
+};
+
+fn flagUnsupported(ctx: *Context, flag: []const u8, command: []const u8) !u8 {
+    try ctx.printErr("error: {s} is not supported by {s}\n", .{ flag, command });
+    return 2;
 }
 
 pub fn handleClean(ctx: *Context, _: []const []const u8) !u8 {
     try core.fs.removeTreeIfExists(".ovo");
-    try core.fs.deleteFileIfExists("ovo.lock.zon");
-    try ctx.print("clean: removed .ovo and transient lock artifacts\n", .{});
+    try ctx.print("clean: removed .ovo\n", .{});
     return 0;
 }
 
-pub fn handleInstall(ctx: *Context, _: []const []const u8) !u8 {
-    const result = try build.orchestrator.buildProject(ctx.allocator, .{
-        .optimize_override = ctx.profile,
+pub fn handleInstall(ctx: *Context, command_args: []const []const u8) !u8 {
+    const install_args = try cli_args.parseInstallArgs(command_args);
+    const build_args = install_args.build;
+    if (build_args.watch) return flagUnsupported(ctx, "--watch", "install");
+    if (build_args.explain) return flagUnsupported(ctx, "--explain", "install");
+    if (build_args.pgo == .train) return flagUnsupported(ctx, "--pgo=train", "install");
+    const project = try loadProject(ctx);
+    var recorder: ?build.trace.Recorder = if (build_args.timings != null) .init(ctx.allocator) else null;
+    const result = result: {
+        defer if (recorder) |*r| writeTimings(ctx, r, build_args.timings.?);
+        break :result try build.orchestrator.buildProject(ctx.allocator, .{
+            .target_name = build_args.target,
+            .optimize_override = ctx.profile,
+            .jobs = build_args.jobs,
+            .unity = build_args.unity,
+            .project = project,
+            .trace = if (recorder) |*r| r else null,
+            .pgo = if (build_args.pgo != null) .use else null,
+        });
+    };
+
+    var layout = build.install.Layout{};
+    if (install_args.prefix) |prefix| layout.prefix = prefix;
+    if (install_args.bindir) |dir| layout.bindir = dir;
+    if (install_args.libdir) |dir| layout.libdir = dir;
+    if (install_args.includedir) |dir| layout.includedir = dir;
+    const items = try build.install.plan(ctx.allocator, project, result.artifacts, layout);
+    const methods = try build.install.run(ctx.allocator, items, .{
+        .prefix = layout.prefix,
+        .mode = if (install_args.link) .link else .copy,
+        .jobs = build_args.jobs orelse build.job_pool.defaultJobCount(),
     });
-    try core.fs.ensureDir(".ovo/install/bin");
-    try core.fs.ensureDir(".ovo/install/lib");
+    var unchanged: usize = 0;
+    for (items, methods) |item, method| {
+        if (method == .up_to_date) {
+            unchanged += 1;
+            continue;
+        }
+        try ctx.print("install: {s} ({s})\n", .{ item.dest, method.label() });
+    }
 
     for (result.artifacts) |artifact| {
-        const file_name = std.fs.path.basename(artifact.path);
-        const install_path = switch (artifact.kind) {
-            .executable, .test_target => try std.fmt.allocPrint(ctx.allocator, ".ovo/install/bin/{s}", .{file_name}),
-            .library_static, .library_shared => try std.fmt.allocPrint(ctx.allocator, ".ovo/install/lib/{s}", .{file_name}),
-        };
-        defer ctx.allocator.free(install_path);
-
-        try core.fs.copyFile(ctx.allocator, artifact.path, install_path);
-        try ctx.print("install: {s}\n", .{install_path});
+        if (artifact.kind != .library_static and artifact.kind != .library_shared) continue;
+        try installPkgConfig(ctx, project, layout);
+        break;
     }
+    if (unchanged > 0) try ctx.print("install: {d} file(s) up to date\n", .{unchanged});
     return 0;
 }
 
+/// `<libdir>/pkgconfig/<project>.pc` for the libraries just installed,
+/// rewritten only when its contents change.
+fn installPkgConfig(ctx: *Context, project: project_mod.Project, layout: build.install.Layout) !void {
+    const prefix = if (std.fs.path.isAbsolute(layout.prefix))
+        layout.prefix
+    else
+        try std.fs.path.join(ctx.allocator, &.{ try core.fs.currentPathAlloc(ctx.allocator), layout.prefix });
+    const contents = try translate.exporter.exportPkgConfig(ctx.allocator, project, .{
+        .prefix = prefix,
+        .libdir = layout.libdir,
+        .includedir = layout.includedir,
+    });
+    const file_name = try std.fmt.allocPrint(ctx.allocator, "{s}.pc", .{project.name});
+    const path = try std.fs.path.join(ctx.allocator, &.{ layout.prefix, layout.libdir, "pkgconfig", file_name });
+    const existing: ?[]const u8 = core.fs.readFileAlloc(ctx.allocator, path) catch null;
+    if (existing) |current| {
+        if (std.mem.eql(u8, current, contents)) return;
+    }
+    try core.fs.writeFile(path, contents);
+    try ctx.print("install: {s} (pkg-config)\n", .{path});
+}
+
 pub fn handleAdd(ctx: *Context, command_args: []const []const u8) !u8 {
     if (command_args.len == 0) {
         try ctx.printErr("error: missing package name\n", .{});
@@ -137,12 +403,38 @@ pub fn handleRemove(ctx: *Context, command_args: []const []const u8) !u8 {
     return 0;
 }
 
-pub fn handleFetch(ctx: *Context, _: []const []const u8) !u8 {
-    const project = try build.orchestrator.loadProject(ctx.allocator);
+pub fn handleFetch(ctx: *Context, command_args: []const []const u8) !u8 {
+    const jobs = try cli_args.parseJobArgs(command_args);
     var manager = package.manager.PackageManager.init(ctx.allocator);
-    try manager.fetch();
-    try ctx.print("fetch: dependency cache refreshed ({d} deps)\n", .{project.dependencies.len});
-    return 0;
+    const resolution = try manager.fetch(jobs orelse package.fetch.default_connections);
+    const failed = try reportFetch(ctx, resolution.items);
+    if (resolution.lock_written) try ctx.print("  wrote {s}\n", .{package.lockfile.path});
+    return if (failed > 0) 1 else 0;
+}
+
+/// Prints what a fetch did, dependency by dependency, and returns how many
+/// failed.
+fn reportFetch(ctx: *Context, items: []const package.fetch.Item) !usize {
+    var failed: usize = 0;
+    var network: usize = 0;
+    for (items) |item| {
+        switch (item.outcome) {
+            .failed => {
+                failed += 1;
+                try ctx.printErr("error: fetch {s}@{s}: {s}\n", .{ item.dep.name, item.dep.version, item.message });
+            },
+            .skipped => try ctx.printErr("warning: fetch {s}@{s}: {s}\n", .{ item.dep.name, item.dep.version, item.message }),
+            .downloaded => {
+                network += 1;
+                try ctx.print("  downloaded {s}@{s}\n", .{ item.dep.name, item.dep.version });
+                if (item.message.len > 0) try ctx.printErr("warning: fetch {s}@{s}: {s}\n", .{ item.dep.name, item.dep.version, item.message });
+            },
+            .linked => try ctx.print("  linked {s}@{s} from the store\n", .{ item.dep.name, item.dep.version }),
+            .up_to_date => {},
+        }
+    }
+    try ctx.print("fetch: dependency cache refreshed ({d} deps, {d} downloaded, {d} failed)\n", .{ items.len, network, failed });
+    return failed;
 }
 
 pub fn handleUpdate(ctx: *Context, command_args: []const []const u8) !u8 {
@@ -157,11 +449,17 @@ pub fn handleUpdate(ctx: *Context, command_args: []const []const u8) !u8 {
     return 0;
 }
 
-pub fn handleLock(ctx: *Context, _: []const []const u8) !u8 {
+pub fn handleLock(ctx: *Context, command_args: []const []const u8) !u8 {
+    const jobs = try cli_args.parseJobArgs(command_args);
     var manager = package.manager.PackageManager.init(ctx.allocator);
-    try manager.lock();
-    try ctx.print("lock: wrote ovo.lock.zon\n", .{});
-    return 0;
+    const resolution = try manager.fetch(jobs orelse package.fetch.default_connections);
+    const failed = try reportFetch(ctx, resolution.items);
+    if (resolution.lock_written) {
+        try ctx.print("lock: wrote {s}\n", .{package.lockfile.path});
+    } else {
+        try ctx.print("lock: {s} is up to date\n", .{package.lockfile.path});
+    }
+    return if (failed > 0) 1 else 0;
 }
 
 pub fn handleDeps(ctx: *Context, _: []const []const u8) !u8 {
@@ -198,83 +496,82 @@ pub fn handleDoctor(ctx: *Context, _: []const []const u8) !u8 {
     else
         "0.16.0";
     try ctx.print("doctor: required_zig={s}\n", .{required_version});
-    const zig_version_code = core.exec.runInherit(ctx.allocator, &.{ "zig", "version" }) catch 1;
-    if (zig_version_code != 0) {
+
+    // Probed concurrently, and only again once a binary changes.
+    const specs = [_]toolchain.Spec{
+        .{ .argv = &.{"zig"}, .version_args = &.{"version"} },
+        toolchain.compilerSpec(.clang),
+        toolchain.compilerSpec(.gcc),
+        .{ .argv = &.{"cmake"} },
+        .{ .argv = &.{"ninja"} },
+        .{ .argv = &.{"clang-format"} },
+        .{ .argv = &.{"clang-tidy"} },
+        .{ .argv = &.{"doxygen"} },
+        .{ .argv = &.{"clang-doc"} },
+    };
+    var tools = toolchain.Toolchain.init(ctx.allocator, toolchain.cache_path);
+    const probes = try tools.probe(ctx.allocator, &specs);
+    tools.save() catch {};
+    if (!probes[0].found) {
         try ctx.printErr("doctor: unable to run `zig version`\n", .{});
     }
 
-    const tools = [_][]const u8{
-        "zig",
-        "clang++",
-        "g++",
-        "cmake",
-        "ninja",
-        "clang-format",
-        "clang-tidy",
-        "doxygen",
-        "clang-doc",
-    };
     var missing: usize = 0;
-    for (tools) |tool| {
-        const available = core.exec.commandExists(ctx.allocator, tool);
-        try ctx.print("doctor: {s} {s}\n", .{ tool, if (available) "ok" else "missing" });
-        if (!available) missing += 1;
+    for (probes) |probe| {
+        if (!probe.found) {
+            try ctx.print("doctor: {s} missing\n", .{probe.name});
+            missing += 1;
+            continue;
+        }
+        try ctx.print("doctor: {s} ok ({s})\n", .{ probe.name, probe.version() });
+        if (probe.target.len > 0) try ctx.print("doctor: {s} target={s}\n", .{ probe.name, probe.target });
+        for (probe.unsupported_flags) |flag| {
+            try ctx.print("doctor: {s} rejects {s}\n", .{ probe.name, flag });
+        }
     }
     return if (missing == 0) 0 else 1;
 }
 
-pub fn handleFmt(ctx: *Context, _: []const []const u8) !u8 {
-    if (!core.exec.commandExists(ctx.allocator, "clang-format")) {
-        try ctx.printErr("error: clang-format not found in PATH\n", .{});
-        return 2;
-    }
-    const project = try build.orchestrator.loadProject(ctx.allocator);
-    var any = false;
-    for (project.targets) |target| {
-        for (target.sources) |pattern| {
-            const sources = try build.orchestrator.resolveSourcePattern(ctx.allocator, pattern);
-            for (sources) |source| {
-                const code = try core.exec.runInherit(ctx.allocator, &.{ "clang-format", "-i", source });
-                if (code != 0) return code;
-                any = true;
-            }
-        }
-    }
-    if (!any) {
-        try ctx.print("fmt: no source files found\n", .{});
-    } else {
-        try ctx.print("fmt: formatted project sources\n", .{});
-    }
-    return 0;
+pub fn handleFmt(ctx: *Context, command_args: []const []const u8) !u8 {
+    return runSourceTool(ctx, command_args, .format, "fmt", "formatted");
+}
+
+pub fn handleLint(ctx: *Context, command_args: []const []const u8) !u8 {
+    return runSourceTool(ctx, command_args, .tidy, "lint", "linted");
 }
 
-pub fn handleLint(ctx: *Context, _: []const []const u8) !u8 {
-    if (!core.exec.commandExists(ctx.allocator, "clang-tidy")) {
-        try ctx.printErr("error: clang-tidy not found in PATH\n", .{});
+fn runSourceTool(
+    ctx: *Context,
+    command_args: []const []const u8,
+    tool: build.code_tools.Tool,
+    name: []const u8,
+    verb: []const u8,
+) !u8 {
+    const parsed = try cli_args.parseSourceToolArgs(command_args);
+    const version = build.code_tools.toolVersion(ctx.allocator, tool) orelse {
+        try ctx.printErr("error: {s} not found in PATH\n", .{tool.command()});
         return 2;
+    };
+    const project = try loadProject(ctx);
+    const report = try build.code_tools.run(ctx.allocator, project, tool, .{
+        .version = version,
+        .jobs = parsed.jobs,
+        .changed = parsed.changed,
+    });
+    if (report.checked == 0 and report.clean == 0) {
+        try ctx.print("{s}: no {s}source files found\n", .{ name, if (parsed.changed) "changed " else "" });
+        return 0;
     }
-    const project = try build.orchestrator.loadProject(ctx.allocator);
-    var any = false;
-    for (project.targets) |target| {
-        for (target.sources) |pattern| {
-            const sources = try build.orchestrator.resolveSourcePattern(ctx.allocator, pattern);
-            for (sources) |source| {
-                const code = try core.exec.runInherit(ctx.allocator, &.{ "clang-tidy", source, "--", "-std=c++20" });
-                if (code != 0) return code;
-                any = true;
-            }
-        }
-    }
-    if (!any) {
-        try ctx.print("lint: no source files found\n", .{});
-    } else {
-        try ctx.print("lint: linted project sources\n", .{});
+    try ctx.print("{s}: {s} {d} files, {d} unchanged since their last clean run\n", .{ name, verb, report.checked, report.clean });
+    if (report.failed > 0) {
+        try ctx.printErr("error: {s}: {d} {s} runs failed\n", .{ name, report.failed, tool.command() });
+        return 1;
     }
     return 0;
 }
 
 pub fn handleInfo(ctx: *Context, _: []const []const u8) !u8 {
-    const project = try build.orchestrator.loadProject(ctx.allocator);
+    const project = try loadProject(ctx);
     try ctx.print("project: {s}\n", .{project.name});
     try ctx.print("version: {s}\n", .{project.version});
     try ctx.print("license: {s}\n", .{project.license orelse "n/a"});
@@ -284,6 +581,21 @@ pub fn handleInfo(ctx: *Context, _: []const []const u8) !u8 {
     try ctx.print("backend: {s}\n", .{project.defaults.backend});
     try ctx.print("optimize: {s}\n", .{project.defaults.optimize});
     try ctx.print("output_dir: {s}\n", .{project.defaults.output_dir});
+    if (try build.object_cache.ObjectCache.open(ctx.allocator)) |cache| {
+        const stats = try build.object_cache.loadStats(ctx.allocator, cache.root);
+        try ctx.print("cache: {s}\n", .{cache.root});
+        try ctx.print("cache_size: {d} MiB / {d} MiB\n", .{ stats.size_bytes >> 20, cache.max_size >> 20 });
+        try ctx.print("cache_hits: {d}\n", .{stats.hits});
+        try ctx.print("cache_misses: {d} ({d}% hit rate)\n", .{ stats.misses, stats.hitRatePercent() });
+        try ctx.print("cache_evictions: {d}\n", .{stats.evictions});
+        if (project.defaults.remote_cache) |remote| {
+            try ctx.print("remote_cache: {s} ({s})\n", .{ remote.url, project_mod.remoteCacheModeLabel(remote.mode) });
+            try ctx.print("remote_cache_hits: {d}\n", .{stats.remote_hits});
+            try ctx.print("remote_cache_uploads: {d}\n", .{stats.remote_uploads});
+        }
+    } else {
+        try ctx.print("cache: disabled\n", .{});
+    }
     if (project.targets.len > 0) {
         try ctx.print("target_list:\n", .{});
         for (project.targets) |target| {
@@ -328,16 +640,40 @@ pub fn handleExport(ctx: *Context, command_args: []const []const u8) !u8 {
         return 2;
     };
     const project = try build.orchestrator.loadProject(ctx.allocator);
-    const content = try translate.exporter.exportProject(ctx.allocator, project, format);
     const output_path = if (command_args.len > 1)
         command_args[1]
     else
         try translate.exporter.defaultPathForFormat(ctx.allocator, project, format);
-    try translate.exporter.writeExport(output_path, content);
+    const content = if (format == .ninja)
+        try translate.exporter.exportNinja(ctx.allocator, project, .{ .path = output_path, .optimize = ctx.profile })
+    else
+        try translate.exporter.exportProject(ctx.allocator, project, format);
+    try translate.exporter.writeExport(ctx.allocator, output_path, content);
     try ctx.print("export: wrote {s}\n", .{output_path});
     return 0;
 }
 
+pub fn handleDaemon(ctx: *Context, command_args: []const []const u8) !u8 {
+    if (command_args.len == 0) return daemon.serve(ctx);
+    const action = command_args[0];
+    if (!std.mem.eql(u8, action, "stop") and !std.mem.eql(u8, action, "status")) {
+        try ctx.printErr("error: daemon: unknown action '{s}'\n", .{action});
+        return 2;
+    }
+    if (try daemon.forward(ctx.allocator, &.{ "ovo", "daemon", action })) |code| return code;
+    try ctx.print("daemon: not running\n", .{});
+    return if (std.mem.eql(u8, action, "status")) 1 else 0;
+}
+
+pub fn handleWorker(ctx: *Context, command_args: []const []const u8) !u8 {
+    const parsed = try cli_args.parseWorkerArgs(command_args);
+    try build.distributed.serve(ctx.allocator, .{
+        .listen = parsed.listen,
+        .jobs = parsed.jobs orelse build.job_pool.defaultJobCount(),
+    });
+    return 0;
+}
+
 fn projectNameFromCwd(allocator: std.mem.Allocator) []const u8 {
     const cwd = core.fs.currentPathAlloc(allocator) catch return "app";
     return std.fs.path.basename(cwd);
@@ -19,6 +19,7 @@ pub fn printGlobalHelp(ctx: *Context) !void {
     try ctx.print("  --version, -V         Show version\n", .{});
     try ctx.print("  --verbose             Enable verbose output\n", .{});
     try ctx.print("  --quiet               Minimize output\n", .{});
+    try ctx.print("  --stats               Report allocations and peak memory\n", .{});
     try ctx.print("  --cwd <path>          Override working directory\n", .{});
     try ctx.print("  --profile <name>      Build profile override\n", .{});
 
@@ -2,6 +2,8 @@ const std = @import("std");
 const args = @import("args.zig");
 const dispatch = @import("command_dispatch.zig");
 const Context = @import("context.zig").Context;
+const daemon = @import("daemon.zig");
+const core = @import("../core/mod.zig");
 
 pub fn run(allocator: std.mem.Allocator, process_args: std.process.Args) !u8 {
     var arena = std.heap.ArenaAllocator.init(allocator);
@@ -22,13 +24,28 @@ pub fn run(allocator: std.mem.Allocator, process_args: std.process.Args) !u8 {
         // std.Io.Threaded.chdir is the correct Zig 0.16 POSIX chdir API
         try std.Io.Threaded.chdir(cwd);
     }
+    if (daemon.shouldForward(&parsed)) {
+        if (try daemon.forward(arena_alloc, argv.items)) |code| return code;
+    }
 
+    // With --stats the command's allocations are counted on their way to the arena.
+    var counting = core.memory.Counting{ .child = arena_alloc };
     var ctx = Context{
-        .allocator = arena_alloc,
+        .allocator = if (parsed.stats) counting.allocator() else arena_alloc,
         .cwd_path = ".",
         .profile = parsed.profile,
         .verbose = parsed.verbose,
         .quiet = parsed.quiet,
     };
+    defer if (parsed.stats) printStats(&ctx, &counting, &arena);
     return dispatch.dispatch(&ctx, &parsed);
 }
+
+fn printStats(ctx: *Context, counting: *const core.memory.Counting, arena: *const std.heap.ArenaAllocator) void {
+    ctx.printErr("stats: {d} allocation(s), {d} KiB requested, arena {d} KiB, peak {d} KiB from the OS\n", .{
+        counting.allocations,
+        counting.requested_bytes / 1024,
+        arena.queryCapacity() / 1024,
+        core.memory.peakPageBytes() / 1024,
+    }) catch {};
+}
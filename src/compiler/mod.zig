@@ -1 +1,2 @@
 pub const backend = @import("backend.zig");
+pub const toolchain = @import("toolchain.zig");
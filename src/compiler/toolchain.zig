@@ -0,0 +1,365 @@
+const std = @import("std");
+const builtin = @import("builtin");
+const core = @import("../core/mod.zig");
+const zon = @import("../zon/mod.zig");
+const backend_mod = @import("backend.zig");
+
+/// Probes of every tool looked up in the project, shared by all commands.
+pub const cache_path = ".ovo/toolchain.zon";
+
+const format_version = 1;
+
+/// Flags whose support varies between compiler releases, tried once per
+/// compiler binary.
+pub const probed_flags = [_][]const u8{
+    "-std=c++17",
+    "-std=c++20",
+    "-std=c++23",
+    "-gsplit-dwarf",
+    "-flto=thin",
+    "-fprofile-update=atomic",
+};
+
+/// Compile probes read this instead of a source file.
+const empty_input = if (builtin.os.tag == .windows) "NUL" else "/dev/null";
+
+/// A tool to look up: the command it runs as, what makes it print its
+/// version, and whether it is a compiler driver and so worth asking for
+/// its target, include paths and flags.
+pub const Spec = struct {
+    argv: []const []const u8,
+    version_args: []const []const u8 = &.{"--version"},
+    compiler: bool = false,
+};
+
+/// The compiler driver of `backend`, as `orchestrator.appendCompilerPrefix`
+/// invokes it. msvc's `cl` prints its banner when run without arguments.
+pub fn compilerSpec(backend: backend_mod.Backend) Spec {
+    return switch (backend) {
+        .clang => .{ .argv = &.{"clang++"}, .compiler = true },
+        .gcc => .{ .argv = &.{"g++"}, .compiler = true },
+        .zigcc => .{ .argv = &.{ "zig", "c++" }, .compiler = true },
+        .msvc => .{ .argv = &.{"cl"}, .version_args = &.{}, .compiler = true },
+    };
+}
+
+/// What one tool's probe found. It stays valid while the binary PATH
+/// resolves to keeps its path, mtime and size.
+pub const Probe = struct {
+    /// `Spec.argv` joined with spaces, e.g. `zig c++`.
+    name: []const u8,
+    path: []const u8 = "",
+    mtime_ns: i128 = 0,
+    size: u64 = 0,
+    /// False when the command isn't on PATH or its version probe failed.
+    found: bool = false,
+    /// Everything the version probe printed, stdout then stderr.
+    banner: []const u8 = "",
+    /// The compiler's default target, e.g. `x86_64-pc-linux-gnu`.
+    target: []const u8 = "",
+    /// Where the compiler looks for `#include <...>`, in search order.
+    include_dirs: []const []const u8 = &.{},
+    /// The `probed_flags` the compiler accepted and those it rejected;
+    /// both empty for tools that aren't compilers and for msvc.
+    flags: []const []const u8 = &.{},
+    unsupported_flags: []const []const u8 = &.{},
+
+    /// First line of the banner.
+    pub fn version(self: Probe) []const u8 {
+        const line = self.banner[0 .. std.mem.indexOfScalar(u8, self.banner, '\n') orelse self.banner.len];
+        return std.mem.trim(u8, line, " \t\r");
+    }
+
+    /// True only for a probed flag the compiler refused; flags that weren't
+    /// probed aren't known to be unsupported.
+    pub fn rejects(self: Probe, flag: []const u8) bool {
+        for (self.unsupported_flags) |unsupported| {
+            if (std.mem.eql(u8, unsupported, flag)) return true;
+        }
+        return false;
+    }
+};
+
+/// Where PATH resolves a command, and the stat its probe is keyed on.
+pub const Located = struct {
+    path: []const u8,
+    mtime_ns: i128,
+    size: u64,
+};
+
+/// Resolves `name` against PATH with one stat per directory instead of
+/// starting it, which is what makes cached probes cheap.
+pub fn findExecutable(allocator: std.mem.Allocator, name: []const u8) !?Located {
+    if (std.mem.indexOfAny(u8, name, "/\\") != null) return locate(name);
+    const search = core.runtime.getEnv("PATH") orelse return null;
+    var dirs = std.mem.tokenizeScalar(u8, search, std.fs.path.delimiter);
+    while (dirs.next()) |dir| {
+        const candidate = try std.fs.path.join(allocator, &.{ dir, name });
+        if (locate(candidate)) |found| return found;
+        if (builtin.os.tag == .windows) {
+            if (locate(try std.fmt.allocPrint(allocator, "{s}.exe", .{candidate}))) |found| return found;
+        }
+    }
+    return null;
+}
+
+fn locate(path: []const u8) ?Located {
+    const stat = core.fs.fingerprint(path) catch return null;
+    return .{ .path = path, .mtime_ns = stat.mtime_ns, .size = stat.size };
+}
+
+/// Probes kept in `path`, loaded on first use. Missing tools aren't
+/// recorded, so installing one is noticed on the next lookup.
+pub const Toolchain = struct {
+    allocator: std.mem.Allocator,
+    path: ?[]const u8,
+    probes: std.StringArrayHashMapUnmanaged(Probe) = .empty,
+    loaded: bool = false,
+    dirty: bool = false,
+
+    pub fn init(allocator: std.mem.Allocator, path: ?[]const u8) Toolchain {
+        return .{ .allocator = allocator, .path = path };
+    }
+
+    /// A probe per spec, in order, in `allocator`. Cached probes whose
+    /// binary is unchanged are reused as they are; the rest run
+    /// concurrently, one thread per tool.
+    pub fn probe(self: *Toolchain, allocator: std.mem.Allocator, specs: []const Spec) ![]const Probe {
+        if (!self.loaded) self.load();
+        const results = try allocator.alloc(Probe, specs.len);
+        var jobs: std.ArrayList(Job) = .empty;
+        defer jobs.deinit(allocator);
+
+        for (specs, results, 0..) |spec, *result, i| {
+            const name = try std.mem.join(allocator, " ", spec.argv);
+            result.* = .{ .name = name };
+            const located = try findExecutable(allocator, spec.argv[0]) orelse continue;
+            if (self.probes.get(name)) |cached| {
+                if (cached.mtime_ns == located.mtime_ns and cached.size == located.size and std.mem.eql(u8, cached.path, located.path)) {
+                    result.* = cached;
+                    continue;
+                }
+            }
+            try jobs.append(allocator, .{
+                .spec = spec,
+                .name = name,
+                .located = located,
+                .slot = i,
+                .arena = std.heap.ArenaAllocator.init(core.memory.page_allocator),
+            });
+        }
+        if (jobs.items.len == 0) return results;
+
+        var threads: std.ArrayList(std.Thread) = .empty;
+        defer threads.deinit(allocator);
+        for (jobs.items[1..]) |*job| {
+            const thread = std.Thread.spawn(.{}, Job.run, .{job}) catch {
+                job.run();
+                continue;
+            };
+            try threads.append(allocator, thread);
+        }
+        jobs.items[0].run();
+        for (threads.items) |thread| thread.join();
+
+        defer for (jobs.items) |*job| job.arena.deinit();
+        for (jobs.items) |*job| {
+            if (job.err) |err| return err;
+            const fresh = try dupeProbe(self.allocator, job.result);
+            results[job.slot] = fresh;
+            try self.probes.put(self.allocator, fresh.name, fresh);
+            self.dirty = true;
+        }
+        return results;
+    }
+
+    pub fn save(self: *Toolchain) !void {
+        const path = self.path orelse return;
+        if (!self.dirty) return;
+        const rendered = try render(self.allocator, self.probes.values());
+        defer self.allocator.free(rendered);
+        try core.fs.writeFile(path, rendered);
+        self.dirty = false;
+    }
+
+    /// An unreadable or outdated cache is treated as empty and rewritten.
+    fn load(self: *Toolchain) void {
+        self.loaded = true;
+        const path = self.path orelse return;
+        const bytes = core.fs.readFileAlloc(self.allocator, path) catch return;
+        const probes = parse(self.allocator, bytes) catch return;
+        for (probes) |cached| self.probes.put(self.allocator, cached.name, cached) catch return;
+    }
+};
+
+/// One tool probed on its own thread, allocating from its own arena.
+const Job = struct {
+    spec: Spec,
+    name: []const u8,
+    located: Located,
+    slot: usize,
+    arena: std.heap.ArenaAllocator,
+    result: Probe = undefined,
+    err: ?anyerror = null,
+
+    fn run(job: *Job) void {
+        job.result = probeTool(job.arena.allocator(), job.spec, job.name, job.located) catch |err| {
+            job.err = err;
+            return;
+        };
+    }
+};
+
+fn probeTool(allocator: std.mem.Allocator, spec: Spec, name: []const u8, located: Located) !Probe {
+    var result = Probe{ .name = name, .path = located.path, .mtime_ns = located.mtime_ns, .size = located.size };
+    const banner = try runWith(allocator, spec.argv, spec.version_args) orelse return result;
+    if (banner.exit_code != 0 and spec.version_args.len > 0) return result;
+    result.found = true;
+    result.banner = banner.output;
+    if (!spec.compiler or std.mem.eql(u8, spec.argv[0], "cl")) return result;
+
+    if (try runWith(allocator, spec.argv, &.{"-dumpmachine"})) |machine| {
+        if (machine.exit_code == 0) result.target = std.mem.trim(u8, machine.output, " \t\r\n");
+    }
+    if (try runWith(allocator, spec.argv, &.{ "-E", "-x", "c++", "-v", empty_input })) |verbose| {
+        result.include_dirs = try parseIncludeDirs(allocator, verbose.output);
+    }
+    var flags: std.ArrayList([]const u8) = .empty;
+    var unsupported: std.ArrayList([]const u8) = .empty;
+    for (probed_flags) |flag| {
+        const accepted = if (try runWith(allocator, spec.argv, &.{ "-E", "-x", "c++", flag, empty_input })) |run| run.exit_code == 0 else false;
+        try (if (accepted) &flags else &unsupported).append(allocator, flag);
+    }
+    result.flags = flags.items;
+    result.unsupported_flags = unsupported.items;
+    return result;
+}
+
+/// Null when the command couldn't be started at all.
+fn runWith(allocator: std.mem.Allocator, argv: []const []const u8, extra: []const []const u8) !?core.exec.Captured {
+    const full = try std.mem.concat(allocator, []const u8, &.{ argv, extra });
+    return core.exec.runCaptured(allocator, full) catch |err| switch (err) {
+        error.OutOfMemory => return err,
+        else => return null,
+    };
+}
+
+/// The `#include <...>` search list of a compiler's `-v` output. macOS
+/// marks framework directories, which aren't include paths.
+pub fn parseIncludeDirs(allocator: std.mem.Allocator, output: []const u8) ![]const []const u8 {
+    var dirs: std.ArrayList([]const u8) = .empty;
+    var lines = std.mem.splitScalar(u8, output, '\n');
+    var inside = false;
+    while (lines.next()) |raw| {
+        const line = std.mem.trim(u8, raw, " \t\r");
+        if (!inside) {
+            inside = std.mem.startsWith(u8, line, "#include <...> search starts here");
+            continue;
+        }
+        if (std.mem.startsWith(u8, line, "End of search list")) break;
+        if (line.len == 0 or std.mem.endsWith(u8, line, "(framework directory)")) continue;
+        try dirs.append(allocator, line);
+    }
+    return dirs.items;
+}
+
+fn dupeProbe(allocator: std.mem.Allocator, probe: Probe) !Probe {
+    var copy = probe;
+    copy.name = try allocator.dupe(u8, probe.name);
+    copy.path = try allocator.dupe(u8, probe.path);
+    copy.banner = try allocator.dupe(u8, probe.banner);
+    copy.target = try allocator.dupe(u8, probe.target);
+    copy.include_dirs = try dupeStrings(allocator, probe.include_dirs);
+    copy.flags = try dupeStrings(allocator, probe.flags);
+    copy.unsupported_flags = try dupeStrings(allocator, probe.unsupported_flags);
+    return copy;
+}
+
+fn dupeStrings(allocator: std.mem.Allocator, values: []const []const u8) ![]const []const u8 {
+    const copy = try allocator.alloc([]const u8, values.len);
+    for (copy, values) |*out, value| out.* = try allocator.dupe(u8, value);
+    return copy;
+}
+
+pub fn render(allocator: std.mem.Allocator, probes: []const Probe) ![]u8 {
+    var out: std.ArrayList(u8) = .empty;
+    try out.print(allocator, ".{{\n    .version = {d},\n    .tools = .{{\n", .{format_version});
+    for (probes) |probe| {
+        try out.appendSlice(allocator, "        .{\n");
+        try out.print(allocator, "            .name = {f},\n", .{zon.writer.zonString(probe.name)});
+        try out.print(allocator, "            .path = {f},\n", .{zon.writer.zonString(probe.path)});
+        try out.print(allocator, "            .mtime_ns = {d},\n", .{probe.mtime_ns});
+        try out.print(allocator, "            .size = {d},\n", .{probe.size});
+        try out.print(allocator, "            .found = {},\n", .{probe.found});
+        try out.print(allocator, "            .banner = {f},\n", .{zon.writer.zonString(probe.banner)});
+        try out.print(allocator, "            .target = {f},\n", .{zon.writer.zonString(probe.target)});
+        try renderList(allocator, &out, "include_dirs", probe.include_dirs);
+        try renderList(allocator, &out, "flags", probe.flags);
+        try renderList(allocator, &out, "unsupported_flags", probe.unsupported_flags);
+        try out.appendSlice(allocator, "        },\n");
+    }
+    try out.appendSlice(allocator, "    },\n}\n");
+    return out.toOwnedSlice(allocator);
+}
+
+fn renderList(allocator: std.mem.Allocator, out: *std.ArrayList(u8), name: []const u8, values: []const []const u8) !void {
+    try out.print(allocator, "            .{s} = .{{", .{name});
+    for (values, 0..) |value, i| {
+        try out.print(allocator, "{s}{f}", .{ if (i == 0) " " else ", ", zon.writer.zonString(value) });
+    }
+    try out.appendSlice(allocator, if (values.len == 0) "},\n" else " },\n");
+}
+
+pub fn parse(allocator: std.mem.Allocator, bytes: []const u8) ![]const Probe {
+    const root = try zon.ast.parse(allocator, bytes, null);
+    const version = root.get("version") orelse return error.InvalidToolchainCache;
+    if (version.value != .number or !std.mem.eql(u8, version.value.number, std.fmt.comptimePrint("{d}", .{format_version}))) {
+        return error.InvalidToolchainCache;
+    }
+    const tools = (root.get("tools") orelse return error.InvalidToolchainCache).items() orelse return error.InvalidToolchainCache;
+    const probes = try allocator.alloc(Probe, tools.len);
+    for (tools, probes) |tool, *probe| {
+        probe.* = .{
+            .name = try string(tool, "name"),
+            .path = try string(tool, "path"),
+            .mtime_ns = try number(i128, tool, "mtime_ns"),
+            .size = try number(u64, tool, "size"),
+            .found = switch ((tool.get("found") orelse return error.InvalidToolchainCache).value) {
+                .boolean => |value| value,
+                else => return error.InvalidToolchainCache,
+            },
+            .banner = try string(tool, "banner"),
+            .target = try string(tool, "target"),
+            .include_dirs = try strings(allocator, tool, "include_dirs"),
+            .flags = try strings(allocator, tool, "flags"),
+            .unsupported_flags = try strings(allocator, tool, "unsupported_flags"),
+        };
+    }
+    return probes;
+}
+
+fn string(node: zon.ast.Node, name: []const u8) ![]const u8 {
+    return switch ((node.get(name) orelse return error.InvalidToolchainCache).value) {
+        .string => |value| value,
+        else => error.InvalidToolchainCache,
+    };
+}
+
+fn number(comptime T: type, node: zon.ast.Node, name: []const u8) !T {
+    return switch ((node.get(name) orelse return error.InvalidToolchainCache).value) {
+        .number => |value| std.fmt.parseInt(T, value, 10) catch error.InvalidToolchainCache,
+        else => error.InvalidToolchainCache,
+    };
+}
+
+fn strings(allocator: std.mem.Allocator, node: zon.ast.Node, name: []const u8) ![]const []const u8 {
+    const items = (node.get(name) orelse return error.InvalidToolchainCache).items() orelse return error.InvalidToolchainCache;
+    const values = try allocator.alloc([]const u8, items.len);
+    for (items, values) |item, *value| {
+        value.* = switch (item.value) {
+            .string => |text| text,
+            else => return error.InvalidToolchainCache,
+        };
+    }
+    return values;
+}
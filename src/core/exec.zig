@@ -1,5 +1,13 @@
 const std = @import("std");
+const builtin = @import("builtin");
 const runtime = @import("runtime.zig");
+const fs = @import("fs.zig");
+
+pub const Captured = struct {
+    exit_code: u8,
+    /// Combined stdout followed by stderr, owned by the allocator passed in.
+    output: []u8,
+};
 
 pub fn runInherit(allocator: std.mem.Allocator, argv: []const []const u8) !u8 {
     _ = allocator;
@@ -10,12 +18,7 @@ pub fn runInherit(allocator: std.mem.Allocator, argv: []const []const u8) !u8 {
         .stderr = .inherit,
     });
     const term = try child.wait(runtime.io());
-    return switch (term) {
-        .exited => |code| @as(u8, @intCast(code)),
-        .signal => 128,
-        .stopped => 129,
-        .unknown => 130,
-    };
+    return exitCode(term);
 }
 
 pub fn runQuiet(allocator: std.mem.Allocator, argv: []const []const u8) !u8 {
@@ -27,11 +30,136 @@ pub fn runQuiet(allocator: std.mem.Allocator, argv: []const []const u8) !u8 {
         .stderr = .ignore,
     });
     const term = try child.wait(runtime.io());
-    return switch (term) {
-        .exited => |code| @as(u8, @intCast(code)),
-        .signal => 128,
-        .stopped => 129,
-        .unknown => 130,
+    return exitCode(term);
+}
+
+/// Runs `argv` to completion with stdout and stderr captured instead of
+/// inherited. Safe to call from worker threads when `allocator` is thread-safe.
+pub fn runCaptured(allocator: std.mem.Allocator, argv: []const []const u8) !Captured {
+    const result = try std.process.run(allocator, runtime.io(), .{ .argv = argv });
+    defer allocator.free(result.stdout);
+    defer allocator.free(result.stderr);
+
+    const output = try std.mem.concat(allocator, u8, &.{ result.stdout, result.stderr });
+    return .{
+        .exit_code = exitCode(result.term),
+        .output = output,
+    };
+}
+
+/// Like `runCaptured`, but returns stdout apart from stderr for tools that
+/// print their result.
+pub fn runCapturedStdout(allocator: std.mem.Allocator, argv: []const []const u8) !Split {
+    const result = try std.process.run(allocator, runtime.io(), .{ .argv = argv });
+    return .{
+        .exit_code = exitCode(result.term),
+        .stdout = result.stdout,
+        .stderr = result.stderr,
+    };
+}
+
+pub const Split = struct {
+    exit_code: u8,
+    stdout: []u8,
+    stderr: []u8,
+};
+
+/// A child whose stdout and stderr both go to one log file, in the order
+/// it wrote them. `kill` may be called from another thread until
+/// `awaitExit` returns; once `wait` has reaped the child its pid can belong
+/// to another process.
+pub const Logged = struct {
+    child: std.process.Child,
+
+    /// Blocks until the child has exited without reaping it, so its pid
+    /// (or handle) stays its own until `wait`. Elsewhere than Linux, macOS
+    /// and Windows it returns at once, which gives up killing the child.
+    pub fn awaitExit(self: *const Logged) void {
+        switch (builtin.os.tag) {
+            .linux => {
+                const linux = std.os.linux;
+                var info: linux.siginfo_t = undefined;
+                while (linux.E.init(linux.waitid(.PID, self.child.id, &info, linux.W.EXITED | linux.W.NOWAIT)) == .INTR) {}
+            },
+            .macos => {
+                var info: [darwin_siginfo_size]u8 align(8) = undefined;
+                while (waitid(darwin_p_pid, self.child.id, &info, darwin_wexited | darwin_wnowait) == -1 and
+                    std.posix.errno(-1) == .INTR)
+                {}
+            },
+            .windows => std.os.windows.WaitForSingleObject(self.child.id, std.os.windows.INFINITE) catch {},
+            else => {},
+        }
+    }
+
+    pub fn wait(self: *Logged) !u8 {
+        return exitCode(try self.child.wait(runtime.io()));
+    }
+
+    pub fn kill(self: *const Logged) void {
+        if (builtin.os.tag == .windows) {
+            std.os.windows.TerminateProcess(self.child.id, 1) catch {};
+        } else {
+            std.posix.kill(self.child.id, std.posix.SIG.KILL) catch {};
+        }
+    }
+};
+
+// <sys/wait.h>, which the std library doesn't bind on macOS.
+extern "c" fn waitid(idtype: c_int, id: c_int, infop: *anyopaque, options: c_int) c_int;
+const darwin_p_pid = 1;
+const darwin_wexited = 0x04;
+const darwin_wnowait = 0x20;
+const darwin_siginfo_size = 104;
+
+pub fn spawnLogged(argv: []const []const u8, log_path: []const u8) !Logged {
+    const file = try std.Io.Dir.cwd().createFile(runtime.io(), log_path, .{});
+    defer file.close(runtime.io());
+    const child = try std.process.spawn(runtime.io(), .{
+        .argv = argv,
+        .stdin = .ignore,
+        .stdout = .{ .file = file },
+        .stderr = .{ .file = file },
+    });
+    return .{ .child = child };
+}
+
+pub const Measured = struct {
+    exit_code: u8,
+    /// Combined stdout and stderr, owned by the allocator passed in.
+    output: []u8,
+    /// Peak resident set size in bytes; 0 where the platform doesn't report it.
+    peak_rss: u64,
+};
+
+/// Like `runCaptured`, but also reports the child's peak RSS. On Linux the
+/// child is reaped with `wait4` for its rusage, and its output goes through
+/// `log_path`, which is removed afterwards.
+pub fn runMeasured(allocator: std.mem.Allocator, argv: []const []const u8, log_path: []const u8) !Measured {
+    if (builtin.os.tag != .linux) {
+        const captured = try runCaptured(allocator, argv);
+        return .{ .exit_code = captured.exit_code, .output = captured.output, .peak_rss = 0 };
+    }
+    const linux = std.os.linux;
+    const logged = try spawnLogged(argv, log_path);
+    defer fs.deleteFileIfExists(log_path) catch {};
+    var status: u32 = 0;
+    var usage: linux.rusage = undefined;
+    while (true) {
+        const rc = linux.wait4(logged.child.id, &status, 0, &usage);
+        switch (linux.E.init(rc)) {
+            .SUCCESS => break,
+            .INTR => continue,
+            else => return error.WaitFailed,
+        }
+    }
+    const exit_code: u8 = if (linux.W.IFEXITED(status)) linux.W.EXITSTATUS(status) else 128;
+    // ru_maxrss is in kilobytes on Linux.
+    const peak_kb: u64 = @intCast(@max(usage.maxrss, 0));
+    return .{
+        .exit_code = exit_code,
+        .output = try fs.readFileAllocUnlimited(allocator, log_path),
+        .peak_rss = peak_kb * 1024,
     };
 }
 
@@ -39,3 +167,12 @@ pub fn commandExists(allocator: std.mem.Allocator, command: []const u8) bool {
     const code = runQuiet(allocator, &.{ command, "--version" }) catch return false;
     return code == 0;
 }
+
+fn exitCode(term: anytype) u8 {
+    return switch (term) {
+        .exited => |code| @as(u8, @intCast(code)),
+        .signal => 128,
+        .stopped => 129,
+        .unknown => 130,
+    };
+}
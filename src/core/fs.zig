@@ -6,6 +6,19 @@ pub fn fileExists(path: []const u8) bool {
     return true;
 }
 
+pub const Fingerprint = struct {
+    mtime_ns: i128,
+    size: u64,
+};
+
+pub fn fingerprint(path: []const u8) !Fingerprint {
+    const stat = try std.Io.Dir.cwd().statFile(runtime.io(), path, .{});
+    return .{
+        .mtime_ns = stat.mtime.nanoseconds,
+        .size = stat.size,
+    };
+}
+
 pub fn ensureDir(path: []const u8) !void {
     try std.Io.Dir.cwd().createDirPath(runtime.io(), path);
 }
@@ -31,6 +44,12 @@ pub fn readFileAlloc(allocator: std.mem.Allocator, path: []const u8) ![]u8 {
     );
 }
 
+/// Like `readFileAlloc` without the size cap, for inputs such as `build.zon`
+/// whose size is up to the user.
+pub fn readFileAllocUnlimited(allocator: std.mem.Allocator, path: []const u8) ![]u8 {
+    return std.Io.Dir.cwd().readFileAlloc(runtime.io(), path, allocator, .unlimited);
+}
+
 pub fn removeTreeIfExists(path: []const u8) !void {
     std.Io.Dir.cwd().deleteTree(runtime.io(), path) catch |err| {
         if (err == error.FileNotFound) return;
@@ -38,6 +57,68 @@ pub fn removeTreeIfExists(path: []const u8) !void {
     };
 }
 
+var temp_counter: std.atomic.Value(u64) = .init(0);
+
+/// A file written in pieces through `writer` and moved over `path` by
+/// `finish`, so readers never see it half written. Heap-allocated because
+/// the writer points at its buffer.
+pub const AtomicFile = struct {
+    path: []const u8,
+    tmp_path: []const u8,
+    file: std.Io.File,
+    file_writer: std.Io.File.Writer,
+    buffer: [64 * 1024]u8,
+
+    pub fn create(allocator: std.mem.Allocator, path: []const u8) !*AtomicFile {
+        const self = try allocator.create(AtomicFile);
+        errdefer allocator.destroy(self);
+        self.path = path;
+        // Unique to this writer, so concurrent writers of one path never
+        // share a temporary: no two live threads, in any process, have the
+        // same id, and the counter tells one thread's writers apart.
+        self.tmp_path = try std.fmt.allocPrint(allocator, "{s}.tmp-{x}-{x}", .{
+            path,
+            std.Thread.getCurrentId(),
+            temp_counter.fetchAdd(1, .monotonic),
+        });
+        if (std.fs.path.dirname(path)) |dir| {
+            if (dir.len > 0) try ensureDir(dir);
+        }
+        self.file = try std.Io.Dir.cwd().createFile(runtime.io(), self.tmp_path, .{});
+        self.file_writer = self.file.writer(runtime.io(), &self.buffer);
+        return self;
+    }
+
+    pub fn writer(self: *AtomicFile) *std.Io.Writer {
+        return &self.file_writer.interface;
+    }
+
+    pub fn finish(self: *AtomicFile) !void {
+        self.file_writer.interface.flush() catch |err| {
+            self.abort();
+            return err;
+        };
+        self.file.close(runtime.io());
+        renameFile(self.tmp_path, self.path) catch |err| {
+            deleteFileIfExists(self.tmp_path) catch {};
+            return err;
+        };
+    }
+
+    /// Drops what was written; `path` keeps its old contents.
+    pub fn abort(self: *AtomicFile) void {
+        self.file.close(runtime.io());
+        deleteFileIfExists(self.tmp_path) catch {};
+    }
+};
+
+/// Moves `path`'s mtime to now, leaving its contents alone.
+pub fn touch(path: []const u8) !void {
+    const file = try std.Io.Dir.cwd().openFile(runtime.io(), path, .{ .mode = .write_only });
+    defer file.close(runtime.io());
+    try file.setTimestampsNow(runtime.io());
+}
+
 pub fn deleteFileIfExists(path: []const u8) !void {
     std.Io.Dir.cwd().deleteFile(runtime.io(), path) catch |err| {
         if (err == error.FileNotFound) return;
@@ -45,6 +126,93 @@ pub fn deleteFileIfExists(path: []const u8) !void {
     };
 }
 
+pub fn renameFile(old_path: []const u8, new_path: []const u8) !void {
+    const cwd = std.Io.Dir.cwd();
+    try std.Io.Dir.rename(cwd, old_path, cwd, new_path, runtime.io());
+}
+
+pub const FileEntry = struct {
+    path: []const u8,
+    mtime_ns: i128,
+    size: u64,
+};
+
+/// Every regular file below `root` with its stat data; a missing root is empty.
+pub fn walkFiles(allocator: std.mem.Allocator, root: []const u8) ![]FileEntry {
+    var dir = std.Io.Dir.cwd().openDir(runtime.io(), root, .{ .iterate = true }) catch |err| switch (err) {
+        error.FileNotFound => return &.{},
+        else => return err,
+    };
+    defer dir.close(runtime.io());
+    var walker = try dir.walk(allocator);
+    defer walker.deinit();
+
+    var files: std.ArrayList(FileEntry) = .empty;
+    errdefer files.deinit(allocator);
+    while (try walker.next(runtime.io())) |entry| {
+        if (entry.kind != .file) continue;
+        const stat = dir.statFile(runtime.io(), entry.path, .{}) catch continue;
+        try files.append(allocator, .{
+            .path = try std.fs.path.join(allocator, &.{ root, entry.path }),
+            .mtime_ns = stat.mtime.nanoseconds,
+            .size = stat.size,
+        });
+    }
+    return try files.toOwnedSlice(allocator);
+}
+
+pub const TreeEntry = struct {
+    /// Relative to the walked root.
+    path: []const u8,
+    kind: std.Io.File.Kind,
+};
+
+/// Every directory, regular file and symbolic link below `root`, parents
+/// before their contents; links are listed, not followed. A missing root
+/// is empty.
+pub fn walkTree(allocator: std.mem.Allocator, root: []const u8) ![]TreeEntry {
+    var dir = std.Io.Dir.cwd().openDir(runtime.io(), root, .{ .iterate = true }) catch |err| switch (err) {
+        error.FileNotFound => return &.{},
+        else => return err,
+    };
+    defer dir.close(runtime.io());
+    var walker = try dir.walk(allocator);
+    defer walker.deinit();
+
+    var entries: std.ArrayList(TreeEntry) = .empty;
+    errdefer entries.deinit(allocator);
+    while (try walker.next(runtime.io())) |entry| {
+        switch (entry.kind) {
+            .directory, .file, .sym_link => try entries.append(allocator, .{
+                .path = try allocator.dupe(u8, entry.path),
+                .kind = entry.kind,
+            }),
+            else => {},
+        }
+    }
+    return try entries.toOwnedSlice(allocator);
+}
+
+/// Where the symbolic link `path` points, as stored in the link.
+pub fn readLinkAlloc(allocator: std.mem.Allocator, path: []const u8) ![]u8 {
+    var buffer: [std.fs.max_path_bytes]u8 = undefined;
+    const len = try std.Io.Dir.cwd().readLink(runtime.io(), path, &buffer);
+    return allocator.dupe(u8, buffer[0..len]);
+}
+
+pub fn symLink(target: []const u8, path: []const u8) !void {
+    try std.Io.Dir.cwd().symLink(runtime.io(), target, path, .{});
+}
+
+/// Takes the write permissions off the regular file `path`.
+pub fn makeReadOnly(path: []const u8) !void {
+    const file = try std.Io.Dir.cwd().openFile(runtime.io(), path, .{});
+    defer file.close(runtime.io());
+    var permissions = (try file.stat(runtime.io())).permissions;
+    permissions.setReadOnly(true);
+    try file.setPermissions(runtime.io(), permissions);
+}
+
 pub fn copyFile(
     allocator: std.mem.Allocator,
     source_path: []const u8,
@@ -62,6 +230,19 @@ pub fn copyFile(
     try std.Io.Dir.copyFileAbsolute(source_abs, destination_abs, runtime.io(), .{});
 }
 
+/// Hard-links `source_path` as `destination_path`, copying instead where
+/// links aren't possible, e.g. across file systems.
+pub fn linkOrCopyFile(
+    allocator: std.mem.Allocator,
+    source_path: []const u8,
+    destination_path: []const u8,
+) !void {
+    const cwd = std.Io.Dir.cwd();
+    std.Io.Dir.hardLink(cwd, source_path, cwd, destination_path, runtime.io(), .{}) catch {
+        return copyFile(allocator, source_path, destination_path);
+    };
+}
+
 pub fn currentPathAlloc(allocator: std.mem.Allocator) ![]u8 {
     return std.process.currentPathAlloc(runtime.io(), allocator);
 }
@@ -0,0 +1,107 @@
+const std = @import("std");
+
+/// Backing allocator for every arena ovo runs on: the page allocator, with
+/// the bytes it has handed out tracked so `--stats` can report the peak.
+/// Arenas ask it for large blocks only, so counting costs next to nothing.
+pub const page_allocator: std.mem.Allocator = .{
+    .ptr = undefined,
+    .vtable = &page_vtable,
+};
+
+var pages_live: std.atomic.Value(usize) = .init(0);
+var pages_peak: std.atomic.Value(usize) = .init(0);
+
+/// Most bytes held from the page allocator at once, across all threads.
+pub fn peakPageBytes() usize {
+    return pages_peak.load(.monotonic);
+}
+
+fn grow(len: usize) void {
+    const live = pages_live.fetchAdd(len, .monotonic) + len;
+    _ = pages_peak.fetchMax(live, .monotonic);
+}
+
+fn shrink(len: usize) void {
+    _ = pages_live.fetchSub(len, .monotonic);
+}
+
+const page_vtable: std.mem.Allocator.VTable = .{
+    .alloc = pageAlloc,
+    .resize = pageResize,
+    .remap = pageRemap,
+    .free = pageFree,
+};
+
+fn pageAlloc(_: *anyopaque, len: usize, alignment: std.mem.Alignment, ret_addr: usize) ?[*]u8 {
+    const ptr = std.heap.page_allocator.rawAlloc(len, alignment, ret_addr) orelse return null;
+    grow(len);
+    return ptr;
+}
+
+fn pageResize(_: *anyopaque, memory: []u8, alignment: std.mem.Alignment, new_len: usize, ret_addr: usize) bool {
+    if (!std.heap.page_allocator.rawResize(memory, alignment, new_len, ret_addr)) return false;
+    resized(memory.len, new_len);
+    return true;
+}
+
+fn pageRemap(_: *anyopaque, memory: []u8, alignment: std.mem.Alignment, new_len: usize, ret_addr: usize) ?[*]u8 {
+    const ptr = std.heap.page_allocator.rawRemap(memory, alignment, new_len, ret_addr) orelse return null;
+    resized(memory.len, new_len);
+    return ptr;
+}
+
+fn pageFree(_: *anyopaque, memory: []u8, alignment: std.mem.Alignment, ret_addr: usize) void {
+    std.heap.page_allocator.rawFree(memory, alignment, ret_addr);
+    shrink(memory.len);
+}
+
+fn resized(old_len: usize, new_len: usize) void {
+    if (new_len > old_len) grow(new_len - old_len) else shrink(old_len - new_len);
+}
+
+/// Counts the allocations made through `child`, for `--stats`. Not
+/// thread-safe, like the arena it usually wraps.
+pub const Counting = struct {
+    child: std.mem.Allocator,
+    allocations: usize = 0,
+    /// Bytes requested, including growth by resizing.
+    requested_bytes: usize = 0,
+
+    pub fn allocator(self: *Counting) std.mem.Allocator {
+        return .{ .ptr = self, .vtable = &counting_vtable };
+    }
+
+    const counting_vtable: std.mem.Allocator.VTable = .{
+        .alloc = alloc,
+        .resize = resize,
+        .remap = remap,
+        .free = free,
+    };
+
+    fn alloc(ctx: *anyopaque, len: usize, alignment: std.mem.Alignment, ret_addr: usize) ?[*]u8 {
+        const self: *Counting = @ptrCast(@alignCast(ctx));
+        const ptr = self.child.rawAlloc(len, alignment, ret_addr) orelse return null;
+        self.allocations += 1;
+        self.requested_bytes += len;
+        return ptr;
+    }
+
+    fn resize(ctx: *anyopaque, memory: []u8, alignment: std.mem.Alignment, new_len: usize, ret_addr: usize) bool {
+        const self: *Counting = @ptrCast(@alignCast(ctx));
+        if (!self.child.rawResize(memory, alignment, new_len, ret_addr)) return false;
+        if (new_len > memory.len) self.requested_bytes += new_len - memory.len;
+        return true;
+    }
+
+    fn remap(ctx: *anyopaque, memory: []u8, alignment: std.mem.Alignment, new_len: usize, ret_addr: usize) ?[*]u8 {
+        const self: *Counting = @ptrCast(@alignCast(ctx));
+        const ptr = self.child.rawRemap(memory, alignment, new_len, ret_addr) orelse return null;
+        if (new_len > memory.len) self.requested_bytes += new_len - memory.len;
+        return ptr;
+    }
+
+    fn free(ctx: *anyopaque, memory: []u8, alignment: std.mem.Alignment, ret_addr: usize) void {
+        const self: *Counting = @ptrCast(@alignCast(ctx));
+        self.child.rawFree(memory, alignment, ret_addr);
+    }
+};
@@ -2,3 +2,4 @@ pub const project = @import("project.zig");
 pub const fs = @import("fs.zig");
 pub const exec = @import("exec.zig");
 pub const runtime = @import("runtime.zig");
+pub const memory = @import("memory.zig");
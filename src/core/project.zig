@@ -7,6 +7,21 @@ pub const TargetType = enum {
     test_target,
 };
 
+/// Link-time optimization: `thin` links in parallel and caches per module,
+/// `full` optimizes the program as one unit.
+pub const Lto = enum {
+    thin,
+    full,
+};
+
+/// Linker the compiler driver runs; `default` keeps the driver's own.
+pub const Linker = enum {
+    default,
+    mold,
+    lld,
+    gold,
+};
+
 pub const CppStandard = enum {
     c89,
     c99,
@@ -25,11 +40,51 @@ pub const Target = struct {
     sources: []const []const u8 = &.{},
     include_dirs: []const []const u8 = &.{},
     link_libraries: []const []const u8 = &.{},
+    /// Header compiled once per target and force-included into every source.
+    pch: ?[]const u8 = null,
+    /// Compile sources in generated batches (`.unity_batch` sets the size).
+    unity: bool = false,
+    unity_batch: ?u32 = null,
+    /// Sources (paths or globs) kept out of unity batches.
+    unity_exclude: []const []const u8 = &.{},
+    /// Link-time optimization in optimized builds.
+    lto: ?Lto = null,
+    /// Arguments `ovo build --pgo=train` runs the instrumented executable with.
+    pgo_train: []const []const u8 = &.{},
 };
 
 pub const Dependency = struct {
     name: []const u8,
     version: []const u8 = "latest",
+    /// Archive `ovo fetch` downloads and unpacks with `tar`.
+    url: ?[]const u8 = null,
+    /// Lowercase hex sha256 of the archive; a download that differs is rejected.
+    hash: ?[]const u8 = null,
+
+    /// Whether `build.zon` needs the struct form rather than `.name = "version"`.
+    pub fn hasSource(self: Dependency) bool {
+        return self.url != null or self.hash != null;
+    }
+};
+
+pub fn isSha256Hex(text: []const u8) bool {
+    if (text.len != 64) return false;
+    for (text) |c| {
+        if (!std.ascii.isDigit(c) and !(c >= 'a' and c <= 'f')) return false;
+    }
+    return true;
+}
+
+pub const RemoteCacheMode = enum {
+    read_only,
+    read_write,
+};
+
+/// Shared object cache tier behind the local one. `url` is `http(s)://...`
+/// or `s3://bucket/prefix`.
+pub const RemoteCache = struct {
+    url: []const u8,
+    mode: RemoteCacheMode = .read_only,
 };
 
 pub const Defaults = struct {
@@ -37,6 +92,9 @@ pub const Defaults = struct {
     optimize: []const u8 = "Debug",
     backend: []const u8 = "zigcc",
     output_dir: []const u8 = ".ovo/build",
+    remote_cache: ?RemoteCache = null,
+    /// Null picks the fastest linker installed.
+    linker: ?Linker = null,
 };
 
 pub const Project = struct {
@@ -67,6 +125,36 @@ pub fn targetTypeLabel(kind: TargetType) []const u8 {
     };
 }
 
+pub fn parseLto(value: []const u8) ?Lto {
+    if (std.mem.eql(u8, value, "thin")) return .thin;
+    if (std.mem.eql(u8, value, "full")) return .full;
+    return null;
+}
+
+pub fn ltoLabel(mode: Lto) []const u8 {
+    return switch (mode) {
+        .thin => "thin",
+        .full => "full",
+    };
+}
+
+pub fn parseLinker(value: []const u8) ?Linker {
+    if (std.mem.eql(u8, value, "default")) return .default;
+    if (std.mem.eql(u8, value, "mold")) return .mold;
+    if (std.mem.eql(u8, value, "lld")) return .lld;
+    if (std.mem.eql(u8, value, "gold")) return .gold;
+    return null;
+}
+
+pub fn linkerLabel(linker: Linker) []const u8 {
+    return switch (linker) {
+        .default => "default",
+        .mold => "mold",
+        .lld => "lld",
+        .gold => "gold",
+    };
+}
+
 pub fn parseCppStandard(value: []const u8) ?CppStandard {
     if (std.mem.eql(u8, value, "c89")) return .c89;
     if (std.mem.eql(u8, value, "c99")) return .c99;
@@ -80,6 +168,26 @@ pub fn parseCppStandard(value: []const u8) ?CppStandard {
     return null;
 }
 
+pub fn parseRemoteCacheMode(value: []const u8) ?RemoteCacheMode {
+    if (std.mem.eql(u8, value, "read_only")) return .read_only;
+    if (std.mem.eql(u8, value, "read_write")) return .read_write;
+    return null;
+}
+
+pub fn remoteCacheModeLabel(mode: RemoteCacheMode) []const u8 {
+    return switch (mode) {
+        .read_only => "read_only",
+        .read_write => "read_write",
+    };
+}
+
+pub fn isCStandard(value: CppStandard) bool {
+    return switch (value) {
+        .c89, .c99, .c11, .c17 => true,
+        else => false,
+    };
+}
+
 pub fn cppStandardLabel(value: CppStandard) []const u8 {
     return switch (value) {
         .c89 => "c89",
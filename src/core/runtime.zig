@@ -1,6 +1,7 @@
 const std = @import("std");
 
 var global_io: ?std.Io = null;
+var global_environ: ?*const std.process.Environ.Map = null;
 
 pub fn setIo(io_handle: std.Io) void {
     global_io = io_handle;
@@ -9,3 +10,55 @@ pub fn setIo(io_handle: std.Io) void {
 pub fn io() std.Io {
     return global_io orelse @panic("runtime io has not been initialized");
 }
+
+pub fn setEnviron(environ_map: *const std.process.Environ.Map) void {
+    global_environ = environ_map;
+}
+
+/// Returns null for unset variables and when no environment was installed
+/// (e.g. in unit tests), so callers always have a default path.
+pub fn getEnv(name: []const u8) ?[]const u8 {
+    const environ_map = global_environ orelse return null;
+    return environ_map.get(name);
+}
+
+/// Monotonic nanoseconds; only meaningful as a difference between two calls.
+pub fn nowNs() i128 {
+    return std.Io.Timestamp.now(io(), .awake).nanoseconds;
+}
+
+/// Wall-clock nanoseconds since the epoch, comparable with file mtimes.
+pub fn wallClockNs() i128 {
+    return std.Io.Timestamp.now(io(), .real).nanoseconds;
+}
+
+pub fn sleepMs(ms: u32) !void {
+    try io().sleep(.fromMilliseconds(ms), .awake);
+}
+
+/// Takes what would be printed to stderr, e.g. the client connection while
+/// `ovo daemon` serves a request.
+pub const Sink = struct {
+    context: *anyopaque,
+    writeFn: *const fn (context: *anyopaque, bytes: []const u8) void,
+};
+
+var output_sink: ?Sink = null;
+var sink_mutex: std.Thread.Mutex = .{};
+
+pub fn setOutputSink(sink: ?Sink) void {
+    sink_mutex.lock();
+    defer sink_mutex.unlock();
+    output_sink = sink;
+}
+
+/// Prints to stderr, or to the output sink while one is set. Like
+/// `std.debug.print`, one call's output is never interleaved with another's.
+pub fn printErr(comptime fmt: []const u8, args: anytype) void {
+    sink_mutex.lock();
+    defer sink_mutex.unlock();
+    const sink = output_sink orelse return std.debug.print(fmt, args);
+    const bytes = std.fmt.allocPrint(std.heap.smp_allocator, fmt, args) catch return;
+    defer std.heap.smp_allocator.free(bytes);
+    sink.writeFn(sink.context, bytes);
+}
@@ -4,11 +4,10 @@ const core = @import("core/mod.zig");
 
 pub fn main(init: std.process.Init) !void {
     core.runtime.setIo(init.io);
+    core.runtime.setEnviron(init.environ_map);
 
-    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
-    defer _ = gpa.deinit();
-
-    const exit_code = try cli.run(gpa.allocator(), init.minimal.args);
+    // Commands run on an arena over this and free nothing individually.
+    const exit_code = try cli.run(core.memory.page_allocator, init.minimal.args);
     if (exit_code != 0) {
         std.process.exit(exit_code);
     }
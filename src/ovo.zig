@@ -3,12 +3,42 @@ pub const cli_args = @import("cli/args.zig");
 pub const cli_dispatch = @import("cli/command_dispatch.zig");
 pub const cli_context = @import("cli/context.zig");
 pub const cli_registry = @import("cli/command_registry.zig");
+pub const cli_daemon = @import("cli/daemon.zig");
 
+pub const zon_ast = @import("zon/ast.zig");
 pub const zon_parser = @import("zon/parser.zig");
+pub const zon_snapshot = @import("zon/snapshot.zig");
 pub const zon_writer = @import("zon/writer.zig");
 pub const neural = @import("neural/mod.zig");
 pub const compiler = @import("compiler/mod.zig");
 pub const build_orchestrator = @import("build/orchestrator.zig");
+pub const build_job_pool = @import("build/job_pool.zig");
+pub const build_manifest = @import("build/manifest.zig");
+pub const build_depfile = @import("build/depfile.zig");
+pub const build_dep_db = @import("build/dep_db.zig");
+pub const build_object_cache = @import("build/object_cache.zig");
+pub const build_remote_cache = @import("build/remote_cache.zig");
+pub const build_target_graph = @import("build/target_graph.zig");
+pub const build_glob = @import("build/glob.zig");
+pub const build_watch = @import("build/watch.zig");
+pub const build_trace = @import("build/trace.zig");
+pub const build_pch = @import("build/pch.zig");
+pub const build_unity = @import("build/unity.zig");
+pub const build_modules = @import("build/modules.zig");
+pub const build_test_runner = @import("build/test_runner.zig");
+pub const build_lto = @import("build/lto.zig");
+pub const build_pgo = @import("build/pgo.zig");
+pub const build_linker = @import("build/linker.zig");
+pub const build_code_tools = @import("build/code_tools.zig");
+pub const build_distributed = @import("build/distributed.zig");
+pub const build_schedule = @import("build/schedule.zig");
+pub const build_install = @import("build/install.zig");
 pub const core_project = @import("core/project.zig");
+pub const core_memory = @import("core/memory.zig");
+pub const core_fs = @import("core/fs.zig");
+pub const core_exec = @import("core/exec.zig");
+pub const core_runtime = @import("core/runtime.zig");
 pub const package_manager = @import("package/manager.zig");
+pub const package_fetch = @import("package/fetch.zig");
+pub const package_lockfile = @import("package/lockfile.zig");
 pub const translate = @import("translate/mod.zig");
@@ -0,0 +1,334 @@
+const std = @import("std");
+const core = @import("../core/mod.zig");
+const project_mod = @import("../core/project.zig");
+const job_pool = @import("../build/job_pool.zig");
+const object_cache = @import("../build/object_cache.zig");
+
+const Sha256 = std.crypto.hash.sha2.Sha256;
+
+/// Downloads in flight at once unless `ovo fetch -j N` says otherwise.
+pub const default_connections = 8;
+
+/// Where a project's dependencies are unpacked, one directory each.
+pub const cache_dir = ".ovo/cache";
+
+/// Written into each unpacked dependency: the URL and archive digest it
+/// came from, so a warm fetch can tell it is current without the network.
+const marker_name = ".ovo-fetch";
+
+/// The content-addressed store shared by every project on the machine:
+/// `<root>/<sha256>/` holds one unpacked archive, and project caches are
+/// hard links into it.
+pub fn storeRoot(allocator: std.mem.Allocator) ![]const u8 {
+    const root = try object_cache.resolveRoot(allocator) orelse return ".ovo/store";
+    return std.fs.path.join(allocator, &.{ root, "store" });
+}
+
+pub const Outcome = enum {
+    /// Already unpacked in the project from the same URL and digest.
+    up_to_date,
+    /// Linked from the store without a download.
+    linked,
+    downloaded,
+    /// No `.url` to fetch from.
+    skipped,
+    failed,
+};
+
+pub const Item = struct {
+    dep: project_mod.Dependency,
+    /// `.ovo/cache/<name>-<version>`.
+    dir: []const u8,
+    /// The archive's sha256: the pinned `.hash`, or what was downloaded.
+    digest: ?[]const u8 = null,
+    /// Partial download, kept across runs so a failed transfer resumes.
+    archive: []const u8 = "",
+    outcome: Outcome = .skipped,
+    /// Why it failed, or a warning such as a missing `.hash`.
+    message: []const u8 = "",
+};
+
+pub const Options = struct {
+    connections: usize = default_connections,
+    store: []const u8,
+};
+
+/// Brings `.ovo/cache` in line with `deps`. Dependencies already unpacked
+/// from the same URL and digest are left alone and ones in the store are
+/// linked, neither touching the network. The rest are downloaded up to
+/// `options.connections` at a time, verified, unpacked into the store in
+/// parallel and linked. One failure doesn't stop the others.
+pub fn fetchAll(allocator: std.mem.Allocator, deps: []const project_mod.Dependency, options: Options) ![]Item {
+    const items = try allocator.alloc(Item, deps.len);
+    var downloads: std.ArrayList(usize) = .empty;
+    for (deps, items, 0..) |dep, *item, i| {
+        item.* = .{
+            .dep = dep,
+            .dir = try std.fmt.allocPrint(allocator, "{s}/{s}-{s}", .{ cache_dir, dep.name, dep.version }),
+            .digest = dep.hash,
+        };
+        const url = dep.url orelse {
+            item.message = "no .url to fetch from";
+            continue;
+        };
+        if (try currentDigest(allocator, item.dir, url, dep.hash, options.store)) |digest| {
+            item.digest = digest;
+            item.outcome = .up_to_date;
+            continue;
+        }
+        if (dep.hash) |hash| {
+            if (core.fs.fileExists(try storePath(allocator, options.store, hash))) {
+                item.outcome = .linked;
+                continue;
+            }
+        }
+        item.archive = try archivePath(allocator, options.store, dep);
+        try downloads.append(allocator, i);
+    }
+
+    if (downloads.items.len > 0) {
+        try core.fs.ensureDir(try std.fs.path.join(allocator, &.{ options.store, "downloads" }));
+        try download(allocator, items, downloads.items, options.connections);
+        try verify(allocator, items, downloads.items);
+        try unpack(allocator, items, downloads.items, options);
+    }
+
+    for (items) |*item| {
+        if (item.outcome != .linked and item.outcome != .downloaded) continue;
+        install(allocator, item.*, options.store) catch |err| {
+            item.outcome = .failed;
+            item.message = try std.fmt.allocPrint(allocator, "unable to link from the store: {s}", .{@errorName(err)});
+        };
+    }
+    return items;
+}
+
+/// The digest `dir` was unpacked from when it came from `url` and, if
+/// pinned, matches `hash`, and its store entry still exists.
+fn currentDigest(allocator: std.mem.Allocator, dir: []const u8, url: []const u8, hash: ?[]const u8, store: []const u8) !?[]const u8 {
+    const marker_path = try std.fs.path.join(allocator, &.{ dir, marker_name });
+    const bytes = core.fs.readFileAlloc(allocator, marker_path) catch return null;
+    const marker = parseMarker(bytes) orelse return null;
+    if (!std.mem.eql(u8, marker.url, url)) return null;
+    if (hash) |pinned| {
+        if (!std.mem.eql(u8, marker.digest, pinned)) return null;
+    }
+    if (!core.fs.fileExists(try storePath(allocator, store, marker.digest))) return null;
+    return marker.digest;
+}
+
+/// Makes the next fetch of `dep` resolve it again instead of trusting what
+/// is unpacked: an unpinned URL is downloaded anew.
+pub fn forget(allocator: std.mem.Allocator, dep: project_mod.Dependency) !void {
+    const dir = try std.fmt.allocPrint(allocator, "{s}/{s}-{s}", .{ cache_dir, dep.name, dep.version });
+    try core.fs.deleteFileIfExists(try std.fs.path.join(allocator, &.{ dir, marker_name }));
+}
+
+pub const Marker = struct {
+    url: []const u8,
+    digest: []const u8,
+};
+
+pub fn renderMarker(allocator: std.mem.Allocator, marker: Marker) ![]u8 {
+    return std.fmt.allocPrint(allocator, "{s}\n{s}\n", .{ marker.url, marker.digest });
+}
+
+pub fn parseMarker(bytes: []const u8) ?Marker {
+    var lines = std.mem.splitScalar(u8, bytes, '\n');
+    const url = lines.next() orelse return null;
+    const digest = lines.next() orelse return null;
+    if (url.len == 0 or !project_mod.isSha256Hex(digest)) return null;
+    return .{ .url = url, .digest = digest };
+}
+
+pub fn storePath(allocator: std.mem.Allocator, store: []const u8, digest: []const u8) ![]u8 {
+    return std.fs.path.join(allocator, &.{ store, digest });
+}
+
+/// Partial download of `dep`, named by its pinned digest or, unpinned, by
+/// its URL, so a rerun resumes it.
+pub fn archivePath(allocator: std.mem.Allocator, store: []const u8, dep: project_mod.Dependency) ![]u8 {
+    if (dep.hash) |hash| return std.fmt.allocPrint(allocator, "{s}/downloads/{s}.part", .{ store, hash });
+    return std.fmt.allocPrint(allocator, "{s}/downloads/url-{x:0>16}.part", .{ store, std.hash.Wyhash.hash(0, dep.url.?) });
+}
+
+/// The curl command for one download; `--continue-at -` resumes a partial
+/// archive from where the last run stopped.
+pub fn downloadArgv(allocator: std.mem.Allocator, url: []const u8, archive: []const u8) ![]const []const u8 {
+    const flags = [_][]const u8{ "curl", "--fail", "--silent", "--show-error", "--location", "--retry", "3", "--connect-timeout", "10" };
+    return std.mem.concat(allocator, []const u8, &.{ &flags, &.{ "--continue-at", "-", "--output", archive, url } });
+}
+
+fn download(allocator: std.mem.Allocator, items: []Item, indices: []const usize, connections: usize) !void {
+    var jobs: std.ArrayList(job_pool.Job) = .empty;
+    var owners: std.ArrayList(usize) = .empty;
+    for (indices) |i| {
+        const item = &items[i];
+        // A complete archive left behind by a failed unpack needs no transfer.
+        if (item.dep.hash) |hash| {
+            if (core.fs.fileExists(item.archive)) {
+                const digest = hashFile(item.archive) catch null;
+                if (digest != null and std.mem.eql(u8, &digest.?, hash)) continue;
+            }
+        }
+        try jobs.append(allocator, .{
+            .label = item.dep.name,
+            .argv = try downloadArgv(allocator, item.dep.url.?, item.archive),
+            .may_fail = true,
+        });
+        try owners.append(allocator, i);
+    }
+    _ = try job_pool.runAll(allocator, jobs.items, connections);
+    defer job_pool.freeOutputs(jobs.items);
+    for (jobs.items, owners.items) |job, i| {
+        if (job.exit_code == 0) continue;
+        items[i].outcome = .failed;
+        // curl's own message has already been printed with the job's output.
+        items[i].message = try std.fmt.allocPrint(allocator, "download failed (curl exited with {d})", .{job.exit_code});
+    }
+}
+
+/// Hashes the downloaded archives on parallel threads, reading each in
+/// chunks so no archive is held in memory.
+fn verify(allocator: std.mem.Allocator, items: []Item, indices: []const usize) !void {
+    var state = VerifyState{ .items = items, .indices = indices, .digests = try allocator.alloc(?[64]u8, indices.len) };
+    const thread_count = @min(indices.len, job_pool.defaultJobCount());
+    const threads = try allocator.alloc(std.Thread, thread_count -| 1);
+    var spawned: usize = 0;
+    for (threads) |*thread| {
+        thread.* = std.Thread.spawn(.{}, verifyWorker, .{&state}) catch break;
+        spawned += 1;
+    }
+    verifyWorker(&state);
+    for (threads[0..spawned]) |thread| thread.join();
+
+    for (indices, state.digests) |i, digest| {
+        const item = &items[i];
+        if (item.outcome == .failed) continue;
+        const actual = digest orelse {
+            item.outcome = .failed;
+            item.message = "unable to read the downloaded archive";
+            continue;
+        };
+        if (item.dep.hash) |expected| {
+            if (!std.mem.eql(u8, &actual, expected)) {
+                // A corrupt partial download must not be resumed.
+                core.fs.deleteFileIfExists(item.archive) catch {};
+                item.outcome = .failed;
+                item.message = try std.fmt.allocPrint(allocator, "sha256 mismatch: expected {s}, got {s}", .{ expected, &actual });
+                continue;
+            }
+        } else {
+            item.message = try std.fmt.allocPrint(allocator, "not pinned; add .hash = \"{s}\"", .{&actual});
+        }
+        item.digest = try allocator.dupe(u8, &actual);
+    }
+}
+
+const VerifyState = struct {
+    items: []const Item,
+    indices: []const usize,
+    digests: []?[64]u8,
+    next: std.atomic.Value(usize) = .init(0),
+};
+
+fn verifyWorker(state: *VerifyState) void {
+    while (true) {
+        const n = state.next.fetchAdd(1, .monotonic);
+        if (n >= state.indices.len) return;
+        const item = state.items[state.indices[n]];
+        state.digests[n] = if (item.outcome == .failed) null else hashFile(item.archive) catch null;
+    }
+}
+
+pub fn hashFile(path: []const u8) ![64]u8 {
+    const io = core.runtime.io();
+    const file = try std.Io.Dir.cwd().openFile(io, path, .{});
+    defer file.close(io);
+    var buffer: [64 * 1024]u8 = undefined;
+    var reader = file.reader(io, &buffer);
+    var hasher = Sha256.init(.{});
+    while (true) {
+        const chunk = reader.interface.peekGreedy(1) catch |err| switch (err) {
+            error.EndOfStream => break,
+            else => return err,
+        };
+        hasher.update(chunk);
+        reader.interface.toss(chunk.len);
+    }
+    return std.fmt.bytesToHex(hasher.finalResult(), .lower);
+}
+
+/// Unpacks verified archives into staging directories in parallel and
+/// moves each into the store once complete, so a store entry is never
+/// partial. Archives are deleted once unpacked.
+fn unpack(allocator: std.mem.Allocator, items: []Item, indices: []const usize, options: Options) !void {
+    var jobs: std.ArrayList(job_pool.Job) = .empty;
+    var owners: std.ArrayList(usize) = .empty;
+    var staging: std.ArrayList([]const u8) = .empty;
+    for (indices) |i| {
+        const item = &items[i];
+        if (item.outcome == .failed) continue;
+        const digest = item.digest.?;
+        if (core.fs.fileExists(try storePath(allocator, options.store, digest))) {
+            // Another URL or project already brought the same archive.
+            item.outcome = .downloaded;
+            core.fs.deleteFileIfExists(item.archive) catch {};
+            continue;
+        }
+        const dir = try std.fmt.allocPrint(allocator, "{s}/tmp/{s}", .{ options.store, digest });
+        try core.fs.removeTreeIfExists(dir);
+        try core.fs.ensureDir(dir);
+        try jobs.append(allocator, .{
+            .label = item.dep.name,
+            .argv = try allocator.dupe([]const u8, &.{ "tar", "-xf", item.archive, "-C", dir }),
+            .may_fail = true,
+        });
+        try owners.append(allocator, i);
+        try staging.append(allocator, dir);
+    }
+    _ = try job_pool.runAll(allocator, jobs.items, job_pool.defaultJobCount());
+    defer job_pool.freeOutputs(jobs.items);
+    for (jobs.items, owners.items, staging.items) |job, i, dir| {
+        const item = &items[i];
+        if (job.exit_code != 0) {
+            core.fs.removeTreeIfExists(dir) catch {};
+            item.outcome = .failed;
+            item.message = try std.fmt.allocPrint(allocator, "unable to unpack (tar exited with {d})", .{job.exit_code});
+            continue;
+        }
+        // Projects hard-link these files; none of them may edit the store.
+        for (try core.fs.walkFiles(allocator, dir)) |file| try core.fs.makeReadOnly(file.path);
+        const entry = try storePath(allocator, options.store, item.digest.?);
+        core.fs.renameFile(dir, entry) catch |err| {
+            // Lost a race with another fetch of the same archive.
+            core.fs.removeTreeIfExists(dir) catch {};
+            if (!core.fs.fileExists(entry)) return err;
+        };
+        core.fs.deleteFileIfExists(item.archive) catch {};
+        item.outcome = .downloaded;
+    }
+}
+
+/// Replaces the project's copy of `item` with the store's tree: hard links
+/// to its files, which are read-only, and its directories and symbolic
+/// links recreated as they are. Where links can't be made, e.g. on Windows
+/// without the privilege, a link's target is copied.
+fn install(allocator: std.mem.Allocator, item: Item, store: []const u8) !void {
+    const entry = try storePath(allocator, store, item.digest.?);
+    try core.fs.removeTreeIfExists(item.dir);
+    try core.fs.ensureDir(item.dir);
+    for (try core.fs.walkTree(allocator, entry)) |node| {
+        const source = try std.fs.path.join(allocator, &.{ entry, node.path });
+        const destination = try std.fs.path.join(allocator, &.{ item.dir, node.path });
+        switch (node.kind) {
+            .directory => try core.fs.ensureDir(destination),
+            .sym_link => core.fs.symLink(try core.fs.readLinkAlloc(allocator, source), destination) catch {
+                try core.fs.copyFile(allocator, source, destination);
+            },
+            else => try core.fs.linkOrCopyFile(allocator, source, destination),
+        }
+    }
+    const marker = try renderMarker(allocator, .{ .url = item.dep.url.?, .digest = item.digest.? });
+    try core.fs.writeFile(try std.fs.path.join(allocator, &.{ item.dir, marker_name }), marker);
+}
@@ -0,0 +1,210 @@
+const std = @import("std");
+const project_mod = @import("../core/project.zig");
+const zon = @import("../zon/mod.zig");
+
+const Sha256 = std.crypto.hash.sha2.Sha256;
+const Dependency = project_mod.Dependency;
+
+pub const path = "ovo.lock.zon";
+
+/// One dependency as it was resolved.
+pub const Entry = struct {
+    name: []const u8,
+    version: []const u8,
+    url: ?[]const u8 = null,
+    /// sha256 of the archive the dependency resolved to; null until fetched.
+    hash: ?[]const u8 = null,
+    /// Digest of the name, version, source and content: what a build of the
+    /// dependency depends on. It changes exactly when the unpacked tree may.
+    fingerprint: []const u8 = "",
+
+    /// Whether `dep` still declares what this entry was resolved from. An
+    /// unpinned declaration accepts whatever digest was locked.
+    pub fn resolves(self: Entry, dep: Dependency) bool {
+        if (!std.mem.eql(u8, self.name, dep.name) or !std.mem.eql(u8, self.version, dep.version)) return false;
+        if (!optionalEql(self.url, dep.url)) return false;
+        return dep.hash == null or optionalEql(self.hash, dep.hash);
+    }
+};
+
+pub const Lock = struct {
+    project: []const u8 = "",
+    version: []const u8 = "",
+    /// `manifestDigest` of the `build.zon` dependencies this was resolved from.
+    manifest: []const u8 = "",
+    /// In declaration order.
+    entries: []const Entry = &.{},
+
+    /// Whether `deps` is exactly what was resolved, so every entry can be
+    /// trusted as-is, in order.
+    pub fn isCurrent(self: Lock, deps: []const Dependency) bool {
+        if (self.entries.len != deps.len) return false;
+        return std.mem.eql(u8, self.manifest, &manifestDigest(deps));
+    }
+
+    pub fn find(self: Lock, name: []const u8) ?Entry {
+        for (self.entries) |entry| {
+            if (std.mem.eql(u8, entry.name, name)) return entry;
+        }
+        return null;
+    }
+
+    /// The lock without the entry of `name`, or without any entries when
+    /// `name` is null, so the next fetch re-resolves just those.
+    pub fn without(self: Lock, allocator: std.mem.Allocator, name: ?[]const u8) !Lock {
+        var entries: std.ArrayList(Entry) = .empty;
+        if (name) |needle| {
+            for (self.entries) |entry| {
+                if (!std.mem.eql(u8, entry.name, needle)) try entries.append(allocator, entry);
+            }
+        }
+        return .{ .project = self.project, .version = self.version, .manifest = self.manifest, .entries = entries.items };
+    }
+};
+
+/// Digest of the dependency declarations, in order.
+pub fn manifestDigest(deps: []const Dependency) [64]u8 {
+    var hasher = Sha256.init(.{});
+    for (deps) |dep| {
+        hashField(&hasher, dep.name);
+        hashField(&hasher, dep.version);
+        hashField(&hasher, dep.url orelse "");
+        hashField(&hasher, dep.hash orelse "");
+    }
+    return std.fmt.bytesToHex(hasher.finalResult(), .lower);
+}
+
+pub fn fingerprint(entry: Entry) [64]u8 {
+    var hasher = Sha256.init(.{});
+    hashField(&hasher, entry.name);
+    hashField(&hasher, entry.version);
+    hashField(&hasher, entry.url orelse "");
+    hashField(&hasher, entry.hash orelse "");
+    return std.fmt.bytesToHex(hasher.finalResult(), .lower);
+}
+
+/// Length-prefixed, so adjacent fields can't run into each other.
+fn hashField(hasher: *Sha256, bytes: []const u8) void {
+    var len: [8]u8 = undefined;
+    std.mem.writeInt(u64, &len, bytes.len, .little);
+    hasher.update(&len);
+    hasher.update(bytes);
+}
+
+/// `deps` with each unpinned dependency pinned to the digest it was locked
+/// to, so fetch links or verifies it instead of resolving it again. A
+/// current lock is taken whole; otherwise only the entries whose
+/// declaration is unchanged count, and the rest resolve afresh.
+pub fn pin(allocator: std.mem.Allocator, deps: []const Dependency, lock: Lock) ![]Dependency {
+    const pinned = try allocator.dupe(Dependency, deps);
+    const current = lock.isCurrent(deps);
+    for (pinned, 0..) |*dep, i| {
+        if (dep.hash != null) continue;
+        const entry = if (current and std.mem.eql(u8, lock.entries[i].name, dep.name))
+            lock.entries[i]
+        else
+            lock.find(dep.name) orelse continue;
+        if (entry.resolves(dep.*)) dep.hash = entry.hash;
+    }
+    return pinned;
+}
+
+/// The lock for `deps` given the digest each resolved to (null if it
+/// hasn't been fetched).
+pub fn resolved(
+    allocator: std.mem.Allocator,
+    project: project_mod.Project,
+    deps: []const Dependency,
+    digests: []const ?[]const u8,
+) !Lock {
+    const entries = try allocator.alloc(Entry, deps.len);
+    for (entries, deps, digests) |*entry, dep, digest| {
+        entry.* = .{ .name = dep.name, .version = dep.version, .url = dep.url, .hash = digest };
+        entry.fingerprint = try allocator.dupe(u8, &fingerprint(entry.*));
+    }
+    return .{
+        .project = project.name,
+        .version = project.version,
+        .manifest = try allocator.dupe(u8, &manifestDigest(deps)),
+        .entries = entries,
+    };
+}
+
+pub fn render(allocator: std.mem.Allocator, lock: Lock) ![]u8 {
+    const zonString = zon.writer.zonString;
+    var output: std.ArrayList(u8) = .empty;
+    errdefer output.deinit(allocator);
+    try output.appendSlice(allocator, ".{\n");
+    try output.print(allocator, "    .project = {f},\n", .{zonString(lock.project)});
+    try output.print(allocator, "    .version = {f},\n", .{zonString(lock.version)});
+    try output.print(allocator, "    .manifest = {f},\n", .{zonString(lock.manifest)});
+    try output.appendSlice(allocator, "    .dependencies = .{\n");
+    for (lock.entries) |entry| {
+        try output.print(allocator, "        {f} = .{{\n", .{zon.writer.zonName(entry.name)});
+        try output.print(allocator, "            .version = {f},\n", .{zonString(entry.version)});
+        if (entry.url) |url| try output.print(allocator, "            .url = {f},\n", .{zonString(url)});
+        if (entry.hash) |hash| try output.print(allocator, "            .hash = {f},\n", .{zonString(hash)});
+        try output.print(allocator, "            .fingerprint = {f},\n", .{zonString(entry.fingerprint)});
+        try output.appendSlice(allocator, "        },\n");
+    }
+    try output.appendSlice(allocator, "    },\n");
+    try output.appendSlice(allocator, "}\n");
+    return try output.toOwnedSlice(allocator);
+}
+
+/// Reads a lockfile. Locks written before entries carried sources
+/// (`.zlib = "1.3.1"`) parse as unresolved entries. Strings may point into
+/// `bytes`.
+pub fn parse(allocator: std.mem.Allocator, bytes: []const u8) !Lock {
+    const root = try zon.ast.parse(allocator, bytes, null);
+    var lock: Lock = .{};
+    for (root.fields() orelse return error.InvalidLockfile) |field| {
+        if (std.mem.eql(u8, field.name, "project")) {
+            lock.project = try string(field.value);
+        } else if (std.mem.eql(u8, field.name, "version")) {
+            lock.version = try string(field.value);
+        } else if (std.mem.eql(u8, field.name, "manifest")) {
+            lock.manifest = try string(field.value);
+        } else if (std.mem.eql(u8, field.name, "dependencies")) {
+            const deps = field.value.fields() orelse return error.InvalidLockfile;
+            const entries = try allocator.alloc(Entry, deps.len);
+            for (deps, entries) |dep, *entry| entry.* = try parseEntry(dep);
+            lock.entries = entries;
+        }
+    }
+    return lock;
+}
+
+fn parseEntry(field: zon.ast.Field) !Entry {
+    var entry: Entry = .{ .name = field.name, .version = "" };
+    if (field.value.value == .string) {
+        entry.version = field.value.value.string;
+        return entry;
+    }
+    for (field.value.fields() orelse return error.InvalidLockfile) |item| {
+        if (std.mem.eql(u8, item.name, "version")) {
+            entry.version = try string(item.value);
+        } else if (std.mem.eql(u8, item.name, "url")) {
+            entry.url = try string(item.value);
+        } else if (std.mem.eql(u8, item.name, "hash")) {
+            const hash = try string(item.value);
+            if (!project_mod.isSha256Hex(hash)) return error.InvalidLockfile;
+            entry.hash = hash;
+        } else if (std.mem.eql(u8, item.name, "fingerprint")) {
+            entry.fingerprint = try string(item.value);
+        }
+    }
+    return entry;
+}
+
+fn string(node: zon.ast.Node) ![]const u8 {
+    return switch (node.value) {
+        .string => |value| value,
+        else => error.InvalidLockfile,
+    };
+}
+
+fn optionalEql(a: ?[]const u8, b: ?[]const u8) bool {
+    if (a == null or b == null) return a == null and b == null;
+    return std.mem.eql(u8, a.?, b.?);
+}
@@ -2,6 +2,8 @@ const std = @import("std");
 const core = @import("../core/mod.zig");
 const project_mod = @import("../core/project.zig");
 const zon = @import("../zon/mod.zig");
+const fetch_mod = @import("fetch.zig");
+const lockfile = @import("lockfile.zig");
 
 pub const PackageManager = struct {
     allocator: std.mem.Allocator,
@@ -49,71 +51,84 @@ pub const PackageManager = struct {
         try saveProject(self.allocator, project);
     }
 
-    pub fn fetch(self: *PackageManager) !void {
+    pub const Resolution = struct {
+        items: []const fetch_mod.Item,
+        /// Whether `ovo.lock.zon` changed.
+        lock_written: bool,
+    };
+
+    /// Downloads or links every dependency into `.ovo/cache`; see
+    /// `fetch.fetchAll`. Dependencies the lockfile still resolves are pinned
+    /// to their locked digest, so only new or changed declarations are
+    /// resolved again; the lock is rewritten only when that changes it.
+    /// Outcomes are also logged to `.ovo/cache/fetch.log`.
+    pub fn fetch(self: *PackageManager, connections: usize) !Resolution {
         const project = try loadProject(self.allocator);
-        try core.fs.ensureDir(".ovo/cache");
-
+        const existing: ?[]const u8 = core.fs.readFileAlloc(self.allocator, lockfile.path) catch null;
+        // A malformed lock is resolved afresh and overwritten.
+        const previous: lockfile.Lock = if (existing) |bytes| lockfile.parse(self.allocator, bytes) catch .{} else .{};
+        const deps = try lockfile.pin(self.allocator, project.dependencies, previous);
+
+        try core.fs.ensureDir(fetch_mod.cache_dir);
+        const items = try fetch_mod.fetchAll(self.allocator, deps, .{
+            .connections = connections,
+            .store = try fetch_mod.storeRoot(self.allocator),
+        });
+
+        const digests = try self.allocator.alloc(?[]const u8, items.len);
         var fetch_log: std.ArrayList(u8) = .empty;
-        for (project.dependencies) |dep| {
-            const dep_dir = try std.fmt.allocPrint(self.allocator, ".ovo/cache/{s}-{s}", .{ dep.name, dep.version });
-            try core.fs.ensureDir(dep_dir);
-            try core.fs.writeFile(
-                try std.fmt.allocPrint(self.allocator, "{s}/manifest.txt", .{dep_dir}),
-                try std.fmt.allocPrint(self.allocator, "name={s}\nversion={s}\nsource=registry\n", .{ dep.name, dep.version }),
-            );
-            try fetch_log.print(self.allocator, "fetched {s}@{s}\n", .{ dep.name, dep.version });
+        for (items, project.dependencies, digests) |*item, declared, *digest| {
+            if (item.outcome == .failed and declared.hash == null and item.dep.hash != null) {
+                item.message = try std.fmt.allocPrint(self.allocator, "{s} (locked in {s}; `ovo update {s}` re-resolves it)", .{ item.message, lockfile.path, declared.name });
+            }
+            digest.* = item.digest;
+            try fetch_log.print(self.allocator, "{s} {s}@{s}", .{ @tagName(item.outcome), item.dep.name, item.dep.version });
+            if (item.digest) |value| try fetch_log.print(self.allocator, " sha256={s}", .{value});
+            if (item.message.len > 0) try fetch_log.print(self.allocator, ": {s}", .{item.message});
+            try fetch_log.append(self.allocator, '\n');
         }
         if (project.dependencies.len == 0) {
             try fetch_log.appendSlice(self.allocator, "no dependencies declared\n");
         }
-        try core.fs.writeFile(".ovo/cache/fetch.log", fetch_log.items);
+        try core.fs.writeFile(fetch_mod.cache_dir ++ "/fetch.log", fetch_log.items);
+
+        const lock = try lockfile.resolved(self.allocator, project, project.dependencies, digests);
+        const rendered = try lockfile.render(self.allocator, lock);
+        const lock_written = existing == null or !std.mem.eql(u8, existing.?, rendered);
+        if (lock_written) try core.fs.writeFile(lockfile.path, rendered);
+        return .{ .items = items, .lock_written = lock_written };
     }
 
+    /// Resets `name` (every dependency when null) so the next fetch resolves
+    /// it again: its lock entry is dropped, and a dependency without a `.url`
+    /// goes back to "latest". A `.url` names exact contents, so its
+    /// declaration is kept.
     pub fn update(self: *PackageManager, name: ?[]const u8) !void {
         var project = try loadProject(self.allocator);
-        if (name) |needle| {
-            var changed = false;
-            var deps: std.ArrayList(project_mod.Dependency) = .empty;
-            errdefer deps.deinit(self.allocator);
-            for (project.dependencies) |dep| {
-                if (std.mem.eql(u8, dep.name, needle)) {
-                    try deps.append(self.allocator, .{
-                        .name = dep.name,
-                        .version = "latest",
-                    });
-                    changed = true;
-                } else {
+        var changed = false;
+        var deps: std.ArrayList(project_mod.Dependency) = .empty;
+        errdefer deps.deinit(self.allocator);
+        for (project.dependencies) |dep| {
+            if (name == null or std.mem.eql(u8, dep.name, name.?)) {
+                if (dep.url != null) {
+                    try fetch_mod.forget(self.allocator, dep);
                     try deps.append(self.allocator, dep);
+                } else {
+                    try deps.append(self.allocator, .{ .name = dep.name, .version = "latest" });
                 }
+                changed = true;
+            } else {
+                try deps.append(self.allocator, dep);
             }
-            if (!changed) return error.DependencyNotFound;
-            project.dependencies = try sortedUniqueDependencies(self.allocator, deps.items);
-        } else {
-            var deps: std.ArrayList(project_mod.Dependency) = .empty;
-            errdefer deps.deinit(self.allocator);
-            for (project.dependencies) |dep| {
-                try deps.append(self.allocator, .{ .name = dep.name, .version = "latest" });
-            }
-            project.dependencies = try sortedUniqueDependencies(self.allocator, deps.items);
         }
-
+        if (name != null and !changed) return error.DependencyNotFound;
+        project.dependencies = try sortedUniqueDependencies(self.allocator, deps.items);
         try saveProject(self.allocator, project);
-    }
 
-    pub fn lock(self: *PackageManager) !void {
-        const project = try loadProject(self.allocator);
-        var lock_data: std.ArrayList(u8) = .empty;
-        defer lock_data.deinit(self.allocator);
-        try lock_data.appendSlice(self.allocator, ".{\n");
-        try lock_data.print(self.allocator, "    .project = \"{s}\",\n", .{project.name});
-        try lock_data.print(self.allocator, "    .version = \"{s}\",\n", .{project.version});
-        try lock_data.appendSlice(self.allocator, "    .dependencies = .{\n");
-        for (project.dependencies) |dep| {
-            try lock_data.print(self.allocator, "        .{s} = \"{s}\",\n", .{ dep.name, dep.version });
-        }
-        try lock_data.appendSlice(self.allocator, "    },\n");
-        try lock_data.appendSlice(self.allocator, "}\n");
-        try core.fs.writeFile("ovo.lock.zon", lock_data.items);
+        const existing = core.fs.readFileAlloc(self.allocator, lockfile.path) catch return;
+        const previous = lockfile.parse(self.allocator, existing) catch return;
+        const lock = try previous.without(self.allocator, name);
+        try core.fs.writeFile(lockfile.path, try lockfile.render(self.allocator, lock));
     }
 
     pub fn dependencySummary(self: *PackageManager) ![]const u8 {
@@ -172,11 +187,11 @@ pub fn insertionSortDependencies(items: []project_mod.Dependency) void {
 }
 
 fn loadProject(allocator: std.mem.Allocator) !project_mod.Project {
-    const bytes = try core.fs.readFileAlloc(allocator, "build.zon");
-    return zon.parser.parseBuildZon(allocator, bytes);
+    return zon.snapshot.loadProject(allocator);
 }
 
 fn saveProject(allocator: std.mem.Allocator, project: project_mod.Project) !void {
     const rendered = try zon.writer.renderBuildZon(allocator, project);
     try core.fs.writeFile("build.zon", rendered);
+    zon.snapshot.storeProject(allocator, project, rendered);
 }
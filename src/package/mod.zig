@@ -1 +1,3 @@
 pub const manager = @import("manager.zig");
+pub const fetch = @import("fetch.zig");
+pub const lockfile = @import("lockfile.zig");
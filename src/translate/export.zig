@@ -1,7 +1,12 @@
 const std = @import("std");
 const core = @import("../core/mod.zig");
 const project_mod = @import("../core/project.zig");
+const glob = @import("../build/glob.zig");
+const manifest_mod = @import("../build/manifest.zig");
 const orchestrator = @import("../build/orchestrator.zig");
+const lto = @import("../build/lto.zig");
+const linker_mod = @import("../build/linker.zig");
+const target_graph = @import("../build/target_graph.zig");
 
 pub const ExportFormat = enum {
     cmake,
@@ -43,10 +48,10 @@ pub fn exportProject(allocator: std.mem.Allocator, project: project_mod.Project,
         .cmake => exportCMake(allocator, project),
         .xcode => exportXcode(allocator, project),
         .msbuild => exportMSBuild(allocator, project),
-        .ninja => exportNinja(allocator, project),
+        .ninja => exportNinja(allocator, project, .{}),
         .compile_commands => exportCompileCommands(allocator, project),
         .makefile => exportMakefile(allocator, project),
-        .pkg_config => exportPkgConfig(allocator, project),
+        .pkg_config => exportPkgConfig(allocator, project, .{}),
     };
 }
 
@@ -62,7 +67,13 @@ pub fn defaultPathForFormat(allocator: std.mem.Allocator, project: project_mod.P
     };
 }
 
-pub fn writeExport(path: []const u8, content: []const u8) !void {
+/// Leaves `path` untouched when it already holds `content`, so a Ninja
+/// regeneration that changes nothing restats clean.
+pub fn writeExport(allocator: std.mem.Allocator, path: []const u8, content: []const u8) !void {
+    const existing: ?[]const u8 = core.fs.readFileAlloc(allocator, path) catch null;
+    if (existing) |current| {
+        if (std.mem.eql(u8, current, content)) return;
+    }
     try core.fs.writeFile(path, content);
 }
 
@@ -95,55 +106,302 @@ fn exportCMake(allocator: std.mem.Allocator, project: project_mod.Project) ![]co
             }
             try out.appendSlice(allocator, ")\n");
         }
+        if (target.pch) |pch| {
+            try out.print(allocator, "target_precompile_headers({s} PRIVATE {s})\n", .{ target.name, pch });
+        }
         try out.appendSlice(allocator, "\n");
     }
     return try out.toOwnedSlice(allocator);
 }
 
-fn exportNinja(allocator: std.mem.Allocator, project: project_mod.Project) ![]const u8 {
+pub const NinjaOptions = struct {
+    /// Where the file is written; its regeneration edge rewrites it there.
+    path: []const u8 = "build.ninja",
+    /// Overrides `.defaults.optimize`, like `--profile`.
+    optimize: ?[]const u8 = null,
+};
+
+/// A complete Ninja build of the project: a compile edge per source with
+/// the flags `ovo build` uses and compiler-tracked headers, archive and link
+/// edges ordered after the libraries they link, and an edge that
+/// regenerates the file when `build.zon` or a globbed directory changes.
+/// Outputs go to `<output_dir>/ninja`, apart from `ovo build`'s own.
+/// Precompiled headers, unity batches and C++ modules are left to
+/// `ovo build`.
+pub fn exportNinja(allocator: std.mem.Allocator, project: project_mod.Project, options: NinjaOptions) ![]const u8 {
+    const backend = project.defaults.backend;
+    const msvc = std.mem.eql(u8, backend, "msvc");
+    const optimize = options.optimize orelse project.defaults.optimize;
+    // Not detected: the file may well be built on another machine.
+    const linker = project.defaults.linker orelse .default;
+    const out_dir = try std.fmt.allocPrint(allocator, "{s}/ninja", .{project.defaults.output_dir});
+    const graph = try target_graph.build(allocator, project.targets);
+    const pic = try graph.needsPic(allocator);
+
+    var index = glob.Index.init(allocator, glob.default_path);
+    defer index.deinit();
+    defer index.save() catch {};
+
     var out: std.ArrayList(u8) = .empty;
     errdefer out.deinit(allocator);
+    try out.appendSlice(allocator, "# Generated by `ovo export ninja` from build.zon, and regenerated when it changes.\n");
+    try out.appendSlice(allocator, "ninja_required_version = 1.3\n");
+    try out.print(allocator, "builddir = {f}\n", .{ninjaPath(out_dir)});
+    var compiler: std.ArrayList([]const u8) = .empty;
+    try orchestrator.appendCompilerPrefix(allocator, &compiler, backend);
+    try out.appendSlice(allocator, "cxx =");
+    for (compiler.items) |arg| try out.print(allocator, " {f}", .{ninjaArg(arg, msvc)});
+    try out.append(allocator, '\n');
+    try appendNinjaArchiver(allocator, &out, "ar", false, backend);
+    try out.append(allocator, '\n');
+
+    if (msvc) {
+        try out.appendSlice(allocator,
+            \\rule cxx
+            \\  command = $cxx /showIncludes $cflags /c $in /Fo:$out
+            \\  deps = msvc
+            \\  description = CXX $in
+            \\
+            \\rule ar
+            \\  command = $ar /OUT:$out $in
+            \\  description = AR $out
+            \\
+            \\rule link
+            \\  command = $cxx $in $libs /Fe:$out $ldflags
+            \\  description = LINK $out
+            \\
+            \\rule link_shared
+            \\  command = $cxx /LD $in $libs /Fe:$out $ldflags
+            \\  description = LINK $out
+            \\
+            \\
+        );
+    } else {
+        // `ar rcs` only adds members, so archives start fresh like in `ovo build`.
+        try out.appendSlice(allocator,
+            \\rule cxx
+            \\  command = $cxx $cflags -MD -MF $out.d -c $in -o $out
+            \\  depfile = $out.d
+            \\  deps = gcc
+            \\  description = CXX $in
+            \\
+            \\rule ar
+            \\  command = rm -f $out && $ar rcs $out $in
+            \\  description = AR $out
+            \\
+            \\rule link
+            \\  command = $cxx $ldflags $in $libs -o $out
+            \\  description = LINK $out
+            \\
+            \\rule link_shared
+            \\  command = $cxx -shared $ldflags $in $libs -o $out
+            \\  description = LINK $out
+            \\
+            \\
+        );
+    }
 
-    try out.appendSlice(allocator, "rule cxx\n");
-    try out.appendSlice(allocator, "  command = c++ -std=c++20 -O2 $in -o $out\n\n");
-    for (project.targets) |target| {
-        if (target.sources.len == 0) continue;
-        const first_source = target.sources[0];
-        try out.print(allocator, "build {s}: cxx {s}\n", .{ target.name, first_source });
+    // Dependencies come first in `order`, so every library's artifact is
+    // known before a target links it.
+    const artifacts = try allocator.alloc(?[]const u8, project.targets.len);
+    @memset(artifacts, null);
+    var flags: std.ArrayList([]const u8) = .empty;
+    var objects: std.ArrayList([]const u8) = .empty;
+    for (graph.order) |i| {
+        const target = project.targets[i];
+        const sources = index.resolveSources(target.sources) catch target.sources;
+        if (sources.len == 0) continue;
+        try out.ensureUnusedCapacity(allocator, sources.len * 160);
+
+        flags.clearRetainingCapacity();
+        if (pic[i] and !msvc) try flags.append(allocator, "-fPIC");
+        try orchestrator.appendCommonCompileFlags(allocator, &flags, optimize, project.defaults.cpp_standard, target.include_dirs, backend);
+        try linker_mod.appendCompileFlags(allocator, &flags, backend, optimize, linker);
+        const lto_mode = lto.active(target.lto, optimize);
+        if (lto_mode) |mode| try lto.appendCompileFlags(allocator, &flags, mode, backend);
+        try out.print(allocator, "# {s}\ncflags_{f} =", .{ target.name, ninjaName(target.name) });
+        for (flags.items) |flag| try out.print(allocator, " {f}", .{ninjaArg(flag, msvc)});
+        try out.append(allocator, '\n');
+
+        objects.clearRetainingCapacity();
+        const obj_dir = try std.fmt.allocPrint(allocator, "{s}/obj-{s}", .{ out_dir, target.name });
+        for (sources) |source| {
+            const name = try manifest_mod.objectFileName(allocator, source, orchestrator.objectExtension(backend));
+            const object = try std.fmt.allocPrint(allocator, "{s}/{s}", .{ obj_dir, name });
+            try objects.append(allocator, object);
+            try out.print(allocator, "build {f}: cxx {f}\n  cflags = $cflags_{f}\n", .{ ninjaPath(object), ninjaPath(source), ninjaName(target.name) });
+        }
+
+        const artifact = try orchestrator.artifactPath(allocator, out_dir, target);
+        artifacts[i] = artifact;
+        const rule = switch (target.kind) {
+            .executable, .test_target => "link",
+            .library_shared => "link_shared",
+            .library_static => "ar",
+        };
+        try out.print(allocator, "build {f}: {s}", .{ ninjaPath(artifact), rule });
+        for (objects.items) |object| try out.print(allocator, " {f}", .{ninjaPath(object)});
+        if (target.kind == .library_static) {
+            try out.append(allocator, '\n');
+            if (lto_mode != null) try appendNinjaArchiver(allocator, &out, "  ar", true, backend);
+        } else {
+            const plan = try graph.linkPlan(allocator, i);
+            const project_libs = try allocator.alloc(project_mod.Target, plan.project_libs.len);
+            // The libraries' artifacts are implicit inputs: linked after
+            // them, and again whenever one changes.
+            var first_lib = true;
+            var link_lto = target.lto;
+            for (plan.project_libs, project_libs) |lib, *out_lib| {
+                out_lib.* = project.targets[lib];
+                link_lto = link_lto orelse out_lib.lto;
+                const lib_artifact = artifacts[lib] orelse continue;
+                try out.appendSlice(allocator, if (first_lib) " | " else " ");
+                try out.print(allocator, "{f}", .{ninjaPath(lib_artifact)});
+                first_lib = false;
+            }
+            var libs: std.ArrayList([]const u8) = .empty;
+            try orchestrator.appendLinkLibraries(allocator, &libs, .{
+                .output_dir = out_dir,
+                .project_libs = project_libs,
+                .external = plan.external,
+            }, backend);
+            try out.appendSlice(allocator, "\n  libs =");
+            for (libs.items) |arg| try out.print(allocator, " {f}", .{ninjaArg(arg, msvc)});
+            try out.append(allocator, '\n');
+            var ldflags: std.ArrayList([]const u8) = .empty;
+            if (msvc) try ldflags.append(allocator, "/link");
+            const initial = ldflags.items.len;
+            try linker_mod.appendLinkFlags(allocator, &ldflags, backend, optimize, linker);
+            if (lto.active(link_lto, optimize)) |mode| {
+                const cache_dir = try std.fmt.allocPrint(allocator, "{s}/{s}", .{ out_dir, lto.cache_dir_name });
+                try lto.appendLinkFlags(allocator, &ldflags, mode, backend, cache_dir, artifact);
+            }
+            if (ldflags.items.len > initial) {
+                try out.appendSlice(allocator, "  ldflags =");
+                for (ldflags.items) |arg| try out.print(allocator, " {f}", .{ninjaArg(arg, msvc)});
+                try out.append(allocator, '\n');
+            }
+        }
+        try out.print(allocator, "build {f}: phony {f}\n\n", .{ ninjaPath(target.name), ninjaPath(artifact) });
+    }
+
+    try out.appendSlice(allocator, "default");
+    for (artifacts) |artifact| {
+        if (artifact) |path| try out.print(allocator, " {f}", .{ninjaPath(path)});
+    }
+    try out.appendSlice(allocator, "\n\n");
+
+    // Adding or removing a file changes its directory, so globbed
+    // directories regenerate the file along with build.zon. `ovo export`
+    // leaves an unchanged file alone, and `restat` then skips the rest.
+    try out.appendSlice(allocator, "rule regen\n  command = ovo");
+    if (options.optimize) |profile| try out.print(allocator, " --profile {f}", .{ninjaArg(profile, msvc)});
+    try out.print(allocator, " export ninja {f}\n", .{ninjaArg(options.path, msvc)});
+    try out.appendSlice(allocator, "  description = Regenerating $out\n  generator = 1\n  restat = 1\n");
+    try out.print(allocator, "build {f}: regen build.zon", .{ninjaPath(options.path)});
+    var dirs = index.visitedDirs();
+    var first_dir = true;
+    while (dirs.next()) |dir| {
+        try out.appendSlice(allocator, if (first_dir) " | " else " ");
+        try out.print(allocator, "{f}", .{ninjaPath(dir.*)});
+        first_dir = false;
     }
+    try out.append(allocator, '\n');
     return try out.toOwnedSlice(allocator);
 }
 
+/// `name = <archiver>` for the `ar` rule; LTO objects need one that reads them.
+fn appendNinjaArchiver(allocator: std.mem.Allocator, out: *std.ArrayList(u8), name: []const u8, lto_objects: bool, backend: []const u8) !void {
+    var archiver: std.ArrayList([]const u8) = .empty;
+    try lto.appendArchiver(allocator, &archiver, lto_objects, backend);
+    try out.print(allocator, "{s} =", .{name});
+    for (archiver.items) |arg| try out.print(allocator, " {f}", .{ninjaArg(arg, std.mem.eql(u8, backend, "msvc"))});
+    try out.append(allocator, '\n');
+}
+
+/// Escapes a path in a `build` line: `$`, spaces and colons.
+fn ninjaPath(path: []const u8) NinjaPath {
+    return .{ .path = path };
+}
+
+/// Quotes an argument for the shell that runs the command, then escapes it
+/// for Ninja.
+fn ninjaArg(arg: []const u8, windows: bool) NinjaArg {
+    return .{ .arg = arg, .windows = windows };
+}
+
+/// A target name as part of a Ninja variable name.
+fn ninjaName(name: []const u8) NinjaName {
+    return .{ .name = name };
+}
+
+const NinjaPath = struct {
+    path: []const u8,
+
+    pub fn format(self: NinjaPath, w: *std.Io.Writer) std.Io.Writer.Error!void {
+        for (self.path) |c| {
+            switch (c) {
+                '$', ' ', ':' => try w.writeByte('$'),
+                else => {},
+            }
+            try w.writeByte(c);
+        }
+    }
+};
+
+const NinjaArg = struct {
+    arg: []const u8,
+    windows: bool,
+
+    pub fn format(self: NinjaArg, w: *std.Io.Writer) std.Io.Writer.Error!void {
+        if (isPlainArg(self.arg)) return w.writeAll(self.arg);
+        const quote: u8 = if (self.windows) '"' else '\'';
+        try w.writeByte(quote);
+        for (self.arg) |c| {
+            if (c == '$') {
+                try w.writeAll("$$");
+            } else if (c == quote) {
+                try w.writeAll(if (self.windows) "\\\"" else "'\\''");
+            } else {
+                try w.writeByte(c);
+            }
+        }
+        try w.writeByte(quote);
+    }
+};
+
+fn isPlainArg(arg: []const u8) bool {
+    if (arg.len == 0) return false;
+    for (arg) |c| {
+        if (!std.ascii.isAlphanumeric(c) and std.mem.indexOfScalar(u8, "+-_./:=,@%", c) == null) return false;
+    }
+    return true;
+}
+
+const NinjaName = struct {
+    name: []const u8,
+
+    pub fn format(self: NinjaName, w: *std.Io.Writer) std.Io.Writer.Error!void {
+        for (self.name) |c| try w.writeByte(if (std.ascii.isAlphanumeric(c) or c == '_' or c == '-') c else '_');
+    }
+};
+
+/// The database `ovo build` writes, for every target: each entry is a
+/// translation unit's exact compile, PCH, module and depfile flags
+/// included, so exporting it over the build's own never changes what an
+/// editor sees.
 fn exportCompileCommands(allocator: std.mem.Allocator, project: project_mod.Project) ![]const u8 {
     var out: std.ArrayList(u8) = .empty;
     errdefer out.deinit(allocator);
     try out.appendSlice(allocator, "[\n");
-
     var first = true;
-    for (project.targets) |target| {
-        for (target.sources) |pattern| {
-            const sources = orchestrator.resolveSourcePattern(allocator, pattern) catch blk: {
-                const single = try allocator.alloc([]const u8, 1);
-                single[0] = pattern;
-                break :blk single;
-            };
-            for (sources) |source| {
-                if (!first) try out.appendSlice(allocator, ",\n");
-                first = false;
-                var include_flags: std.ArrayList(u8) = .empty;
-                defer include_flags.deinit(allocator);
-                for (target.include_dirs) |include_dir| {
-                    try include_flags.print(allocator, " -I{s}", .{include_dir});
-                }
-                try out.print(
-                    allocator,
-                    "  {{\"directory\":\".\",\"command\":\"c++ -std=c++20{s} -c {s}\",\"file\":\"{s}\"}}",
-                    .{ include_flags.items, source, source },
-                );
-            }
-        }
+    for (try orchestrator.commandParts(allocator, project)) |part| {
+        if (part.len == 0) continue;
+        if (!first) try out.appendSlice(allocator, ",\n");
+        first = false;
+        try out.appendSlice(allocator, part);
     }
-    try out.appendSlice(allocator, "\n]\n");
+    try out.appendSlice(allocator, if (first) "]\n" else "\n]\n");
     return try out.toOwnedSlice(allocator);
 }
 
@@ -162,17 +420,29 @@ fn exportMakefile(allocator: std.mem.Allocator, project: project_mod.Project) ![
     return try out.toOwnedSlice(allocator);
 }
 
-fn exportPkgConfig(allocator: std.mem.Allocator, project: project_mod.Project) ![]const u8 {
+pub const PkgConfigOptions = struct {
+    prefix: []const u8 = "/usr/local",
+    /// Relative to `prefix`, as `ovo install --libdir` and `--includedir` take them.
+    libdir: []const u8 = "lib",
+    includedir: []const u8 = "include",
+};
+
+/// `Libs` names every library target, so the file is usable as installed.
+pub fn exportPkgConfig(allocator: std.mem.Allocator, project: project_mod.Project, options: PkgConfigOptions) ![]const u8 {
     var out: std.ArrayList(u8) = .empty;
     errdefer out.deinit(allocator);
-    try out.appendSlice(allocator, "prefix=/usr/local\n");
+    try out.print(allocator, "prefix={s}\n", .{options.prefix});
     try out.appendSlice(allocator, "exec_prefix=${prefix}\n");
-    try out.appendSlice(allocator, "libdir=${exec_prefix}/lib\n");
-    try out.appendSlice(allocator, "includedir=${prefix}/include\n\n");
+    try out.print(allocator, "libdir=${{exec_prefix}}/{s}\n", .{options.libdir});
+    try out.print(allocator, "includedir=${{prefix}}/{s}\n\n", .{options.includedir});
     try out.print(allocator, "Name: {s}\n", .{project.name});
     try out.appendSlice(allocator, "Description: Export from OVO\n");
     try out.print(allocator, "Version: {s}\n", .{project.version});
-    try out.appendSlice(allocator, "Libs: -L${libdir}\n");
+    try out.appendSlice(allocator, "Libs: -L${libdir}");
+    for (project.targets) |target| {
+        if (target.kind == .library_static or target.kind == .library_shared) try out.print(allocator, " -l{s}", .{target.name});
+    }
+    try out.appendSlice(allocator, "\n");
     try out.appendSlice(allocator, "Cflags: -I${includedir}\n");
     return try out.toOwnedSlice(allocator);
 }
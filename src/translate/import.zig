@@ -64,288 +64,412 @@ const CMakeCommand = struct {
     args: []const u8,
 };
 
-const CMakeVariable = struct {
+/// A command with its arguments split, before variables are expanded.
+const CMakeStatement = struct {
     name: []const u8,
-    values: []const []const u8,
+    args: []const []const u8,
+};
+
+/// Files read in one parallel wave before threads are worth spawning.
+const parallel_threshold = 4;
+const max_threads = 16;
+
+/// Values in first-seen order; `seen` keeps the duplicate check constant-time.
+const UniqueList = struct {
+    items: std.ArrayList([]const u8) = .empty,
+    seen: std.StringHashMapUnmanaged(void) = .empty,
+
+    /// `value` must outlive the list; the importer passes interned strings.
+    fn append(self: *UniqueList, allocator: std.mem.Allocator, value: []const u8) !void {
+        const entry = try self.seen.getOrPut(allocator, value);
+        if (entry.found_existing) return;
+        try self.items.append(allocator, value);
+    }
 };
 
 const CMakeTarget = struct {
     name: []const u8,
     kind: project_mod.TargetType,
-    sources: std.ArrayList([]const u8),
-    include_dirs: std.ArrayList([]const u8),
-    link_libraries: std.ArrayList([]const u8),
+    sources: UniqueList = .{},
+    include_dirs: UniqueList = .{},
+    link_libraries: UniqueList = .{},
+};
+
+/// Variables of one directory. `add_subdirectory` opens a child whose
+/// lookups fall back to its parents, so what a subdirectory sets stays there
+/// unless it says `PARENT_SCOPE`; `include` runs in the caller's scope.
+const CMakeScope = struct {
+    parent: ?*CMakeScope,
+    values: std.StringHashMapUnmanaged([]const []const u8) = .empty,
+
+    fn lookup(self: *const CMakeScope, name: []const u8) ?[]const []const u8 {
+        var scope: ?*const CMakeScope = self;
+        while (scope) |current| : (scope = current.parent) {
+            if (current.values.get(name)) |values| return values;
+        }
+        return null;
+    }
 };
 
+/// A file's statements, or null when it can't be read.
+const LoadedFiles = std.StringHashMapUnmanaged(?[]const CMakeStatement);
+
 const CMakeParseContext = struct {
     allocator: std.mem.Allocator,
-    target_data: *std.ArrayList(CMakeTarget),
-    global_include_dirs: *std.ArrayList([]const u8),
-    variable_values: *std.ArrayList(CMakeVariable),
-    parsed_project_name: *[]const u8,
-    cpp_standard: *project_mod.CppStandard,
-    visited_paths: *std.ArrayList([]const u8),
+    targets: std.ArrayList(CMakeTarget) = .empty,
+    target_index: std.StringHashMapUnmanaged(usize) = .empty,
+    global_include_dirs: UniqueList = .{},
+    parsed_project_name: []const u8,
+    cpp_standard: project_mod.CppStandard = .cpp20,
+    /// Every string the import keeps, stored once in `allocator`. File
+    /// buffers live in the loaders' arenas, and large trees repeat the same
+    /// paths and names throughout.
+    strings: std.StringHashMapUnmanaged(void) = .empty,
+    visited_paths: std.StringHashMapUnmanaged(void) = .empty,
+    /// Filled by `prefetch`; files it couldn't predict are loaded when
+    /// evaluation reaches them.
+    files: LoadedFiles = .empty,
+    /// One per loader thread; the first also loads files during evaluation.
+    arenas: []std.heap.ArenaAllocator,
+    /// Reused to build interpolated arguments.
+    scratch: std.ArrayList(u8) = .empty,
+
+    fn intern(self: *CMakeParseContext, value: []const u8) ![]const u8 {
+        const entry = try self.strings.getOrPut(self.allocator, value);
+        if (!entry.found_existing) entry.key_ptr.* = try self.allocator.dupe(u8, value);
+        return entry.key_ptr.*;
+    }
+
+    fn setVariable(self: *CMakeParseContext, scope: *CMakeScope, key: []const u8, values: []const []const u8) !void {
+        const stored = try self.allocator.alloc([]const u8, values.len);
+        for (values, stored) |value, *slot| slot.* = try self.intern(value);
+        const entry = try scope.values.getOrPut(self.allocator, key);
+        if (!entry.found_existing) entry.key_ptr.* = try self.intern(key);
+        entry.value_ptr.* = stored;
+    }
+
+    fn findOrCreateTarget(self: *CMakeParseContext, name: []const u8, kind: project_mod.TargetType) !*CMakeTarget {
+        const entry = try self.target_index.getOrPut(self.allocator, name);
+        if (!entry.found_existing) {
+            const owned = try self.intern(name);
+            entry.key_ptr.* = owned;
+            entry.value_ptr.* = self.targets.items.len;
+            try self.targets.append(self.allocator, .{ .name = owned, .kind = kind });
+        }
+        return &self.targets.items[entry.value_ptr.*];
+    }
+
+    /// Reads and tokenizes `root`, then wave by wave the files its
+    /// `add_subdirectory` and `include` calls name literally, on all
+    /// threads. Evaluation still runs serially in declaration order.
+    fn prefetch(self: *CMakeParseContext, root: []const u8) !void {
+        var wave: std.ArrayList(LoadJob) = .empty;
+        defer wave.deinit(self.allocator);
+        try self.queue(&wave, root);
+
+        while (wave.items.len > 0) {
+            var batch = LoadBatch{ .jobs = wave.items };
+            const wanted = if (wave.items.len < parallel_threshold) 1 else @min(wave.items.len / parallel_threshold + 1, self.arenas.len);
+            var threads: [max_threads]std.Thread = undefined;
+            var spawned: usize = 0;
+            while (spawned + 1 < wanted) : (spawned += 1) {
+                threads[spawned] = std.Thread.spawn(.{}, LoadBatch.run, .{ &batch, &self.arenas[spawned + 1] }) catch break;
+            }
+            batch.run(&self.arenas[0]);
+            for (threads[0..spawned]) |thread| thread.join();
+
+            var next: std.ArrayList(LoadJob) = .empty;
+            for (wave.items) |job| {
+                if (job.err) |err| return err;
+                try self.files.put(self.allocator, job.path, job.statements);
+                const statements = job.statements orelse continue;
+                const dir = std.fs.path.dirname(job.path) orelse ".";
+                for (statements) |statement| {
+                    if (statement.args.len == 0) continue;
+                    const operand = statement.args[0];
+                    if (operand.len == 0 or std.mem.indexOf(u8, operand, "${") != null) continue;
+                    if (std.ascii.eqlIgnoreCase(statement.name, "add_subdirectory")) {
+                        const sub_dir = try resolveRelativePath(self.allocator, dir, operand);
+                        try self.queue(&next, try listFilePath(self.allocator, sub_dir));
+                    } else if (std.ascii.eqlIgnoreCase(statement.name, "include")) {
+                        const resolved = try resolveRelativePath(self.allocator, dir, operand);
+                        if (std.mem.endsWith(u8, resolved, ".cmake")) {
+                            try self.queue(&next, resolved);
+                        } else {
+                            try self.queue(&next, try std.fmt.allocPrint(self.allocator, "{s}.cmake", .{resolved}));
+                        }
+                    }
+                }
+            }
+            wave.deinit(self.allocator);
+            wave = next;
+        }
+    }
+
+    fn queue(self: *CMakeParseContext, wave: *std.ArrayList(LoadJob), path: []const u8) !void {
+        const entry = try self.files.getOrPut(self.allocator, path);
+        if (entry.found_existing) return;
+        entry.value_ptr.* = null;
+        try wave.append(self.allocator, .{ .path = path });
+    }
+
+    fn statementsOf(self: *CMakeParseContext, path: []const u8) !?[]const CMakeStatement {
+        if (self.files.get(path)) |loaded| return loaded;
+        const loaded = try loadStatements(self.arenas[0].allocator(), path);
+        try self.files.put(self.allocator, path, loaded);
+        return loaded;
+    }
 };
 
-fn importCMake(allocator: std.mem.Allocator, source_path: []const u8) !project_mod.Project {
-    var target_data: std.ArrayList(CMakeTarget) = .empty;
-    var global_include_dirs: std.ArrayList([]const u8) = .empty;
-    var variable_values: std.ArrayList(CMakeVariable) = .empty;
-    var parsed_project_name = project_mod.guessProjectNameFromPath(source_path);
-    var cpp_standard = project_mod.CppStandard.cpp20;
-    var visited_paths: std.ArrayList([]const u8) = .empty;
-
-    const root_path = if (std.mem.eql(u8, source_path, "."))
-        try allocator.dupe(u8, "CMakeLists.txt")
-    else
-        try std.fmt.allocPrint(allocator, "{s}/CMakeLists.txt", .{source_path});
-    defer allocator.free(root_path);
+/// Files read by loader threads; each allocates from its own arena and
+/// claims jobs through a shared counter.
+const LoadBatch = struct {
+    jobs: []LoadJob,
+    next_job: std.atomic.Value(usize) = .init(0),
+
+    fn run(batch: *LoadBatch, arena: *std.heap.ArenaAllocator) void {
+        while (true) {
+            const index = batch.next_job.fetchAdd(1, .monotonic);
+            if (index >= batch.jobs.len) return;
+            const job = &batch.jobs[index];
+            job.statements = loadStatements(arena.allocator(), job.path) catch |err| {
+                job.err = err;
+                continue;
+            };
+        }
+    }
+};
+
+const LoadJob = struct {
+    path: []const u8,
+    statements: ?[]const CMakeStatement = null,
+    err: ?anyerror = null,
+};
 
+/// Null when the file can't be read, which the import treats as absent.
+fn loadStatements(allocator: std.mem.Allocator, path: []const u8) !?[]const CMakeStatement {
+    const bytes = core.fs.readFileAlloc(allocator, path) catch |err| {
+        return if (err == error.OutOfMemory) err else null;
+    };
+    const commands = try extractCMakeCommands(allocator, bytes);
+    const statements = try allocator.alloc(CMakeStatement, commands.len);
+    for (commands, statements) |command, *statement| {
+        var args = try tokenizeCMakeArguments(allocator, command.args);
+        statement.* = .{ .name = command.name, .args = try args.toOwnedSlice(allocator) };
+    }
+    return statements;
+}
+
+fn listFilePath(allocator: std.mem.Allocator, dir: []const u8) ![]const u8 {
+    if (std.mem.eql(u8, dir, ".")) return allocator.dupe(u8, "CMakeLists.txt");
+    return std.fmt.allocPrint(allocator, "{s}/CMakeLists.txt", .{dir});
+}
+
+fn importCMake(allocator: std.mem.Allocator, source_path: []const u8) !project_mod.Project {
+    const root_path = try listFilePath(allocator, source_path);
     if (!core.fs.fileExists(root_path)) return error.CMakeFileNotFound;
 
-    try setVariable(allocator, &variable_values, "PROJECT_NAME", &.{parsed_project_name});
-    try setVariable(allocator, &variable_values, "CMAKE_SOURCE_DIR", &.{source_path});
-    try setVariable(allocator, &variable_values, "CMAKE_CURRENT_SOURCE_DIR", &.{source_path});
-    try setVariable(allocator, &variable_values, "CMAKE_CURRENT_LIST_DIR", &.{source_path});
-    try setVariable(allocator, &variable_values, "PROJECT_SOURCE_DIR", &.{source_path});
+    const thread_count = @max(@min(max_threads, std.Thread.getCpuCount() catch 1), 1);
+    const arenas = try allocator.alloc(std.heap.ArenaAllocator, thread_count);
+    for (arenas) |*arena| arena.* = std.heap.ArenaAllocator.init(core.memory.page_allocator);
+    defer for (arenas) |*arena| arena.deinit();
 
     var context = CMakeParseContext{
         .allocator = allocator,
-        .target_data = &target_data,
-        .global_include_dirs = &global_include_dirs,
-        .variable_values = &variable_values,
-        .parsed_project_name = &parsed_project_name,
-        .cpp_standard = &cpp_standard,
-        .visited_paths = &visited_paths,
+        .parsed_project_name = project_mod.guessProjectNameFromPath(source_path),
+        .arenas = arenas,
     };
-
-    try importCMakeFromPath(allocator, source_path, true, &context);
-
-    if (target_data.items.len == 0) {
-        var sources: std.ArrayList([]const u8) = .empty;
-        var includes: std.ArrayList([]const u8) = .empty;
-        try sources.append(allocator, "src/main.cpp");
-        try includes.append(allocator, "include");
-        try target_data.append(allocator, .{
-            .name = parsed_project_name,
-            .kind = .executable,
-            .sources = sources,
-            .include_dirs = includes,
-            .link_libraries = .empty,
-        });
+    var root_scope = CMakeScope{ .parent = null };
+    try context.setVariable(&root_scope, "PROJECT_NAME", &.{context.parsed_project_name});
+    try context.setVariable(&root_scope, "CMAKE_SOURCE_DIR", &.{source_path});
+    try context.setVariable(&root_scope, "PROJECT_SOURCE_DIR", &.{source_path});
+
+    try context.prefetch(root_path);
+    try evalDirectory(&context, source_path, &root_scope, true);
+
+    if (context.targets.items.len == 0) {
+        const target = try context.findOrCreateTarget(context.parsed_project_name, .executable);
+        try target.sources.append(allocator, "src/main.cpp");
+        try target.include_dirs.append(allocator, "include");
     }
 
-    const rendered_targets = try allocator.alloc(project_mod.Target, target_data.items.len);
-    for (target_data.items, 0..) |_, target_index| {
-        var target = &target_data.items[target_index];
-        const target_sources = if (target.sources.items.len > 0)
-            try target.sources.toOwnedSlice(allocator)
-        else
-            try allocator.dupe([]const u8, &[_][]const u8{});
-        const merged_includes = try mergeIncludeDirs(
-            allocator,
-            global_include_dirs.items,
-            target.include_dirs.items,
-        );
-        const links = try target.link_libraries.toOwnedSlice(allocator);
-        rendered_targets[target_index] = .{
+    const rendered_targets = try allocator.alloc(project_mod.Target, context.targets.items.len);
+    for (context.targets.items, rendered_targets) |*target, *rendered| {
+        rendered.* = .{
             .name = target.name,
             .kind = target.kind,
-            .sources = target_sources,
-            .include_dirs = merged_includes,
-            .link_libraries = links,
+            .sources = try target.sources.items.toOwnedSlice(allocator),
+            .include_dirs = try mergeIncludeDirs(
+                allocator,
+                context.global_include_dirs.items.items,
+                target.include_dirs.items.items,
+            ),
+            .link_libraries = try target.link_libraries.items.toOwnedSlice(allocator),
         };
     }
 
     return .{
-        .name = parsed_project_name,
+        .name = context.parsed_project_name,
         .version = "0.1.0",
         .license = "MIT",
-        .defaults = .{ .cpp_standard = cpp_standard },
+        .defaults = .{ .cpp_standard = context.cpp_standard },
         .targets = rendered_targets,
     };
 }
 
-fn importCMakeFromPath(
-    allocator: std.mem.Allocator,
-    source_path: []const u8,
-    is_root: bool,
+/// Runs the `CMakeLists.txt` of `dir` in `scope`.
+fn evalDirectory(
     context: *CMakeParseContext,
+    dir: []const u8,
+    scope: *CMakeScope,
+    is_root: bool,
 ) CMakeParseError!void {
-    const path = if (std.mem.eql(u8, source_path, "."))
-        try allocator.dupe(u8, "CMakeLists.txt")
-    else
-        try std.fmt.allocPrint(allocator, "{s}/CMakeLists.txt", .{source_path});
-    defer allocator.free(path);
-
-    if (!core.fs.fileExists(path)) return;
-    if (isVisited(context.visited_paths, path)) return;
-    const visited_path = try allocator.dupe(u8, path);
-    try context.visited_paths.append(allocator, visited_path);
-
-    const cmake = core.fs.readFileAlloc(allocator, path) catch |err| {
-        return if (err == error.OutOfMemory) err else {};
-    };
-    defer allocator.free(cmake);
-
-    try parseCMakeBuffer(allocator, source_path, cmake, context, is_root);
+    try context.setVariable(scope, "CMAKE_CURRENT_SOURCE_DIR", &.{dir});
+    try context.setVariable(scope, "CMAKE_CURRENT_LIST_DIR", &.{dir});
+    try evalFile(context, try listFilePath(context.allocator, dir), dir, scope, is_root);
 }
 
-fn parseCMakeBuffer(
-    allocator: std.mem.Allocator,
-    source_path: []const u8,
-    cmake: []const u8,
+fn evalFile(
     context: *CMakeParseContext,
+    path: []const u8,
+    source_path: []const u8,
+    scope: *CMakeScope,
     parse_project_name: bool,
 ) CMakeParseError!void {
-    const commands = try extractCMakeCommands(allocator, cmake);
-    defer allocator.free(commands);
-
-    for (commands) |command| {
-        var raw_args = try tokenizeCMakeArguments(allocator, command.args);
-        defer raw_args.deinit(allocator);
-        if (raw_args.items.len == 0) continue;
-
-        var args: std.ArrayList([]const u8) = .empty;
-        defer args.deinit(allocator);
-        try expandVariables(allocator, raw_args.items, context.variable_values, &args);
-
-        if (std.ascii.eqlIgnoreCase(command.name, "project") and parse_project_name) {
-            if (parseProjectNameFromTokens(args.items)) |name| {
-                context.parsed_project_name.* = name;
-                try setVariable(allocator, context.variable_values, "PROJECT_NAME", &.{name});
+    const visited = try context.visited_paths.getOrPut(context.allocator, path);
+    if (visited.found_existing) return;
+    const statements = try context.statementsOf(path) orelse return;
+
+    var args: std.ArrayList([]const u8) = .empty;
+    defer args.deinit(context.allocator);
+    for (statements) |statement| {
+        if (statement.args.len == 0) continue;
+        const name = statement.name;
+
+        args.clearRetainingCapacity();
+        try expandVariables(context, statement.args, scope, &args);
+
+        if (std.ascii.eqlIgnoreCase(name, "project") and parse_project_name) {
+            if (parseProjectNameFromTokens(args.items)) |project_name| {
+                context.parsed_project_name = try context.intern(project_name);
+                try context.setVariable(scope, "PROJECT_NAME", &.{project_name});
             }
             continue;
         }
 
-        if (std.ascii.eqlIgnoreCase(command.name, "set")) {
-            try parseSetCommand(allocator, args.items, context.variable_values, context.cpp_standard);
+        if (std.ascii.eqlIgnoreCase(name, "set")) {
+            try parseSetCommand(context, args.items, scope);
             continue;
         }
 
-        if (std.ascii.eqlIgnoreCase(command.name, "set_property")) {
-            parseSetPropertyCommand(args.items, context.cpp_standard);
+        if (std.ascii.eqlIgnoreCase(name, "set_property")) {
+            parseSetPropertyCommand(args.items, &context.cpp_standard);
             continue;
         }
 
-        if (std.ascii.eqlIgnoreCase(command.name, "set_target_properties")) {
-            parseSetTargetPropertiesCommand(args.items, context.cpp_standard);
+        if (std.ascii.eqlIgnoreCase(name, "set_target_properties")) {
+            parseSetTargetPropertiesCommand(args.items, &context.cpp_standard);
             continue;
         }
 
-        if (std.ascii.eqlIgnoreCase(command.name, "target_compile_features")) {
-            parseTargetCompileFeatures(args.items, context.cpp_standard);
+        if (std.ascii.eqlIgnoreCase(name, "target_compile_features")) {
+            parseTargetCompileFeatures(args.items, &context.cpp_standard);
             continue;
         }
 
-        if (std.ascii.eqlIgnoreCase(command.name, "add_executable")) {
-            try parseTargetCommand(allocator, args.items, .executable, context.target_data);
+        if (std.ascii.eqlIgnoreCase(name, "add_executable")) {
+            try parseTargetCommand(context, args.items, .executable);
             continue;
         }
 
-        if (std.ascii.eqlIgnoreCase(command.name, "add_library")) {
-            try parseAddLibraryCommand(allocator, args.items, context.target_data);
+        if (std.ascii.eqlIgnoreCase(name, "add_library")) {
+            try parseAddLibraryCommand(context, args.items);
             continue;
         }
 
-        if (std.ascii.eqlIgnoreCase(command.name, "add_subdirectory")) {
-            try parseAddSubdirectoryCommand(allocator, args.items, source_path, context);
+        if (std.ascii.eqlIgnoreCase(name, "add_subdirectory")) {
+            try parseAddSubdirectoryCommand(context, args.items, source_path, scope);
             continue;
         }
 
-        if (std.ascii.eqlIgnoreCase(command.name, "include")) {
-            try parseIncludeCommand(allocator, args.items, source_path, context);
+        if (std.ascii.eqlIgnoreCase(name, "include")) {
+            try parseIncludeCommand(context, args.items, source_path, scope);
             continue;
         }
 
-        if (std.ascii.eqlIgnoreCase(command.name, "target_sources")) {
-            try parseTargetSourcesCommand(allocator, args.items, context.target_data);
+        if (std.ascii.eqlIgnoreCase(name, "target_sources")) {
+            try parseTargetSourcesCommand(context, args.items);
             continue;
         }
 
-        if (std.ascii.eqlIgnoreCase(command.name, "include_directories") or
-            std.ascii.eqlIgnoreCase(command.name, "include_directory"))
+        if (std.ascii.eqlIgnoreCase(name, "include_directories") or
+            std.ascii.eqlIgnoreCase(name, "include_directory"))
         {
-            try appendDirectoryList(allocator, context.global_include_dirs, args.items, &.{ "BEFORE", "AFTER", "SYSTEM" });
+            try appendDirectoryList(context, &context.global_include_dirs, args.items, &.{ "BEFORE", "AFTER", "SYSTEM" });
             continue;
         }
 
-        if (std.ascii.eqlIgnoreCase(command.name, "target_include_directories")) {
-            try parseTargetIncludeDirectoriesCommand(allocator, args.items, context.target_data);
+        if (std.ascii.eqlIgnoreCase(name, "target_include_directories")) {
+            try parseTargetIncludeDirectoriesCommand(context, args.items);
             continue;
         }
 
-        if (std.ascii.eqlIgnoreCase(command.name, "target_link_libraries")) {
-            try parseTargetLinkLibrariesCommand(allocator, args.items, context.target_data);
+        if (std.ascii.eqlIgnoreCase(name, "target_link_libraries")) {
+            try parseTargetLinkLibrariesCommand(context, args.items);
             continue;
         }
     }
 }
 
 fn parseAddSubdirectoryCommand(
-    allocator: std.mem.Allocator,
+    context: *CMakeParseContext,
     args: []const []const u8,
     source_path: []const u8,
-    context: *CMakeParseContext,
+    scope: *CMakeScope,
 ) CMakeParseError!void {
     if (args.len == 0) return;
     const sub_dir = args[0];
     if (sub_dir.len == 0) return;
     if (sub_dir[0] == '$') return;
 
-    const resolved = try resolveRelativePath(allocator, source_path, sub_dir);
-    defer allocator.free(resolved);
-
-    try importCMakeFromPath(allocator, resolved, false, context);
+    const resolved = try resolveRelativePath(context.allocator, source_path, sub_dir);
+    var child = CMakeScope{ .parent = scope };
+    defer child.values.deinit(context.allocator);
+    try evalDirectory(context, resolved, &child, false);
 }
 
 fn parseIncludeCommand(
-    allocator: std.mem.Allocator,
+    context: *CMakeParseContext,
     args: []const []const u8,
     source_path: []const u8,
-    context: *CMakeParseContext,
+    scope: *CMakeScope,
 ) CMakeParseError!void {
     if (args.len == 0) return;
     const include_path = args[0];
     if (include_path.len == 0 or include_path[0] == '$') return;
-    const resolved = try resolveRelativePath(allocator, source_path, include_path);
-    defer allocator.free(resolved);
-    try parseCMakeFile(allocator, resolved, context);
+    const resolved = try resolveRelativePath(context.allocator, source_path, include_path);
+    try parseCMakeFile(context, resolved, scope);
     if (!std.mem.endsWith(u8, resolved, ".cmake")) {
-        const with_ext = try std.fmt.allocPrint(allocator, "{s}.cmake", .{resolved});
-        defer allocator.free(with_ext);
-        try parseCMakeFile(allocator, with_ext, context);
+        const with_ext = try std.fmt.allocPrint(context.allocator, "{s}.cmake", .{resolved});
+        try parseCMakeFile(context, with_ext, scope);
     }
 }
 
+/// Included files see their own directory as `CMAKE_CURRENT_LIST_DIR`
+/// while they run.
 fn parseCMakeFile(
-    allocator: std.mem.Allocator,
-    file_path: []const u8,
     context: *CMakeParseContext,
+    file_path: []const u8,
+    scope: *CMakeScope,
 ) CMakeParseError!void {
     if (!std.mem.endsWith(u8, file_path, ".cmake")) {
         return;
     }
-    if (!core.fs.fileExists(file_path)) return;
-    if (isVisited(context.visited_paths, file_path)) return;
-    const visited_path = try allocator.dupe(u8, file_path);
-    try context.visited_paths.append(allocator, visited_path);
-
-    const bytes = core.fs.readFileAlloc(allocator, file_path) catch |err| {
-        return if (err == error.OutOfMemory) err else {};
-    };
-    defer allocator.free(bytes);
-
     const source_dir = if (std.fs.path.dirname(file_path)) |dir| dir else ".";
-    const source_buffer: []const u8 = bytes;
-    try parseCMakeBuffer(allocator, source_dir, source_buffer, context, false);
-}
-
-fn isVisited(visited: *std.ArrayList([]const u8), candidate: []const u8) bool {
-    for (visited.items) |path| {
-        if (std.mem.eql(u8, path, candidate)) return true;
-    }
-    return false;
+    const caller_dir = scope.lookup("CMAKE_CURRENT_LIST_DIR") orelse &.{};
+    try context.setVariable(scope, "CMAKE_CURRENT_LIST_DIR", &.{source_dir});
+    try evalFile(context, file_path, source_dir, scope, false);
+    try scope.values.put(context.allocator, "CMAKE_CURRENT_LIST_DIR", caller_dir);
 }
 
 fn resolveRelativePath(allocator: std.mem.Allocator, base: []const u8, candidate: []const u8) ![]const u8 {
@@ -1140,21 +1264,25 @@ fn parseProjectNameFromTokens(tokens: []const []const u8) ?[]const u8 {
 }
 
 fn parseSetCommand(
-    allocator: std.mem.Allocator,
+    context: *CMakeParseContext,
     args: []const []const u8,
-    variables: *std.ArrayList(CMakeVariable),
-    cpp_standard: *project_mod.CppStandard,
+    scope: *CMakeScope,
 ) !void {
     if (args.len < 2) return;
 
     if (std.ascii.eqlIgnoreCase(args[0], "CMAKE_CXX_STANDARD")) {
-        if (parseCppStandardFromToken(args[1])) |standard| cpp_standard.* = standard;
+        if (parseCppStandardFromToken(args[1])) |standard| context.cpp_standard = standard;
         return;
     }
 
     if (std.ascii.eqlIgnoreCase(args[0], "CMAKE_C_STANDARD")) return;
 
-    try setVariable(allocator, variables, args[0], args[1..]);
+    if (std.mem.eql(u8, args[args.len - 1], "PARENT_SCOPE")) {
+        // CMake only warns at the top level, where there is no parent.
+        const parent = scope.parent orelse return;
+        return context.setVariable(parent, args[0], args[1 .. args.len - 1]);
+    }
+    try context.setVariable(scope, args[0], args[1..]);
 }
 
 fn parseSetPropertyCommand(args: []const []const u8, cpp_standard: *project_mod.CppStandard) void {
@@ -1201,16 +1329,14 @@ fn parseTargetCompileFeatures(args: []const []const u8, cpp_standard: *project_m
 }
 
 fn parseTargetCommand(
-    allocator: std.mem.Allocator,
+    context: *CMakeParseContext,
     args: []const []const u8,
     default_kind: project_mod.TargetType,
-    targets: *std.ArrayList(CMakeTarget),
 ) !void {
     if (args.len == 0) return;
 
     const target_name = args[0];
-    const target_index = try findOrCreateTarget(allocator, targets, target_name, default_kind);
-    const target = &targets.items[target_index];
+    const target = try context.findOrCreateTarget(target_name, default_kind);
 
     var i: usize = 1;
     if (default_kind == .library_static or default_kind == .library_shared) {
@@ -1229,22 +1355,21 @@ fn parseTargetCommand(
             continue;
         }
         if (isLikelySourceToken(token)) {
-            try appendSplitTokenValues(allocator, &target.sources, token);
+            try appendSplitTokenValues(context, &target.sources, token);
         }
         i += 1;
     }
 
-    if (target.sources.items.len == 0 and
+    if (target.sources.items.items.len == 0 and
         (target.kind == .executable or target.kind == .test_target))
     {
-        try appendUnique(allocator, &target.sources, "src/main.cpp");
+        try target.sources.append(context.allocator, "src/main.cpp");
     }
 }
 
 fn parseAddLibraryCommand(
-    allocator: std.mem.Allocator,
+    context: *CMakeParseContext,
     args: []const []const u8,
-    targets: *std.ArrayList(CMakeTarget),
 ) !void {
     if (args.len < 2) return;
     const name = args[0];
@@ -1256,8 +1381,7 @@ fn parseAddLibraryCommand(
     }
     if (start_index == 1 and std.ascii.eqlIgnoreCase(args[1], "ALIAS")) return;
 
-    const target_index = try findOrCreateTarget(allocator, targets, name, kind);
-    const target = &targets.items[target_index];
+    const target = try context.findOrCreateTarget(name, kind);
     target.kind = kind;
 
     var i = start_index;
@@ -1268,21 +1392,19 @@ fn parseAddLibraryCommand(
             continue;
         }
         if (isLikelySourceToken(token)) {
-            try appendSplitTokenValues(allocator, &target.sources, token);
+            try appendSplitTokenValues(context, &target.sources, token);
         }
         i += 1;
     }
 }
 
 fn parseTargetSourcesCommand(
-    allocator: std.mem.Allocator,
+    context: *CMakeParseContext,
     args: []const []const u8,
-    targets: *std.ArrayList(CMakeTarget),
 ) !void {
     if (args.len < 1) return;
     const target_name = args[0];
-    const target_index = try findOrCreateTarget(allocator, targets, target_name, .executable);
-    const target = &targets.items[target_index];
+    const target = try context.findOrCreateTarget(target_name, .executable);
 
     var i: usize = 1;
     if (i < args.len and isScopeToken(args[i])) i += 1;
@@ -1293,128 +1415,81 @@ fn parseTargetSourcesCommand(
             continue;
         }
         if (isLikelySourceToken(token)) {
-            try appendSplitTokenValues(allocator, &target.sources, token);
+            try appendSplitTokenValues(context, &target.sources, token);
         }
         i += 1;
     }
 }
 
 fn parseTargetIncludeDirectoriesCommand(
-    allocator: std.mem.Allocator,
+    context: *CMakeParseContext,
     args: []const []const u8,
-    targets: *std.ArrayList(CMakeTarget),
 ) !void {
     if (args.len < 1) return;
     const target_name = args[0];
-    const target_index = try findOrCreateTarget(allocator, targets, target_name, .executable);
-    const target = &targets.items[target_index];
+    const target = try context.findOrCreateTarget(target_name, .executable);
 
     var i: usize = 1;
     while (i < args.len) : (i += 1) {
         const token = args[i];
         if (isScopeToken(token)) continue;
         if (isLikelyIncludeToken(token)) {
-            try appendSplitTokenValues(allocator, &target.include_dirs, token);
+            try appendSplitTokenValues(context, &target.include_dirs, token);
         }
     }
 }
 
 fn parseTargetLinkLibrariesCommand(
-    allocator: std.mem.Allocator,
+    context: *CMakeParseContext,
     args: []const []const u8,
-    targets: *std.ArrayList(CMakeTarget),
 ) !void {
     if (args.len < 1) return;
     const target_name = args[0];
-    const target_index = try findOrCreateTarget(allocator, targets, target_name, .executable);
-    const target = &targets.items[target_index];
+    const target = try context.findOrCreateTarget(target_name, .executable);
 
     var i: usize = 1;
     if (i < args.len and isScopeToken(args[i])) i += 1;
     while (i < args.len) : (i += 1) {
         const token = args[i];
         if (isIgnoredTargetToken(token)) continue;
-        if (token.len > 0) try appendSplitTokenValues(allocator, &target.link_libraries, token);
+        if (token.len > 0) try appendSplitTokenValues(context, &target.link_libraries, token);
     }
 }
 
 fn appendDirectoryList(
-    allocator: std.mem.Allocator,
-    target: *std.ArrayList([]const u8),
+    context: *CMakeParseContext,
+    target: *UniqueList,
     args: []const []const u8,
     skip: []const []const u8,
 ) !void {
     for (args) |token| {
         if (isKeyword(skip, token)) continue;
-        if (isLikelyIncludeToken(token)) try appendSplitTokenValues(allocator, target, token);
+        if (isLikelyIncludeToken(token)) try appendSplitTokenValues(context, target, token);
     }
 }
 
 fn appendSplitTokenValues(
-    allocator: std.mem.Allocator,
-    target: *std.ArrayList([]const u8),
+    context: *CMakeParseContext,
+    target: *UniqueList,
     token: []const u8,
 ) !void {
     var parts = std.mem.splitScalar(u8, token, ';');
     while (parts.next()) |part| {
         const value = trim(part);
         if (value.len == 0) continue;
-        try appendUnique(allocator, target, value);
-    }
-}
-
-fn findOrCreateTarget(
-    allocator: std.mem.Allocator,
-    targets: *std.ArrayList(CMakeTarget),
-    name: []const u8,
-    kind: project_mod.TargetType,
-) !usize {
-    if (findTargetIndex(targets, name)) |index| {
-        return index;
-    }
-
-    try targets.append(allocator, .{
-        .name = name,
-        .kind = kind,
-        .sources = .empty,
-        .include_dirs = .empty,
-        .link_libraries = .empty,
-    });
-
-    return targets.items.len - 1;
-}
-
-fn findTargetIndex(targets: *std.ArrayList(CMakeTarget), name: []const u8) ?usize {
-    for (targets.items, 0..) |target, index| {
-        if (std.mem.eql(u8, target.name, name)) return index;
-    }
-    return null;
-}
-
-fn appendUnique(
-    allocator: std.mem.Allocator,
-    target: *std.ArrayList([]const u8),
-    value: []const u8,
-) !void {
-    const owned = try allocator.dupe(u8, value);
-    for (target.items) |item| {
-        if (std.mem.eql(u8, item, value)) {
-            allocator.free(owned);
-            return;
-        }
+        try target.append(context.allocator, try context.intern(value));
     }
-    try target.append(allocator, owned);
 }
 
 fn mergeIncludeDirs(allocator: std.mem.Allocator, global_includes: []const []const u8, target_includes: []const []const u8) ![]const []const u8 {
-    var merged: std.ArrayList([]const u8) = .empty;
+    var merged: UniqueList = .{};
     for (global_includes) |include_dir| {
-        try appendUnique(allocator, &merged, include_dir);
+        try merged.append(allocator, include_dir);
     }
     for (target_includes) |include_dir| {
-        try appendUnique(allocator, &merged, include_dir);
+        try merged.append(allocator, include_dir);
     }
-    return try merged.toOwnedSlice(allocator);
+    return try merged.items.toOwnedSlice(allocator);
 }
 
 fn parseCppStandardFromToken(value: []const u8) ?project_mod.CppStandard {
@@ -1463,72 +1538,40 @@ fn parseTargetLibraryType(token: []const u8) ?project_mod.TargetType {
     return null;
 }
 
-fn setVariable(
-    allocator: std.mem.Allocator,
-    variables: *std.ArrayList(CMakeVariable),
-    key: []const u8,
-    values: []const []const u8,
-) !void {
-    for (variables.items, 0..) |*entry, index| {
-        if (std.mem.eql(u8, entry.name, key)) {
-            var stored_values: std.ArrayList([]const u8) = .empty;
-            for (values) |value| {
-                try stored_values.append(allocator, try allocator.dupe(u8, value));
-            }
-            variables.items[index].values = try stored_values.toOwnedSlice(allocator);
-            return;
-        }
-    }
-    var stored_values: std.ArrayList([]const u8) = .empty;
-    for (values) |value| {
-        try stored_values.append(allocator, try allocator.dupe(u8, value));
-    }
-    try variables.append(allocator, .{
-        .name = try allocator.dupe(u8, key),
-        .values = try stored_values.toOwnedSlice(allocator),
-    });
-}
-
-fn findVariable(variables: *std.ArrayList(CMakeVariable), key: []const u8) ?CMakeVariable {
-    for (variables.items) |entry| {
-        if (std.mem.eql(u8, entry.name, key)) return entry;
-    }
-    return null;
-}
-
+/// Plain tokens are passed through as they are; only interpolated ones are
+/// built, and those are interned.
 fn expandVariables(
-    allocator: std.mem.Allocator,
+    context: *CMakeParseContext,
     input: []const []const u8,
-    variables: *std.ArrayList(CMakeVariable),
+    scope: *const CMakeScope,
     output: *std.ArrayList([]const u8),
 ) !void {
     for (input) |token| {
         if (extractVariableName(token)) |name| {
-            if (findVariable(variables, name)) |entry| {
-                for (entry.values) |value| {
-                    try output.append(allocator, try allocator.dupe(u8, value));
-                }
+            if (scope.lookup(name)) |values| {
+                try output.appendSlice(context.allocator, values);
                 continue;
             }
         }
         if (token.len > 0) {
             if (std.mem.indexOf(u8, token, "${") == null) {
-                try output.append(allocator, try allocator.dupe(u8, token));
+                try output.append(context.allocator, token);
             } else {
-                try interpolateVariableToken(allocator, token, variables, output);
+                try interpolateVariableToken(context, token, scope, output);
             }
         }
     }
 }
 
 fn interpolateVariableToken(
-    allocator: std.mem.Allocator,
+    context: *CMakeParseContext,
     token: []const u8,
-    variables: *std.ArrayList(CMakeVariable),
+    scope: *const CMakeScope,
     output: *std.ArrayList([]const u8),
 ) !void {
-    var expanded: std.ArrayList(u8) = .empty;
-    defer expanded.deinit(allocator);
+    const allocator = context.allocator;
+    const expanded = &context.scratch;
+    expanded.clearRetainingCapacity();
 
     var i: usize = 0;
     var found_any = false;
@@ -1548,16 +1591,12 @@ fn interpolateVariableToken(
             break;
         };
         const name = token[abs_start + 2 .. abs_start + 2 + close];
-        if (findVariable(variables, name)) |entry| {
-            if (entry.values.len > 0) {
+        if (scope.lookup(name)) |values| {
+            if (values.len > 0) {
                 found_any = true;
-                if (entry.values.len == 1) {
-                    try expanded.appendSlice(allocator, entry.values[0]);
-                } else {
-                    for (entry.values, 0..) |value, index| {
-                        if (index > 0) try expanded.append(allocator, ' ');
-                        try expanded.appendSlice(allocator, value);
-                    }
+                for (values, 0..) |value, index| {
+                    if (index > 0) try expanded.append(allocator, ' ');
+                    try expanded.appendSlice(allocator, value);
                 }
             }
         } else {
@@ -1567,15 +1606,8 @@ fn interpolateVariableToken(
         i = abs_start + 2 + close + 1;
     }
 
-    const expanded_token = try expanded.toOwnedSlice(allocator);
-    if (expanded_token.len == 0) return;
-    if (found_any) {
-        try output.append(allocator, expanded_token);
-    } else {
-        try output.append(allocator, try allocator.dupe(u8, token));
-    }
-
-    return;
+    if (expanded.items.len == 0) return;
+    try output.append(allocator, if (found_any) try context.intern(expanded.items) else token);
 }
 
 fn extractVariableName(token: []const u8) ?[]const u8 {
@@ -1740,14 +1772,14 @@ test "variable expansion replaces defined variables" {
     defer arena.deinit();
     const alloc = arena.allocator();
 
-    var vars = std.ArrayList(CMakeVariable).empty;
-    defer vars.deinit(alloc);
-    try setVariable(alloc, &vars, "FOO", &.{ "one", "two" });
+    var context = CMakeParseContext{ .allocator = alloc, .parsed_project_name = "test", .arenas = try alloc.alloc(std.heap.ArenaAllocator, 0) };
+    var scope = CMakeScope{ .parent = null };
+    try context.setVariable(&scope, "FOO", &.{ "one", "two" });
 
     var input = [_][]const u8{ "${FOO}", "keep", "${MISSING}" };
     var output = std.ArrayList([]const u8).empty;
     defer output.deinit(alloc);
-    try expandVariables(alloc, &input, &vars, &output);
+    try expandVariables(&context, &input, &scope, &output);
 
     try std.testing.expectEqual(@as(usize, 4), output.items.len);
     try std.testing.expectEqualStrings("one", output.items[0]);
@@ -1829,3 +1861,34 @@ test "cmake variable list values split on semicolon" {
     try std.testing.expectEqualStrings("src/a.cpp", project.targets[0].sources[0]);
     try std.testing.expectEqualStrings("src/b.cpp", project.targets[0].sources[1]);
 }
+
+test "cmake subdirectories get their own variable scope" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const fixture = try std.fmt.allocPrint(alloc, "build/.tmp-ovo-cmake-import-scope-{d}", .{std.time.milliTimestamp()});
+    defer core.fs.removeTreeIfExists(fixture) catch {};
+
+    try core.fs.writeFile(try std.fmt.allocPrint(alloc, "{s}/CMakeLists.txt", .{fixture}),
+        \\project(Scoped)
+        \\add_subdirectory(lib)
+        \\add_executable(app main.cpp ${SHARED} ${LOCAL})
+    );
+    try core.fs.writeFile(try std.fmt.allocPrint(alloc, "{s}/lib/CMakeLists.txt", .{fixture}),
+        \\set(LOCAL local.cpp)
+        \\set(SHARED shared.cpp PARENT_SCOPE)
+        \\add_library(lib STATIC ${CMAKE_CURRENT_SOURCE_DIR}/${LOCAL})
+    );
+
+    const project = try importCMake(alloc, fixture);
+    try std.testing.expectEqual(@as(usize, 2), project.targets.len);
+    const lib = project.targets[0];
+    try std.testing.expectEqualStrings("lib", lib.name);
+    try std.testing.expectEqual(@as(usize, 1), lib.sources.len);
+    try std.testing.expectEqualStrings(try std.fmt.allocPrint(alloc, "{s}/lib/local.cpp", .{fixture}), lib.sources[0]);
+    const app = project.targets[1];
+    try std.testing.expectEqual(@as(usize, 2), app.sources.len);
+    try std.testing.expectEqualStrings("main.cpp", app.sources[0]);
+    try std.testing.expectEqualStrings("shared.cpp", app.sources[1]);
+}
@@ -0,0 +1,265 @@
+const std = @import("std");
+const tokenizer_mod = @import("tokenizer.zig");
+
+const Token = tokenizer_mod.Token;
+const Tokenizer = tokenizer_mod.Tokenizer;
+
+pub const Error = error{ InvalidZon, OutOfMemory };
+
+/// Where and why parsing failed. `message` is a static string.
+pub const Diagnostic = struct {
+    line: usize = 0,
+    column: usize = 0,
+    message: []const u8 = "",
+
+    pub fn set(self: *Diagnostic, source: []const u8, offset: usize, message: []const u8) void {
+        const loc = tokenizer_mod.location(source, offset);
+        self.* = .{ .line = loc.line, .column = loc.column, .message = message };
+    }
+};
+
+pub const Node = struct {
+    /// Byte offset of the value in the source, for diagnostics.
+    offset: usize,
+    value: Value,
+
+    pub const Value = union(enum) {
+        object: []const Field,
+        list: []const Node,
+        /// Unescaped contents; a slice of the source unless it had escapes.
+        string: []const u8,
+        /// Name without the leading `.`.
+        enum_literal: []const u8,
+        /// Source text; ZON consumers here never need the numeric value.
+        number: []const u8,
+        boolean: bool,
+        null_value,
+    };
+
+    /// Fields of a struct literal. `.{}` is both an empty struct and an empty tuple.
+    pub fn fields(self: Node) ?[]const Field {
+        return switch (self.value) {
+            .object => |object| object,
+            .list => |list| if (list.len == 0) &.{} else null,
+            else => null,
+        };
+    }
+
+    pub fn items(self: Node) ?[]const Node {
+        return switch (self.value) {
+            .list => |list| list,
+            .object => |object| if (object.len == 0) &.{} else null,
+            else => null,
+        };
+    }
+
+    /// First field called `name`; a linear scan, meant for small structs.
+    pub fn get(self: Node, name: []const u8) ?Node {
+        for (self.fields() orelse return null) |field| {
+            if (std.mem.eql(u8, field.name, name)) return field.value;
+        }
+        return null;
+    }
+};
+
+pub const Field = struct {
+    name: []const u8,
+    name_offset: usize,
+    value: Node,
+};
+
+/// Nesting deeper than this is rejected instead of risking the stack.
+pub const max_depth = 64;
+
+/// Parses `source` into a tree in one pass over the tokens. Allocations are
+/// owned by `allocator` (typically an arena). Empty input is an empty
+/// struct. On `error.InvalidZon`, `diagnostic` holds the location.
+pub fn parse(allocator: std.mem.Allocator, source: []const u8, diagnostic: ?*Diagnostic) Error!Node {
+    var parser = Parser{
+        .allocator = allocator,
+        .source = source,
+        .tokenizer = Tokenizer.init(source),
+        .token = undefined,
+        .diagnostic = diagnostic,
+    };
+    parser.advance();
+    if (parser.token.tag == .eof) return .{ .offset = 0, .value = .{ .object = &.{} } };
+    const root = try parser.parseValue();
+    if (parser.token.tag != .eof) return parser.fail(parser.token.start, "expected end of input");
+    return root;
+}
+
+const Parser = struct {
+    allocator: std.mem.Allocator,
+    source: []const u8,
+    tokenizer: Tokenizer,
+    token: Token,
+    diagnostic: ?*Diagnostic,
+    depth: usize = 0,
+
+    fn advance(self: *Parser) void {
+        self.token = self.tokenizer.next();
+    }
+
+    fn peek(self: *const Parser) Token {
+        var lookahead = self.tokenizer;
+        return lookahead.next();
+    }
+
+    fn fail(self: *Parser, offset: usize, message: []const u8) error{InvalidZon} {
+        if (self.diagnostic) |diagnostic| diagnostic.set(self.source, offset, message);
+        return error.InvalidZon;
+    }
+
+    fn parseValue(self: *Parser) Error!Node {
+        const token = self.token;
+        const value: Node.Value = switch (token.tag) {
+            .l_brace => return self.parseContainer(),
+            .string => .{ .string = try self.decodeString(token.start) },
+            .enum_literal => .{ .enum_literal = try self.enumName(token) },
+            .number => .{ .number = self.source[token.start..token.end] },
+            .identifier => blk: {
+                const word = self.source[token.start..token.end];
+                if (std.mem.eql(u8, word, "true")) break :blk .{ .boolean = true };
+                if (std.mem.eql(u8, word, "false")) break :blk .{ .boolean = false };
+                if (std.mem.eql(u8, word, "null")) break :blk .null_value;
+                return self.fail(token.start, "unexpected identifier; enum values need a leading '.'");
+            },
+            .invalid => return self.fail(token.start, invalidMessage(self.source[token.start])),
+            .eof => return self.fail(token.start, "unexpected end of input"),
+            .r_brace, .equal, .comma => return self.fail(token.start, "expected a value"),
+        };
+        self.advance();
+        return .{ .offset = token.start, .value = value };
+    }
+
+    fn parseContainer(self: *Parser) Error!Node {
+        const offset = self.token.start;
+        if (self.depth == max_depth) return self.fail(offset, "nesting is too deep");
+        self.depth += 1;
+        defer self.depth -= 1;
+        self.advance();
+
+        if (self.token.tag == .r_brace) {
+            self.advance();
+            return .{ .offset = offset, .value = .{ .object = &.{} } };
+        }
+        if (self.token.tag == .enum_literal and self.peek().tag == .equal) {
+            return .{ .offset = offset, .value = .{ .object = try self.parseFields() } };
+        }
+        return .{ .offset = offset, .value = .{ .list = try self.parseItems() } };
+    }
+
+    fn parseFields(self: *Parser) Error![]const Field {
+        var fields: std.ArrayList(Field) = .empty;
+        while (self.token.tag != .r_brace) {
+            if (self.token.tag != .enum_literal) return self.fail(self.token.start, "expected a field name like '.name'");
+            const name_token = self.token;
+            self.advance();
+            if (self.token.tag != .equal) return self.fail(self.token.start, "expected '=' after field name");
+            self.advance();
+            try fields.append(self.allocator, .{
+                .name = try self.enumName(name_token),
+                .name_offset = name_token.start,
+                .value = try self.parseValue(),
+            });
+            if (!try self.separator()) break;
+        }
+        self.advance();
+        return try fields.toOwnedSlice(self.allocator);
+    }
+
+    fn parseItems(self: *Parser) Error![]const Node {
+        var items: std.ArrayList(Node) = .empty;
+        while (self.token.tag != .r_brace) {
+            try items.append(self.allocator, try self.parseValue());
+            if (!try self.separator()) break;
+        }
+        self.advance();
+        return try items.toOwnedSlice(self.allocator);
+    }
+
+    /// Consumes a `,`; returns false when the container ends instead.
+    fn separator(self: *Parser) Error!bool {
+        switch (self.token.tag) {
+            .comma => {
+                self.advance();
+                return true;
+            },
+            .r_brace => return false,
+            .eof => return self.fail(self.token.start, "unterminated '.{'; expected '}'"),
+            else => return self.fail(self.token.start, "expected ',' or '}'"),
+        }
+    }
+
+    fn enumName(self: *Parser, token: Token) Error![]const u8 {
+        if (self.source[token.start + 1] == '@') return self.decodeString(token.start + 2);
+        return self.source[token.start + 1 .. token.end];
+    }
+
+    /// Decodes the string literal whose opening quote is at `quote`. The
+    /// tokenizer already found the closing quote, so only escapes are checked.
+    fn decodeString(self: *Parser, quote: usize) Error![]const u8 {
+        var end = quote + 1;
+        var escaped = false;
+        while (self.source[end] != '"') : (end += 1) {
+            if (self.source[end] == '\\') {
+                escaped = true;
+                end += 1;
+            }
+        }
+        const raw = self.source[quote + 1 .. end];
+        if (!escaped) return raw;
+
+        var out: std.ArrayList(u8) = try .initCapacity(self.allocator, raw.len);
+        var i: usize = 0;
+        while (i < raw.len) {
+            const c = raw[i];
+            if (c != '\\') {
+                out.appendAssumeCapacity(c);
+                i += 1;
+                continue;
+            }
+            const escape_offset = quote + 1 + i;
+            switch (raw[i + 1]) {
+                'n' => out.appendAssumeCapacity('\n'),
+                'r' => out.appendAssumeCapacity('\r'),
+                't' => out.appendAssumeCapacity('\t'),
+                '\\', '"', '\'' => |literal| out.appendAssumeCapacity(literal),
+                'x' => {
+                    if (i + 4 > raw.len) return self.fail(escape_offset, "invalid '\\x' escape");
+                    const byte = std.fmt.parseInt(u8, raw[i + 2 .. i + 4], 16) catch
+                        return self.fail(escape_offset, "invalid '\\x' escape");
+                    out.appendAssumeCapacity(byte);
+                    i += 4;
+                    continue;
+                },
+                'u' => {
+                    const close = std.mem.indexOfScalarPos(u8, raw, i, '}') orelse
+                        return self.fail(escape_offset, "invalid '\\u{...}' escape");
+                    if (i + 3 > close or raw[i + 2] != '{') return self.fail(escape_offset, "invalid '\\u{...}' escape");
+                    const codepoint = std.fmt.parseInt(u21, raw[i + 3 .. close], 16) catch
+                        return self.fail(escape_offset, "invalid '\\u{...}' escape");
+                    var buf: [4]u8 = undefined;
+                    const len = std.unicode.utf8Encode(codepoint, &buf) catch
+                        return self.fail(escape_offset, "invalid '\\u{...}' escape");
+                    // `\u{...}` is at least 5 bytes, longer than any UTF-8 sequence.
+                    out.appendSliceAssumeCapacity(buf[0..len]);
+                    i = close + 1;
+                    continue;
+                },
+                else => return self.fail(escape_offset, "invalid escape sequence"),
+            }
+            i += 2;
+        }
+        return try out.toOwnedSlice(self.allocator);
+    }
+};
+
+fn invalidMessage(c: u8) []const u8 {
+    return switch (c) {
+        '"' => "unterminated string",
+        '.' => "expected '{', a name or '@\"...\"' after '.'",
+        else => "unexpected character",
+    };
+}
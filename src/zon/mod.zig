@@ -1,3 +1,6 @@
 pub const schema = @import("schema.zig");
+pub const tokenizer = @import("tokenizer.zig");
+pub const ast = @import("ast.zig");
 pub const parser = @import("parser.zig");
 pub const writer = @import("writer.zig");
+pub const snapshot = @import("snapshot.zig");
@@ -1,238 +1,197 @@
 const std = @import("std");
+const core = @import("../core/mod.zig");
 const project_mod = @import("../core/project.zig");
+const ast = @import("ast.zig");
+
+pub const Diagnostic = ast.Diagnostic;
 
 pub fn parseBuildZon(allocator: std.mem.Allocator, bytes: []const u8) !project_mod.Project {
-    var project = project_mod.Project{
-        .ovo_schema = extractStringField(bytes, ".ovo_schema") orelse "0",
-        .name = extractStringField(bytes, ".name") orelse return error.MissingName,
-        .version = extractStringField(bytes, ".version") orelse return error.MissingVersion,
-        .license = extractStringField(bytes, ".license"),
-    };
+    return parseBuildZonDiagnostic(allocator, bytes, null);
+}
 
-    if (findObjectBlock(bytes, ".defaults")) |defaults_block| {
-        if (extractEnumField(defaults_block, ".cpp_standard")) |cpp| {
-            project.defaults.cpp_standard = project_mod.parseCppStandard(cpp) orelse project.defaults.cpp_standard;
+/// Like `parseBuildZonDiagnostic`, printing `path:line:column: error: ...`
+/// to stderr (the client, on the daemon) when `bytes` (read from `path`) is malformed.
+pub fn parseBuildZonReporting(allocator: std.mem.Allocator, path: []const u8, bytes: []const u8) !project_mod.Project {
+    var diagnostic: Diagnostic = .{};
+    return parseBuildZonDiagnostic(allocator, bytes, &diagnostic) catch |err| {
+        if (err == error.InvalidZon) {
+            core.runtime.printErr("{s}:{d}:{d}: error: {s}\n", .{ path, diagnostic.line, diagnostic.column, diagnostic.message });
         }
-        if (extractStringField(defaults_block, ".optimize")) |optimize| {
-            project.defaults.optimize = optimize;
-        }
-        if (extractStringField(defaults_block, ".backend")) |backend| {
-            project.defaults.backend = backend;
-        }
-        if (extractStringField(defaults_block, ".output_dir")) |out_dir| {
-            project.defaults.output_dir = out_dir;
+        return err;
+    };
+}
+
+/// Parses `build.zon` into a project. Only top-level fields are read, so a
+/// nested `.name` never shadows the project's. Unknown fields are ignored
+/// and unknown enum values fall back to the defaults; malformed input or a
+/// value of the wrong type is `error.InvalidZon`, located in `diagnostic`.
+pub fn parseBuildZonDiagnostic(
+    allocator: std.mem.Allocator,
+    bytes: []const u8,
+    diagnostic: ?*Diagnostic,
+) !project_mod.Project {
+    const root = try ast.parse(allocator, bytes, diagnostic);
+    var m = Mapper{ .source = bytes, .diagnostic = diagnostic };
+
+    var project = project_mod.Project{ .name = "", .version = "" };
+    var name: ?[]const u8 = null;
+    var version: ?[]const u8 = null;
+    for (try m.fields(root)) |field| {
+        if (std.mem.eql(u8, field.name, "ovo_schema")) {
+            project.ovo_schema = try m.string(field.value);
+        } else if (std.mem.eql(u8, field.name, "name")) {
+            name = try m.string(field.value);
+        } else if (std.mem.eql(u8, field.name, "version")) {
+            version = try m.string(field.value);
+        } else if (std.mem.eql(u8, field.name, "license")) {
+            project.license = try m.string(field.value);
+        } else if (std.mem.eql(u8, field.name, "defaults")) {
+            try m.defaults(&project.defaults, field.value);
+        } else if (std.mem.eql(u8, field.name, "targets")) {
+            project.targets = try m.targets(allocator, field.value);
+        } else if (std.mem.eql(u8, field.name, "dependencies")) {
+            project.dependencies = try m.dependencies(allocator, field.value);
         }
     }
-
-    project.targets = try parseTargets(allocator, bytes);
-    project.dependencies = try parseDependencies(allocator, bytes);
+    project.name = name orelse return error.MissingName;
+    project.version = version orelse return error.MissingVersion;
     return project;
 }
 
-fn parseTargets(allocator: std.mem.Allocator, bytes: []const u8) ![]const project_mod.Target {
-    const block = findObjectBlock(bytes, ".targets") orelse return &.{};
-    var targets: std.ArrayList(project_mod.Target) = .empty;
-    errdefer targets.deinit(allocator);
+/// Maps AST nodes onto `core.project` types, reporting type mismatches at
+/// the offending value.
+const Mapper = struct {
+    source: []const u8,
+    diagnostic: ?*Diagnostic,
 
-    var cursor: usize = 0;
-    while (findTopLevelEntryObject(block, &cursor)) |entry| {
-        var target = project_mod.Target{
-            .name = entry.name,
-            .kind = .executable,
-        };
-        if (extractEnumField(entry.body, ".type")) |kind| {
-            target.kind = project_mod.parseTargetType(kind) orelse .executable;
-        }
-        target.sources = try parseStringArray(allocator, entry.body, ".sources");
-        target.include_dirs = try parseStringArray(allocator, entry.body, ".include_dirs");
-        target.link_libraries = try parseStringArray(allocator, entry.body, ".link");
-        try targets.append(allocator, target);
+    fn fail(self: *Mapper, node: ast.Node, message: []const u8) error{InvalidZon} {
+        if (self.diagnostic) |diagnostic| diagnostic.set(self.source, node.offset, message);
+        return error.InvalidZon;
     }
 
-    return try targets.toOwnedSlice(allocator);
-}
-
-fn parseDependencies(allocator: std.mem.Allocator, bytes: []const u8) ![]const project_mod.Dependency {
-    const block = findObjectBlock(bytes, ".dependencies") orelse return &.{};
-    var deps: std.ArrayList(project_mod.Dependency) = .empty;
-    errdefer deps.deinit(allocator);
-
-    var i: usize = 0;
-    var depth: usize = 0;
-    while (i < block.len) : (i += 1) {
-        const c = block[i];
-        if (c == '"') {
-            i = skipQuoted(block, i);
-            continue;
-        }
-        if (c == '{') {
-            depth += 1;
-            continue;
-        }
-        if (c == '}') {
-            if (depth > 0) depth -= 1;
-            continue;
-        }
-        if (c != '.' or depth != 0) continue;
-
-        const name_start = i + 1;
-        var eq = std.mem.indexOfPos(u8, block, name_start, "=") orelse continue;
-        const raw_name = std.mem.trim(u8, block[name_start..eq], " \t\r\n");
-        eq += 1;
-        while (eq < block.len and (block[eq] == ' ' or block[eq] == '\t')) : (eq += 1) {}
-        if (eq >= block.len or block[eq] != '"') continue;
-        const end = findNextQuote(block, eq + 1) orelse continue;
-        const version = block[eq + 1 .. end];
-
-        try deps.append(allocator, .{
-            .name = raw_name,
-            .version = version,
-        });
-        i = end;
+    fn fields(self: *Mapper, node: ast.Node) ![]const ast.Field {
+        return node.fields() orelse return self.fail(node, "expected a struct literal '.{ .field = ... }'");
     }
 
-    return try deps.toOwnedSlice(allocator);
-}
-
-fn parseStringArray(
-    allocator: std.mem.Allocator,
-    bytes: []const u8,
-    field_name: []const u8,
-) ![]const []const u8 {
-    const block = findObjectBlock(bytes, field_name) orelse return &.{};
-    var values: std.ArrayList([]const u8) = .empty;
-    errdefer values.deinit(allocator);
-
-    var i: usize = 0;
-    while (i < block.len) : (i += 1) {
-        if (block[i] != '"') continue;
-        const end = findNextQuote(block, i + 1) orelse break;
-        try values.append(allocator, block[i + 1 .. end]);
-        i = end;
+    fn string(self: *Mapper, node: ast.Node) ![]const u8 {
+        return switch (node.value) {
+            .string => |value| value,
+            else => return self.fail(node, "expected a string"),
+        };
     }
-    return try values.toOwnedSlice(allocator);
-}
-
-const EntryObject = struct {
-    name: []const u8,
-    body: []const u8,
-};
 
-fn findTopLevelEntryObject(bytes: []const u8, cursor: *usize) ?EntryObject {
-    var i = cursor.*;
-    var depth: usize = 0;
-    while (i < bytes.len) : (i += 1) {
-        const c = bytes[i];
-        if (c == '"') {
-            i = skipQuoted(bytes, i);
-            continue;
-        }
-        if (c == '{') {
-            depth += 1;
-            continue;
-        }
-        if (c == '}') {
-            if (depth > 0) depth -= 1;
-            continue;
-        }
-        if (c != '.' or depth != 0) continue;
-
-        const name_start = i + 1;
-        const eq_index = std.mem.indexOfPos(u8, bytes, name_start, "=") orelse continue;
-        const name = std.mem.trim(u8, bytes[name_start..eq_index], " \t\r\n");
-        var after_eq = eq_index + 1;
-        while (after_eq < bytes.len and (bytes[after_eq] == ' ' or bytes[after_eq] == '\t')) : (after_eq += 1) {}
-        if (after_eq >= bytes.len or bytes[after_eq] != '.') continue;
-        after_eq += 1;
-        while (after_eq < bytes.len and (bytes[after_eq] == ' ' or bytes[after_eq] == '\t')) : (after_eq += 1) {}
-        if (after_eq >= bytes.len or bytes[after_eq] != '{') continue;
-        const close = findMatchingBrace(bytes, after_eq) orelse continue;
-        cursor.* = close + 1;
-        return .{
-            .name = name,
-            .body = bytes[after_eq + 1 .. close],
+    fn enumLiteral(self: *Mapper, node: ast.Node) ![]const u8 {
+        return switch (node.value) {
+            .enum_literal => |value| value,
+            else => return self.fail(node, "expected an enum literal like '.value'"),
         };
     }
-    cursor.* = i;
-    return null;
-}
 
-fn extractStringField(bytes: []const u8, field_name: []const u8) ?[]const u8 {
-    const field_start = std.mem.indexOf(u8, bytes, field_name) orelse return null;
-    const rest = bytes[field_start + field_name.len ..];
-    const first_quote_rel = std.mem.indexOfScalar(u8, rest, '"') orelse return null;
-    const quoted_tail = rest[first_quote_rel + 1 ..];
-    const second_quote_rel = std.mem.indexOfScalar(u8, quoted_tail, '"') orelse return null;
-    return quoted_tail[0..second_quote_rel];
-}
+    fn boolean(self: *Mapper, node: ast.Node) !bool {
+        return switch (node.value) {
+            .boolean => |value| value,
+            else => return self.fail(node, "expected true or false"),
+        };
+    }
 
-fn extractEnumField(bytes: []const u8, field_name: []const u8) ?[]const u8 {
-    const field_start = std.mem.indexOf(u8, bytes, field_name) orelse return null;
-    const rest = bytes[field_start + field_name.len ..];
-    const dot_rel = std.mem.indexOfScalar(u8, rest, '.') orelse return null;
-    const enum_start = dot_rel + 1;
-    var end = enum_start;
-    while (end < rest.len) : (end += 1) {
-        const c = rest[end];
-        if (!(std.ascii.isAlphanumeric(c) or c == '_')) break;
+    fn unsigned(self: *Mapper, comptime T: type, node: ast.Node) !T {
+        return switch (node.value) {
+            .number => |value| std.fmt.parseInt(T, value, 0) catch return self.fail(node, "expected a non-negative integer"),
+            else => return self.fail(node, "expected a non-negative integer"),
+        };
     }
-    if (end <= enum_start) return null;
-    return rest[enum_start..end];
-}
 
-fn findObjectBlock(bytes: []const u8, field_name: []const u8) ?[]const u8 {
-    const field_start = std.mem.indexOf(u8, bytes, field_name) orelse return null;
-    const rest = bytes[field_start + field_name.len ..];
-    const open_rel = std.mem.indexOfScalar(u8, rest, '{') orelse return null;
-    const open_idx = field_start + field_name.len + open_rel;
-    const close_idx = findMatchingBrace(bytes, open_idx) orelse return null;
-    if (close_idx <= open_idx) return null;
-    return bytes[open_idx + 1 .. close_idx];
-}
+    fn stringList(self: *Mapper, allocator: std.mem.Allocator, node: ast.Node) ![]const []const u8 {
+        const items = node.items() orelse return self.fail(node, "expected a list of strings '.{ \"...\" }'");
+        const values = try allocator.alloc([]const u8, items.len);
+        for (items, values) |item, *value| value.* = try self.string(item);
+        return values;
+    }
 
-fn findMatchingBrace(bytes: []const u8, open_idx: usize) ?usize {
-    var depth: usize = 0;
-    var i = open_idx;
-    while (i < bytes.len) : (i += 1) {
-        const c = bytes[i];
-        if (c == '"') {
-            i = skipQuoted(bytes, i);
-            continue;
-        }
-        if (c == '{') {
-            depth += 1;
-            continue;
-        }
-        if (c == '}') {
-            if (depth == 0) return null;
-            depth -= 1;
-            if (depth == 0) return i;
+    fn defaults(self: *Mapper, out: *project_mod.Defaults, node: ast.Node) !void {
+        for (try self.fields(node)) |field| {
+            if (std.mem.eql(u8, field.name, "cpp_standard")) {
+                const standard = try self.enumLiteral(field.value);
+                out.cpp_standard = project_mod.parseCppStandard(standard) orelse out.cpp_standard;
+            } else if (std.mem.eql(u8, field.name, "optimize")) {
+                out.optimize = try self.string(field.value);
+            } else if (std.mem.eql(u8, field.name, "backend")) {
+                out.backend = try self.string(field.value);
+            } else if (std.mem.eql(u8, field.name, "output_dir")) {
+                out.output_dir = try self.string(field.value);
+            } else if (std.mem.eql(u8, field.name, "remote_cache")) {
+                out.remote_cache = try self.remoteCache(field.value);
+            } else if (std.mem.eql(u8, field.name, "linker")) {
+                out.linker = project_mod.parseLinker(try self.enumLiteral(field.value)) orelse
+                    return self.fail(field.value, "expected .mold, .lld, .gold or .default");
+            }
         }
     }
-    return null;
-}
 
-fn skipQuoted(bytes: []const u8, quote_index: usize) usize {
-    if (bytes.len == 0) return 0;
-    var i = quote_index + 1;
-    while (i < bytes.len) : (i += 1) {
-        if (bytes[i] == '\\' and i + 1 < bytes.len) {
-            i += 1;
-            continue;
+    fn remoteCache(self: *Mapper, node: ast.Node) !?project_mod.RemoteCache {
+        _ = try self.fields(node);
+        const url_node = node.get("url") orelse return null;
+        var remote = project_mod.RemoteCache{ .url = try self.string(url_node) };
+        if (node.get("mode")) |mode| {
+            remote.mode = project_mod.parseRemoteCacheMode(try self.enumLiteral(mode)) orelse .read_only;
         }
-        if (bytes[i] == '"') return i;
+        return remote;
     }
-    return bytes.len - 1;
-}
 
-fn findNextQuote(bytes: []const u8, start: usize) ?usize {
-    var i = start;
-    while (i < bytes.len) : (i += 1) {
-        if (bytes[i] == '\\' and i + 1 < bytes.len) {
-            i += 1;
-            continue;
-        }
-        if (bytes[i] == '"') return i;
+    fn targets(self: *Mapper, allocator: std.mem.Allocator, node: ast.Node) ![]const project_mod.Target {
+        const entries = try self.fields(node);
+        const out = try allocator.alloc(project_mod.Target, entries.len);
+        for (entries, out) |entry, *target| {
+            target.* = .{ .name = entry.name };
+            for (try self.fields(entry.value)) |field| {
+                if (std.mem.eql(u8, field.name, "type")) {
+                    target.kind = project_mod.parseTargetType(try self.enumLiteral(field.value)) orelse .executable;
+                } else if (std.mem.eql(u8, field.name, "sources")) {
+                    target.sources = try self.stringList(allocator, field.value);
+                } else if (std.mem.eql(u8, field.name, "include_dirs")) {
+                    target.include_dirs = try self.stringList(allocator, field.value);
+                } else if (std.mem.eql(u8, field.name, "link")) {
+                    target.link_libraries = try self.stringList(allocator, field.value);
+                } else if (std.mem.eql(u8, field.name, "pch")) {
+                    target.pch = try self.string(field.value);
+                } else if (std.mem.eql(u8, field.name, "unity")) {
+                    target.unity = try self.boolean(field.value);
+                } else if (std.mem.eql(u8, field.name, "unity_batch")) {
+                    target.unity_batch = try self.unsigned(u32, field.value);
+                } else if (std.mem.eql(u8, field.name, "unity_exclude")) {
+                    target.unity_exclude = try self.stringList(allocator, field.value);
+                } else if (std.mem.eql(u8, field.name, "lto")) {
+                    target.lto = project_mod.parseLto(try self.enumLiteral(field.value)) orelse
+                        return self.fail(field.value, "expected .thin or .full");
+                } else if (std.mem.eql(u8, field.name, "pgo_train")) {
+                    target.pgo_train = try self.stringList(allocator, field.value);
+                }
+            }
+        }
+        return out;
     }
-    return null;
-}
+
+    fn dependencies(self: *Mapper, allocator: std.mem.Allocator, node: ast.Node) ![]const project_mod.Dependency {
+        const entries = try self.fields(node);
+        const out = try allocator.alloc(project_mod.Dependency, entries.len);
+        for (entries, out) |entry, *dep| {
+            dep.* = .{ .name = entry.name };
+            if (entry.value.value == .string) {
+                dep.version = try self.string(entry.value);
+                continue;
+            }
+            for (try self.fields(entry.value)) |field| {
+                if (std.mem.eql(u8, field.name, "version")) {
+                    dep.version = try self.string(field.value);
+                } else if (std.mem.eql(u8, field.name, "url")) {
+                    dep.url = try self.string(field.value);
+                } else if (std.mem.eql(u8, field.name, "hash")) {
+                    const hash = try self.string(field.value);
+                    if (!project_mod.isSha256Hex(hash)) return self.fail(field.value, "expected a sha256 of 64 lowercase hex digits");
+                    dep.hash = hash;
+                }
+            }
+        }
+        return out;
+    }
+};
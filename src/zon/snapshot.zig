@@ -0,0 +1,286 @@
+const std = @import("std");
+const core = @import("../core/mod.zig");
+const project_mod = @import("../core/project.zig");
+const version = @import("../version.zig");
+const parser = @import("parser.zig");
+
+const Sha256 = std.crypto.hash.sha2.Sha256;
+pub const Digest = [Sha256.digest_length]u8;
+
+pub const zon_path = "build.zon";
+pub const default_path = ".ovo/project.snapshot";
+
+const magic = "OVOSNAP6";
+
+// Layout (integers little-endian, strings as u32 length + bytes):
+//   magic[8] zon_digest[32] zon_size:u64 zon_mtime_ns:i128 ovo_version
+//   target_count:u32 list_item_count:u32 dependency_count:u32
+//   ovo_schema name version has_license:u8 [license]
+//   cpp_standard optimize backend output_dir has_remote:u8 [url mode] has_linker:u8 [linker]
+//   targets:      target_count * { name kind 5 * (count:u32 strings) has_pch:u8 [pch]
+//                                  unity:u8 has_unity_batch:u8 [unity_batch:u32]
+//                                  has_lto:u8 [lto] }
+//   dependencies: dependency_count * { name version has_url:u8 [url] has_hash:u8 [hash] }
+// Enums are stored by their build.zon labels. Strings are sliced straight
+// out of the snapshot buffer and every list shares one allocation, so
+// loading costs a single read plus two allocations.
+
+/// Identifies the `build.zon` a snapshot was taken from. The mtime and size
+/// are a fast path; the digest decides when they disagree.
+pub const Key = struct {
+    digest: Digest,
+    size: u64,
+    mtime_ns: i128,
+};
+
+/// Returns the project described by `build.zon`, from the snapshot when it
+/// matches the file and this ovo version, otherwise by parsing and then
+/// refreshing the snapshot. An unchanged `build.zon` is never read.
+pub fn loadProject(allocator: std.mem.Allocator) !project_mod.Project {
+    return loadProjectAt(allocator, zon_path, default_path);
+}
+
+pub fn loadProjectAt(allocator: std.mem.Allocator, path: []const u8, snapshot_path: []const u8) !project_mod.Project {
+    const stat = try core.fs.fingerprint(path);
+    const snapshot_bytes: ?[]const u8 = core.fs.readFileAllocUnlimited(allocator, snapshot_path) catch null;
+    const stored: ?Key = if (snapshot_bytes) |bytes| readKey(bytes) catch null else null;
+
+    if (stored) |key| {
+        if (key.size == stat.size and key.mtime_ns == stat.mtime_ns) {
+            if (deserialize(allocator, snapshot_bytes.?)) |project| return project else |_| {}
+        }
+    }
+
+    const bytes = try core.fs.readFileAllocUnlimited(allocator, path);
+    const key = Key{ .digest = digestOf(bytes), .size = stat.size, .mtime_ns = stat.mtime_ns };
+    if (stored) |old| {
+        // Touched but unchanged: keep the snapshot and record the new stat.
+        if (std.mem.eql(u8, &old.digest, &key.digest)) {
+            if (deserialize(allocator, snapshot_bytes.?)) |project| {
+                const rekeyed = try allocator.dupe(u8, snapshot_bytes.?);
+                writeKey(rekeyed, key);
+                save(allocator, snapshot_path, rekeyed);
+                return project;
+            } else |_| {}
+        }
+    }
+
+    const project = try parser.parseBuildZonReporting(allocator, path, bytes);
+    if (serialize(allocator, project, key)) |rendered| {
+        save(allocator, snapshot_path, rendered);
+    } else |_| {}
+    return project;
+}
+
+/// Snapshots `project` as the parse of `zon_bytes`, which the caller has just
+/// written to `build.zon` from it, so the next load skips parsing.
+pub fn storeProject(allocator: std.mem.Allocator, project: project_mod.Project, zon_bytes: []const u8) void {
+    const stat = core.fs.fingerprint(zon_path) catch return;
+    const key = Key{ .digest = digestOf(zon_bytes), .size = stat.size, .mtime_ns = stat.mtime_ns };
+    const rendered = serialize(allocator, project, key) catch return;
+    defer allocator.free(rendered);
+    save(allocator, default_path, rendered);
+}
+
+pub fn digestOf(bytes: []const u8) Digest {
+    var digest: Digest = undefined;
+    Sha256.hash(bytes, &digest, .{});
+    return digest;
+}
+
+/// Best effort: a read-only checkout or a racing writer only costs a re-parse.
+fn save(allocator: std.mem.Allocator, snapshot_path: []const u8, bytes: []const u8) void {
+    const tmp_path = std.fmt.allocPrint(allocator, "{s}.tmp", .{snapshot_path}) catch return;
+    defer allocator.free(tmp_path);
+    core.fs.writeFile(tmp_path, bytes) catch return;
+    core.fs.renameFile(tmp_path, snapshot_path) catch {
+        core.fs.deleteFileIfExists(tmp_path) catch {};
+    };
+}
+
+const key_offset = magic.len;
+const key_len = @sizeOf(Digest) + 8 + 16;
+
+/// Reads the header, rejecting snapshots from another format or ovo version.
+pub fn readKey(bytes: []const u8) !Key {
+    var reader = Reader{ .bytes = bytes };
+    if (!std.mem.eql(u8, try reader.take(magic.len), magic)) return error.InvalidSnapshot;
+    const key = Key{
+        .digest = (try reader.take(@sizeOf(Digest)))[0..@sizeOf(Digest)].*,
+        .size = std.mem.readInt(u64, (try reader.take(8))[0..8], .little),
+        .mtime_ns = std.mem.readInt(i128, (try reader.take(16))[0..16], .little),
+    };
+    if (!std.mem.eql(u8, try reader.string(), version.string)) return error.InvalidSnapshot;
+    return key;
+}
+
+fn writeKey(bytes: []u8, key: Key) void {
+    const out = bytes[key_offset..][0..key_len];
+    out[0..@sizeOf(Digest)].* = key.digest;
+    std.mem.writeInt(u64, out[@sizeOf(Digest)..][0..8], key.size, .little);
+    std.mem.writeInt(i128, out[@sizeOf(Digest) + 8 ..][0..16], key.mtime_ns, .little);
+}
+
+pub fn serialize(allocator: std.mem.Allocator, project: project_mod.Project, key: Key) ![]u8 {
+    var out: std.ArrayList(u8) = .empty;
+    errdefer out.deinit(allocator);
+    try out.appendSlice(allocator, magic);
+    try out.appendNTimes(allocator, 0, key_len);
+    writeKey(out.items, key);
+    try appendString(allocator, &out, version.string);
+
+    var list_items: usize = 0;
+    for (project.targets) |target| {
+        list_items += target.sources.len + target.include_dirs.len + target.link_libraries.len + target.unity_exclude.len + target.pgo_train.len;
+    }
+    try appendU32(allocator, &out, project.targets.len);
+    try appendU32(allocator, &out, list_items);
+    try appendU32(allocator, &out, project.dependencies.len);
+
+    try appendString(allocator, &out, project.ovo_schema);
+    try appendString(allocator, &out, project.name);
+    try appendString(allocator, &out, project.version);
+    try out.append(allocator, @intFromBool(project.license != null));
+    if (project.license) |license| try appendString(allocator, &out, license);
+
+    const defaults = project.defaults;
+    try appendString(allocator, &out, project_mod.cppStandardLabel(defaults.cpp_standard));
+    try appendString(allocator, &out, defaults.optimize);
+    try appendString(allocator, &out, defaults.backend);
+    try appendString(allocator, &out, defaults.output_dir);
+    try out.append(allocator, @intFromBool(defaults.remote_cache != null));
+    if (defaults.remote_cache) |remote| {
+        try appendString(allocator, &out, remote.url);
+        try appendString(allocator, &out, project_mod.remoteCacheModeLabel(remote.mode));
+    }
+    try out.append(allocator, @intFromBool(defaults.linker != null));
+    if (defaults.linker) |linker| try appendString(allocator, &out, project_mod.linkerLabel(linker));
+
+    for (project.targets) |target| {
+        try appendString(allocator, &out, target.name);
+        try appendString(allocator, &out, project_mod.targetTypeLabel(target.kind));
+        for ([_][]const []const u8{ target.sources, target.include_dirs, target.link_libraries, target.unity_exclude, target.pgo_train }) |list| {
+            try appendU32(allocator, &out, list.len);
+            for (list) |item| try appendString(allocator, &out, item);
+        }
+        try out.append(allocator, @intFromBool(target.pch != null));
+        if (target.pch) |pch| try appendString(allocator, &out, pch);
+        try out.append(allocator, @intFromBool(target.unity));
+        try out.append(allocator, @intFromBool(target.unity_batch != null));
+        if (target.unity_batch) |size| try appendU32(allocator, &out, size);
+        try out.append(allocator, @intFromBool(target.lto != null));
+        if (target.lto) |mode| try appendString(allocator, &out, project_mod.ltoLabel(mode));
+    }
+    for (project.dependencies) |dep| {
+        try appendString(allocator, &out, dep.name);
+        try appendString(allocator, &out, dep.version);
+        try out.append(allocator, @intFromBool(dep.url != null));
+        if (dep.url) |url| try appendString(allocator, &out, url);
+        try out.append(allocator, @intFromBool(dep.hash != null));
+        if (dep.hash) |hash| try appendString(allocator, &out, hash);
+    }
+    return try out.toOwnedSlice(allocator);
+}
+
+/// Rebuilds the project from `bytes`, which must outlive it: every string
+/// in the result is a slice of the snapshot.
+pub fn deserialize(allocator: std.mem.Allocator, bytes: []const u8) !project_mod.Project {
+    _ = try readKey(bytes);
+    var reader = Reader{ .bytes = bytes, .index = key_offset + key_len };
+    _ = try reader.string();
+
+    const target_count = try reader.int();
+    const list_item_count = try reader.int();
+    const dependency_count = try reader.int();
+    // Each entry takes at least four bytes, so counts beyond that are corrupt
+    // and must not drive an allocation.
+    if (@as(u64, target_count) + list_item_count + dependency_count > bytes.len / 4) return error.InvalidSnapshot;
+
+    var project = project_mod.Project{
+        .ovo_schema = try reader.string(),
+        .name = try reader.string(),
+        .version = try reader.string(),
+    };
+    if (try reader.flag()) project.license = try reader.string();
+
+    project.defaults.cpp_standard = project_mod.parseCppStandard(try reader.string()) orelse return error.InvalidSnapshot;
+    project.defaults.optimize = try reader.string();
+    project.defaults.backend = try reader.string();
+    project.defaults.output_dir = try reader.string();
+    if (try reader.flag()) {
+        project.defaults.remote_cache = .{
+            .url = try reader.string(),
+            .mode = project_mod.parseRemoteCacheMode(try reader.string()) orelse return error.InvalidSnapshot,
+        };
+    }
+    if (try reader.flag()) project.defaults.linker = project_mod.parseLinker(try reader.string()) orelse return error.InvalidSnapshot;
+
+    const targets = try allocator.alloc(project_mod.Target, target_count);
+    const list_items = try allocator.alloc([]const u8, list_item_count);
+    var next_item: usize = 0;
+    for (targets) |*target| {
+        target.* = .{
+            .name = try reader.string(),
+            .kind = project_mod.parseTargetType(try reader.string()) orelse return error.InvalidSnapshot,
+        };
+        for ([_]*[]const []const u8{ &target.sources, &target.include_dirs, &target.link_libraries, &target.unity_exclude, &target.pgo_train }) |list| {
+            const len = try reader.int();
+            if (len > list_items.len - next_item) return error.InvalidSnapshot;
+            const items = list_items[next_item..][0..len];
+            for (items) |*item| item.* = try reader.string();
+            next_item += len;
+            list.* = items;
+        }
+        if (try reader.flag()) target.pch = try reader.string();
+        target.unity = try reader.flag();
+        if (try reader.flag()) target.unity_batch = try reader.int();
+        if (try reader.flag()) target.lto = project_mod.parseLto(try reader.string()) orelse return error.InvalidSnapshot;
+    }
+    if (next_item != list_items.len) return error.InvalidSnapshot;
+
+    const dependencies = try allocator.alloc(project_mod.Dependency, dependency_count);
+    for (dependencies) |*dep| {
+        dep.* = .{ .name = try reader.string(), .version = try reader.string() };
+        if (try reader.flag()) dep.url = try reader.string();
+        if (try reader.flag()) dep.hash = try reader.string();
+    }
+    if (reader.index != bytes.len) return error.InvalidSnapshot;
+
+    project.targets = targets;
+    project.dependencies = dependencies;
+    return project;
+}
+
+const Reader = struct {
+    bytes: []const u8,
+    index: usize = 0,
+
+    fn take(self: *Reader, len: usize) ![]const u8 {
+        if (len > self.bytes.len - self.index) return error.InvalidSnapshot;
+        defer self.index += len;
+        return self.bytes[self.index..][0..len];
+    }
+
+    fn int(self: *Reader) !u32 {
+        return std.mem.readInt(u32, (try self.take(4))[0..4], .little);
+    }
+
+    fn flag(self: *Reader) !bool {
+        return (try self.take(1))[0] != 0;
+    }
+
+    fn string(self: *Reader) ![]const u8 {
+        return self.take(try self.int());
+    }
+};
+
+fn appendU32(allocator: std.mem.Allocator, out: *std.ArrayList(u8), value: usize) !void {
+    var buf: [4]u8 = undefined;
+    std.mem.writeInt(u32, &buf, @intCast(value), .little);
+    try out.appendSlice(allocator, &buf);
+}
+
+fn appendString(allocator: std.mem.Allocator, out: *std.ArrayList(u8), value: []const u8) !void {
+    try appendU32(allocator, out, value.len);
+    try out.appendSlice(allocator, value);
+}
@@ -0,0 +1,156 @@
+const std = @import("std");
+
+pub const Token = struct {
+    tag: Tag,
+    /// Byte range in the source, including quotes and the leading `.` of
+    /// enum literals.
+    start: usize,
+    end: usize,
+
+    pub const Tag = enum {
+        /// `.{`, opening either a struct or a tuple literal.
+        l_brace,
+        r_brace,
+        /// `.name` or `.@"quoted name"`.
+        enum_literal,
+        /// `true`, `false`, `null` or any other bare word.
+        identifier,
+        string,
+        number,
+        equal,
+        comma,
+        eof,
+        invalid,
+    };
+};
+
+/// Splits ZON source into tokens in a single forward pass, skipping
+/// whitespace and `//` comments. Copying the struct is a free lookahead.
+pub const Tokenizer = struct {
+    source: []const u8,
+    index: usize = 0,
+
+    pub fn init(source: []const u8) Tokenizer {
+        return .{ .source = source };
+    }
+
+    pub fn next(self: *Tokenizer) Token {
+        self.skipTrivia();
+        const start = self.index;
+        if (start >= self.source.len) return .{ .tag = .eof, .start = start, .end = start };
+
+        const c = self.source[start];
+        self.index += 1;
+        const tag: Token.Tag = switch (c) {
+            '}' => .r_brace,
+            '=' => .equal,
+            ',' => .comma,
+            '"' => if (self.skipString()) .string else .invalid,
+            '.' => self.dotted(),
+            '-', '0'...'9' => self.numberTail(c),
+            'a'...'z', 'A'...'Z', '_' => blk: {
+                self.skipIdentifier();
+                break :blk .identifier;
+            },
+            else => .invalid,
+        };
+        return .{ .tag = tag, .start = start, .end = self.index };
+    }
+
+    fn dotted(self: *Tokenizer) Token.Tag {
+        if (self.index >= self.source.len) return .invalid;
+        switch (self.source[self.index]) {
+            '{' => {
+                self.index += 1;
+                return .l_brace;
+            },
+            '@' => {
+                self.index += 1;
+                if (self.index >= self.source.len or self.source[self.index] != '"') return .invalid;
+                self.index += 1;
+                return if (self.skipString()) .enum_literal else .invalid;
+            },
+            'a'...'z', 'A'...'Z', '_' => {
+                self.skipIdentifier();
+                return .enum_literal;
+            },
+            else => return .invalid,
+        }
+    }
+
+    /// Advances past the closing quote; false when the string is unterminated
+    /// on its line.
+    fn skipString(self: *Tokenizer) bool {
+        while (self.index < self.source.len) : (self.index += 1) {
+            switch (self.source[self.index]) {
+                '"' => {
+                    self.index += 1;
+                    return true;
+                },
+                '\\' => if (self.index + 1 < self.source.len and self.source[self.index + 1] != '\n') {
+                    self.index += 1;
+                },
+                '\n' => return false,
+                else => {},
+            }
+        }
+        return false;
+    }
+
+    // Bare names also accept `-`, which is not valid Zig, so files written
+    // before names were quoted (`.my-app = ...`) keep parsing.
+    fn skipIdentifier(self: *Tokenizer) void {
+        while (self.index < self.source.len) : (self.index += 1) {
+            const c = self.source[self.index];
+            if (!(std.ascii.isAlphanumeric(c) or c == '_' or c == '-')) break;
+        }
+    }
+
+    fn numberTail(self: *Tokenizer, first: u8) Token.Tag {
+        if (first == '-' and (self.index >= self.source.len or !std.ascii.isDigit(self.source[self.index]))) {
+            return .invalid;
+        }
+        while (self.index < self.source.len) : (self.index += 1) {
+            const c = self.source[self.index];
+            if (std.ascii.isAlphanumeric(c) or c == '_' or c == '.') continue;
+            const prev = self.source[self.index - 1];
+            if ((c == '+' or c == '-') and (prev == 'e' or prev == 'E' or prev == 'p' or prev == 'P')) continue;
+            break;
+        }
+        return .number;
+    }
+
+    fn skipTrivia(self: *Tokenizer) void {
+        while (self.index < self.source.len) {
+            switch (self.source[self.index]) {
+                ' ', '\t', '\r', '\n' => self.index += 1,
+                '/' => {
+                    if (self.index + 1 >= self.source.len or self.source[self.index + 1] != '/') return;
+                    while (self.index < self.source.len and self.source[self.index] != '\n') : (self.index += 1) {}
+                },
+                else => return,
+            }
+        }
+    }
+};
+
+pub const Location = struct {
+    line: usize,
+    column: usize,
+};
+
+/// 1-based line and column of `offset`. Only computed when reporting an
+/// error, so the happy path never counts lines.
+pub fn location(source: []const u8, offset: usize) Location {
+    const end = @min(offset, source.len);
+    var loc = Location{ .line = 1, .column = 1 };
+    for (source[0..end]) |c| {
+        if (c == '\n') {
+            loc.line += 1;
+            loc.column = 1;
+        } else {
+            loc.column += 1;
+        }
+    }
+    return loc;
+}
@@ -6,49 +6,133 @@ pub fn renderBuildZon(allocator: std.mem.Allocator, project: project_mod.Project
     errdefer output.deinit(allocator);
 
     try output.appendSlice(allocator, ".{\n");
-    try output.print(allocator, "    .ovo_schema = \"{s}\",\n", .{project.ovo_schema});
-    try output.print(allocator, "    .name = \"{s}\",\n", .{project.name});
-    try output.print(allocator, "    .version = \"{s}\",\n", .{project.version});
+    try output.print(allocator, "    .ovo_schema = {f},\n", .{zonString(project.ovo_schema)});
+    try output.print(allocator, "    .name = {f},\n", .{zonString(project.name)});
+    try output.print(allocator, "    .version = {f},\n", .{zonString(project.version)});
     if (project.license) |license| {
-        try output.print(allocator, "    .license = \"{s}\",\n", .{license});
+        try output.print(allocator, "    .license = {f},\n", .{zonString(license)});
     }
 
     try output.appendSlice(allocator, "    .defaults = .{\n");
     try output.print(allocator, "        .cpp_standard = .{s},\n", .{project_mod.cppStandardLabel(project.defaults.cpp_standard)});
-    try output.print(allocator, "        .optimize = \"{s}\",\n", .{project.defaults.optimize});
-    try output.print(allocator, "        .backend = \"{s}\",\n", .{project.defaults.backend});
-    try output.print(allocator, "        .output_dir = \"{s}\",\n", .{project.defaults.output_dir});
+    try output.print(allocator, "        .optimize = {f},\n", .{zonString(project.defaults.optimize)});
+    try output.print(allocator, "        .backend = {f},\n", .{zonString(project.defaults.backend)});
+    try output.print(allocator, "        .output_dir = {f},\n", .{zonString(project.defaults.output_dir)});
+    if (project.defaults.remote_cache) |remote| {
+        try output.appendSlice(allocator, "        .remote_cache = .{\n");
+        try output.print(allocator, "            .url = {f},\n", .{zonString(remote.url)});
+        try output.print(allocator, "            .mode = .{s},\n", .{project_mod.remoteCacheModeLabel(remote.mode)});
+        try output.appendSlice(allocator, "        },\n");
+    }
+    if (project.defaults.linker) |linker| {
+        try output.print(allocator, "        .linker = .{s},\n", .{project_mod.linkerLabel(linker)});
+    }
     try output.appendSlice(allocator, "    },\n");
 
     try output.appendSlice(allocator, "    .targets = .{\n");
     for (project.targets) |target| {
-        try output.print(allocator, "        .{s} = .{{\n", .{target.name});
+        try output.print(allocator, "        {f} = .{{\n", .{zonName(target.name)});
         try output.print(allocator, "            .type = .{s},\n", .{project_mod.targetTypeLabel(target.kind)});
         try output.appendSlice(allocator, "            .sources = .{\n");
         for (target.sources) |source| {
-            try output.print(allocator, "                \"{s}\",\n", .{source});
+            try output.print(allocator, "                {f},\n", .{zonString(source)});
         }
         try output.appendSlice(allocator, "            },\n");
         try output.appendSlice(allocator, "            .include_dirs = .{\n");
         for (target.include_dirs) |include_dir| {
-            try output.print(allocator, "                \"{s}\",\n", .{include_dir});
+            try output.print(allocator, "                {f},\n", .{zonString(include_dir)});
         }
         try output.appendSlice(allocator, "            },\n");
         try output.appendSlice(allocator, "            .link = .{\n");
         for (target.link_libraries) |lib| {
-            try output.print(allocator, "                \"{s}\",\n", .{lib});
+            try output.print(allocator, "                {f},\n", .{zonString(lib)});
         }
         try output.appendSlice(allocator, "            },\n");
+        if (target.pch) |pch| try output.print(allocator, "            .pch = {f},\n", .{zonString(pch)});
+        if (target.unity) try output.appendSlice(allocator, "            .unity = true,\n");
+        if (target.unity_batch) |size| try output.print(allocator, "            .unity_batch = {d},\n", .{size});
+        if (target.unity_exclude.len > 0) {
+            try output.appendSlice(allocator, "            .unity_exclude = .{\n");
+            for (target.unity_exclude) |pattern| {
+                try output.print(allocator, "                {f},\n", .{zonString(pattern)});
+            }
+            try output.appendSlice(allocator, "            },\n");
+        }
+        if (target.lto) |mode| try output.print(allocator, "            .lto = .{s},\n", .{project_mod.ltoLabel(mode)});
+        if (target.pgo_train.len > 0) {
+            try output.appendSlice(allocator, "            .pgo_train = .{\n");
+            for (target.pgo_train) |arg| {
+                try output.print(allocator, "                {f},\n", .{zonString(arg)});
+            }
+            try output.appendSlice(allocator, "            },\n");
+        }
         try output.appendSlice(allocator, "        },\n");
     }
     try output.appendSlice(allocator, "    },\n");
 
     try output.appendSlice(allocator, "    .dependencies = .{\n");
     for (project.dependencies) |dep| {
-        try output.print(allocator, "        .{s} = \"{s}\",\n", .{ dep.name, dep.version });
+        if (!dep.hasSource()) {
+            try output.print(allocator, "        {f} = {f},\n", .{ zonName(dep.name), zonString(dep.version) });
+            continue;
+        }
+        try output.print(allocator, "        {f} = .{{\n", .{zonName(dep.name)});
+        try output.print(allocator, "            .version = {f},\n", .{zonString(dep.version)});
+        if (dep.url) |url| try output.print(allocator, "            .url = {f},\n", .{zonString(url)});
+        if (dep.hash) |hash| try output.print(allocator, "            .hash = {f},\n", .{zonString(hash)});
+        try output.appendSlice(allocator, "        },\n");
     }
     try output.appendSlice(allocator, "    },\n");
     try output.appendSlice(allocator, "}\n");
 
     return try output.toOwnedSlice(allocator);
 }
+
+/// Formats a string literal, escaping quotes, backslashes and control bytes.
+pub fn zonString(bytes: []const u8) ZonString {
+    return .{ .bytes = bytes };
+}
+
+/// Formats a field name, quoting it as `.@"..."` unless it is a plain identifier.
+pub fn zonName(name: []const u8) ZonName {
+    return .{ .name = name };
+}
+
+const ZonString = struct {
+    bytes: []const u8,
+
+    pub fn format(self: ZonString, w: *std.Io.Writer) std.Io.Writer.Error!void {
+        try w.writeByte('"');
+        for (self.bytes) |c| {
+            switch (c) {
+                '"' => try w.writeAll("\\\""),
+                '\\' => try w.writeAll("\\\\"),
+                '\n' => try w.writeAll("\\n"),
+                '\r' => try w.writeAll("\\r"),
+                '\t' => try w.writeAll("\\t"),
+                0...0x08, 0x0b, 0x0c, 0x0e...0x1f, 0x7f => try w.print("\\x{x:0>2}", .{c}),
+                else => try w.writeByte(c),
+            }
+        }
+        try w.writeByte('"');
+    }
+};
+
+const ZonName = struct {
+    name: []const u8,
+
+    pub fn format(self: ZonName, w: *std.Io.Writer) std.Io.Writer.Error!void {
+        try w.writeByte('.');
+        if (isBareName(self.name)) return w.writeAll(self.name);
+        try w.writeByte('@');
+        try zonString(self.name).format(w);
+    }
+};
+
+fn isBareName(name: []const u8) bool {
+    if (name.len == 0 or std.ascii.isDigit(name[0])) return false;
+    for (name) |c| {
+        if (!(std.ascii.isAlphanumeric(c) or c == '_')) return false;
+    }
+    return true;
+}
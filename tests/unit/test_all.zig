@@ -4,14 +4,41 @@ const registry = ovo.cli_registry;
 const dispatch = ovo.cli_dispatch;
 const parser = ovo.zon_parser;
 const writer = ovo.zon_writer;
+const zon_ast = ovo.zon_ast;
+const zon_snapshot = ovo.zon_snapshot;
 const neural = ovo.neural;
 const compiler = ovo.compiler;
 const orchestrator = ovo.build_orchestrator;
+const build_manifest = ovo.build_manifest;
+const build_depfile = ovo.build_depfile;
+const build_dep_db = ovo.build_dep_db;
+const object_cache = ovo.build_object_cache;
+const remote_cache = ovo.build_remote_cache;
+const target_graph = ovo.build_target_graph;
+const build_glob = ovo.build_glob;
+const build_watch = ovo.build_watch;
+const build_trace = ovo.build_trace;
+const build_pch = ovo.build_pch;
+const build_unity = ovo.build_unity;
+const build_modules = ovo.build_modules;
+const test_runner = ovo.build_test_runner;
+const build_lto = ovo.build_lto;
+const build_pgo = ovo.build_pgo;
+const build_linker = ovo.build_linker;
+const code_tools = ovo.build_code_tools;
 const project_mod = ovo.core_project;
+const core_memory = ovo.core_memory;
 const pkg_manager = ovo.package_manager;
+const pkg_fetch = ovo.package_fetch;
+const pkg_lockfile = ovo.package_lockfile;
 const importer = ovo.translate.importer;
 const exporter = ovo.translate.exporter;
 const cli_args = ovo.cli_args;
+const cli_daemon = ovo.cli_daemon;
+const distributed = ovo.build_distributed;
+const schedule = ovo.build_schedule;
+const job_pool = ovo.build_job_pool;
+const build_install = ovo.build_install;
 
 // Pull in inline tests from translate modules
 comptime {
@@ -22,7 +49,7 @@ comptime {
 // ── Registry & Dispatch ─────────────────────────────────────────────
 
 test "registry contains full command surface" {
-    try std.testing.expectEqual(@as(usize, 20), registry.commands.len);
+    try std.testing.expectEqual(@as(usize, 22), registry.commands.len);
     for (registry.commands) |command| {
         try std.testing.expect(dispatch.hasHandler(command.name));
     }
@@ -144,6 +171,116 @@ test "zon parser extracts all cpp_standard enum values" {
     }
 }
 
+test "zon parser reads remote cache defaults and round-trips them" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const parsed = try parser.parseBuildZon(alloc,
+        \\.{
+        \\    .name = "t",
+        \\    .version = "1.0.0",
+        \\    .defaults = .{
+        \\        .output_dir = ".ovo/build",
+        \\        .remote_cache = .{
+        \\            .url = "s3://ci-cache/ovo",
+        \\            .mode = .read_write,
+        \\        },
+        \\    },
+        \\}
+    );
+    const remote = parsed.defaults.remote_cache orelse return error.TestExpectedEqual;
+    try std.testing.expectEqualStrings("s3://ci-cache/ovo", remote.url);
+    try std.testing.expectEqual(project_mod.RemoteCacheMode.read_write, remote.mode);
+    try std.testing.expectEqualStrings(".ovo/build", parsed.defaults.output_dir);
+
+    const reparsed = try parser.parseBuildZon(alloc, try writer.renderBuildZon(alloc, parsed));
+    try std.testing.expectEqualStrings(remote.url, reparsed.defaults.remote_cache.?.url);
+    try std.testing.expectEqual(remote.mode, reparsed.defaults.remote_cache.?.mode);
+}
+
+test "zon parser reads only top-level project fields" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+
+    const parsed = try parser.parseBuildZon(arena.allocator(),
+        \\.{
+        \\    .targets = .{
+        \\        .app = .{ .name = "inner", .version = "9.9.9", .sources = .{"main.cpp"} },
+        \\    },
+        \\    .name = "outer",
+        \\    .version = "1.0.0",
+        \\}
+    );
+    try std.testing.expectEqualStrings("outer", parsed.name);
+    try std.testing.expectEqualStrings("1.0.0", parsed.version);
+    try std.testing.expectEqualStrings("main.cpp", parsed.targets[0].sources[0]);
+}
+
+test "zon parser reports syntax errors with line and column" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+
+    var diagnostic: parser.Diagnostic = .{};
+    try std.testing.expectError(error.InvalidZon, parser.parseBuildZonDiagnostic(arena.allocator(),
+        \\.{
+        \\    .name = "demo"
+        \\    .version = "1.0.0",
+        \\}
+    , &diagnostic));
+    try std.testing.expectEqual(@as(usize, 3), diagnostic.line);
+    try std.testing.expectEqual(@as(usize, 5), diagnostic.column);
+    try std.testing.expectEqualStrings("expected ',' or '}'", diagnostic.message);
+
+    try std.testing.expectError(error.InvalidZon, parser.parseBuildZonDiagnostic(
+        arena.allocator(),
+        ".{ .name = \"x\", .version = \"1\", .targets = .{ .app = .{ .sources = \"main.cpp\" } } }",
+        &diagnostic,
+    ));
+    try std.testing.expectEqual(@as(usize, 1), diagnostic.line);
+    try std.testing.expectEqual(@as(usize, 68), diagnostic.column);
+
+    try std.testing.expectError(error.InvalidZon, parser.parseBuildZonDiagnostic(arena.allocator(), ".{ .name = \"x", &diagnostic));
+    try std.testing.expectEqualStrings("unterminated string", diagnostic.message);
+}
+
+test "zon ast decodes escapes, quoted names and comments" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+
+    const root = try zon_ast.parse(arena.allocator(),
+        \\// leading comment
+        \\.{
+        \\    .@"my-lib" = "C:\\src\t\x41\u{e9}", // trailing comment
+        \\    .flags = .{ true, null, 42, .on },
+        \\}
+    , null);
+    try std.testing.expectEqualStrings("C:\\src\tA\u{e9}", root.get("my-lib").?.value.string);
+    const flags = root.get("flags").?.items().?;
+    try std.testing.expectEqual(@as(usize, 4), flags.len);
+    try std.testing.expect(flags[0].value.boolean);
+    try std.testing.expectEqualStrings("on", flags[3].value.enum_literal);
+    try std.testing.expectEqual(@as(usize, 0), (try zon_ast.parse(arena.allocator(), ".{}", null)).items().?.len);
+}
+
+test "zon writer quotes names and escapes strings for the parser" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const project = project_mod.Project{
+        .name = "say \"hi\"",
+        .version = "1.0.0",
+        .targets = &.{.{ .name = "my-app", .sources = &.{"src\\main.cpp"} }},
+        .dependencies = &.{.{ .name = "boost.asio", .version = "1.84" }},
+    };
+    const reparsed = try parser.parseBuildZon(alloc, try writer.renderBuildZon(alloc, project));
+    try std.testing.expectEqualStrings(project.name, reparsed.name);
+    try std.testing.expectEqualStrings("my-app", reparsed.targets[0].name);
+    try std.testing.expectEqualStrings("src\\main.cpp", reparsed.targets[0].sources[0]);
+    try std.testing.expectEqualStrings("boost.asio", reparsed.dependencies[0].name);
+}
+
 // ── ZON Writer ──────────────────────────────────────────────────────
 
 test "renderBuildZon produces valid minimal project" {
@@ -253,6 +390,71 @@ test "renderBuildZon round-trips through parser" {
     try std.testing.expectEqualStrings("10.2.1", parsed.dependencies[0].version);
 }
 
+// ── Project Snapshot ────────────────────────────────────────────────
+
+test "project snapshot round-trips a parsed build.zon" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const source =
+        \\.{
+        \\    .name = "snap",
+        \\    .version = "1.2.3",
+        \\    .license = "MIT",
+        \\    .defaults = .{ .cpp_standard = .cpp17, .remote_cache = .{ .url = "https://cache", .mode = .read_write }, .linker = .mold },
+        \\    .targets = .{
+        \\        .core = .{ .type = .library_static, .sources = .{ "a.cpp", "b.cpp" }, .include_dirs = .{"include"}, .pch = "include/pch.hpp" },
+        \\        .app = .{ .sources = .{"main.cpp"}, .link = .{ "core", "m" }, .unity = true, .unity_batch = 4, .unity_exclude = .{"main.cpp"}, .lto = .thin, .pgo_train = .{ "--requests", "1000" } },
+        \\        .app_test = .{ .type = .test, .sources = .{} },
+        \\    },
+        \\    .dependencies = .{ .fmt = "10.2.1", .zlib = .{ .version = "1.3.1", .url = "https://zlib.net/zlib-1.3.1.tar.gz", .hash = "9a93b2b7dfdac77ceba5a558a580e74667dd6fede4585b91eefb60f03b72df23" } },
+        \\}
+    ;
+    const project = try parser.parseBuildZon(alloc, source);
+    const key = zon_snapshot.Key{ .digest = zon_snapshot.digestOf(source), .size = source.len, .mtime_ns = 42 };
+    const bytes = try zon_snapshot.serialize(alloc, project, key);
+
+    const stored = try zon_snapshot.readKey(bytes);
+    try std.testing.expectEqualSlices(u8, &key.digest, &stored.digest);
+    try std.testing.expectEqual(@as(i128, 42), stored.mtime_ns);
+
+    const loaded = try zon_snapshot.deserialize(alloc, bytes);
+    try std.testing.expectEqualStrings(try writer.renderBuildZon(alloc, project), try writer.renderBuildZon(alloc, loaded));
+    try std.testing.expectEqual(project_mod.TargetType.test_target, loaded.targets[2].kind);
+    try std.testing.expectEqualStrings("m", loaded.targets[1].link_libraries[1]);
+    try std.testing.expectEqualStrings("include/pch.hpp", loaded.targets[0].pch.?);
+    try std.testing.expectEqual(@as(?project_mod.Linker, .mold), loaded.defaults.linker);
+    try std.testing.expect(loaded.targets[1].pch == null);
+    try std.testing.expect(loaded.targets[1].unity and !loaded.targets[0].unity);
+    try std.testing.expectEqual(@as(?u32, 4), loaded.targets[1].unity_batch);
+    try std.testing.expectEqualStrings("main.cpp", loaded.targets[1].unity_exclude[0]);
+    try std.testing.expectEqual(@as(?project_mod.Lto, .thin), loaded.targets[1].lto);
+    try std.testing.expect(loaded.targets[0].lto == null);
+    try std.testing.expectEqualStrings("1000", loaded.targets[1].pgo_train[1]);
+    try std.testing.expect(loaded.dependencies[0].url == null);
+    try std.testing.expectEqualStrings("https://zlib.net/zlib-1.3.1.tar.gz", loaded.dependencies[1].url.?);
+    try std.testing.expectEqualStrings(project.dependencies[1].hash.?, loaded.dependencies[1].hash.?);
+}
+
+test "project snapshot rejects other versions and truncation" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const project = try parser.parseBuildZon(alloc, ".{ .name = \"x\", .version = \"1\", .targets = .{ .a = .{ .sources = .{\"a.cpp\"} } } }");
+    const key = zon_snapshot.Key{ .digest = zon_snapshot.digestOf(""), .size = 0, .mtime_ns = 0 };
+    const bytes = try zon_snapshot.serialize(alloc, project, key);
+
+    for (1..bytes.len) |len| {
+        try std.testing.expectError(error.InvalidSnapshot, zon_snapshot.deserialize(alloc, bytes[0..len]));
+    }
+    // The ovo version string follows the fixed-size key.
+    const other_version = try alloc.dupe(u8, bytes);
+    other_version[8 + 32 + 8 + 16 + 4] ^= 0xff;
+    try std.testing.expectError(error.InvalidSnapshot, zon_snapshot.readKey(other_version));
+}
+
 // ── Neural ──────────────────────────────────────────────────────────
 
 test "neural layer and loss are deterministic" {
@@ -290,6 +492,60 @@ test "backend label round-trips with parseBackend" {
     }
 }
 
+// ── Toolchain Probes ────────────────────────────────────────────────
+
+test "toolchain cache round-trips probes" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+    const probes = [_]compiler.toolchain.Probe{
+        .{
+            .name = "clang++",
+            .path = "/usr/bin/clang++",
+            .mtime_ns = 1_700_000_000_123_456_789,
+            .size = 4096,
+            .found = true,
+            .banner = "clang version 18.1.3\nTarget: x86_64-pc-linux-gnu\n",
+            .target = "x86_64-pc-linux-gnu",
+            .include_dirs = &.{ "/usr/include/c++/13", "/usr/include" },
+            .flags = &.{ "-std=c++17", "-std=c++20" },
+            .unsupported_flags = &.{"-std=c++23"},
+        },
+        .{ .name = "zig", .path = "/opt/zig/zig", .found = true, .banner = "0.16.0\n" },
+    };
+    const parsed = try compiler.toolchain.parse(alloc, try compiler.toolchain.render(alloc, &probes));
+    try std.testing.expectEqual(@as(usize, 2), parsed.len);
+    try std.testing.expectEqualStrings("/usr/bin/clang++", parsed[0].path);
+    try std.testing.expectEqual(probes[0].mtime_ns, parsed[0].mtime_ns);
+    try std.testing.expectEqualStrings(probes[0].banner, parsed[0].banner);
+    try std.testing.expectEqualStrings("clang version 18.1.3", parsed[0].version());
+    try std.testing.expectEqual(@as(usize, 2), parsed[0].include_dirs.len);
+    try std.testing.expect(parsed[0].rejects("-std=c++23"));
+    try std.testing.expect(!parsed[0].rejects("-std=c++20"));
+    try std.testing.expectEqual(@as(usize, 0), parsed[1].flags.len);
+
+    try std.testing.expectError(error.InvalidToolchainCache, compiler.toolchain.parse(alloc, ".{ .version = 0, .tools = .{} }"));
+}
+
+test "toolchain include paths come from the verbose search list" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const output =
+        \\clang version 18.1.3
+        \\#include "..." search starts here:
+        \\#include <...> search starts here:
+        \\ /usr/include/c++/13
+        \\ /usr/local/include
+        \\ /System/Library/Frameworks (framework directory)
+        \\End of search list.
+        \\ /not/a/path
+    ;
+    const dirs = try compiler.toolchain.parseIncludeDirs(arena.allocator(), output);
+    try std.testing.expectEqual(@as(usize, 2), dirs.len);
+    try std.testing.expectEqualStrings("/usr/include/c++/13", dirs[0]);
+    try std.testing.expectEqualStrings("/usr/local/include", dirs[1]);
+}
+
 // ── Build Orchestrator ──────────────────────────────────────────────
 
 test "default runnable target prefers executable then test" {
@@ -307,6 +563,837 @@ test "default runnable target prefers executable then test" {
     try std.testing.expectEqualStrings("demo", runnable.name);
 }
 
+test "compile database entries carry the exact argv" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    var out: std.ArrayList(u8) = .empty;
+    try orchestrator.appendCommandEntry(alloc, &out, "/work", "src/a.cpp", &.{ "clang++", "-DNAME=\"x\"", "-c", "src/a.cpp" }, "obj/a.o", true);
+    try orchestrator.appendCommandEntry(alloc, &out, "/work", "src/b.cpp", &.{ "clang++", "-c", "src/b.cpp" }, "obj/b.o", false);
+    try std.testing.expectEqualStrings(
+        \\  {"directory":"/work","file":"src/a.cpp","arguments":["clang++","-DNAME=\"x\"","-c","src/a.cpp"],"output":"obj/a.o"},
+        \\  {"directory":"/work","file":"src/b.cpp","arguments":["clang++","-c","src/b.cpp"],"output":"obj/b.o"}
+    , out.items);
+}
+
+// ── LTO & PGO ───────────────────────────────────────────────────────
+
+fn joinArgs(alloc: std.mem.Allocator, argv: []const []const u8) ![]const u8 {
+    return std.mem.join(alloc, " ", argv);
+}
+
+test "lto maps thin and full onto every backend and skips debug builds" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    try std.testing.expect(build_lto.active(.thin, "Debug") == null);
+    try std.testing.expectEqual(@as(?project_mod.Lto, .full), build_lto.active(.full, "ReleaseFast"));
+
+    const cases = [_]struct { backend: []const u8, mode: project_mod.Lto, compile: []const u8, link: []const u8, archiver: []const u8 }{
+        .{ .backend = "gcc", .mode = .thin, .compile = "-flto=auto", .link = "-flto=auto", .archiver = "gcc-ar" },
+        .{ .backend = "gcc", .mode = .full, .compile = "-flto=auto", .link = "-flto=auto -flto-partition=one", .archiver = "gcc-ar" },
+        .{ .backend = "zigcc", .mode = .thin, .compile = "-flto", .link = "-flto", .archiver = "zig ar" },
+        .{ .backend = "msvc", .mode = .thin, .compile = "/GL", .link = "/LTCG:INCREMENTAL /LTCGOUT:out/lto-cache/app.iobj", .archiver = "lib /LTCG" },
+        .{ .backend = "msvc", .mode = .full, .compile = "/GL", .link = "/LTCG", .archiver = "lib /LTCG" },
+    };
+    for (cases) |case| {
+        var compile: std.ArrayList([]const u8) = .empty;
+        try build_lto.appendCompileFlags(alloc, &compile, case.mode, case.backend);
+        try std.testing.expectEqualStrings(case.compile, try joinArgs(alloc, compile.items));
+        var link: std.ArrayList([]const u8) = .empty;
+        try build_lto.appendLinkFlags(alloc, &link, case.mode, case.backend, "out/lto-cache", "out/app.exe");
+        try std.testing.expectEqualStrings(case.link, try joinArgs(alloc, link.items));
+        var archiver: std.ArrayList([]const u8) = .empty;
+        try build_lto.appendArchiver(alloc, &archiver, true, case.backend);
+        try std.testing.expectEqualStrings(case.archiver, try joinArgs(alloc, archiver.items));
+    }
+
+    // clang's ThinLTO links keep a persistent cache; the flags depend on the host linker.
+    var compile: std.ArrayList([]const u8) = .empty;
+    try build_lto.appendCompileFlags(alloc, &compile, .thin, "clang");
+    try std.testing.expectEqualStrings("-flto=thin", compile.items[0]);
+    var thin: std.ArrayList([]const u8) = .empty;
+    try build_lto.appendLinkFlags(alloc, &thin, .thin, "clang", "out/lto-cache", "out/app");
+    try std.testing.expectEqualStrings("-flto=thin", thin.items[0]);
+    try std.testing.expect(std.mem.indexOf(u8, try joinArgs(alloc, thin.items), "out/lto-cache") != null);
+}
+
+test "pgo stages map onto each backend and its profile merge" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const dir = try build_pgo.profileDir(alloc, ".ovo/build", "clang");
+    try std.testing.expectEqualStrings(".ovo/build/pgo/clang", dir);
+    try std.testing.expectEqualStrings(".ovo/build/pgo/clang/default.profdata", (try build_pgo.mergedProfile(alloc, dir, "clang")).?);
+    try std.testing.expect((try build_pgo.mergedProfile(alloc, dir, "gcc")) == null);
+
+    var flags: std.ArrayList([]const u8) = .empty;
+    try build_pgo.appendCompileFlags(alloc, &flags, .instrument, "gcc", "p");
+    try std.testing.expectEqualStrings("-fprofile-generate=p -fprofile-update=atomic", try joinArgs(alloc, flags.items));
+    flags.clearRetainingCapacity();
+    try build_pgo.appendCompileFlags(alloc, &flags, .use, "clang", "p");
+    try std.testing.expectEqualStrings("-fprofile-use=p/default.profdata", flags.items[0]);
+    try std.testing.expectError(error.PgoUnsupportedBackend, build_pgo.appendCompileFlags(alloc, &flags, .instrument, "zigcc", "p"));
+
+    var link: std.ArrayList([]const u8) = .empty;
+    try build_pgo.appendLinkFlags(alloc, &link, .use, "clang", "p", "out/app");
+    try std.testing.expectEqual(@as(usize, 0), link.items.len);
+    try build_pgo.appendLinkFlags(alloc, &link, .instrument, "msvc", "p", "out/app.exe");
+    try std.testing.expectEqualStrings("/LTCG /GENPROFILE:PGD=p/app.pgd", try joinArgs(alloc, link.items));
+
+    const merges = try build_pgo.mergeCommands(alloc, "msvc", "p", &.{"out/app.exe"});
+    try std.testing.expectEqualStrings("pgomgr /merge p/app.pgd", try joinArgs(alloc, merges[0]));
+    try std.testing.expectEqual(@as(usize, 0), (try build_pgo.mergeCommands(alloc, "gcc", "p", &.{"out/app"})).len);
+}
+
+test "linker flags pick the linker and split debug info" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    try std.testing.expectEqual(@as(?project_mod.Linker, .lld), project_mod.parseLinker("lld"));
+    try std.testing.expect(project_mod.parseLinker("bfd") == null);
+    try std.testing.expectError(error.InvalidZon, parser.parseBuildZon(alloc,
+        \\.{ .name = "t", .version = "1.0.0", .defaults = .{ .linker = .bfd } }
+    ));
+
+    var flags: std.ArrayList([]const u8) = .empty;
+    try build_linker.appendCompileFlags(alloc, &flags, "clang", "ReleaseFast", .mold);
+    try build_linker.appendLinkFlags(alloc, &flags, "zigcc", "Debug", .mold);
+    try build_linker.appendLinkFlags(alloc, &flags, "msvc", "ReleaseFast", .default);
+    try std.testing.expectEqual(@as(usize, 0), flags.items.len);
+    try build_linker.appendCompileFlags(alloc, &flags, "msvc", "Debug", .default);
+    try build_linker.appendLinkFlags(alloc, &flags, "msvc", "Debug", .default);
+    try std.testing.expectEqualStrings("/Z7 /DEBUG:FASTLINK", try joinArgs(alloc, flags.items));
+
+    flags.clearRetainingCapacity();
+    try build_linker.appendLinkFlags(alloc, &flags, "gcc", "ReleaseFast", .gold);
+    try std.testing.expectEqualStrings("-fuse-ld=gold", try joinArgs(alloc, flags.items));
+
+    flags.clearRetainingCapacity();
+    try build_linker.appendCompileFlags(alloc, &flags, "clang", "Debug", .lld);
+    try build_linker.appendLinkFlags(alloc, &flags, "clang", "Debug", .lld);
+    const expected = if (build_linker.elf_host)
+        "-g -gsplit-dwarf=single -ggnu-pubnames -fuse-ld=lld -Wl,--gdb-index"
+    else
+        "-g -fuse-ld=lld";
+    try std.testing.expectEqualStrings(expected, try joinArgs(alloc, flags.items));
+    try std.testing.expectEqual(build_linker.elf_host, build_linker.writesDwo("gcc", "Debug"));
+    try std.testing.expect(!build_linker.writesDwo("clang", "Debug"));
+}
+
+// ── Build Manifest ──────────────────────────────────────────────────
+
+test "object file names are stable and unique per source path" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const first = try build_manifest.objectFileName(alloc, "src/util.cpp", ".o");
+    const again = try build_manifest.objectFileName(alloc, "src/util.cpp", ".o");
+    const other = try build_manifest.objectFileName(alloc, "lib/util.cpp", ".o");
+    try std.testing.expectEqualStrings(first, again);
+    try std.testing.expect(!std.mem.eql(u8, first, other));
+    try std.testing.expect(std.mem.startsWith(u8, first, "util-"));
+    try std.testing.expect(std.mem.endsWith(u8, first, ".o"));
+}
+
+test "hashArgv distinguishes argument boundaries" {
+    const joined = build_manifest.hashArgv(&.{ "clang++", "-Ia" });
+    const split = build_manifest.hashArgv(&.{ "clang++", "-I", "a" });
+    try std.testing.expect(joined != split);
+    try std.testing.expectEqual(joined, build_manifest.hashArgv(&.{ "clang++", "-Ia" }));
+}
+
+test "manifest render round-trips through parse" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    var manifest = build_manifest.Manifest{};
+    try manifest.recordObject(alloc, ".ovo/build/obj-app/main-0000abcd.o", .{
+        .source = "src/main.cpp",
+        .argv_hash = 0x1234,
+        .inputs_hash = 0xfeed,
+    });
+    try manifest.recordArtifact(alloc, ".ovo/build/app", 0xbeef);
+
+    const rendered = try manifest.render(alloc);
+    const parsed = try build_manifest.parse(alloc, rendered);
+    const record = parsed.objects.get(".ovo/build/obj-app/main-0000abcd.o") orelse return error.TestExpectedEqual;
+    try std.testing.expectEqualStrings("src/main.cpp", record.source);
+    try std.testing.expectEqual(@as(u64, 0x1234), record.argv_hash);
+    try std.testing.expectEqual(@as(u64, 0xfeed), record.inputs_hash);
+    try std.testing.expectEqual(@as(?u64, 0xbeef), parsed.artifacts.get(".ovo/build/app"));
+}
+
+test "manifest parse ignores unknown format versions" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const parsed = try build_manifest.parse(arena.allocator(), "ovo-build-manifest 0\na\tapp\t00000000000000ff\n");
+    try std.testing.expectEqual(@as(u32, 0), parsed.artifacts.count());
+}
+
+test "inputs stat'ed before a compile hash as they were then" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+    const paths = [_][]const u8{ "src/main.cpp", "include/util.hpp" };
+
+    var before: build_manifest.InputStats = .empty;
+    try before.put(alloc, paths[0], .{ .mtime_ns = 100, .size = 10 });
+    try before.put(alloc, paths[1], .{ .mtime_ns = 200, .size = 20 });
+    var saved: build_manifest.InputStats = .empty;
+    try saved.put(alloc, paths[0], .{ .mtime_ns = 300, .size = 12 });
+    try saved.put(alloc, paths[1], .{ .mtime_ns = 200, .size = 20 });
+
+    // Never stat'ed again, so the start time doesn't matter.
+    const first = build_manifest.fingerprintInputsSince(&paths, &before, 0) orelse return error.TestExpectedEqual;
+    try std.testing.expectEqual(first, build_manifest.fingerprintInputsSince(&paths, &before, 0).?);
+    try std.testing.expect(first != build_manifest.fingerprintInputsSince(&paths, &saved, 0).?);
+}
+
+// ── Header Dependencies ─────────────────────────────────────────────
+
+test "parseMake reads continued and escaped prerequisites" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const deps = try build_depfile.parseMake(
+        arena.allocator(),
+        "obj/main.o: src/main.cpp \\\n  include/my\\ lib.h \\\r\n  cost$$.h\ninclude/my\\ lib.h:\n",
+    );
+    try std.testing.expectEqual(@as(usize, 3), deps.len);
+    try std.testing.expectEqualStrings("src/main.cpp", deps[0]);
+    try std.testing.expectEqualStrings("include/my lib.h", deps[1]);
+    try std.testing.expectEqualStrings("cost$.h", deps[2]);
+}
+
+test "parseMake skips drive letter colons in the target" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const deps = try build_depfile.parseMake(arena.allocator(), "C:\\build\\main.o: C:\\src\\main.cpp\n");
+    try std.testing.expectEqual(@as(usize, 1), deps.len);
+    try std.testing.expectEqualStrings("C:\\src\\main.cpp", deps[0]);
+}
+
+test "parseMsvcJson reads source dependency includes" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const deps = try build_depfile.parseMsvcJson(
+        arena.allocator(),
+        "{\"Version\":\"1.2\",\"Data\":{\"Source\":\"main.cpp\",\"Includes\":[\"a.h\",\"b.h\"]}}",
+    );
+    try std.testing.expectEqual(@as(usize, 2), deps.len);
+    try std.testing.expectEqualStrings("b.h", deps[1]);
+}
+
+test "dep db serializes, reloads and lets updates shadow entries" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    var db = build_dep_db.DepDb{};
+    try db.record(alloc, "obj/b.o", &.{ "src/b.cpp", "include/common.h" });
+    try db.record(alloc, "obj/a.o", &.{ "src/a.cpp", "include/common.h", "include/a.h" });
+    const bytes = try db.serialize(alloc);
+
+    var loaded = try build_dep_db.DepDb.fromBytes(bytes);
+    try std.testing.expectEqual(@as(u32, 2), loaded.object_count);
+    // "include/common.h" is interned once across both objects.
+    try std.testing.expectEqual(@as(u32, 5), loaded.path_count);
+
+    var deps: std.ArrayList([]const u8) = .empty;
+    try std.testing.expect(try loaded.collect(alloc, "obj/a.o", &deps));
+    try std.testing.expectEqual(@as(usize, 3), deps.items.len);
+    try std.testing.expectEqualStrings("include/a.h", deps.items[2]);
+    try std.testing.expect(!try loaded.collect(alloc, "obj/missing.o", &deps));
+
+    try loaded.record(alloc, "obj/a.o", &.{"src/a.cpp"});
+    deps.clearRetainingCapacity();
+    _ = try loaded.collect(alloc, "obj/a.o", &deps);
+    try std.testing.expectEqual(@as(usize, 1), deps.items.len);
+
+    const merged = try build_dep_db.DepDb.fromBytes(try loaded.serialize(alloc));
+    deps.clearRetainingCapacity();
+    try std.testing.expect(try merged.collect(alloc, "obj/b.o", &deps));
+    try std.testing.expectEqual(@as(usize, 2), deps.items.len);
+}
+
+test "dep db rejects truncated files" {
+    try std.testing.expectError(error.InvalidDepDb, build_dep_db.DepDb.fromBytes("OVODEP01\x01"));
+}
+
+test "dep db rejects entries that point outside their tables" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    var db = build_dep_db.DepDb{};
+    try db.record(alloc, "obj/b.o", &.{ "src/b.cpp", "include/common.h" });
+    try db.record(alloc, "obj/a.o", &.{ "src/a.cpp", "include/common.h", "include/a.h" });
+    const bytes = try db.serialize(alloc);
+    _ = try build_dep_db.DepDb.fromBytes(bytes);
+
+    // Header 24 bytes, two objects of 12, five paths of 8, then the edges.
+    const first_edge = 24 + 4;
+    const first_path_len = 24 + 2 * 12 + 4;
+    const first_edge_path = 24 + 2 * 12 + 5 * 8;
+    for ([_]usize{ first_edge, first_path_len, first_edge_path }) |offset| {
+        const damaged = try alloc.dupe(u8, bytes);
+        std.mem.writeInt(u32, damaged[offset..][0..4], 0xffff_fff0, .little);
+        try std.testing.expectError(error.InvalidDepDb, build_dep_db.DepDb.fromBytes(damaged));
+    }
+}
+
+// ── Object Cache ────────────────────────────────────────────────────
+
+test "object cache size limits accept binary suffixes" {
+    try std.testing.expectEqual(@as(?u64, 4096), object_cache.parseSize("4096"));
+    try std.testing.expectEqual(@as(?u64, 512 * 1024), object_cache.parseSize("512K"));
+    try std.testing.expectEqual(@as(?u64, 20 * 1024 * 1024 * 1024), object_cache.parseSize("20g"));
+    try std.testing.expectEqual(@as(?u64, null), object_cache.parseSize("lots"));
+    try std.testing.expectEqual(@as(?u64, null), object_cache.parseSize(""));
+}
+
+test "normalizeArgv hides per-checkout output paths" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const gnu = try object_cache.normalizeArgv(alloc, &.{
+        "clang++", "-MD", "-MF", "/wt1/.ovo/build/obj-app/main-1.o.d", "-c", "src/main.cpp", "-o", "/wt1/.ovo/build/obj-app/main-1.o",
+    }, "/wt1/.ovo/build/obj-app/main-1.o", "/wt1/.ovo/build/obj-app/main-1.o.d");
+    try std.testing.expectEqualStrings("<depfile>", gnu[3]);
+    try std.testing.expectEqualStrings("src/main.cpp", gnu[5]);
+    try std.testing.expectEqualStrings("<object>", gnu[7]);
+
+    const msvc = try object_cache.normalizeArgv(alloc, &.{ "cl", "/c", "main.cpp", "/Fo:obj\\main.obj" }, "obj\\main.obj", "obj\\main.obj.json");
+    try std.testing.expectEqualStrings("/Fo:<object>", msvc[3]);
+}
+
+test "object cache entries and stats round-trip" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    var key: object_cache.Digest = undefined;
+    @memset(&key, 0xab);
+    const rendered = try object_cache.renderEntry(alloc, key, &.{ "src/main.cpp", "include/app.h" });
+    const entry = try object_cache.parseEntry(alloc, rendered);
+    try std.testing.expectEqualSlices(u8, &key, &entry.object_key);
+    try std.testing.expectEqual(@as(usize, 2), entry.deps.len);
+    try std.testing.expectEqualStrings("include/app.h", entry.deps[1]);
+    try std.testing.expectError(error.InvalidCacheEntry, object_cache.parseEntry(alloc, "ovo-cache-entry 0\n"));
+
+    const stats = object_cache.parseStats(try object_cache.renderStats(alloc, .{ .hits = 3, .misses = 1, .size_bytes = 42 }));
+    try std.testing.expectEqual(@as(u64, 3), stats.hits);
+    try std.testing.expectEqual(@as(u64, 42), stats.size_bytes);
+    try std.testing.expectEqual(@as(u64, 75), stats.hitRatePercent());
+}
+
+test "remote cache endpoints map http and s3 urls" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const http = try remote_cache.resolveEndpoint(alloc, "https://cache.example.com/ovo/", null, null);
+    try std.testing.expectEqualStrings("https://cache.example.com/ovo", http.base_url);
+    try std.testing.expect(http.s3_region == null);
+
+    const s3 = try remote_cache.resolveEndpoint(alloc, "s3://ci-cache/ovo", "eu-west-1", null);
+    try std.testing.expectEqualStrings("https://ci-cache.s3.eu-west-1.amazonaws.com/ovo", s3.base_url);
+    try std.testing.expectEqualStrings("eu-west-1", s3.s3_region.?);
+
+    const minio = try remote_cache.resolveEndpoint(alloc, "s3://ci-cache", null, "http://minio:9000/");
+    try std.testing.expectEqualStrings("http://minio:9000/ci-cache", minio.base_url);
+
+    try std.testing.expectError(error.InvalidRemoteCacheUrl, remote_cache.resolveEndpoint(alloc, "ftp://x", null, null));
+}
+
+test "remote cache urls mirror the local cache layout" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const url = try remote_cache.mirrorUrl(
+        arena.allocator(),
+        "https://cache.example.com/ovo",
+        "/home/dev/.cache/ovo",
+        "/home/dev/.cache/ovo/objects/ab/cdef.o",
+        ".zst",
+    );
+    try std.testing.expectEqualStrings("https://cache.example.com/ovo/objects/ab/cdef.o.zst", url);
+}
+
+// ── Target Graph ────────────────────────────────────────────────────
+
+test "target graph orders libraries before their dependents" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const targets = [_]project_mod.Target{
+        .{ .name = "app", .kind = .executable, .link_libraries = &.{ "net", "m" } },
+        .{ .name = "net", .kind = .library_static, .link_libraries = &.{"core"} },
+        .{ .name = "core", .kind = .library_static },
+        .{ .name = "tool", .kind = .executable },
+    };
+    const graph = try target_graph.build(alloc, &targets);
+    try std.testing.expectEqualSlices(usize, &.{ 2, 1, 0, 3 }, graph.order);
+    try std.testing.expectEqualSlices(usize, &.{1}, graph.deps[0]);
+
+    // Requesting only `app` pulls in its libraries but not `tool`.
+    const selected = try graph.closure(alloc, &.{ true, false, false, false });
+    try std.testing.expectEqualSlices(bool, &.{ true, true, true, false }, selected);
+}
+
+test "target graph rejects link cycles" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const targets = [_]project_mod.Target{
+        .{ .name = "a", .kind = .library_static, .link_libraries = &.{"b"} },
+        .{ .name = "b", .kind = .library_static, .link_libraries = &.{"a"} },
+    };
+    try std.testing.expectError(error.DependencyCycle, target_graph.build(arena.allocator(), &targets));
+}
+
+test "link plan pulls static dependencies through in dependents-first order" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const targets = [_]project_mod.Target{
+        .{ .name = "app", .kind = .executable, .link_libraries = &.{ "a", "b" } },
+        .{ .name = "a", .kind = .library_static, .link_libraries = &.{ "c", "pthread" } },
+        .{ .name = "b", .kind = .library_static, .link_libraries = &.{"c"} },
+        .{ .name = "c", .kind = .library_static, .link_libraries = &.{"m"} },
+        .{ .name = "plugin", .kind = .library_shared, .link_libraries = &.{"c"} },
+    };
+    const graph = try target_graph.build(alloc, &targets);
+    const plan = try graph.linkPlan(alloc, 0);
+    // Both `a` and `b` need `c`, so it must come after both of them.
+    try std.testing.expectEqualSlices(usize, &.{ 2, 1, 3 }, plan.project_libs);
+    try std.testing.expectEqual(@as(usize, 2), plan.external.len);
+    try std.testing.expectEqualStrings("pthread", plan.external[0]);
+    try std.testing.expectEqualStrings("m", plan.external[1]);
+
+    // `c` ends up inside the shared `plugin`, so it has to be PIC.
+    const pic = try graph.needsPic(alloc);
+    try std.testing.expectEqualSlices(bool, &.{ false, false, false, true, true }, pic);
+}
+
+// ── Source Globs ────────────────────────────────────────────────────
+
+test "glob segments support wildcards, classes and hidden names" {
+    try std.testing.expect(build_glob.matchSegment("*.cpp", "main.cpp"));
+    try std.testing.expect(!build_glob.matchSegment("*.cpp", "main.cc"));
+    try std.testing.expect(build_glob.matchSegment("*_test.c*", "io_test.cpp"));
+    try std.testing.expect(build_glob.matchSegment("file?.[ch]", "file1.h"));
+    try std.testing.expect(!build_glob.matchSegment("file?.[!ch]", "file1.h"));
+    try std.testing.expect(build_glob.matchSegment("[a-c]*", "beta"));
+    try std.testing.expect(!build_glob.matchSegment("*", ".hidden"));
+    try std.testing.expect(build_glob.matchSegment(".*", ".hidden"));
+}
+
+test "glob paths span directories with ** and expand braces" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+
+    try std.testing.expect(build_glob.matchPath("src/**/*.cpp", "src/main.cpp"));
+    try std.testing.expect(build_glob.matchPath("src/**/*.cpp", "src/a/b/c.cpp"));
+    try std.testing.expect(!build_glob.matchPath("src/**/*.cpp", "src/.git/x.cpp"));
+    try std.testing.expect(!build_glob.matchPath("src/*.cpp", "src/a/b.cpp"));
+    try std.testing.expect(build_glob.matchPath("**", "a/b"));
+
+    const expanded = try build_glob.expandBraces(arena.allocator(), "src/{core,net/{tcp,udp}}/*.{c,cpp}");
+    try std.testing.expectEqual(@as(usize, 6), expanded.len);
+    try std.testing.expectEqualStrings("src/core/*.c", expanded[0]);
+    try std.testing.expectEqualStrings("src/net/udp/*.cpp", expanded[5]);
+    const unbalanced = try build_glob.expandBraces(arena.allocator(), "src/{a,b.cpp");
+    try std.testing.expectEqualStrings("src/{a,b.cpp", unbalanced[0]);
+}
+
+test "glob index applies exclusions and drops duplicates" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+
+    var index = build_glob.Index.init(arena.allocator(), null);
+    defer index.deinit();
+    const sources = try index.resolveSources(&.{ "src/main.cpp", "src/io_test.cpp", "src/main.cpp", "!src/**/*_test.cpp" });
+    try std.testing.expectEqual(@as(usize, 1), sources.len);
+    try std.testing.expectEqualStrings("src/main.cpp", sources[0]);
+}
+
+test "glob index never lists directories an exclusion covers" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    var index = build_glob.Index.init(alloc, null);
+    defer index.deinit();
+    // Listings already checked this run, so nothing is read from disk; a
+    // walk into `vendor` would have to list it.
+    try index.listings.put(alloc, ".", .{ .mtime_ns = 1, .files = &.{}, .dirs = &.{ "src", "vendor" } });
+    try index.listings.put(alloc, "src", .{ .mtime_ns = 1, .files = &.{ "main.cpp", "util.cpp" }, .dirs = &.{} });
+    try index.verified.put(alloc, ".", {});
+    try index.verified.put(alloc, "src", {});
+
+    const sources = try index.resolveSources(&.{ "**/*.cpp", "!vendor/**" });
+    try std.testing.expectEqual(@as(usize, 2), sources.len);
+    try std.testing.expectEqualStrings("src/main.cpp", sources[0]);
+    try std.testing.expect(!index.verified.contains("vendor"));
+}
+
+test "glob index listings round-trip through the on-disk format" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    var listings: std.StringHashMapUnmanaged(build_glob.Listing) = .empty;
+    try listings.put(alloc, "src", .{ .mtime_ns = 1700000000123456789, .files = &.{ "a.cpp", "b.h" }, .dirs = &.{"net"} });
+    try listings.put(alloc, "src/net", .{ .mtime_ns = -5, .files = &.{}, .dirs = &.{} });
+
+    const parsed = try build_glob.parseListings(alloc, try build_glob.renderListings(alloc, listings));
+    try std.testing.expectEqual(@as(u32, 2), parsed.count());
+    const src = parsed.get("src").?;
+    try std.testing.expectEqual(@as(i128, 1700000000123456789), src.mtime_ns);
+    try std.testing.expectEqualStrings("b.h", src.files[1]);
+    try std.testing.expectEqualStrings("net", src.dirs[0]);
+    try std.testing.expectEqual(@as(usize, 0), parsed.get("src/net").?.files.len);
+    try std.testing.expectError(error.InvalidGlobIndex, build_glob.parseListings(alloc, "ovo-glob-index 0\n"));
+}
+
+// ── Watch Mode ──────────────────────────────────────────────────────
+
+test "watch paths are normalized to the spelling events use" {
+    try std.testing.expectEqualStrings("src/a.cpp", build_watch.normalizePath("./src/a.cpp"));
+    try std.testing.expectEqualStrings("src", build_watch.normalizePath("././src/"));
+    try std.testing.expectEqualStrings(".", build_watch.normalizePath("./"));
+    try std.testing.expectEqualStrings("/", build_watch.normalizePath("/"));
+}
+
+test "watch event paths join the watched directory and entry name" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    try std.testing.expectEqualStrings("build.zon", try build_watch.childPath(alloc, ".", "build.zon"));
+    try std.testing.expectEqualStrings("src/a.cpp", try build_watch.childPath(alloc, "src", "a.cpp"));
+    try std.testing.expectEqualStrings("/usr/include", try build_watch.childPath(alloc, "/usr/include", ""));
+    try std.testing.expectEqualStrings("/a.h", try build_watch.childPath(alloc, "/", "a.h"));
+}
+
+// ── Build Timings ───────────────────────────────────────────────────
+
+test "critical path follows the latest-finishing prerequisite" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const events = [_]build_trace.Event{
+        .{ .name = "src/fast.cpp", .category = .compile, .start_ns = 0, .end_ns = 100, .lane = 1 },
+        .{ .name = "src/slow.cpp", .category = .compile, .start_ns = 0, .end_ns = 900, .lane = 2 },
+        .{ .name = "libcore.a", .category = .archive, .start_ns = 900, .end_ns = 950, .lane = 1, .after = &.{ 0, 1 } },
+        .{ .name = "src/main.cpp", .category = .compile, .start_ns = 100, .end_ns = 400, .lane = 1 },
+        .{ .name = "app", .category = .link, .start_ns = 950, .end_ns = 1200, .lane = 2, .after = &.{ 3, 2 } },
+        .{ .name = "write compile_commands.json", .category = .output, .start_ns = 1200, .end_ns = 1300 },
+    };
+    const path = try build_trace.criticalPath(alloc, &events);
+    try std.testing.expectEqualSlices(usize, &.{ 1, 2, 4 }, path);
+
+    const slowest = try build_trace.slowestCompiles(alloc, &events, 2);
+    try std.testing.expectEqualSlices(usize, &.{ 1, 3 }, slowest);
+}
+
+test "explain compares the predicted critical path with the actual one" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    // big.cpp was expected to dominate, but small.cpp ran long this time.
+    const events = [_]build_trace.Event{
+        .{ .name = "src/big.cpp", .category = .compile, .start_ns = 0, .end_ns = 500, .predicted_ns = 800 },
+        .{ .name = "src/small.cpp", .category = .compile, .start_ns = 0, .end_ns = 900, .predicted_ns = 100 },
+        .{ .name = "app", .category = .link, .start_ns = 900, .end_ns = 1000, .predicted_ns = 100, .after = &.{ 0, 1 } },
+        .{ .name = "src/new.cpp", .category = .compile, .start_ns = 0, .end_ns = 50 },
+    };
+    try std.testing.expectEqualSlices(usize, &.{ 0, 2 }, try build_trace.predictedCriticalPath(alloc, &events));
+    try std.testing.expectEqualSlices(usize, &.{ 1, 2 }, try build_trace.criticalPath(alloc, &events));
+
+    const report = try build_trace.renderExplain(alloc, &events);
+    try std.testing.expect(std.mem.startsWith(u8, report, "explain: critical path predicted 0.000s, took 0.000s\n"));
+    try std.testing.expect(std.mem.indexOf(u8, report, "  predicted path (predicted, actual):\n") != null);
+    try std.testing.expect(std.mem.indexOf(u8, report, "  actual path (predicted, actual):\n") != null);
+    try std.testing.expect(std.mem.indexOf(u8, report, "compile src/small.cpp\n") != null);
+    try std.testing.expect(std.mem.endsWith(u8, report, "  1 step(s) had no history\n"));
+}
+
+test "chrome trace names lanes and escapes event names" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const events = [_]build_trace.Event{
+        .{ .name = "load build.zon", .category = .project, .start_ns = 1_000, .end_ns = 3_500 },
+        .{ .name = "src/\"odd\".cpp", .category = .compile, .start_ns = 4_000, .end_ns = 9_000, .lane = 1, .exit_code = 1, .backend = "clang" },
+    };
+    const rendered = try build_trace.renderChromeTrace(alloc, &events, 1_000);
+    try std.testing.expect(std.mem.indexOf(u8, rendered, "\"tid\":1,\"args\":{\"name\":\"worker 1\"}") != null);
+    try std.testing.expect(std.mem.indexOf(u8, rendered, "\"name\":\"src/\\\"odd\\\".cpp\"") != null);
+    try std.testing.expect(std.mem.indexOf(u8, rendered, "\"ts\":3.000,\"dur\":5.000,\"args\":{\"backend\":\"clang\",\"exit\":1}") != null);
+    try std.testing.expect(std.mem.startsWith(u8, rendered, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+}
+
+// ── Precompiled Headers ─────────────────────────────────────────────
+
+test "pch plan uses each backend's create and use flags" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const clang = try build_pch.plan(alloc, "out/obj-app/pch", "src/pch.hpp", "clang", "");
+    try std.testing.expectEqualStrings("out/obj-app/pch/pch.hpp.pch", clang.output);
+    var clang_create: std.ArrayList([]const u8) = .empty;
+    try build_pch.appendCreateFlags(alloc, &clang_create, clang, .cpp20, "clang");
+    try std.testing.expectEqualStrings("c++-header", clang_create.items[1]);
+    try std.testing.expectEqualStrings("src/pch.hpp", clang_create.items[2]);
+    var clang_use: std.ArrayList([]const u8) = .empty;
+    try build_pch.appendUseFlags(alloc, &clang_use, clang, "clang");
+    try std.testing.expectEqualStrings("-include-pch", clang_use.items[0]);
+    try std.testing.expectEqualStrings(clang.output, clang_use.items[1]);
+
+    const gcc = try build_pch.plan(alloc, "out/obj-app/pch", "src/pch.h", "gcc", "");
+    try std.testing.expectEqualStrings("out/obj-app/pch/pch.h.gch", gcc.output);
+    var gcc_create: std.ArrayList([]const u8) = .empty;
+    try build_pch.appendCreateFlags(alloc, &gcc_create, gcc, .c11, "gcc");
+    try std.testing.expectEqualStrings("c-header", gcc_create.items[1]);
+    var gcc_use: std.ArrayList([]const u8) = .empty;
+    try build_pch.appendUseFlags(alloc, &gcc_use, gcc, "gcc");
+    try std.testing.expectEqualStrings("-include", gcc_use.items[0]);
+    try std.testing.expectEqualStrings("out/obj-app/pch/pch.h", gcc_use.items[1]);
+
+    const msvc = try build_pch.plan(alloc, "out/obj-app/pch", "src/pch.hpp", "msvc", "/work");
+    try std.testing.expectEqualStrings("/work/src/pch.hpp", msvc.include);
+    try std.testing.expectEqualStrings("#include \"/work/src/pch.hpp\"\n", try build_pch.stubSource(alloc, msvc));
+    var msvc_create: std.ArrayList([]const u8) = .empty;
+    try build_pch.appendCreateFlags(alloc, &msvc_create, msvc, .cpp20, "msvc");
+    try std.testing.expectEqualStrings(msvc.stub_source.?, msvc_create.items[1]);
+    try std.testing.expectEqualStrings("/Yc/work/src/pch.hpp", msvc_create.items[2]);
+    var msvc_use: std.ArrayList([]const u8) = .empty;
+    try build_pch.appendUseFlags(alloc, &msvc_use, msvc, "msvc");
+    try std.testing.expectEqualStrings("/Yu/work/src/pch.hpp", msvc_use.items[0]);
+    try std.testing.expectEqualStrings("/Fpout/obj-app/pch/pch.hpp.pch", msvc_use.items[1]);
+    try std.testing.expectEqualStrings("/FI/work/src/pch.hpp", msvc_use.items[2]);
+}
+
+test "pch mergeHeaders adds the header's includes and drops the pch file" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const merged = try build_pch.mergeHeaders(
+        arena.allocator(),
+        &.{ "src/main.cpp", "out/pch/pch.hpp.pch", "src/util.h" },
+        "out/pch/pch.hpp.pch",
+        &.{ "src/pch.hpp", "src/util.h", "/usr/include/vector" },
+    );
+    try std.testing.expectEqual(@as(usize, 4), merged.len);
+    try std.testing.expectEqualStrings("src/main.cpp", merged[0]);
+    try std.testing.expectEqualStrings("src/util.h", merged[1]);
+    try std.testing.expectEqualStrings("src/pch.hpp", merged[2]);
+    try std.testing.expectEqualStrings("/usr/include/vector", merged[3]);
+}
+
+// ── Unity Builds ────────────────────────────────────────────────────
+
+test "unity batches stay put when a source is added" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    var sources: std.ArrayList([]const u8) = .empty;
+    for (0..200) |i| try sources.append(alloc, try std.fmt.allocPrint(alloc, "src/file{d:0>3}.cpp", .{i}));
+    const before = try build_unity.batches(alloc, sources.items, 8);
+    const added = "src/file100a.cpp";
+    try sources.append(alloc, added);
+    const after = try build_unity.batches(alloc, sources.items, 8);
+
+    var count: usize = 0;
+    for (after) |batch| {
+        try std.testing.expect(batch.len > 0 and batch.len <= 16);
+        count += batch.len;
+    }
+    try std.testing.expectEqual(sources.items.len, count);
+
+    // Batches that close before the new source, or after the first split the
+    // path hashes force past it, are unchanged.
+    var resync: ?[]const u8 = null;
+    for (after) |batch| {
+        const last = batch[batch.len - 1];
+        if (std.mem.order(u8, last, added) != .lt and std.hash.Wyhash.hash(0, last) % 8 == 0) {
+            resync = last;
+            break;
+        }
+    }
+    for (before) |batch| {
+        const before_added = std.mem.order(u8, batch[batch.len - 1], added) == .lt;
+        const after_resync = if (resync) |last| std.mem.order(u8, batch[0], last) == .gt else false;
+        if (!before_added and !after_resync) continue;
+        const kept = for (after) |other| {
+            if (other.len == batch.len and std.mem.eql(u8, other[0], batch[0]) and std.mem.eql(u8, other[other.len - 1], batch[batch.len - 1])) break true;
+        } else false;
+        try std.testing.expect(kept);
+    }
+}
+
+test "unity batch size and include prefix" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    try std.testing.expectEqual(@as(?usize, null), build_unity.batchSize(false, null, false));
+    try std.testing.expectEqual(@as(?usize, build_unity.default_batch), build_unity.batchSize(false, null, true));
+    try std.testing.expectEqual(@as(?usize, 32), build_unity.batchSize(false, 32, false));
+    try std.testing.expectEqual(@as(?usize, null), build_unity.batchSize(true, 1, true));
+
+    try std.testing.expectEqualStrings("../../../../", try build_unity.includePrefix(alloc, ".ovo/build/obj-app/unity", "/work"));
+    try std.testing.expectEqualStrings("/work/", try build_unity.includePrefix(alloc, "../out/unity", "/work"));
+    const unit = try build_unity.render(alloc, &.{ "src/a.cpp", "/abs/b.cpp" }, "../../");
+    try std.testing.expect(std.mem.indexOf(u8, unit, "#include \"../../src/a.cpp\"\n#include \"/abs/b.cpp\"\n") != null);
+}
+
+// ── C++ Modules ─────────────────────────────────────────────────────
+
+test "parseP1689 reads provided and required modules" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const scan = try build_modules.parseP1689(arena.allocator(),
+        \\{"version": 1, "revision": 0, "rules": [{
+        \\  "primary-output": "obj/math.o",
+        \\  "provides": [{"logical-name": "math:detail", "is-interface": false, "source-path": "src/detail.cpp"}],
+        \\  "requires": [{"logical-name": "math.core"}, {"logical-name": "std", "lookup-method": "by-name"}]
+        \\}]}
+    );
+    try std.testing.expect(scan.usesModules());
+    try std.testing.expectEqualStrings("math:detail", scan.provides[0].name);
+    try std.testing.expect(!scan.provides[0].is_interface);
+    try std.testing.expectEqual(@as(usize, 2), scan.requires.len);
+    try std.testing.expectEqualStrings("std", scan.requires[1]);
+
+    const plain = try build_modules.parseP1689(arena.allocator(), "{\"version\": 1, \"rules\": [{\"primary-output\": \"main.o\"}]}");
+    try std.testing.expect(!plain.usesModules());
+}
+
+test "module flags name interfaces per backend" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    try std.testing.expect(build_modules.supported(.cpp20, "clang"));
+    try std.testing.expect(!build_modules.supported(.cpp17, "clang"));
+    try std.testing.expect(!build_modules.supported(.cpp23, "zigcc"));
+    try std.testing.expect(build_modules.isInterfaceUnit("src/math.cppm"));
+    try std.testing.expect(!build_modules.isInterfaceUnit("src/main.cpp"));
+    try std.testing.expectEqualStrings("bmi/math-detail.pcm", try build_modules.bmiPath(alloc, "bmi", "math:detail", "clang"));
+    try std.testing.expectEqualStrings("bmi/math.ifc", try build_modules.bmiPath(alloc, "bmi", "math", "msvc"));
+
+    var clang: std.ArrayList([]const u8) = .empty;
+    try build_modules.appendCompileFlags(alloc, &clang, "src/math.ixx", .{ .name = "math" }, "bmi/math.pcm", "bmi", "bmi/module.map", "clang");
+    try std.testing.expectEqualStrings("-fprebuilt-module-path=bmi", clang.items[0]);
+    try std.testing.expectEqualStrings("-fmodule-output=bmi/math.pcm", clang.items[1]);
+    try std.testing.expectEqualStrings("c++-module", clang.items[3]);
+
+    var gcc: std.ArrayList([]const u8) = .empty;
+    try build_modules.appendCompileFlags(alloc, &gcc, "src/main.cpp", null, null, "bmi", "bmi/module.map", "gcc");
+    try std.testing.expectEqual(@as(usize, 2), gcc.items.len);
+    try std.testing.expectEqualStrings("-fmodule-mapper=bmi/module.map", gcc.items[1]);
+
+    var msvc: std.ArrayList([]const u8) = .empty;
+    try build_modules.appendCompileFlags(alloc, &msvc, "src/part.cpp", .{ .name = "m:part", .is_interface = false }, "bmi/m-part.ifc", "bmi", "", "msvc");
+    try std.testing.expectEqualStrings("/internalPartition", msvc.items[2]);
+    try std.testing.expectEqualStrings("bmi/m-part.ifc", msvc.items[4]);
+
+    var scan: std.ArrayList([]const u8) = .empty;
+    try build_modules.appendScanArgv(alloc, &scan, &.{ "clang++", "-std=c++20" }, "src/math.cppm", "obj/math.o", "obj/math.o.ddi", "clang");
+    try std.testing.expectEqualStrings("clang-scan-deps", scan.items[0]);
+    try std.testing.expectEqualStrings("clang++", scan.items[3]);
+}
+
+// ── Test Runner ─────────────────────────────────────────────────────
+
+test "select splits tests into disjoint shards by name" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+    const tests = [_]test_runner.Test{
+        .{ .name = "e", .path = "bin/e" },
+        .{ .name = "a", .path = "bin/a" },
+        .{ .name = "d", .path = "bin/d" },
+        .{ .name = "b", .path = "bin/b" },
+        .{ .name = "c", .path = "bin/c" },
+    };
+
+    const all = try test_runner.select(alloc, &tests, null);
+    try std.testing.expectEqual(@as(usize, 5), all.len);
+    try std.testing.expectEqualStrings("a", all[0].name);
+
+    const first = try test_runner.select(alloc, &tests, try test_runner.parseShard("1/2"));
+    const second = try test_runner.select(alloc, &tests, try test_runner.parseShard("2/2"));
+    try std.testing.expectEqual(@as(usize, 3), first.len);
+    try std.testing.expectEqual(@as(usize, 2), second.len);
+    try std.testing.expectEqualStrings("c", first[1].name);
+    try std.testing.expectEqualStrings("d", second[1].name);
+
+    try std.testing.expectError(error.InvalidShard, test_runner.parseShard("0/2"));
+    try std.testing.expectError(error.InvalidShard, test_runner.parseShard("3/2"));
+    try std.testing.expectError(error.InvalidShard, test_runner.parseShard("2"));
+}
+
+test "orderSlowestFirst puts unknown then slow tests first" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+    var history = try test_runner.parseHistory(alloc, "120 fast\n9000 slow\nbogus line\n450 medium\n");
+    try std.testing.expectEqual(@as(u32, 3), history.count());
+    try std.testing.expectEqualStrings("120 fast\n450 medium\n9000 slow\n", try test_runner.renderHistory(alloc, history));
+
+    var tests = [_]test_runner.Test{
+        .{ .name = "fast", .path = "bin/fast" },
+        .{ .name = "medium", .path = "bin/medium" },
+        .{ .name = "new", .path = "bin/new" },
+        .{ .name = "slow", .path = "bin/slow" },
+    };
+    test_runner.orderSlowestFirst(&tests, &history);
+    try std.testing.expectEqualStrings("new", tests[0].name);
+    try std.testing.expectEqualStrings("slow", tests[1].name);
+    try std.testing.expectEqualStrings("medium", tests[2].name);
+    try std.testing.expectEqualStrings("fast", tests[3].name);
+}
+
+test "test reports carry status and duration" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+    const results = [_]test_runner.Result{
+        .{ .name = "core", .duration_ns = 1500 * std.time.ns_per_ms, .log_path = ".ovo/test-logs/core.log" },
+        .{ .name = "net", .status = .failed, .exit_code = 3, .duration_ns = 20 * std.time.ns_per_ms, .log_path = ".ovo/test-logs/net.log", .output = "expected <1> & got 2\n" },
+        .{ .name = "io", .status = .timed_out, .exit_code = 128, .log_path = ".ovo/test-logs/io.log" },
+    };
+    try std.testing.expectEqual(@as(usize, 2), test_runner.failureCount(&results));
+
+    const junit = try test_runner.renderJUnit(alloc, "app", &results);
+    try std.testing.expect(std.mem.indexOf(u8, junit, "<testsuites tests=\"3\" failures=\"2\" time=\"1.520\">") != null);
+    try std.testing.expect(std.mem.indexOf(u8, junit, "<testcase name=\"core\" classname=\"app\" time=\"1.500\"/>") != null);
+    try std.testing.expect(std.mem.indexOf(u8, junit, "<failure message=\"exit code 3\">expected &lt;1&gt; &amp; got 2\n</failure>") != null);
+    try std.testing.expect(std.mem.indexOf(u8, junit, "<failure message=\"timed out\">") != null);
+
+    const json = try test_runner.renderJson(alloc, "app", &results);
+    try std.testing.expect(std.mem.indexOf(u8, json, "\"tests\":3,\"failures\":2,\"duration_ms\":1520") != null);
+    try std.testing.expect(std.mem.indexOf(u8, json, "{\"name\":\"net\",\"status\":\"failed\",\"exit_code\":3,\"duration_ms\":20,") != null);
+    try std.testing.expect(std.mem.indexOf(u8, json, "\"status\":\"timed_out\"") != null);
+
+    try std.testing.expectEqualStrings("logs/unit_io.log", try test_runner.logPath(alloc, "logs", "unit/io"));
+}
+
 // ── Package Manager Pure Functions ──────────────────────────────────
 
 test "sortedUniqueDependencies sorts alphabetically" {
@@ -382,6 +1469,107 @@ test "sortedUniqueDependencies handles already-sorted input" {
     try std.testing.expectEqualStrings("ccc", result[2].name);
 }
 
+// ── Dependency Fetch ────────────────────────────────────────────────
+
+test "dependencies with a source render and parse in struct form" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const hash = "9a93b2b7dfdac77ceba5a558a580e74667dd6fede4585b91eefb60f03b72df23";
+    const deps = [_]project_mod.Dependency{
+        .{ .name = "fmt", .version = "10.2.1" },
+        .{ .name = "zlib", .version = "1.3.1", .url = "https://zlib.net/zlib-1.3.1.tar.gz", .hash = hash },
+    };
+    const rendered = try writer.renderBuildZon(alloc, .{ .name = "demo", .version = "1.0.0", .dependencies = &deps });
+    try std.testing.expect(std.mem.indexOf(u8, rendered, ".fmt = \"10.2.1\"") != null);
+    try std.testing.expect(std.mem.indexOf(u8, rendered, ".zlib = .{\n            .version = \"1.3.1\",\n            .url = ") != null);
+
+    const parsed = try parser.parseBuildZon(alloc, rendered);
+    try std.testing.expectEqualStrings("1.3.1", parsed.dependencies[1].version);
+    try std.testing.expectEqualStrings(hash, parsed.dependencies[1].hash.?);
+    try std.testing.expect(parsed.dependencies[0].url == null);
+
+    try std.testing.expectError(error.InvalidZon, parser.parseBuildZon(alloc,
+        \\.{ .name = "x", .version = "1", .dependencies = .{ .zlib = .{ .url = "https://x", .hash = "ABC" } } }
+    ));
+}
+
+test "fetch helpers name downloads and markers" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const hash = "9a93b2b7dfdac77ceba5a558a580e74667dd6fede4585b91eefb60f03b72df23";
+    const pinned = project_mod.Dependency{ .name = "zlib", .version = "1.3.1", .url = "https://zlib.net/z.tar.gz", .hash = hash };
+    try std.testing.expectEqualStrings("/store/downloads/" ++ hash ++ ".part", try pkg_fetch.archivePath(alloc, "/store", pinned));
+    const loose = try pkg_fetch.archivePath(alloc, "/store", .{ .name = "zlib", .url = "https://zlib.net/z.tar.gz" });
+    try std.testing.expect(std.mem.startsWith(u8, loose, "/store/downloads/url-"));
+    try std.testing.expectEqualStrings(loose, try pkg_fetch.archivePath(alloc, "/store", .{ .name = "other", .url = "https://zlib.net/z.tar.gz" }));
+
+    const argv = try pkg_fetch.downloadArgv(alloc, "https://zlib.net/z.tar.gz", "z.part");
+    try std.testing.expectEqualStrings("curl", argv[0]);
+    try std.testing.expectEqualStrings("--continue-at", argv[argv.len - 5]);
+    try std.testing.expectEqualStrings("https://zlib.net/z.tar.gz", argv[argv.len - 1]);
+
+    const marker = try pkg_fetch.renderMarker(alloc, .{ .url = "https://zlib.net/z.tar.gz", .digest = hash });
+    const read = pkg_fetch.parseMarker(marker).?;
+    try std.testing.expectEqualStrings("https://zlib.net/z.tar.gz", read.url);
+    try std.testing.expectEqualStrings(hash, read.digest);
+    try std.testing.expect(pkg_fetch.parseMarker("https://x\nnot-a-digest\n") == null);
+    try std.testing.expect(project_mod.isSha256Hex(hash));
+    try std.testing.expect(!project_mod.isSha256Hex(hash[1..]));
+}
+
+test "lockfile round-trips and pins unchanged dependencies" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const hash = "9a93b2b7dfdac77ceba5a558a580e74667dd6fede4585b91eefb60f03b72df23";
+    const deps = [_]project_mod.Dependency{
+        .{ .name = "fmt", .version = "10.2.1" },
+        .{ .name = "zlib", .version = "1.3.1", .url = "https://zlib.net/z.tar.gz" },
+    };
+    const project = project_mod.Project{ .name = "demo", .version = "0.1.0" };
+    const lock = try pkg_lockfile.resolved(alloc, project, &deps, &.{ null, hash });
+    try std.testing.expect(lock.isCurrent(&deps));
+
+    const read = try pkg_lockfile.parse(alloc, try pkg_lockfile.render(alloc, lock));
+    try std.testing.expectEqualStrings("demo", read.project);
+    try std.testing.expect(read.isCurrent(&deps));
+    try std.testing.expectEqual(@as(usize, 2), read.entries.len);
+    try std.testing.expectEqualStrings(hash, read.entries[1].hash.?);
+    try std.testing.expectEqualStrings(lock.entries[1].fingerprint, read.entries[1].fingerprint);
+    try std.testing.expect(read.entries[0].hash == null);
+
+    const pinned = try pkg_lockfile.pin(alloc, &deps, read);
+    try std.testing.expectEqualStrings(hash, pinned[1].hash.?);
+
+    // A changed declaration resolves again; the others stay pinned.
+    const edited = [_]project_mod.Dependency{
+        .{ .name = "fmt", .version = "11.0.0" },
+        .{ .name = "zlib", .version = "1.3.1", .url = "https://zlib.net/z.tar.gz" },
+        .{ .name = "zstd", .version = "1.5.6", .url = "https://zstd.net/z.tar.gz" },
+    };
+    try std.testing.expect(!read.isCurrent(&edited));
+    const repinned = try pkg_lockfile.pin(alloc, &edited, read);
+    try std.testing.expectEqualStrings(hash, repinned[1].hash.?);
+    try std.testing.expect(repinned[2].hash == null);
+    try std.testing.expect(!pkg_lockfile.Entry.resolves(read.entries[1], .{ .name = "zlib", .version = "1.3.1", .url = "https://mirror/z.tar.gz" }));
+    try std.testing.expect(!std.mem.eql(u8, &pkg_lockfile.manifestDigest(&deps), &pkg_lockfile.manifestDigest(&edited)));
+
+    const updated = try read.without(alloc, "zlib");
+    try std.testing.expectEqual(@as(usize, 1), updated.entries.len);
+    try std.testing.expect((try pkg_lockfile.pin(alloc, &deps, updated))[1].hash == null);
+    try std.testing.expectEqual(@as(usize, 0), (try read.without(alloc, null)).entries.len);
+
+    const legacy = try pkg_lockfile.parse(alloc, ".{ .project = \"demo\", .dependencies = .{ .fmt = \"10.2.1\" } }");
+    try std.testing.expectEqualStrings("10.2.1", legacy.find("fmt").?.version);
+    try std.testing.expect(!legacy.isCurrent(deps[0..1]));
+    try std.testing.expectError(error.InvalidLockfile, pkg_lockfile.parse(alloc, ".{ .dependencies = .{ .zlib = .{ .hash = \"short\" } } }"));
+}
+
 // ── Export Formats ──────────────────────────────────────────────────
 
 test "parseExportFormat recognizes all formats" {
@@ -423,20 +1611,36 @@ test "exportCMake produces valid cmake output" {
     try std.testing.expect(std.mem.indexOf(u8, output, "target_link_libraries") != null);
 }
 
-test "exportNinja produces build rules" {
+test "exportNinja emits per-source compiles and ordered links" {
     var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
     defer arena.deinit();
     const alloc = arena.allocator();
 
-    const targets = [_]project_mod.Target{.{
-        .name = "app",
-        .kind = .executable,
-        .sources = &.{"src/main.cpp"},
-    }};
+    const targets = [_]project_mod.Target{
+        .{ .name = "app", .kind = .executable, .sources = &.{"src/main.cpp"}, .link_libraries = &.{ "core", "m" } },
+        .{ .name = "core", .kind = .library_static, .sources = &.{ "src/a.cpp", "src/b.cpp" }, .include_dirs = &.{"include"} },
+    };
     const project = project_mod.Project{ .name = "demo", .version = "1.0.0", .targets = &targets };
-    const output = try exporter.exportProject(alloc, project, .ninja);
-    try std.testing.expect(std.mem.indexOf(u8, output, "rule cxx") != null);
-    try std.testing.expect(std.mem.indexOf(u8, output, "build app: cxx src/main.cpp") != null);
+    const output = try exporter.exportNinja(alloc, project, .{ .optimize = "ReleaseFast" });
+
+    try std.testing.expect(std.mem.indexOf(u8, output, "cxx = zig c++\n") != null);
+    try std.testing.expect(std.mem.indexOf(u8, output, "  depfile = $out.d\n  deps = gcc\n") != null);
+    try std.testing.expect(std.mem.indexOf(u8, output, "cflags_core = -std=c++20 -O3 -Wall -Wextra -Iinclude\n") != null);
+    try std.testing.expect(std.mem.indexOf(u8, output, ": cxx src/a.cpp\n  cflags = $cflags_core\n") != null);
+    try std.testing.expect(std.mem.indexOf(u8, output, ": cxx src/b.cpp\n") != null);
+    try std.testing.expect(std.mem.indexOf(u8, output, ": cxx src/main.cpp\n  cflags = $cflags_app\n") != null);
+    try std.testing.expect(std.mem.indexOf(u8, output, "  libs = -L.ovo/build/ninja -lcore -lm\n") != null);
+    try std.testing.expect(std.mem.indexOf(u8, output, "build app: phony ") != null);
+    try std.testing.expect(std.mem.indexOf(u8, output, "command = ovo --profile ReleaseFast export ninja build.ninja\n") != null);
+    try std.testing.expect(std.mem.indexOf(u8, output, "build build.ninja: regen build.zon\n") != null);
+
+    // The library is archived before the executable that links it, which
+    // also lists it as an implicit input.
+    const archive = std.mem.indexOf(u8, output, ": ar ").?;
+    const link = std.mem.indexOf(u8, output, ": link ").?;
+    try std.testing.expect(archive < link);
+    const link_line = output[link..std.mem.indexOfScalarPos(u8, output, link, '\n').?];
+    try std.testing.expect(std.mem.indexOf(u8, link_line, " | .ovo/build/ninja/") != null);
 }
 
 test "exportMakefile produces make rules" {
@@ -466,6 +1670,22 @@ test "exportPkgConfig produces pkg-config file" {
     try std.testing.expect(std.mem.indexOf(u8, output, "Version: 2.3.4") != null);
 }
 
+test "exportPkgConfig points at an install layout and names its libraries" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const targets = [_]project_mod.Target{
+        .{ .name = "core", .kind = .library_static },
+        .{ .name = "app", .kind = .executable },
+        .{ .name = "plugin", .kind = .library_shared },
+    };
+    const project = project_mod.Project{ .name = "demo", .version = "1.0.0", .targets = &targets };
+    const output = try exporter.exportPkgConfig(alloc, project, .{ .prefix = "/opt/demo", .libdir = "lib64" });
+    try std.testing.expect(std.mem.startsWith(u8, output, "prefix=/opt/demo\nexec_prefix=${prefix}\nlibdir=${exec_prefix}/lib64\nincludedir=${prefix}/include\n"));
+    try std.testing.expect(std.mem.indexOf(u8, output, "Libs: -L${libdir} -lcore -lplugin\n") != null);
+}
+
 test "exportMSBuild produces valid vcxproj XML" {
     var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
     defer arena.deinit();
@@ -544,6 +1764,398 @@ test "parse handles passthrough args after double-dash" {
     try std.testing.expectEqualStrings("8080", parsed.passthroughArgs()[1]);
 }
 
+test "parseBuildArgs reads target and job count forms" {
+    const cases = [_]struct { argv: []const []const u8, target: ?[]const u8, jobs: ?usize }{
+        .{ .argv = &.{}, .target = null, .jobs = null },
+        .{ .argv = &.{"app"}, .target = "app", .jobs = null },
+        .{ .argv = &.{ "app", "-j", "8" }, .target = "app", .jobs = 8 },
+        .{ .argv = &.{ "-j4", "app" }, .target = "app", .jobs = 4 },
+        .{ .argv = &.{"--jobs=12"}, .target = null, .jobs = 12 },
+        .{ .argv = &.{ "--watch", "app" }, .target = "app", .jobs = null },
+    };
+    for (cases) |case| {
+        const parsed = try cli_args.parseBuildArgs(case.argv);
+        if (case.target) |expected| {
+            try std.testing.expectEqualStrings(expected, parsed.target.?);
+        } else {
+            try std.testing.expect(parsed.target == null);
+        }
+        try std.testing.expectEqual(case.jobs, parsed.jobs);
+    }
+    try std.testing.expect((try cli_args.parseBuildArgs(&.{"-w"})).watch);
+    try std.testing.expectEqualStrings("t.json", (try cli_args.parseBuildArgs(&.{"--timings=t.json"})).timings.?);
+    try std.testing.expectEqualStrings("t.json", (try cli_args.parseBuildArgs(&.{ "--timings", "t.json" })).timings.?);
+    try std.testing.expect(!(try cli_args.parseBuildArgs(&.{"app"})).watch);
+    try std.testing.expect((try cli_args.parseBuildArgs(&.{ "app", "--unity" })).unity);
+    try std.testing.expect((try cli_args.parseBuildArgs(&.{ "app", "--explain" })).explain);
+    try std.testing.expectEqual(@as(?cli_args.PgoMode, .train), (try cli_args.parseBuildArgs(&.{ "app", "--pgo=train" })).pgo);
+}
+
+test "parseTestArgs separates runner flags from build flags" {
+    const parsed = try cli_args.parseTestArgs(&.{ "unit", "-j", "4", "--timeout=30", "--shard", "2/3", "--junit=out.xml", "--slowest-first" });
+    try std.testing.expectEqualStrings("unit", parsed.build.target.?);
+    try std.testing.expectEqual(@as(?usize, 4), parsed.build.jobs);
+    try std.testing.expectEqual(@as(?u64, 30), parsed.timeout_s);
+    try std.testing.expectEqualStrings("2/3", parsed.shard.?);
+    try std.testing.expectEqualStrings("out.xml", parsed.junit.?);
+    try std.testing.expect(parsed.json == null);
+    try std.testing.expectEqualStrings("--timeout", parsed.runnerFlag().?);
+    try std.testing.expect((try cli_args.parseTestArgs(&.{"--watch"})).runnerFlag() == null);
+
+    try std.testing.expectError(error.InvalidTimeout, cli_args.parseTestArgs(&.{"--timeout=0"}));
+    try std.testing.expectError(error.InvalidTimeout, cli_args.parseTestArgs(&.{"--timeout"}));
+    try std.testing.expectError(error.MissingReportPath, cli_args.parseTestArgs(&.{"--json="}));
+    try std.testing.expectError(error.UnknownBuildFlag, cli_args.parseTestArgs(&.{"--bogus"}));
+}
+
+test "parseBuildArgs rejects invalid job counts" {
+    try std.testing.expectError(error.MissingJobCount, cli_args.parseBuildArgs(&.{"-j"}));
+    try std.testing.expectError(error.InvalidJobCount, cli_args.parseBuildArgs(&.{ "-j", "0" }));
+    try std.testing.expectError(error.InvalidJobCount, cli_args.parseBuildArgs(&.{"-jfast"}));
+    try std.testing.expectError(error.UnknownBuildFlag, cli_args.parseBuildArgs(&.{"--bogus"}));
+    try std.testing.expectError(error.MissingTimingsPath, cli_args.parseBuildArgs(&.{"--timings="}));
+    try std.testing.expectError(error.InvalidPgoMode, cli_args.parseBuildArgs(&.{"--pgo=fast"}));
+}
+
+test "parseSourceToolArgs reads --changed and job counts" {
+    const parsed = try cli_args.parseSourceToolArgs(&.{ "--changed", "-j", "8" });
+    try std.testing.expect(parsed.changed);
+    try std.testing.expectEqual(@as(?usize, 8), parsed.jobs);
+    try std.testing.expect(!(try cli_args.parseSourceToolArgs(&.{})).changed);
+    try std.testing.expectError(error.UnexpectedArgument, cli_args.parseSourceToolArgs(&.{"src/a.cpp"}));
+    try std.testing.expectError(error.UnknownBuildFlag, cli_args.parseSourceToolArgs(&.{"--unity"}));
+}
+
+// ── Source Tools ────────────────────────────────────────────────────
+
+test "source tools batch files and key clean results" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    try std.testing.expectEqual(@as(usize, 1), code_tools.batchSize(3, 8));
+    try std.testing.expectEqual(@as(usize, 13), code_tools.batchSize(100, 8));
+    try std.testing.expectEqual(code_tools.max_batch, code_tools.batchSize(100_000, 8));
+
+    const key = code_tools.cleanKey("clang-format 18", 1, 2, "int x;\n");
+    try std.testing.expectEqual(key, code_tools.cleanKey("clang-format 18", 1, 2, "int x;\n"));
+    try std.testing.expect(key != code_tools.cleanKey("clang-format 19", 1, 2, "int x;\n"));
+    try std.testing.expect(key != code_tools.cleanKey("clang-format 18", 3, 2, "int x;\n"));
+    try std.testing.expect(key != code_tools.cleanKey("clang-format 18", 1, 4, "int x;\n"));
+    try std.testing.expect(key != code_tools.cleanKey("clang-format 18", 1, 2, "int y;\n"));
+
+    var state = code_tools.State{};
+    try state.clean.put(alloc, "src/a b.cpp", key);
+    const loaded = try code_tools.parseState(alloc, try state.render(alloc));
+    try std.testing.expectEqual(@as(?u64, key), loaded.clean.get("src/a b.cpp"));
+    try std.testing.expectEqual(@as(u32, 0), (try code_tools.parseState(alloc, "ovo-source-tool-state 0\nsrc/a.cpp\t1\n")).clean.count());
+}
+
+// ── Build Daemon ────────────────────────────────────────────────────
+
+test "daemon frames round-trip requests, output and exit codes" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    var buffer: [256]u8 = undefined;
+    var out: std.Io.Writer = .fixed(&buffer);
+    try cli_daemon.writeFrame(&out, .{ .environment = cli_daemon.environmentDigest() });
+    try cli_daemon.writeFrame(&out, .{ .request = &.{ "ovo", "run", "app", "--", "" } });
+    try cli_daemon.writeFrame(&out, .{ .output = "build: project=demo\n" });
+    try cli_daemon.writeFrame(&out, .{ .run = &.{"build/app"} });
+    try cli_daemon.writeFrame(&out, .{ .exit = 3 });
+    try cli_daemon.writeFrame(&out, .{ .declined = "environment differs" });
+
+    var in: std.Io.Reader = .fixed(out.buffered());
+    try std.testing.expectEqual(cli_daemon.environmentDigest(), (try cli_daemon.readFrame(&in, alloc)).environment);
+    const request = (try cli_daemon.readFrame(&in, alloc)).request;
+    try std.testing.expectEqual(@as(usize, 5), request.len);
+    try std.testing.expectEqualStrings("app", request[2]);
+    try std.testing.expectEqualStrings("", request[4]);
+    try std.testing.expectEqualStrings("build: project=demo\n", (try cli_daemon.readFrame(&in, alloc)).output);
+    try std.testing.expectEqualStrings("build/app", (try cli_daemon.readFrame(&in, alloc)).run[0]);
+    try std.testing.expectEqual(@as(u8, 3), (try cli_daemon.readFrame(&in, alloc)).exit);
+    try std.testing.expectEqualStrings("environment differs", (try cli_daemon.readFrame(&in, alloc)).declined);
+
+    var short_digest: std.Io.Reader = .fixed("e\x02\x00\x00\x00\x01\x02");
+    try std.testing.expectError(error.InvalidDaemonFrame, cli_daemon.readFrame(&short_digest, alloc));
+    var bad: std.Io.Reader = .fixed("x\x02\x00\x00\x00\x01\x02");
+    try std.testing.expectError(error.InvalidDaemonFrame, cli_daemon.readFrame(&bad, alloc));
+}
+
+test "daemon serves builds but not watch, stats or other commands" {
+    if (!cli_daemon.supported) return error.SkipZigTest;
+    try std.testing.expect(cli_daemon.shouldForward(&(try cli_args.parse(&.{ "ovo", "build", "app" }))));
+    try std.testing.expect(cli_daemon.shouldForward(&(try cli_args.parse(&.{ "ovo", "info" }))));
+    try std.testing.expect(!cli_daemon.shouldForward(&(try cli_args.parse(&.{ "ovo", "test", "--watch" }))));
+    try std.testing.expect(!cli_daemon.shouldForward(&(try cli_args.parse(&.{ "ovo", "--stats", "build" }))));
+    try std.testing.expect(!cli_daemon.shouldForward(&(try cli_args.parse(&.{ "ovo", "fmt" }))));
+}
+
+// ── Distributed Compilation ─────────────────────────────────────────
+
+test "OVO_WORKERS lists hosts with optional ports and slots" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+    const hosts = try distributed.parseHosts(alloc, "farm-1, farm-2:4000/32 [::1]:5000\t10.0.0.7/8");
+    try std.testing.expectEqual(@as(usize, 4), hosts.len);
+    try std.testing.expectEqualStrings("farm-1", hosts[0].name);
+    try std.testing.expectEqual(distributed.default_port, hosts[0].port);
+    try std.testing.expectEqual(@as(usize, distributed.default_slots), hosts[0].slots);
+    try std.testing.expectEqual(@as(u16, 4000), hosts[1].port);
+    try std.testing.expectEqual(@as(usize, 32), hosts[1].slots);
+    try std.testing.expectEqualStrings("::1", hosts[2].name);
+    try std.testing.expectEqual(@as(u16, 5000), hosts[2].port);
+    try std.testing.expectEqualStrings("10.0.0.7", hosts[3].name);
+    try std.testing.expectEqual(@as(usize, 0), (try distributed.parseHosts(alloc, " ")).len);
+    try std.testing.expectError(error.InvalidWorkerHost, distributed.parseHosts(alloc, "farm-1/0"));
+    try std.testing.expectError(error.InvalidWorkerHost, distributed.parseHosts(alloc, "farm-1:port"));
+}
+
+test "remote compiles preprocess locally and ship only code-generation flags" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+    const argv = [_][]const u8{ "zig", "c++", "-std=c++20", "-O2", "-Iinclude", "-DNDEBUG", "-fPIC", "-MD", "-MF", "build/obj-app/main.d", "-c", "src/main.cpp", "-o", "build/obj-app/main.o" };
+
+    const flags = (try distributed.remoteFlags(alloc, &argv, 2)).?;
+    try std.testing.expectEqual(@as(usize, 3), flags.len);
+    try std.testing.expectEqualStrings("-std=c++20", flags[0]);
+    try std.testing.expectEqualStrings("-fPIC", flags[2]);
+    for (flags) |flag| try std.testing.expect(distributed.allowedFlag(flag));
+
+    const preprocess = try distributed.preprocessArgv(alloc, &argv, "build/obj-app/main.o.ii");
+    try std.testing.expectEqualStrings("-MF", preprocess[8]);
+    try std.testing.expectEqualStrings("-E", preprocess[10]);
+    try std.testing.expectEqualStrings("src/main.cpp", preprocess[11]);
+    try std.testing.expectEqualStrings("build/obj-app/main.o.ii", preprocess[13]);
+
+    try std.testing.expect((try distributed.remoteFlags(alloc, &.{ "cl", "/c", "a.cpp", "/Fo:a.obj" }, 1)) == null);
+    try std.testing.expect(distributed.allowedFlag("-march=native"));
+    try std.testing.expect(!distributed.allowedFlag("-fplugin=evil.so"));
+    try std.testing.expect(!distributed.allowedFlag("@flags.rsp"));
+    try std.testing.expect(!distributed.allowedFlag("-o"));
+    try std.testing.expect(!distributed.allowedFlag("/etc/passwd"));
+}
+
+test "workers refuse flags that load code or name files" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+    var compilers: std.StringArrayHashMapUnmanaged([]const u8) = .empty;
+    try compilers.put(alloc, "clang++", "00ff");
+
+    const accepted = [_][]const u8{ distributed.protocol_version, "clang++", "00ff", "-std=c++20", "-O2", "-g", "-fPIC", "-flto=thin", "-fno-exceptions", "-march=native", "-gsplit-dwarf=single", "--target=aarch64-linux-gnu", "-Wall", "-Werror=return-type" };
+    try std.testing.expect(distributed.refusal(&compilers, &accepted) == null);
+
+    const refused = [_][]const u8{
+        "-fpass-plugin=evil.so",
+        "--config=evil.cfg",
+        "-MJout.json",
+        "-ftime-trace=trace.json",
+        "-foptimization-record-file=x.yaml",
+        "-fcrash-diagnostics-dir=tmp",
+        "-Wa,-o,evil",
+        "-oevil.o",
+        "-o",
+        "-fplugin=evil.so",
+        "-mllvm",
+        "-mllvm=-enable-misched",
+        "-gen-reproducer",
+        "-gsplit-dwarf",
+        "-fprofile-use=default.profdata",
+        "@flags.rsp",
+        "/etc/passwd",
+    };
+    for (refused) |flag| {
+        var request = accepted;
+        request[request.len - 1] = flag;
+        try std.testing.expectEqualStrings("flag not allowed", distributed.refusal(&compilers, &request).?);
+    }
+    try std.testing.expectEqualStrings("compiler version differs", distributed.refusal(&compilers, &.{ distributed.protocol_version, "clang++", "0000" }).?);
+    try std.testing.expectEqualStrings("compiler not installed", distributed.refusal(&compilers, &.{ distributed.protocol_version, "g++", "00ff" }).?);
+}
+
+test "worker frames round-trip jobs and results" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    var buffer: [256]u8 = undefined;
+    var out: std.Io.Writer = .fixed(&buffer);
+    try distributed.writeFrame(&out, .{ .compile = &.{ "1", "clang++", "00ff", "-O2" } });
+    try distributed.writeFrame(&out, .{ .source = "int main() { return 0; }\n" });
+    try distributed.writeFrame(&out, .{ .object = "\x7fELF" });
+    try distributed.writeFrame(&out, .{ .refused = "busy" });
+    try distributed.writeFrame(&out, .{ .exit = 0 });
+
+    var in: std.Io.Reader = .fixed(out.buffered());
+    const request = (try distributed.readFrame(&in, alloc)).compile;
+    try std.testing.expectEqual(@as(usize, 4), request.len);
+    try std.testing.expectEqualStrings("clang++", request[1]);
+    try std.testing.expectEqualStrings("int main() { return 0; }\n", (try distributed.readFrame(&in, alloc)).source);
+    try std.testing.expectEqualStrings("\x7fELF", (try distributed.readFrame(&in, alloc)).object);
+    try std.testing.expectEqualStrings("busy", (try distributed.readFrame(&in, alloc)).refused);
+    try std.testing.expectEqual(@as(u8, 0), (try distributed.readFrame(&in, alloc)).exit);
+}
+
+test "parseWorkerArgs takes a listen address and a job count" {
+    const parsed = try cli_args.parseWorkerArgs(&.{ "--listen=127.0.0.1:4000", "-j", "16" });
+    try std.testing.expectEqualStrings("127.0.0.1:4000", parsed.listen);
+    try std.testing.expectEqual(@as(?usize, 16), parsed.jobs);
+    try std.testing.expectEqualStrings("0.0.0.0:3633", (try cli_args.parseWorkerArgs(&.{})).listen);
+    try std.testing.expectError(error.MissingListenAddress, cli_args.parseWorkerArgs(&.{"--listen"}));
+    try std.testing.expectError(error.UnexpectedArgument, cli_args.parseWorkerArgs(&.{"farm-1"}));
+}
+
+// ── Build History ───────────────────────────────────────────────────
+
+test "build history round-trips and rejects other formats" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    var history: schedule.History = .{};
+    try history.record(alloc, ".ovo/obj-app/main.o", .{ .wall_ns = 2_500 * std.time.ns_per_us, .peak_rss = 300 * 1024 * 1024 });
+    try history.record(alloc, ".ovo/app", .{ .wall_ns = 40 * std.time.ns_per_us });
+    try history.record(alloc, ".ovo/app", .{ .wall_ns = 70 * std.time.ns_per_us });
+    const rendered = try schedule.render(alloc, history);
+    try std.testing.expectEqualStrings("ovo-build-history 1\n70\t0\t.ovo/app\n2500\t307200\t.ovo/obj-app/main.o\n", rendered);
+
+    const parsed = try schedule.parse(alloc, rendered);
+    try std.testing.expectEqual(@as(u64, 300 * 1024 * 1024), parsed.get(".ovo/obj-app/main.o").?.peak_rss);
+    try std.testing.expectError(error.InvalidBuildHistory, schedule.parse(alloc, "70 .ovo/app\n"));
+    try std.testing.expectError(error.InvalidBuildHistory, schedule.parse(alloc, "ovo-build-history 1\n70\t.ovo/app\n"));
+}
+
+test "predictions treat new outputs as long and chains follow dependents" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    var history: schedule.History = .{};
+    try history.record(alloc, "a.o", .{ .wall_ns = 900, .peak_rss = 100 });
+    try history.record(alloc, "b.o", .{ .wall_ns = 100, .peak_rss = 300 });
+    const predictor = schedule.Predictor.init(&history);
+    try std.testing.expectEqual(@as(u64, 100), predictor.predict("b.o").wall_ns);
+    const unknown = predictor.predict("new.o");
+    try std.testing.expectEqual(@as(u64, 900), unknown.wall_ns);
+    try std.testing.expectEqual(@as(u64, 200), unknown.peak_rss);
+
+    // app links core and util; util links core.
+    const graph = target_graph.Graph{
+        .targets = &.{},
+        .deps = &.{ &.{}, &.{0}, &.{ 0, 1 } },
+        .order = &.{ 0, 1, 2 },
+    };
+    const chain = try schedule.chainTimes(alloc, graph, &.{ 10, 20, 40 });
+    try std.testing.expectEqualSlices(u64, &.{ 70, 60, 40 }, chain);
+}
+
+test "local job count and memory probes read procfs formats" {
+    try std.testing.expectEqual(@as(usize, 16), schedule.localJobs(16, null));
+    try std.testing.expectEqual(@as(usize, 12), schedule.localJobs(16, 4.7));
+    try std.testing.expectEqual(@as(usize, 8), schedule.localJobs(16, 40));
+    try std.testing.expectEqual(@as(usize, 1), schedule.localJobs(1, 3));
+
+    const meminfo = "MemTotal:       32000000 kB\nMemFree:         1000000 kB\nMemAvailable:   12000000 kB\n";
+    try std.testing.expectEqual(@as(?u64, 12000000 * 1024), schedule.parseMemAvailable(meminfo));
+    try std.testing.expectEqual(@as(?u64, null), schedule.parseMemAvailable("MemTotal: 1 kB\n"));
+    try std.testing.expectEqual(@as(?f64, 2.5), schedule.parseLoadAverage("2.50 1.20 0.80 3/900 1234\n"));
+}
+
+test "memory slots admit a job bigger than the budget when alone" {
+    var slots = job_pool.Slots{ .free = 4, .memory_budget = 1000 };
+    slots.acquire(1500);
+    try std.testing.expectEqual(@as(u64, 1500), slots.memory_reserved);
+    slots.release(1500);
+    slots.acquire(600);
+    slots.acquire(400);
+    try std.testing.expectEqual(@as(usize, 2), slots.free);
+    slots.release(400);
+    slots.release(600);
+    try std.testing.expectEqual(@as(u64, 0), slots.memory_reserved);
+}
+
+// ── Install ─────────────────────────────────────────────────────────
+
+test "install plan follows the layout" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    const artifacts = [_]orchestrator.BuiltArtifact{
+        .{ .name = "app", .kind = .executable, .path = ".ovo/build/app" },
+        .{ .name = "core", .kind = .library_static, .path = ".ovo/build/libcore.a" },
+    };
+    const project = project_mod.Project{ .name = "demo", .version = "1.0.0" };
+    const items = try build_install.plan(alloc, project, &artifacts, .{ .prefix = "/opt/demo", .libdir = "lib64" });
+    try std.testing.expectEqual(@as(usize, 2), items.len);
+    try std.testing.expectEqualStrings("/opt/demo/bin/app", items[0].dest);
+    try std.testing.expect(items[0].executable);
+    try std.testing.expectEqualStrings("/opt/demo/lib64/libcore.a", items[1].dest);
+    try std.testing.expectEqualStrings(".ovo/build/libcore.a", items[1].source);
+    try std.testing.expect(!items[1].executable);
+}
+
+test "install records round-trip and reject other formats" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    const alloc = arena.allocator();
+
+    var records: build_install.Records = .empty;
+    try records.put(alloc, "/opt/demo/bin/app", .{
+        .source = ".ovo/build/app",
+        .source_fingerprint = .{ .mtime_ns = 1_700_000_000_000_000_000, .size = 4096 },
+        .dest_fingerprint = .{ .mtime_ns = 1_700_000_000_500_000_000, .size = 4096 },
+        .mode = .link,
+    });
+    const rendered = try build_install.renderRecords(alloc, records);
+    try std.testing.expectEqualStrings("ovo-install 1\n1700000000000000000\t4096\t1700000000500000000\t4096\tlink\t/opt/demo/bin/app\t.ovo/build/app\n", rendered);
+
+    const parsed = try build_install.parseRecords(alloc, rendered);
+    const record = parsed.get("/opt/demo/bin/app").?;
+    try std.testing.expectEqualStrings(".ovo/build/app", record.source);
+    try std.testing.expectEqual(@as(i128, 1_700_000_000_500_000_000), record.dest_fingerprint.mtime_ns);
+    try std.testing.expectEqual(build_install.Mode.link, record.mode);
+    try std.testing.expectError(error.InvalidInstallRecord, build_install.parseRecords(alloc, "ovo-install 1\n1\t2\t3\t4\tmove\ta\tb\n"));
+    try std.testing.expectError(error.InvalidInstallRecord, build_install.parseRecords(alloc, "1\t2\t3\t4\tcopy\ta\tb\n"));
+}
+
+test "parseInstallArgs separates the layout from build flags" {
+    const parsed = try cli_args.parseInstallArgs(&.{ "app", "--prefix=/opt/demo", "--libdir", "lib64", "--link", "-j", "8" });
+    try std.testing.expectEqualStrings("app", parsed.build.target.?);
+    try std.testing.expectEqual(@as(?usize, 8), parsed.build.jobs);
+    try std.testing.expectEqualStrings("/opt/demo", parsed.prefix.?);
+    try std.testing.expectEqualStrings("lib64", parsed.libdir.?);
+    try std.testing.expect(parsed.bindir == null);
+    try std.testing.expect(parsed.link);
+    try std.testing.expectError(error.MissingInstallDir, cli_args.parseInstallArgs(&.{"--prefix="}));
+    try std.testing.expectError(error.UnknownBuildFlag, cli_args.parseInstallArgs(&.{"--destdir=x"}));
+}
+
+// ── Memory Accounting ───────────────────────────────────────────────
+
+test "Counting tracks allocations over an arena on the page allocator" {
+    var arena = std.heap.ArenaAllocator.init(core_memory.page_allocator);
+    defer arena.deinit();
+    var counting = core_memory.Counting{ .child = arena.allocator() };
+    const alloc = counting.allocator();
+
+    const flag = try std.fmt.allocPrint(alloc, "-I{s}", .{"include"});
+    try std.testing.expectEqualStrings("-Iinclude", flag);
+    var list: std.ArrayList(u32) = .empty;
+    try list.appendSlice(alloc, &.{ 1, 2, 3 });
+    alloc.free(flag);
+
+    try std.testing.expect(counting.allocations >= 2);
+    try std.testing.expect(counting.requested_bytes >= flag.len + 3 * @sizeOf(u32));
+    try std.testing.expect(core_memory.peakPageBytes() >= arena.queryCapacity());
+    try std.testing.expect((try cli_args.parse(&.{ "ovo", "--stats", "build" })).stats);
+}
+
 // ── Core Project Helpers ────────────────────────────────────────────
 
 test "guessProjectNameFromPath handles edge cases" {